@@ -78,6 +78,7 @@ check_include_files(string.h HAVE_STRING_H)
 check_include_files(unistd.h HAVE_UNISTD_H)
 check_include_files(sys/param.h HAVE_SYS_PARAM_H)
 check_include_files(sys/stat.h HAVE_SYS_STAT_H)
+check_include_files(sys/inotify.h HAVE_SYS_INOTIFY_H)
 check_include_files(sys/types.h HAVE_SYS_TYPES_H)
 check_include_files(sys/utsname.h HAVE_SYS_UTSNAME_H)
 check_include_files(sys/wait.h HAVE_SYS_WAIT_H)
@@ -49,6 +49,7 @@
 
 std::vector<TimingData> AdjustSync::s_vpTimingDataOriginal;
 float AdjustSync::s_fGlobalOffsetSecondsOriginal = 0.0f;
+int AdjustSync::s_iSyncChanges = 0;
 int AdjustSync::s_iAutosyncOffsetSample = 0;
 float AdjustSync::s_fAutosyncOffset[AdjustSync::OFFSET_SAMPLE_COUNT];
 float AdjustSync::s_fStandardDeviation = 0.0f;
@@ -137,6 +138,7 @@ void AdjustSync::RevertSyncChanges()
 		s->m_Timing = s_vpTimingDataOriginal[location];
 		location++;
 	}
+	++s_iSyncChanges;
 
 	ResetOriginalSyncData();
 	s_fStandardDeviation = 0.0f;
@@ -220,6 +222,7 @@ void AdjustSync::AutosyncOffset()
 			default:
 				FAIL_M(ssprintf("Invalid autosync type: %i", type));
 		}
+		++s_iSyncChanges;
 
 		SCREENMAN->SystemMessage( AUTOSYNC_CORRECTION_APPLIED.GetValue() );
 	}
@@ -284,6 +287,7 @@ void AdjustSync::AutosyncTempo()
 			const DelaySegment *s = ToDelay( delays[i] );
 			timing.AddSegment( DelaySegment(s->GetRow(), s->GetPause() * (1.0f - fSlope)) );
 		}
+		++s_iSyncChanges;
 
 		SCREENMAN->SystemMessage( AUTOSYNC_CORRECTION_APPLIED.GetValue() );
 	}
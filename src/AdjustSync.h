@@ -22,6 +22,9 @@ public:
 	static std::vector<TimingData> s_vpTimingDataOriginal;
 
 	static float s_fGlobalOffsetSecondsOriginal;
+	/* Counts changes to the offsets and tempo made during a song, so
+	 * anything that worked out note times from them can do it again. */
+	static int s_iSyncChanges;
 	/* We only want to call the Reset methods before a song, not immediately after
 	 * a song. If we reset it at the end of a song, we have to carefully check
 	 * the logic to make sure we never reset it before the user gets a chance to
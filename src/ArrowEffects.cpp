@@ -9,6 +9,7 @@
 #include "RageMath.h"
 #include "ScreenDimensions.h"
 #include "PlayerState.h"
+#include "NoteFieldCache.h"
 #include "GameState.h"
 #include "Style.h"
 #include "ThemeMetric.h"
@@ -16,6 +17,7 @@
 #include <cfloat>
 #include <cmath>
 #include <cstddef>
+#include <initializer_list>
 #include <vector>
 
 
@@ -85,7 +87,6 @@ static ThemeMetric<float>	TINY_PERCENT_GATE( "ArrowEffects", "TinyPercentGate" )
 
 static const PlayerOptions* curr_options= nullptr;
 
-float ArrowGetPercentVisible(float fYPosWithoutReverse, int iCol, float fYOffset);
 
 static float GetNoteFieldHeight()
 {
@@ -152,38 +153,6 @@ static float SelectTanType(float angle, bool is_cosec)
 	    return std::tan(angle);
 }
 
-static float CalculateTornadoOffsetFromMagnitude(int dimension, int col_id,
-	float magnitude, float effect_offset, float period,
-	const Style::ColumnInfo* pCols, float field_zoom,
-	PerPlayerData& data, float y_offset, bool is_tan)
-{
-	float const real_pixel_offset= pCols[col_id].fXOffset * field_zoom;
-	float const position_between= SCALE(real_pixel_offset,
-		data.m_MinTornado[dimension][col_id] * field_zoom,
-		data.m_MaxTornado[dimension][col_id] * field_zoom,
-		tornado_position_scale_to_low[dimension],
-		tornado_position_scale_to_high[dimension]);
-	float rads= std::acos(position_between);
-	float frequency= tornado_offset_frequency[dimension];
-	rads+= (y_offset + effect_offset) * ((period * frequency) + frequency) / SCREEN_HEIGHT;
-	float processed_rads = is_tan ? SelectTanType(rads, curr_options->m_bCosecant) : std::cos(rads);
-
-	float const adjusted_pixel_offset= SCALE(processed_rads,
-		tornado_offset_scale_from_low[dimension],
-		tornado_offset_scale_from_high[dimension],
-		data.m_MinTornado[dimension][col_id] * field_zoom,
-		data.m_MaxTornado[dimension][col_id] * field_zoom);
-	return (adjusted_pixel_offset - real_pixel_offset) * magnitude;
-}
-
-static float CalculateDrunkAngle(float speed, int col, float offset,
-	float col_frequency, float y_offset, float period, float offset_frequency)
-{
-	float time = ArrowEffects::GetTime();
-	return time * (1+speed) + col*( (offset*col_frequency) + col_frequency)
-		+ y_offset * ( (period*offset_frequency) + offset_frequency) / SCREEN_HEIGHT;
-}
-
 static float CalculateBumpyAngle(float y_offset, float offset, float period)
 {
 	return (y_offset+(100.0f*offset))/((period*16.0f)+16.0f);
@@ -436,175 +405,110 @@ void ArrowEffects::SetCurrentOptions(const PlayerOptions* options)
 
 static float GetDisplayedBeat( const PlayerState* pPlayerState, float beat )
 {
-	// do a binary search here
-	const std::vector<CacheDisplayedBeat> &data = pPlayerState->m_CacheDisplayedBeat;
-	int max = data.size() - 1;
-	int l = 0, r = max;
-	while( l <= r )
-	{
-		int m = ( l + r ) / 2;
-		if( ( m == 0 || data[m].beat <= beat ) && ( m == max || beat < data[m + 1].beat ) )
-		{
-			return data[m].displayedBeat + data[m].velocity * (beat - data[m].beat);
-		}
-		else if( data[m].beat <= beat )
-		{
-			l = m + 1;
-		}
-		else
-		{
-			r = m - 1;
-		}
-	}
-	return beat;
+	const NoteFieldCache *pCache = pPlayerState->m_pNoteFieldCache.get();
+	return pCache? pCache->GetDisplayedBeat( beat ):beat;
 }
 
-/* For visibility testing: if bAbsolute is false, random modifiers must return
- * the minimum possible scroll speed. */
-float ArrowEffects::GetYOffset( const PlayerState* pPlayerState, int iCol, float fNoteBeat, float &fPeakYOffsetOut, bool &bIsPastPeakOut, bool bAbsolute )
-{
-	// Default values that are returned if boomerang is off.
-	fPeakYOffsetOut = FLT_MAX;
-	bIsPastPeakOut = true;
-
-	float fYOffset = 0;
-	const SongPosition &position = pPlayerState->GetDisplayedPosition();
+static void ArrowGetReverseShiftAndScale(int iCol, float fYReverseOffsetPixels, float &fShiftOut, float &fScaleOut);
+static float GetCenterLine();
+static float GetHiddenStartLine();
+static float GetHiddenEndLine();
+static float GetSuddenStartLine();
+static float GetSuddenEndLine();
 
-	float fSongBeat = position.m_fSongBeatVisible;
+// Whether any of iMods is set in fMods.
+static bool AnyOn( const float *fMods, std::initializer_list<int> iMods )
+{
+	for( int i : iMods )
+		if( fMods[i] != 0 )
+			return true;
+	return false;
+}
 
+void ArrowEffects::FrameContext::Load( const PlayerState* pPlayerState, int iCol, float fYReverseOffsetPixels )
+{
+	m_pPlayerState = pPlayerState;
+	m_iCol = iCol;
+	// TODO: Don't index by PlayerNumber.
+	m_pStyle = GAMESTATE->GetCurrentStyle(pPlayerState->m_PlayerNumber);
+	m_pCols = m_pStyle->m_ColumnInfo[pPlayerState->m_PlayerNumber];
 	Steps *pCurSteps = GAMESTATE->m_pCurSteps[pPlayerState->m_PlayerNumber];
+	m_pTiming = pCurSteps? pCurSteps->GetTimingData():nullptr;
 
-	/* Usually, fTimeSpacing is 0 or 1, in which case we use entirely beat spacing or
-	 * entirely time spacing (respectively). Occasionally, we tween between them. */
-	if( curr_options->m_fTimeSpacing != 1.0f )
-	{
-		if( GAMESTATE->m_bInStepEditor ) {
-			// Use constant spacing in step editor
-			fYOffset = fNoteBeat - fSongBeat;
-		} else {
-			fYOffset = GetDisplayedBeat(pPlayerState, fNoteBeat) - GetDisplayedBeat(pPlayerState, fSongBeat);
-			fYOffset *= pCurSteps->GetTimingData()->GetDisplayedSpeedPercent(
-								     position.m_fSongBeatVisible,
-								     position.m_fMusicSecondsVisible );
-		}
-		fYOffset *= 1 - curr_options->m_fTimeSpacing;
-	}
-
-	if( curr_options->m_fTimeSpacing != 0.0f )
+	const SongPosition &position = pPlayerState->GetDisplayedPosition();
+	m_fSongBeat = position.m_fSongBeatVisible;
+	m_fSongDisplayedBeat = m_fSongBeat;
+	m_fSpeedPercent = 1;
+	if( curr_options->m_fTimeSpacing != 1.0f && !GAMESTATE->m_bInStepEditor && m_pTiming != nullptr )
 	{
-		float fSongSeconds = pPlayerState->m_Position.m_fMusicSecondsVisible;
-		float fNoteSeconds = pCurSteps->GetTimingData()->GetElapsedTimeFromBeat(fNoteBeat);
-		float fSecondsUntilStep = fNoteSeconds - fSongSeconds;
-		float fBPM = curr_options->m_fScrollBPM;
-		float fBPS = fBPM/60.f / GAMESTATE->m_SongOptions.GetCurrent().m_fMusicRate;
-		float fYOffsetTimeSpacing = fSecondsUntilStep * fBPS;
-		fYOffset += fYOffsetTimeSpacing * curr_options->m_fTimeSpacing;
+		m_fSongDisplayedBeat = GetDisplayedBeat( pPlayerState, m_fSongBeat );
+		m_fSpeedPercent = m_pTiming->GetDisplayedSpeedPercent( position.m_fSongBeatVisible, position.m_fMusicSecondsVisible );
 	}
+	m_fSongSeconds = pPlayerState->m_Position.m_fMusicSecondsVisible;
+	m_fBPS = curr_options->m_fScrollBPM/60.f / GAMESTATE->m_SongOptions.GetCurrent().m_fMusicRate;
 
-	// TODO: If we allow noteskins to have metricable row spacing
-	// (per issue 24), edit this to reflect that. -aj
-	fYOffset *= ARROW_SPACING;
-
-	// Factor in scroll speed
-	float fScrollSpeed = curr_options->m_fScrollSpeed;
+	m_fScrollSpeed = curr_options->m_fScrollSpeed;
 	if(curr_options->m_fMaxScrollBPM != 0)
 	{
-		fScrollSpeed= curr_options->m_fMaxScrollBPM /
+		m_fScrollSpeed= curr_options->m_fMaxScrollBPM /
 			(pPlayerState->m_fReadBPM * GAMESTATE->m_SongOptions.GetCurrent().m_fMusicRate);
 	}
 
-	// don't mess with the arrows after they've crossed 0
-	if( fYOffset < 0 )
-	{
-		return fYOffset * fScrollSpeed;
-	}
-
-	const float* fAccels = curr_options->m_fAccels;
-	const float* fEffects = curr_options->m_fEffects;
-
-	// TODO: Don't index by PlayerNumber.
-	PerPlayerData &data = g_EffectData[pPlayerState->m_PlayerNumber];
-
-	float fYAdjust = 0;	// fill this in depending on PlayerOptions
-
-	if( fAccels[PlayerOptions::ACCEL_BOOST] != 0 )
-	{
-		float fEffectHeight = GetNoteFieldHeight();
-		float fNewYOffset = fYOffset * 1.5f / ((fYOffset+fEffectHeight/1.2f)/fEffectHeight);
-		float fAccelYAdjust =	fAccels[PlayerOptions::ACCEL_BOOST] * (fNewYOffset - fYOffset);
-		// TRICKY: Clamp this value, or else BOOST+BOOMERANG will draw a ton of arrows on the screen.
-		CLAMP( fAccelYAdjust, BOOST_MOD_MIN_CLAMP, BOOST_MOD_MAX_CLAMP );
-		fYAdjust += fAccelYAdjust;
-	}
-	if( fAccels[PlayerOptions::ACCEL_BRAKE] != 0 )
-	{
-		float fEffectHeight = GetNoteFieldHeight();
-		float fScale = SCALE( fYOffset, 0.f, fEffectHeight, 0, 1.f );
-		float fNewYOffset = fYOffset * fScale;
-		float fBrakeYAdjust = fAccels[PlayerOptions::ACCEL_BRAKE] * (fNewYOffset - fYOffset);
-		// TRICKY: Clamp this value the same way as BOOST so that in BOOST+BRAKE, BRAKE doesn't overpower BOOST
-		CLAMP( fBrakeYAdjust, BRAKE_MOD_MIN_CLAMP, BRAKE_MOD_MAX_CLAMP );
-		fYAdjust += fBrakeYAdjust;
-	}
-	if( fAccels[PlayerOptions::ACCEL_WAVE] != 0 )
-		fYAdjust +=	fAccels[PlayerOptions::ACCEL_WAVE] * WAVE_MOD_MAGNITUDE *std::sin( fYOffset/((fAccels[PlayerOptions::ACCEL_WAVE_PERIOD]*WAVE_MOD_HEIGHT)+WAVE_MOD_HEIGHT) );
-
-	if( fEffects[PlayerOptions::EFFECT_PARABOLA_Y] != 0 )
-		fYAdjust += fEffects[PlayerOptions::EFFECT_PARABOLA_Y] * (fYOffset/ARROW_SIZE) * (fYOffset/ARROW_SIZE);
-
-	fYOffset += fYAdjust;
-
-	// Factor in boomerang
-	if( fAccels[PlayerOptions::ACCEL_BOOMERANG] != 0 )
-	{
-		float fPeakAtYOffset = SCREEN_HEIGHT * BOOMERANG_PEAK_PERCENTAGE;	// zero point of boomerang function
-		fPeakYOffsetOut = (-1*fPeakAtYOffset*fPeakAtYOffset/SCREEN_HEIGHT) + 1.5f*fPeakAtYOffset;
-		bIsPastPeakOut = fYOffset < fPeakAtYOffset;
-
-		fYOffset = (-1*fYOffset*fYOffset/SCREEN_HEIGHT) + 1.5f*fYOffset;
-	}
-
-	if( curr_options->m_fRandomSpeed > 0 && !bAbsolute )
-	{
-		// Generate a deterministically "random" speed for each arrow.
-		unsigned seed = GAMESTATE->m_iStageSeed + ( BeatToNoteRow( fNoteBeat ) << 8 ) + (iCol * 100);
-
-		for( int i = 0; i < 3; ++i )
-			seed = ((seed * 1664525u) + 1013904223u) & 0xFFFFFFFF;
-		float fRandom = seed / 4294967296.0f;
-
-		/* Random speed always increases speed: a random speed of 10 indicates
-		 * [1,11]. This keeps it consistent with other mods: 0 means no effect. */
-		fScrollSpeed *=
-				SCALE( fRandom,
-						0.0f, 1.0f,
-						1.0f, curr_options->m_fRandomSpeed + 1.0f );
-	}
-
-	if( fAccels[PlayerOptions::ACCEL_EXPAND] != 0 )
-	{
-		float fExpandMultiplier = SCALE( std::cos(data.m_fExpandSeconds*EXPAND_MULTIPLIER_FREQUENCY*(fAccels[PlayerOptions::ACCEL_EXPAND_PERIOD]+1)),
-						EXPAND_MULTIPLIER_SCALE_FROM_LOW, EXPAND_MULTIPLIER_SCALE_FROM_HIGH,
-						EXPAND_MULTIPLIER_SCALE_TO_LOW, EXPAND_MULTIPLIER_SCALE_TO_HIGH );
-		fScrollSpeed *=	SCALE( fAccels[PlayerOptions::ACCEL_EXPAND],
-				      EXPAND_SPEED_SCALE_FROM_LOW, EXPAND_SPEED_SCALE_FROM_HIGH,
-				      EXPAND_SPEED_SCALE_TO_LOW, fExpandMultiplier );
-	}
+	m_fModTime = GetTime();
 
-	if( fAccels[PlayerOptions::ACCEL_TAN_EXPAND] != 0 )
-	{
-		float fTanExpandMultiplier = SCALE( SelectTanType(data.m_fTanExpandSeconds*EXPAND_MULTIPLIER_FREQUENCY*(fAccels[PlayerOptions::ACCEL_TAN_EXPAND_PERIOD]+1), curr_options->m_bCosecant),
-						EXPAND_MULTIPLIER_SCALE_FROM_LOW, EXPAND_MULTIPLIER_SCALE_FROM_HIGH,
-						EXPAND_MULTIPLIER_SCALE_TO_LOW, EXPAND_MULTIPLIER_SCALE_TO_HIGH );
-		fScrollSpeed *=	SCALE( fAccels[PlayerOptions::ACCEL_TAN_EXPAND],
-				      EXPAND_SPEED_SCALE_FROM_LOW, EXPAND_SPEED_SCALE_FROM_HIGH,
-				      EXPAND_SPEED_SCALE_TO_LOW, fTanExpandMultiplier );
-	}
+	ArrowGetReverseShiftAndScale( iCol, fYReverseOffsetPixels, m_fReverseShift, m_fReverseScale );
 
-	fYOffset *= fScrollSpeed;
-	fPeakYOffsetOut *= fScrollSpeed;
+	m_fCenterLine = GetCenterLine();
+	m_fHiddenStartLine = GetHiddenStartLine();
+	m_fHiddenEndLine = GetHiddenEndLine();
+	m_fSuddenStartLine = GetSuddenStartLine();
+	m_fSuddenEndLine = GetSuddenEndLine();
 
-	return fYOffset;
+	const float* fAccels = curr_options->m_fAccels;
+	const float* fEffects = curr_options->m_fEffects;
+	const float* fAppearances = curr_options->m_fAppearances;
+	m_iActiveMods = 0;
+	if( AnyOn(fAccels, { PlayerOptions::ACCEL_BOOST, PlayerOptions::ACCEL_BRAKE, PlayerOptions::ACCEL_WAVE,
+		PlayerOptions::ACCEL_BOOMERANG, PlayerOptions::ACCEL_EXPAND, PlayerOptions::ACCEL_TAN_EXPAND }) ||
+		fEffects[PlayerOptions::EFFECT_PARABOLA_Y] != 0 || curr_options->m_fRandomSpeed > 0 )
+		m_iActiveMods |= MOD_YOFFSET;
+	if( AnyOn(fEffects, { PlayerOptions::EFFECT_TORNADO, PlayerOptions::EFFECT_TAN_TORNADO,
+		PlayerOptions::EFFECT_BUMPY_X, PlayerOptions::EFFECT_TAN_BUMPY_X,
+		PlayerOptions::EFFECT_DRUNK, PlayerOptions::EFFECT_TAN_DRUNK,
+		PlayerOptions::EFFECT_FLIP, PlayerOptions::EFFECT_INVERT, PlayerOptions::EFFECT_BEAT,
+		PlayerOptions::EFFECT_ZIGZAG, PlayerOptions::EFFECT_SAWTOOTH,
+		PlayerOptions::EFFECT_PARABOLA_X, PlayerOptions::EFFECT_ATTENUATE_X,
+		PlayerOptions::EFFECT_DIGITAL, PlayerOptions::EFFECT_TAN_DIGITAL,
+		PlayerOptions::EFFECT_SQUARE, PlayerOptions::EFFECT_BOUNCE, PlayerOptions::EFFECT_XMODE }) )
+		m_iActiveMods |= MOD_XPOS;
+	if( AnyOn(fEffects, { PlayerOptions::EFFECT_ATTENUATE_Y, PlayerOptions::EFFECT_BEAT_Y }) )
+		m_iActiveMods |= MOD_YPOS;
+	if( AnyOn(fEffects, { PlayerOptions::EFFECT_TORNADO_Z, PlayerOptions::EFFECT_TAN_TORNADO_Z,
+		PlayerOptions::EFFECT_BUMPY, PlayerOptions::EFFECT_TAN_BUMPY,
+		PlayerOptions::EFFECT_ZIGZAG_Z, PlayerOptions::EFFECT_SAWTOOTH_Z,
+		PlayerOptions::EFFECT_PARABOLA_Z, PlayerOptions::EFFECT_ATTENUATE_Z,
+		PlayerOptions::EFFECT_DRUNK_Z, PlayerOptions::EFFECT_TAN_DRUNK_Z, PlayerOptions::EFFECT_BEAT_Z,
+		PlayerOptions::EFFECT_DIGITAL_Z, PlayerOptions::EFFECT_TAN_DIGITAL_Z,
+		PlayerOptions::EFFECT_SQUARE_Z, PlayerOptions::EFFECT_BOUNCE_Z }) ||
+		curr_options->m_fBumpy[iCol] != 0 )
+		m_iActiveMods |= MOD_ZPOS;
+	if( AnyOn(fEffects, { PlayerOptions::EFFECT_CONFUSION_X, PlayerOptions::EFFECT_CONFUSION_X_OFFSET, PlayerOptions::EFFECT_ROLL }) ||
+		curr_options->m_fConfusionX[iCol] != 0 )
+		m_iActiveMods |= MOD_ROTATION_X;
+	if( AnyOn(fEffects, { PlayerOptions::EFFECT_CONFUSION_Y, PlayerOptions::EFFECT_CONFUSION_Y_OFFSET, PlayerOptions::EFFECT_TWIRL }) ||
+		curr_options->m_fConfusionY[iCol] != 0 )
+		m_iActiveMods |= MOD_ROTATION_Y;
+	if( AnyOn(fEffects, { PlayerOptions::EFFECT_CONFUSION, PlayerOptions::EFFECT_CONFUSION_OFFSET, PlayerOptions::EFFECT_DIZZY }) ||
+		curr_options->m_fConfusionZ[iCol] != 0 )
+		m_iActiveMods |= MOD_ROTATION_Z;
+	if( AnyOn(fEffects, { PlayerOptions::EFFECT_PULSE_INNER, PlayerOptions::EFFECT_PULSE_OUTER,
+		PlayerOptions::EFFECT_SHRINK_TO_MULT, PlayerOptions::EFFECT_SHRINK_TO_LINEAR, PlayerOptions::EFFECT_TINY }) ||
+		curr_options->m_fTiny[iCol] != 0 )
+		m_iActiveMods |= MOD_ZOOM;
+	if( AnyOn(fAppearances, { PlayerOptions::APPEARANCE_HIDDEN, PlayerOptions::APPEARANCE_SUDDEN,
+		PlayerOptions::APPEARANCE_STEALTH, PlayerOptions::APPEARANCE_BLINK, PlayerOptions::APPEARANCE_RANDOMVANISH }) ||
+		curr_options->m_fStealth[iCol] != 0 )
+		m_iActiveMods |= MOD_VISIBILITY;
 }
 
 static void ArrowGetReverseShiftAndScale(int iCol, float fYReverseOffsetPixels, float &fShiftOut, float &fScaleOut)
@@ -625,54 +529,10 @@ static void ArrowGetReverseShiftAndScale(int iCol, float fYReverseOffsetPixels,
 	fScaleOut = SCALE( fPercentReverse, 0.f, 1.f, 1.f, -1.f );
 }
 
-float ArrowEffects::GetYPos( const PlayerState* pPlayerState, int iCol, float fYOffset, float fYReverseOffsetPixels, bool WithReverse)
-{
-	float f = fYOffset;
-
-	if( WithReverse )
-	{
-		float fShift, fScale;
-		ArrowGetReverseShiftAndScale(iCol, fYReverseOffsetPixels, fShift, fScale);
-
-		f *= fScale;
-		f += fShift;
-	}
-
-	// TODO: Don't index by PlayerNumber.
-	const Style* pStyle = GAMESTATE->GetCurrentStyle(pPlayerState->m_PlayerNumber);
-	const Style::ColumnInfo* pCols = pStyle->m_ColumnInfo[pPlayerState->m_PlayerNumber];
-	const float* fEffects = curr_options->m_fEffects;
-
-	// Doing the math with a precalculated result of 0 should be faster than
-	// checking whether tipsy is on. -Kyz
-	// TODO: Don't index by PlayerNumber.
-	PerPlayerData& data= g_EffectData[curr_options->m_pn];
-	f+= fEffects[PlayerOptions::EFFECT_TIPSY] * data.m_tipsy_result[iCol];
-	f+= fEffects[PlayerOptions::EFFECT_TAN_TIPSY] * data.m_tan_tipsy_result[iCol];
-
-	if( fEffects[PlayerOptions::EFFECT_ATTENUATE_Y] != 0 )
-	{
-		const float fXOffset = pCols[iCol].fXOffset;
-		f += fEffects[PlayerOptions::EFFECT_ATTENUATE_Y] * (fYOffset/ARROW_SIZE) * (fYOffset/ARROW_SIZE) * (fXOffset/ARROW_SIZE);
-	}
-
-
-	if( fEffects[PlayerOptions::EFFECT_BEAT_Y] != 0 )
-	{
-		const float fShift = data.m_fBeatFactor[dim_y]*std::sin( fYOffset / ((fEffects[PlayerOptions::EFFECT_BEAT_Y_PERIOD]*BEAT_Y_OFFSET_HEIGHT)+BEAT_Y_OFFSET_HEIGHT) + PI/BEAT_Y_PI_HEIGHT );
-		f += fEffects[PlayerOptions::EFFECT_BEAT_Y] * fShift;
-	}
-
-	// In beware's DDR Extreme-focused fork of StepMania 3.9, this value is
-	// floored, making arrows show on integer Y coordinates. Supposedly it makes
-	// the arrows look better, but testing needs to be done.
-	// todo: make this a noteskin metric instead of a theme metric? -aj
-	return QUANTIZE_ARROW_Y ? std::floor(f) : f;
-}
-
-float ArrowEffects::GetYOffsetFromYPos(int iCol, float YPos, float fYReverseOffsetPixels)
+float ArrowEffects::GetYOffsetFromYPos(const FrameContext &context, float YPos)
 {
 	float f = YPos;
+	const int iCol = context.m_iCol;
 
 	const float* fEffects = curr_options->m_fEffects;
 	// Doing the math with a precalculated result of 0 should be faster than
@@ -684,241 +544,13 @@ float ArrowEffects::GetYOffsetFromYPos(int iCol, float YPos, float fYReverseOffs
 
 	f+= fEffects[PlayerOptions::EFFECT_PARABOLA_Y] * (YPos/ARROW_SIZE) * (YPos/ARROW_SIZE);
 
-	float fShift, fScale;
-	ArrowGetReverseShiftAndScale(iCol, fYReverseOffsetPixels, fShift, fScale);
-
-	f -= fShift;
-	if( fScale )
-		f /= fScale;
+	f -= context.m_fReverseShift;
+	if( context.m_fReverseScale )
+		f /= context.m_fReverseScale;
 
 	return f;
 }
 
-float ArrowEffects::GetXPos( const PlayerState* pPlayerState, int iColNum, float fYOffset )
-{
-	float fPixelOffsetFromCenter = 0; // fill this in below
-
-	const Style* pStyle = GAMESTATE->GetCurrentStyle(pPlayerState->m_PlayerNumber);
-	const float* fEffects = curr_options->m_fEffects;
-
-	// TODO: Don't index by PlayerNumber.
-	const Style::ColumnInfo* pCols = pStyle->m_ColumnInfo[pPlayerState->m_PlayerNumber];
-	PerPlayerData &data = g_EffectData[pPlayerState->m_PlayerNumber];
-
-	if( fEffects[PlayerOptions::EFFECT_TORNADO] != 0 )
-	{
-		fPixelOffsetFromCenter += CalculateTornadoOffsetFromMagnitude(dim_x,
-			iColNum, fEffects[PlayerOptions::EFFECT_TORNADO],
-			fEffects[PlayerOptions::EFFECT_TORNADO_OFFSET],
-			fEffects[PlayerOptions::EFFECT_TORNADO_PERIOD],
-			pCols, pPlayerState->m_NotefieldZoom, data, fYOffset, false);
-	}
-
-	if( fEffects[PlayerOptions::EFFECT_TAN_TORNADO] != 0 )
-	{
-		fPixelOffsetFromCenter += CalculateTornadoOffsetFromMagnitude(dim_x,
-			iColNum, fEffects[PlayerOptions::EFFECT_TAN_TORNADO],
-			fEffects[PlayerOptions::EFFECT_TAN_TORNADO_OFFSET],
-			fEffects[PlayerOptions::EFFECT_TAN_TORNADO_PERIOD],
-			pCols, pPlayerState->m_NotefieldZoom, data, fYOffset, true);
-	}
-
-	if( fEffects[PlayerOptions::EFFECT_BUMPY_X] != 0 )
-		fPixelOffsetFromCenter += fEffects[PlayerOptions::EFFECT_BUMPY_X] *
-			40*std::sin( CalculateBumpyAngle(fYOffset,
-			fEffects[PlayerOptions::EFFECT_BUMPY_X_OFFSET],
-			fEffects[PlayerOptions::EFFECT_BUMPY_X_PERIOD]) );
-
-	if( fEffects[PlayerOptions::EFFECT_TAN_BUMPY_X] != 0 )
-		fPixelOffsetFromCenter += fEffects[PlayerOptions::EFFECT_TAN_BUMPY_X] *
-			40*SelectTanType( CalculateBumpyAngle(fYOffset,
-			fEffects[PlayerOptions::EFFECT_TAN_BUMPY_X_OFFSET],
-			fEffects[PlayerOptions::EFFECT_TAN_BUMPY_X_PERIOD]), curr_options->m_bCosecant );
-
-	if( fEffects[PlayerOptions::EFFECT_DRUNK] != 0 )
-		fPixelOffsetFromCenter += fEffects[PlayerOptions::EFFECT_DRUNK] *
-			( std::cos( CalculateDrunkAngle(fEffects[PlayerOptions::EFFECT_DRUNK_SPEED], iColNum,
-					fEffects[PlayerOptions::EFFECT_DRUNK_OFFSET], DRUNK_COLUMN_FREQUENCY,
-					fYOffset, fEffects[PlayerOptions::EFFECT_DRUNK_PERIOD],
-					DRUNK_OFFSET_FREQUENCY) ) * ARROW_SIZE*DRUNK_ARROW_MAGNITUDE );
-
-	if( fEffects[PlayerOptions::EFFECT_TAN_DRUNK] != 0 )
-		fPixelOffsetFromCenter += fEffects[PlayerOptions::EFFECT_TAN_DRUNK] *
-			( SelectTanType( CalculateDrunkAngle(fEffects[PlayerOptions::EFFECT_TAN_DRUNK_SPEED],
-					iColNum, fEffects[PlayerOptions::EFFECT_TAN_DRUNK_OFFSET],
-					DRUNK_COLUMN_FREQUENCY, fYOffset,
-					fEffects[PlayerOptions::EFFECT_TAN_DRUNK_PERIOD], DRUNK_OFFSET_FREQUENCY)
-					, curr_options->m_bCosecant) * ARROW_SIZE*DRUNK_ARROW_MAGNITUDE );
-
-	if( fEffects[PlayerOptions::EFFECT_FLIP] != 0 )
-	{
-		const int iFirstCol = 0;
-		const int iLastCol = pStyle->m_iColsPerPlayer-1;
-		const int iNewCol = SCALE( iColNum, iFirstCol, iLastCol, iLastCol, iFirstCol );
-		const float fOldPixelOffset = pCols[iColNum].fXOffset * pPlayerState->m_NotefieldZoom;
-		const float fNewPixelOffset = pCols[iNewCol].fXOffset * pPlayerState->m_NotefieldZoom;
-		const float fDistance = fNewPixelOffset - fOldPixelOffset;
-		fPixelOffsetFromCenter += fDistance * fEffects[PlayerOptions::EFFECT_FLIP];
-	}
-	if( fEffects[PlayerOptions::EFFECT_INVERT] != 0 )
-		fPixelOffsetFromCenter += data.m_fInvertDistance[iColNum] * fEffects[PlayerOptions::EFFECT_INVERT];
-
-	if( fEffects[PlayerOptions::EFFECT_BEAT] != 0 )
-	{
-		const float fShift = data.m_fBeatFactor[dim_x]*std::sin( fYOffset / ((fEffects[PlayerOptions::EFFECT_BEAT_PERIOD]*BEAT_OFFSET_HEIGHT)+BEAT_OFFSET_HEIGHT) + PI/BEAT_PI_HEIGHT );
-		fPixelOffsetFromCenter += fEffects[PlayerOptions::EFFECT_BEAT] * fShift;
-	}
-
-	if( fEffects[PlayerOptions::EFFECT_ZIGZAG] != 0 )
-	{
-		float fResult = RageTriangle( (PI * (1/(fEffects[PlayerOptions::EFFECT_ZIGZAG_PERIOD]+1)) *
-		((fYOffset+(100.0f*(fEffects[PlayerOptions::EFFECT_ZIGZAG_OFFSET])))/ARROW_SIZE) ) );
-
-		fPixelOffsetFromCenter += (fEffects[PlayerOptions::EFFECT_ZIGZAG]*ARROW_SIZE/2) * fResult;
-	}
-
-	if( fEffects[PlayerOptions::EFFECT_SAWTOOTH] != 0 )
-		fPixelOffsetFromCenter += (fEffects[PlayerOptions::EFFECT_SAWTOOTH]*ARROW_SIZE) *
-			((0.5f / (fEffects[PlayerOptions::EFFECT_SAWTOOTH_PERIOD]+1) * fYOffset) / ARROW_SIZE -
-			std::floor((0.5f / (fEffects[PlayerOptions::EFFECT_SAWTOOTH_PERIOD]+1) * fYOffset) / ARROW_SIZE) );
-
-	if( fEffects[PlayerOptions::EFFECT_PARABOLA_X] != 0 )
-		fPixelOffsetFromCenter += fEffects[PlayerOptions::EFFECT_PARABOLA_X] * (fYOffset/ARROW_SIZE) * (fYOffset/ARROW_SIZE);
-
-	if( fEffects[PlayerOptions::EFFECT_ATTENUATE_X] != 0 )
-	{
-		const float fXOffset = pCols[iColNum].fXOffset;
-		fPixelOffsetFromCenter += fEffects[PlayerOptions::EFFECT_ATTENUATE_X] * (fYOffset/ARROW_SIZE) * (fYOffset/ARROW_SIZE) * (fXOffset/ARROW_SIZE);
-	}
-
-	if( fEffects[PlayerOptions::EFFECT_DIGITAL] != 0 )
-		fPixelOffsetFromCenter += (fEffects[PlayerOptions::EFFECT_DIGITAL] * ARROW_SIZE * 0.5f) *
-			std::round((fEffects[PlayerOptions::EFFECT_DIGITAL_STEPS]+1) * std::sin(
-				CalculateDigitalAngle(fYOffset,
-				fEffects[PlayerOptions::EFFECT_DIGITAL_OFFSET],
-				fEffects[PlayerOptions::EFFECT_DIGITAL_PERIOD]) ) )/(fEffects[PlayerOptions::EFFECT_DIGITAL_STEPS]+1);
-
-	if( fEffects[PlayerOptions::EFFECT_TAN_DIGITAL] != 0 )
-		fPixelOffsetFromCenter += (fEffects[PlayerOptions::EFFECT_TAN_DIGITAL] * ARROW_SIZE * 0.5f) *
-			std::round((fEffects[PlayerOptions::EFFECT_TAN_DIGITAL_STEPS]+1) * SelectTanType(
-				CalculateDigitalAngle(fYOffset,
-				fEffects[PlayerOptions::EFFECT_TAN_DIGITAL_OFFSET],
-				fEffects[PlayerOptions::EFFECT_TAN_DIGITAL_PERIOD]), curr_options->m_bCosecant ) )/(fEffects[PlayerOptions::EFFECT_TAN_DIGITAL_STEPS]+1);
-
-
-	if( fEffects[PlayerOptions::EFFECT_SQUARE] != 0 )
-	{
-		float fResult = RageSquare( (PI * (fYOffset+(1.0f*(fEffects[PlayerOptions::EFFECT_SQUARE_OFFSET]))) /
-			(ARROW_SIZE+(fEffects[PlayerOptions::EFFECT_SQUARE_PERIOD]*ARROW_SIZE))) );
-
-		fPixelOffsetFromCenter += (fEffects[PlayerOptions::EFFECT_SQUARE] * ARROW_SIZE * 0.5f) * fResult;
-	}
-
-	if( fEffects[PlayerOptions::EFFECT_BOUNCE] != 0 )
-	{
-		float fBounceAmt = std::abs( std::sin( ( (fYOffset + (1.0f * (fEffects[PlayerOptions::EFFECT_BOUNCE_OFFSET]) ) ) /
-			( 60 + (fEffects[PlayerOptions::EFFECT_BOUNCE_PERIOD]*60) ) ) ) );
-
-		fPixelOffsetFromCenter += fEffects[PlayerOptions::EFFECT_BOUNCE] * ARROW_SIZE * 0.5f * fBounceAmt;
-	}
-
-	if( fEffects[PlayerOptions::EFFECT_XMODE] != 0 )
-	{
-		// based off of code by v1toko for StepNXA, except it should work on
-		// any gametype now.
-		switch( pStyle->m_StyleType )
-		{
-			case StyleType_OnePlayerTwoSides:
-			case StyleType_TwoPlayersSharedSides:
-				{
-					// find the middle, and split based on iColNum
-					// it's unknown if this will work for routine.
-					const int iMiddleColumn = std::floor(pStyle->m_iColsPerPlayer/2.0f);
-					if( iColNum > iMiddleColumn-1 )
-						fPixelOffsetFromCenter += fEffects[PlayerOptions::EFFECT_XMODE]*-(fYOffset);
-					else
-						fPixelOffsetFromCenter += fEffects[PlayerOptions::EFFECT_XMODE]*fYOffset;
-				}
-				break;
-			case StyleType_OnePlayerOneSide:
-			case StyleType_TwoPlayersTwoSides:
-				{
-					// the code was the same for both of these cases in StepNXA.
-					if( pPlayerState->m_PlayerNumber == PLAYER_2 )
-						fPixelOffsetFromCenter += fEffects[PlayerOptions::EFFECT_XMODE]*-(fYOffset);
-					else
-						fPixelOffsetFromCenter += fEffects[PlayerOptions::EFFECT_XMODE]*fYOffset;
-				}
-				break;
-			DEFAULT_FAIL(pStyle->m_StyleType);
-		}
-	}
-
-	fPixelOffsetFromCenter += pCols[iColNum].fXOffset * pPlayerState->m_NotefieldZoom;
-
-	if( fEffects[PlayerOptions::EFFECT_TINY] != 0 )
-	{
-		// Allow Tiny to pull tracks together, but not to push them apart.
-		float fTinyPercent = fEffects[PlayerOptions::EFFECT_TINY];
-		fTinyPercent = std::min( std::pow(TINY_PERCENT_BASE, fTinyPercent), (float)TINY_PERCENT_GATE );
-		fPixelOffsetFromCenter *= fTinyPercent;
-	}
-
-	return fPixelOffsetFromCenter;
-}
-
-float ArrowEffects::GetRotationX(const PlayerState* pPlayerState, float fYOffset, bool bIsHoldCap, int iCol)
-{
-	const float* fEffects = curr_options->m_fEffects;
-	float fRotation = 0;
-	if( fEffects[PlayerOptions::EFFECT_CONFUSION_X] != 0 || fEffects[PlayerOptions::EFFECT_CONFUSION_X_OFFSET] != 0 ||
-	curr_options->m_fConfusionX[iCol] != 0
-	)
-		fRotation += ReceptorGetRotationX( pPlayerState, iCol );
-	if( fEffects[PlayerOptions::EFFECT_ROLL] != 0 && !bIsHoldCap )
-	{
-		fRotation += fEffects[PlayerOptions::EFFECT_ROLL] * fYOffset/2;
-	}
-	return fRotation;
-}
-
-float ArrowEffects::GetRotationY(const PlayerState* pPlayerState, float fYOffset, int iCol)
-{
-	const float* fEffects = curr_options->m_fEffects;
-	float fRotation = 0;
-	if( fEffects[PlayerOptions::EFFECT_CONFUSION_Y] != 0 || fEffects[PlayerOptions::EFFECT_CONFUSION_Y_OFFSET] != 0 ||
-	curr_options->m_fConfusionY[iCol] != 0
-	)
-		fRotation += ReceptorGetRotationY( pPlayerState, iCol );
-	if( fEffects[PlayerOptions::EFFECT_TWIRL] != 0 )
-	{
-		fRotation += fEffects[PlayerOptions::EFFECT_TWIRL] * fYOffset/2;
-	}
-	return fRotation;
-}
-
-float ArrowEffects::GetRotationZ( const PlayerState* pPlayerState, float fNoteBeat, bool bIsHoldHead, int iCol )
-{
-	const float* fEffects = curr_options->m_fEffects;
-	float fRotation = 0;
-	if( fEffects[PlayerOptions::EFFECT_CONFUSION] != 0 || fEffects[PlayerOptions::EFFECT_CONFUSION_OFFSET] != 0 ||
-	curr_options->m_fConfusionZ[iCol] != 0
-	)
-		fRotation += ReceptorGetRotationZ( pPlayerState, iCol );
-
-	// As usual, enable dizzy hold heads at your own risk. -Wolfman2000
-	if( fEffects[PlayerOptions::EFFECT_DIZZY] != 0 && ( curr_options->m_bDizzyHolds || !bIsHoldHead ) )
-	{
-		const float fSongBeat = pPlayerState->m_Position.m_fSongBeatVisible;
-		float fDizzyRotation = fNoteBeat - fSongBeat;
-		fDizzyRotation *= fEffects[PlayerOptions::EFFECT_DIZZY];
-		fDizzyRotation = std::fmod( fDizzyRotation, 2*PI );
-		fDizzyRotation *= 180/PI;
-		fRotation += fDizzyRotation;
-	}
-	return fRotation;
-}
-
 float ArrowEffects::ReceptorGetRotationZ( const PlayerState* pPlayerState, int iCol )
 {
 	const float* fEffects = curr_options->m_fEffects;
@@ -1074,353 +706,1076 @@ static float GetSuddenStartLine()
 		GetCenterLine() * curr_options->m_fAppearances[PlayerOptions::APPEARANCE_SUDDEN_OFFSET];
 }
 
-// used by ArrowGetAlpha and ArrowGetGlow below
-float ArrowGetPercentVisible(float fYPosWithoutReverse, int iCol, float fYOffset)
+float ArrowEffects::GetBrightness( const PlayerState* pPlayerState, float fNoteBeat )
 {
-	const float fDistFromCenterLine = fYPosWithoutReverse - GetCenterLine();
-
-	float fYPos;
-	if( curr_options->m_bStealthType )
-		fYPos = fYOffset;
-	else
-		fYPos = fYPosWithoutReverse;
-
+	if( GAMESTATE->IsEditing() )
+		return 1;
 
-	if( fYPos < 0 && curr_options->m_bStealthPastReceptors == false)	// past Gray Arrows
-		return 1;	// totally visible
+	float fSongBeat = pPlayerState->m_Position.m_fSongBeatVisible;
+	float fBeatsUntilStep = fNoteBeat - fSongBeat;
 
-	const float* fAppearances = curr_options->m_fAppearances;
+	float fBrightness = SCALE( fBeatsUntilStep, 0, -1, 1.f, 0.f );
+	CLAMP( fBrightness, 0, 1 );
+	return fBrightness;
+}
 
-	float fVisibleAdjust = 0;
 
-	if( fAppearances[PlayerOptions::APPEARANCE_HIDDEN] != 0 )
+bool ArrowEffects::NeedZBuffer()
+{
+	const float* fEffects = curr_options->m_fEffects;
+	// We also need to use the Z buffer if twirl is in play, because of
+	// hold modulation. -vyhd (OpenITG r623)
+	if( fEffects[PlayerOptions::EFFECT_BUMPY] != 0 ||
+		fEffects[PlayerOptions::EFFECT_TWIRL] != 0 )
 	{
-		float fHiddenVisibleAdjust = SCALE( fYPos, GetHiddenStartLine(), GetHiddenEndLine(), 0, -1 );
-		CLAMP( fHiddenVisibleAdjust, -1, 0 );
-		fVisibleAdjust += fAppearances[PlayerOptions::APPEARANCE_HIDDEN] * fHiddenVisibleAdjust;
+		return true;
 	}
-	if( fAppearances[PlayerOptions::APPEARANCE_SUDDEN] != 0 )
+	if( fEffects[PlayerOptions::EFFECT_BEAT_Z] != 0 ||
+		fEffects[PlayerOptions::EFFECT_DIGITAL_Z] != 0 )
 	{
-		float fSuddenVisibleAdjust = SCALE( fYPos, GetSuddenStartLine(), GetSuddenEndLine(), -1, 0 );
-		CLAMP( fSuddenVisibleAdjust, -1, 0 );
-		fVisibleAdjust += fAppearances[PlayerOptions::APPEARANCE_SUDDEN] * fSuddenVisibleAdjust;
+		return true;
 	}
-
-	if( fAppearances[PlayerOptions::APPEARANCE_STEALTH] != 0 )
-		fVisibleAdjust -= fAppearances[PlayerOptions::APPEARANCE_STEALTH];
-	if( curr_options->m_fStealth[iCol] != 0 ){
-		fVisibleAdjust -= curr_options->m_fStealth[iCol];
+	if( fEffects[PlayerOptions::EFFECT_ZIGZAG_Z] != 0 ||
+		fEffects[PlayerOptions::EFFECT_SAWTOOTH_Z] != 0 )
+	{
+		return true;
 	}
-	if( fAppearances[PlayerOptions::APPEARANCE_BLINK] != 0 )
+	if( fEffects[PlayerOptions::EFFECT_PARABOLA_Z] != 0 ||
+		fEffects[PlayerOptions::EFFECT_SQUARE_Z] != 0 )
 	{
-		float f = std::sin(ArrowEffects::GetTime()*10);
-		f = Quantize( f, BLINK_MOD_FREQUENCY );
-		fVisibleAdjust += SCALE( f, 0, 1, -1, 0 );
+		return true;
 	}
-	if( fAppearances[PlayerOptions::APPEARANCE_RANDOMVANISH] != 0 )
+	if( curr_options->m_bZBuffer ||
+		fEffects[PlayerOptions::EFFECT_ATTENUATE_Z] != 0 )
 	{
-		const float fRealFadeDist = 80;
-		fVisibleAdjust += SCALE( std::abs(fDistFromCenterLine), fRealFadeDist, 2*fRealFadeDist, -1, 0 )
-			* fAppearances[PlayerOptions::APPEARANCE_RANDOMVANISH];
+		return true;
 	}
-
-	return std::clamp(1 + fVisibleAdjust, 0.0f, 1.0f);
-}
-
-float ArrowEffects::GetAlpha( const PlayerState* pPlayerState, int iCol, float fYOffset, float fPercentFadeToFail, float fYReverseOffsetPixels, float fDrawDistanceBeforeTargetsPixels, float fFadeInPercentOfDrawFar)
-{
-	// Get the YPos without reverse (that is, factor in EFFECT_TIPSY).
-	float fYPosWithoutReverse = ArrowEffects::GetYPos(pPlayerState, iCol, fYOffset, fYReverseOffsetPixels, false );
-
-	float fPercentVisible = ArrowGetPercentVisible(fYPosWithoutReverse, iCol, fYOffset);
-
-	if( fPercentFadeToFail != -1 )
-		fPercentVisible = 1 - fPercentFadeToFail;
-
-
-	float fFullAlphaY = fDrawDistanceBeforeTargetsPixels*(1-fFadeInPercentOfDrawFar);
-	if( fYPosWithoutReverse > fFullAlphaY )
+	if( fEffects[PlayerOptions::EFFECT_BOUNCE_Z] != 0 )
 	{
-		float f = SCALE( fYPosWithoutReverse, fFullAlphaY, fDrawDistanceBeforeTargetsPixels, 1.0f, 0.0f );
-		return f;
+		return true;
 	}
-	return (fPercentVisible>0.5f) ? 1.0f : 0.0f;
+	return false;
 }
 
-float ArrowEffects::GetGlow( const PlayerState* pPlayerState, int iCol, float fYOffset, float fPercentFadeToFail, float fYReverseOffsetPixels, float fDrawDistanceBeforeTargetsPixels, float fFadeInPercentOfDrawFar)
+float ArrowEffects::GetPulseInner()
 {
-	// Get the YPos without reverse (that is, factor in EFFECT_TIPSY).
-	float fYPosWithoutReverse = ArrowEffects::GetYPos(pPlayerState, iCol, fYOffset, fYReverseOffsetPixels, false );
-
-	float fPercentVisible = ArrowGetPercentVisible(fYPosWithoutReverse, iCol, fYOffset);
-
-	if( fPercentFadeToFail != -1 )
-		fPercentVisible = 1 - fPercentFadeToFail;
-
-	const float fDistFromHalf = std::abs( fPercentVisible - 0.5f );
-	return SCALE( fDistFromHalf, 0, 0.5f, 1.3f, 0 );
-}
-
-float ArrowEffects::GetBrightness( const PlayerState* pPlayerState, float fNoteBeat )
+	float fPulseInner = 1.0f;
+	if( curr_options->m_fEffects[PlayerOptions::EFFECT_PULSE_INNER] != 0 || curr_options->m_fEffects[PlayerOptions::EFFECT_PULSE_OUTER] != 0 )
+	{
+		fPulseInner = ((curr_options->m_fEffects[PlayerOptions::EFFECT_PULSE_INNER]*0.5f)+1);
+		if (fPulseInner == 0)
+		{
+			fPulseInner = 0.01f;
+		}
+	}
+	return fPulseInner;
+}
+
+static ThemeMetric<float>	FRAME_WIDTH_EFFECTS_PIXELS_PER_SECOND( "ArrowEffects", "FrameWidthEffectsPixelsPerSecond" );
+static ThemeMetric<float>	FRAME_WIDTH_EFFECTS_MIN_MULTIPLIER( "ArrowEffects", "FrameWidthEffectsMinMultiplier" );
+static ThemeMetric<float>	FRAME_WIDTH_EFFECTS_MAX_MULTIPLIER( "ArrowEffects", "FrameWidthEffectsMaxMultiplier" );
+static ThemeMetric<bool>	FRAME_WIDTH_LOCK_EFFECTS_TO_OVERLAPPING( "ArrowEffects", "FrameWidthLockEffectsToOverlapping" );
+static ThemeMetric<float>	FRAME_WIDTH_LOCK_EFFECTS_TWEEN_PIXELS( "ArrowEffects", "FrameWidthLockEffectsTweenPixels" );
+
+float ArrowEffects::GetFrameWidthScale( const PlayerState* pPlayerState, float fYOffset, float fOverlappedTime )
 {
-	if( GAMESTATE->IsEditing() )
-		return 1;
+	float fFrameWidthMultiplier = 1.0f;
 
-	float fSongBeat = pPlayerState->m_Position.m_fSongBeatVisible;
-	float fBeatsUntilStep = fNoteBeat - fSongBeat;
+	float fPixelsPerSecond = FRAME_WIDTH_EFFECTS_PIXELS_PER_SECOND;
+	float fSecond = fYOffset / fPixelsPerSecond;
+	float fWidthEffect = pPlayerState->m_EffectHistory.GetSample( fSecond );
+	if( fWidthEffect != 0 && FRAME_WIDTH_LOCK_EFFECTS_TO_OVERLAPPING )
+	{
+		// Don't display effect data that happened before this hold overlapped the top.
+		float fFromEndOfOverlapped = fOverlappedTime - fSecond;
+		float fTrailingPixels = FRAME_WIDTH_LOCK_EFFECTS_TWEEN_PIXELS;
+		float fTrailingSeconds = fTrailingPixels / fPixelsPerSecond;
+		float fScaleEffect = SCALE( fFromEndOfOverlapped, 0.0f, fTrailingSeconds, 0.0f, 1.0f );
+		CLAMP( fScaleEffect, 0.0f, 1.0f );
+		fWidthEffect *= fScaleEffect;
+	}
 
-	float fBrightness = SCALE( fBeatsUntilStep, 0, -1, 1.f, 0.f );
-	CLAMP( fBrightness, 0, 1 );
-	return fBrightness;
+	if( fWidthEffect > 0 )
+		fFrameWidthMultiplier *= SCALE( fWidthEffect, 0.0f, 1.0f, 1.0f, FRAME_WIDTH_EFFECTS_MAX_MULTIPLIER );
+	else if( fWidthEffect < 0 )
+		fFrameWidthMultiplier *= SCALE( fWidthEffect, 0.0f, -1.0f, 1.0f, FRAME_WIDTH_EFFECTS_MIN_MULTIPLIER );
+
+	return fFrameWidthMultiplier;
 }
 
+/* Every mod term is worked out here for a run of notes in one column: a mod
+ * is checked once for the whole run, the parts of a term that don't depend
+ * on the note are worked out once, and the rest is a plain loop over the
+ * notes.  The per-note functions at the end run the same code on one note,
+ * so a note comes out the same whichever way it's asked for. */
 
-float ArrowEffects::GetZPos( const PlayerState* pPlayerState, int iCol, float fYOffset)
+void ArrowEffects::NoteBatch::Resize( unsigned iSize )
 {
-	float fZPos=0;
+	m_fBeat.resize( iSize );
+	m_fPercentFadeToFail.resize( iSize );
+	m_bIsHoldHead.resize( iSize );
+	m_bIsHoldCap.resize( iSize );
+	m_fYOffset.resize( iSize );
+	m_fX.resize( iSize );
+	m_fY.resize( iSize );
+	m_fZ.resize( iSize );
+	m_fRotationX.resize( iSize );
+	m_fRotationY.resize( iSize );
+	m_fRotationZ.resize( iSize );
+	m_fZoom.resize( iSize );
+	m_fAlpha.resize( iSize );
+	m_fGlow.resize( iSize );
+	m_fYPosWithoutReverse.resize( iSize );
+	m_fTemp.resize( iSize );
+}
+
+/* GetYOffset for each of fBeat.  fYAdjust is scratch space.  fPeakYOffsetOut
+ * and bIsPastPeakOut may be null; if not, they're filled in for each note
+ * the way GetYOffset does. */
+static void CalculateYOffsets( const ArrowEffects::FrameContext &context, const float *fBeat, float *fYOffset, float *fYAdjust,
+	unsigned iCount, bool bAbsolute, float *fPeakYOffsetOut, bool *bIsPastPeakOut )
+{
+	// Default values that are kept if boomerang is off.
+	if( fPeakYOffsetOut != nullptr )
+	{
+		for( unsigned i = 0; i < iCount; ++i )
+		{
+			fPeakYOffsetOut[i] = FLT_MAX;
+			bIsPastPeakOut[i] = true;
+		}
+	}
+
+	const PlayerState* pPlayerState = context.m_pPlayerState;
+	const int iCol = context.m_iCol;
+	const float fSongBeat = context.m_fSongBeat;
+
+	for( unsigned i = 0; i < iCount; ++i )
+		fYOffset[i] = 0;
+
+	if( curr_options->m_fTimeSpacing != 1.0f )
+	{
+		if( GAMESTATE->m_bInStepEditor )
+		{
+			for( unsigned i = 0; i < iCount; ++i )
+				fYOffset[i] = fBeat[i] - fSongBeat;
+		}
+		else
+		{
+			const float fSongDisplayedBeat = context.m_fSongDisplayedBeat;
+			const float fSpeedPercent = context.m_fSpeedPercent;
+			for( unsigned i = 0; i < iCount; ++i )
+			{
+				fYOffset[i] = GetDisplayedBeat( pPlayerState, fBeat[i] ) - fSongDisplayedBeat;
+				fYOffset[i] *= fSpeedPercent;
+			}
+		}
+		const float fBeatSpacing = 1 - curr_options->m_fTimeSpacing;
+		for( unsigned i = 0; i < iCount; ++i )
+			fYOffset[i] *= fBeatSpacing;
+	}
+
+	if( curr_options->m_fTimeSpacing != 0.0f )
+	{
+		const TimingData *pTiming = context.m_pTiming;
+		const float fSongSeconds = context.m_fSongSeconds;
+		const float fBPS = context.m_fBPS;
+		const float fTimeSpacing = curr_options->m_fTimeSpacing;
+		for( unsigned i = 0; i < iCount; ++i )
+		{
+			const float fSecondsUntilStep = pTiming->GetElapsedTimeFromBeat( fBeat[i] ) - fSongSeconds;
+			fYOffset[i] += fSecondsUntilStep * fBPS * fTimeSpacing;
+		}
+	}
+
+	const float fArrowSpacing = ARROW_SPACING;
+	for( unsigned i = 0; i < iCount; ++i )
+		fYOffset[i] *= fArrowSpacing;
+
+	const float fScrollSpeed = context.m_fScrollSpeed;
+	if( !context.IsOn(ArrowEffects::FrameContext::MOD_YOFFSET) )
+	{
+		for( unsigned i = 0; i < iCount; ++i )
+		{
+			if( fPeakYOffsetOut != nullptr && fYOffset[i] >= 0 )
+				fPeakYOffsetOut[i] *= fScrollSpeed;
+			fYOffset[i] *= fScrollSpeed;
+		}
+		return;
+	}
+
+	const float* fAccels = curr_options->m_fAccels;
 	const float* fEffects = curr_options->m_fEffects;
-	const Style* pStyle = GAMESTATE->GetCurrentStyle(pPlayerState->m_PlayerNumber);
 
 	// TODO: Don't index by PlayerNumber.
-	const Style::ColumnInfo* pCols = pStyle->m_ColumnInfo[pPlayerState->m_PlayerNumber];
 	PerPlayerData &data = g_EffectData[pPlayerState->m_PlayerNumber];
 
-	if( fEffects[PlayerOptions::EFFECT_TORNADO_Z] != 0 )
+	// Notes that have crossed 0 don't get these, but it's cheaper to work
+	// them out for every note and drop them at the end.
+	for( unsigned i = 0; i < iCount; ++i )
+		fYAdjust[i] = 0;
+
+	if( fAccels[PlayerOptions::ACCEL_BOOST] != 0 )
 	{
-		fZPos += CalculateTornadoOffsetFromMagnitude(dim_z, iCol,
-			fEffects[PlayerOptions::EFFECT_TORNADO_Z],
-			fEffects[PlayerOptions::EFFECT_TORNADO_Z_OFFSET],
-			fEffects[PlayerOptions::EFFECT_TORNADO_Z_PERIOD],
-			pCols, pPlayerState->m_NotefieldZoom, data, fYOffset, false);
+		const float fEffectHeight = GetNoteFieldHeight();
+		const float fBoost = fAccels[PlayerOptions::ACCEL_BOOST];
+		const float fMinClamp = BOOST_MOD_MIN_CLAMP;
+		const float fMaxClamp = BOOST_MOD_MAX_CLAMP;
+		for( unsigned i = 0; i < iCount; ++i )
+		{
+			const float fNewYOffset = fYOffset[i] * 1.5f / ((fYOffset[i]+fEffectHeight/1.2f)/fEffectHeight);
+			float fAccelYAdjust = fBoost * (fNewYOffset - fYOffset[i]);
+			CLAMP( fAccelYAdjust, fMinClamp, fMaxClamp );
+			fYAdjust[i] += fAccelYAdjust;
+		}
+	}
+	if( fAccels[PlayerOptions::ACCEL_BRAKE] != 0 )
+	{
+		const float fEffectHeight = GetNoteFieldHeight();
+		const float fBrake = fAccels[PlayerOptions::ACCEL_BRAKE];
+		const float fMinClamp = BRAKE_MOD_MIN_CLAMP;
+		const float fMaxClamp = BRAKE_MOD_MAX_CLAMP;
+		for( unsigned i = 0; i < iCount; ++i )
+		{
+			const float fScale = SCALE( fYOffset[i], 0.f, fEffectHeight, 0, 1.f );
+			const float fNewYOffset = fYOffset[i] * fScale;
+			float fBrakeYAdjust = fBrake * (fNewYOffset - fYOffset[i]);
+			CLAMP( fBrakeYAdjust, fMinClamp, fMaxClamp );
+			fYAdjust[i] += fBrakeYAdjust;
+		}
+	}
+	if( fAccels[PlayerOptions::ACCEL_WAVE] != 0 )
+	{
+		const float fWave = fAccels[PlayerOptions::ACCEL_WAVE] * WAVE_MOD_MAGNITUDE;
+		const float fHeight = WAVE_MOD_HEIGHT;
+		const float fWaveHeight = (fAccels[PlayerOptions::ACCEL_WAVE_PERIOD]*fHeight)+fHeight;
+		for( unsigned i = 0; i < iCount; ++i )
+			fYAdjust[i] += fWave * std::sin( fYOffset[i]/fWaveHeight );
+	}
+	if( fEffects[PlayerOptions::EFFECT_PARABOLA_Y] != 0 )
+	{
+		const float fParabola = fEffects[PlayerOptions::EFFECT_PARABOLA_Y];
+		for( unsigned i = 0; i < iCount; ++i )
+			fYAdjust[i] += fParabola * (fYOffset[i]/ARROW_SIZE) * (fYOffset[i]/ARROW_SIZE);
 	}
 
-	if( fEffects[PlayerOptions::EFFECT_TAN_TORNADO_Z] != 0 )
+	const bool bBoomerang = fAccels[PlayerOptions::ACCEL_BOOMERANG] != 0;
+	const bool bRandomSpeed = curr_options->m_fRandomSpeed > 0 && !bAbsolute;
+	const bool bExpand = fAccels[PlayerOptions::ACCEL_EXPAND] != 0;
+	const bool bTanExpand = fAccels[PlayerOptions::ACCEL_TAN_EXPAND] != 0;
+	const float fScreenHeight = SCREEN_HEIGHT;
+	// zero point of boomerang function
+	const float fPeakAtYOffset = fScreenHeight * BOOMERANG_PEAK_PERCENTAGE;
+	const float fBoomerangPeakYOffset = (-1*fPeakAtYOffset*fPeakAtYOffset/fScreenHeight) + 1.5f*fPeakAtYOffset;
+
+	float fExpandSpeed = 1, fTanExpandSpeed = 1;
+	if( bExpand )
 	{
-		fZPos += CalculateTornadoOffsetFromMagnitude(dim_z, iCol,
-			fEffects[PlayerOptions::EFFECT_TAN_TORNADO_Z],
-			fEffects[PlayerOptions::EFFECT_TAN_TORNADO_Z_OFFSET],
-			fEffects[PlayerOptions::EFFECT_TAN_TORNADO_Z_PERIOD],
-			pCols, pPlayerState->m_NotefieldZoom, data, fYOffset, true);
+		float fExpandMultiplier = SCALE( std::cos(data.m_fExpandSeconds*EXPAND_MULTIPLIER_FREQUENCY*(fAccels[PlayerOptions::ACCEL_EXPAND_PERIOD]+1)),
+						EXPAND_MULTIPLIER_SCALE_FROM_LOW, EXPAND_MULTIPLIER_SCALE_FROM_HIGH,
+						EXPAND_MULTIPLIER_SCALE_TO_LOW, EXPAND_MULTIPLIER_SCALE_TO_HIGH );
+		fExpandSpeed = SCALE( fAccels[PlayerOptions::ACCEL_EXPAND],
+				      EXPAND_SPEED_SCALE_FROM_LOW, EXPAND_SPEED_SCALE_FROM_HIGH,
+				      EXPAND_SPEED_SCALE_TO_LOW, fExpandMultiplier );
+	}
+	if( bTanExpand )
+	{
+		float fTanExpandMultiplier = SCALE( SelectTanType(data.m_fTanExpandSeconds*EXPAND_MULTIPLIER_FREQUENCY*(fAccels[PlayerOptions::ACCEL_TAN_EXPAND_PERIOD]+1), curr_options->m_bCosecant),
+						EXPAND_MULTIPLIER_SCALE_FROM_LOW, EXPAND_MULTIPLIER_SCALE_FROM_HIGH,
+						EXPAND_MULTIPLIER_SCALE_TO_LOW, EXPAND_MULTIPLIER_SCALE_TO_HIGH );
+		fTanExpandSpeed = SCALE( fAccels[PlayerOptions::ACCEL_TAN_EXPAND],
+				      EXPAND_SPEED_SCALE_FROM_LOW, EXPAND_SPEED_SCALE_FROM_HIGH,
+				      EXPAND_SPEED_SCALE_TO_LOW, fTanExpandMultiplier );
 	}
 
-	if( fEffects[PlayerOptions::EFFECT_BUMPY] != 0 )
-		fZPos += fEffects[PlayerOptions::EFFECT_BUMPY] * 40*std::sin(
-			CalculateBumpyAngle(fYOffset,
-			fEffects[PlayerOptions::EFFECT_BUMPY_OFFSET],
-			fEffects[PlayerOptions::EFFECT_BUMPY_PERIOD]) );
+	for( unsigned i = 0; i < iCount; ++i )
+	{
+		float f = fYOffset[i];
+		// don't mess with the arrows after they've crossed 0
+		if( f < 0 )
+		{
+			fYOffset[i] = f * fScrollSpeed;
+			continue;
+		}
 
-	if( curr_options->m_fBumpy[iCol] != 0 )
-		fZPos += curr_options->m_fBumpy[iCol] * 40*std::sin(
-			CalculateBumpyAngle(fYOffset,
-			fEffects[PlayerOptions::EFFECT_BUMPY_OFFSET],
-			fEffects[PlayerOptions::EFFECT_BUMPY_PERIOD]) );
+		f += fYAdjust[i];
+		if( bBoomerang )
+		{
+			if( fPeakYOffsetOut != nullptr )
+			{
+				fPeakYOffsetOut[i] = fBoomerangPeakYOffset;
+				bIsPastPeakOut[i] = f < fPeakAtYOffset;
+			}
+			f = (-1*f*f/fScreenHeight) + 1.5f*f;
+		}
 
-	if( fEffects[PlayerOptions::EFFECT_TAN_BUMPY] != 0 )
-		fZPos += fEffects[PlayerOptions::EFFECT_TAN_BUMPY] * 40*SelectTanType(
-			CalculateBumpyAngle(fYOffset,
-			fEffects[PlayerOptions::EFFECT_TAN_BUMPY_OFFSET],
-			fEffects[PlayerOptions::EFFECT_TAN_BUMPY_PERIOD]), curr_options->m_bCosecant );
+		float fSpeed = fScrollSpeed;
+		if( bRandomSpeed )
+		{
+			unsigned seed = GAMESTATE->m_iStageSeed + ( BeatToNoteRow( fBeat[i] ) << 8 ) + (iCol * 100);
+			for( int j = 0; j < 3; ++j )
+				seed = ((seed * 1664525u) + 1013904223u) & 0xFFFFFFFF;
+			float fRandom = seed / 4294967296.0f;
+			fSpeed *= SCALE( fRandom, 0.0f, 1.0f, 1.0f, curr_options->m_fRandomSpeed + 1.0f );
+		}
+		if( bExpand )
+			fSpeed *= fExpandSpeed;
+		if( bTanExpand )
+			fSpeed *= fTanExpandSpeed;
 
-	if( fEffects[PlayerOptions::EFFECT_ZIGZAG_Z] != 0 )
+		fYOffset[i] = f * fSpeed;
+		if( fPeakYOffsetOut != nullptr )
+			fPeakYOffsetOut[i] *= fSpeed;
+	}
+}
+
+void ArrowEffects::GetYOffsets( const FrameContext &context, NoteBatch &batch, bool bAbsolute )
+{
+	const unsigned iCount = batch.Size();
+	if( iCount == 0 )
+		return;
+	CalculateYOffsets( context, batch.m_fBeat.data(), batch.m_fYOffset.data(), batch.m_fTemp.data(),
+		iCount, bAbsolute, nullptr, nullptr );
+}
+
+// The terms GetXPos and GetZPos have in common, added to fOut.
+static void AddTornado(int dimension, int col_id, float magnitude,
+	float effect_offset, float period, const Style::ColumnInfo* pCols,
+	float field_zoom, PerPlayerData& data, bool is_tan,
+	const float* y_offset, float* out, unsigned count)
+{
+	float const real_pixel_offset= pCols[col_id].fXOffset * field_zoom;
+	float const min_pixel_offset= data.m_MinTornado[dimension][col_id] * field_zoom;
+	float const max_pixel_offset= data.m_MaxTornado[dimension][col_id] * field_zoom;
+	float const position_between= SCALE(real_pixel_offset,
+		min_pixel_offset, max_pixel_offset,
+		tornado_position_scale_to_low[dimension],
+		tornado_position_scale_to_high[dimension]);
+	float const start_rads= std::acos(position_between);
+	float const frequency= tornado_offset_frequency[dimension];
+	float const rads_per_pixel= (period * frequency) + frequency;
+	float const screen_height= SCREEN_HEIGHT;
+	bool const cosecant= curr_options->m_bCosecant;
+	for(unsigned i= 0; i < count; ++i)
+	{
+		float rads= start_rads;
+		rads+= (y_offset[i] + effect_offset) * rads_per_pixel / screen_height;
+		float processed_rads = is_tan ? SelectTanType(rads, cosecant) : std::cos(rads);
+		float const adjusted_pixel_offset= SCALE(processed_rads,
+			tornado_offset_scale_from_low[dimension],
+			tornado_offset_scale_from_high[dimension],
+			min_pixel_offset, max_pixel_offset);
+		out[i]+= (adjusted_pixel_offset - real_pixel_offset) * magnitude;
+	}
+}
+
+static void AddBumpy(float magnitude, float offset, float period, bool is_tan,
+	const float* y_offset, float* out, unsigned count)
+{
+	bool const cosecant= curr_options->m_bCosecant;
+	for(unsigned i= 0; i < count; ++i)
 	{
-		float fResult = RageTriangle( (PI * (1/(fEffects[PlayerOptions::EFFECT_ZIGZAG_Z_PERIOD]+1)) *
-			((fYOffset+(100.0f*(fEffects[PlayerOptions::EFFECT_ZIGZAG_Z_OFFSET])))/ARROW_SIZE) ) );
+		float const angle= CalculateBumpyAngle(y_offset[i], offset, period);
+		out[i]+= magnitude * 40*(is_tan ? SelectTanType(angle, cosecant) : std::sin(angle));
+	}
+}
 
-		fZPos += (fEffects[PlayerOptions::EFFECT_ZIGZAG_Z]*ARROW_SIZE/2) * fResult;
+static void AddDrunk(float magnitude, float time, float speed, int col,
+	float offset, float col_frequency, float period, float offset_frequency,
+	float arrow_magnitude, bool is_tan, const float* y_offset, float* out,
+	unsigned count)
+{
+	float const start_angle= time * (1+speed) + col*( (offset*col_frequency) + col_frequency);
+	float const angle_per_pixel= (period*offset_frequency) + offset_frequency;
+	float const screen_height= SCREEN_HEIGHT;
+	bool const cosecant= curr_options->m_bCosecant;
+	for(unsigned i= 0; i < count; ++i)
+	{
+		float const angle= start_angle + y_offset[i] * angle_per_pixel / screen_height;
+		out[i]+= magnitude *
+			( (is_tan ? SelectTanType(angle, cosecant) : std::cos(angle)) * ARROW_SIZE*arrow_magnitude );
 	}
+}
 
-	if( fEffects[PlayerOptions::EFFECT_SAWTOOTH_Z] != 0 )
-		fZPos += (fEffects[PlayerOptions::EFFECT_SAWTOOTH_Z]*ARROW_SIZE) *
-			((0.5f/(fEffects[PlayerOptions::EFFECT_SAWTOOTH_Z_PERIOD]+1)*fYOffset)/ARROW_SIZE -
-				std::floor((0.5f/(fEffects[PlayerOptions::EFFECT_SAWTOOTH_Z_PERIOD]+1)*fYOffset)/ARROW_SIZE));
+static void AddBeat(float magnitude, float beat_factor, float period,
+	float offset_height, float pi_height, const float* y_offset, float* out,
+	unsigned count)
+{
+	float const height= (period*offset_height)+offset_height;
+	float const phase= PI/pi_height;
+	for(unsigned i= 0; i < count; ++i)
+	{
+		const float fShift = beat_factor*std::sin( y_offset[i] / height + phase );
+		out[i]+= magnitude * fShift;
+	}
+}
 
-	if( fEffects[PlayerOptions::EFFECT_PARABOLA_Z] != 0 )
-		fZPos += fEffects[PlayerOptions::EFFECT_PARABOLA_Z] * (fYOffset/ARROW_SIZE) * (fYOffset/ARROW_SIZE);
+static void AddZigZag(float magnitude, float offset, float period,
+	const float* y_offset, float* out, unsigned count)
+{
+	float const frequency= PI * (1/(period+1));
+	float const amplitude= magnitude*ARROW_SIZE/2;
+	for(unsigned i= 0; i < count; ++i)
+	{
+		float fResult = RageTriangle( frequency * ((y_offset[i]+(100.0f*(offset)))/ARROW_SIZE) );
+		out[i]+= amplitude * fResult;
+	}
+}
 
-	if( fEffects[PlayerOptions::EFFECT_ATTENUATE_Z] != 0 )
+static void AddSawtooth(float magnitude, float period, const float* y_offset,
+	float* out, unsigned count)
+{
+	float const frequency= 0.5f / (period+1);
+	float const amplitude= magnitude*ARROW_SIZE;
+	for(unsigned i= 0; i < count; ++i)
 	{
-		const float fXOffset = pCols[iCol].fXOffset;
-		fZPos += fEffects[PlayerOptions::EFFECT_ATTENUATE_Z] * (fYOffset/ARROW_SIZE) * (fYOffset/ARROW_SIZE) * (fXOffset/ARROW_SIZE);
+		float const f= (frequency * y_offset[i]) / ARROW_SIZE;
+		out[i]+= amplitude * (f - std::floor(f));
 	}
+}
 
-	if( fEffects[PlayerOptions::EFFECT_DRUNK_Z] != 0 )
-		fZPos += fEffects[PlayerOptions::EFFECT_DRUNK_Z] *
-			( std::cos( CalculateDrunkAngle(fEffects[PlayerOptions::EFFECT_DRUNK_Z_SPEED], iCol,
-					fEffects[PlayerOptions::EFFECT_DRUNK_Z_OFFSET], DRUNK_Z_COLUMN_FREQUENCY,
-					fYOffset, fEffects[PlayerOptions::EFFECT_DRUNK_Z_PERIOD],
-					DRUNK_Z_OFFSET_FREQUENCY) ) * ARROW_SIZE*DRUNK_Z_ARROW_MAGNITUDE );
+static void AddParabola(float magnitude, const float* y_offset, float* out,
+	unsigned count)
+{
+	for(unsigned i= 0; i < count; ++i)
+	{
+		out[i]+= magnitude * (y_offset[i]/ARROW_SIZE) * (y_offset[i]/ARROW_SIZE);
+	}
+}
 
-	if( fEffects[PlayerOptions::EFFECT_TAN_DRUNK_Z] != 0 )
-		fZPos += fEffects[PlayerOptions::EFFECT_TAN_DRUNK_Z] *
-			( SelectTanType( CalculateDrunkAngle(fEffects[PlayerOptions::EFFECT_TAN_DRUNK_Z_SPEED],
-					iCol, fEffects[PlayerOptions::EFFECT_TAN_DRUNK_Z_OFFSET],
-					DRUNK_Z_COLUMN_FREQUENCY, fYOffset,
-					fEffects[PlayerOptions::EFFECT_TAN_DRUNK_Z_PERIOD],
-					DRUNK_Z_OFFSET_FREQUENCY)
-					, curr_options->m_bCosecant) * ARROW_SIZE*DRUNK_Z_ARROW_MAGNITUDE );
+static void AddAttenuate(float magnitude, float x_offset, const float* y_offset,
+	float* out, unsigned count)
+{
+	for(unsigned i= 0; i < count; ++i)
+	{
+		out[i]+= magnitude * (y_offset[i]/ARROW_SIZE) * (y_offset[i]/ARROW_SIZE) * (x_offset/ARROW_SIZE);
+	}
+}
 
-	if( fEffects[PlayerOptions::EFFECT_BEAT_Z] != 0 )
+static void AddDigital(float magnitude, float steps, float offset, float period,
+	bool is_tan, const float* y_offset, float* out, unsigned count)
+{
+	float const amplitude= magnitude * ARROW_SIZE * 0.5f;
+	bool const cosecant= curr_options->m_bCosecant;
+	for(unsigned i= 0; i < count; ++i)
 	{
-		const float fShift = data.m_fBeatFactor[dim_z]*std::sin( fYOffset / ((fEffects[PlayerOptions::EFFECT_BEAT_Z_PERIOD]*BEAT_Z_OFFSET_HEIGHT)+BEAT_Z_OFFSET_HEIGHT) + PI/BEAT_Z_PI_HEIGHT );
-		fZPos += fEffects[PlayerOptions::EFFECT_BEAT_Z] * fShift;
+		float const angle= CalculateDigitalAngle(y_offset[i], offset, period);
+		out[i]+= amplitude *
+			std::round((steps+1) * (is_tan ? SelectTanType(angle, cosecant) : std::sin(angle)))/(steps+1);
 	}
+}
 
-	if( fEffects[PlayerOptions::EFFECT_DIGITAL_Z] != 0 )
-		fZPos += (fEffects[PlayerOptions::EFFECT_DIGITAL_Z] * ARROW_SIZE * 0.5f) *
-			std::round((fEffects[PlayerOptions::EFFECT_DIGITAL_Z_STEPS]+1) * std::sin(
-				CalculateDigitalAngle(fYOffset,
-				fEffects[PlayerOptions::EFFECT_DIGITAL_Z_OFFSET],
-				fEffects[PlayerOptions::EFFECT_DIGITAL_Z_PERIOD]) ) ) /(fEffects[PlayerOptions::EFFECT_DIGITAL_Z_STEPS]+1);
+static void AddSquare(float magnitude, float offset, float period,
+	const float* y_offset, float* out, unsigned count)
+{
+	float const wavelength= ARROW_SIZE+(period*ARROW_SIZE);
+	float const amplitude= magnitude * ARROW_SIZE * 0.5f;
+	for(unsigned i= 0; i < count; ++i)
+	{
+		float fResult = RageSquare( (PI * (y_offset[i]+(1.0f*(offset)))) / wavelength );
+		out[i]+= amplitude * fResult;
+	}
+}
 
-	if( fEffects[PlayerOptions::EFFECT_TAN_DIGITAL_Z] != 0 )
-		fZPos += (fEffects[PlayerOptions::EFFECT_TAN_DIGITAL_Z] * ARROW_SIZE * 0.5f) *
-			std::round((fEffects[PlayerOptions::EFFECT_TAN_DIGITAL_Z_STEPS]+1) * SelectTanType(
-				CalculateDigitalAngle(fYOffset,
-				fEffects[PlayerOptions::EFFECT_TAN_DIGITAL_Z_OFFSET],
-				fEffects[PlayerOptions::EFFECT_TAN_DIGITAL_Z_PERIOD]), curr_options->m_bCosecant ) ) /(fEffects[PlayerOptions::EFFECT_TAN_DIGITAL_Z_STEPS]+1);
+static void AddBounce(float magnitude, float offset, float period,
+	const float* y_offset, float* out, unsigned count)
+{
+	float const wavelength= 60 + (period*60);
+	for(unsigned i= 0; i < count; ++i)
+	{
+		float fBounceAmt = std::abs( std::sin( ( (y_offset[i] + (1.0f * (offset) ) ) / wavelength ) ) );
+		out[i]+= magnitude * ARROW_SIZE * 0.5f * fBounceAmt;
+	}
+}
 
+static void AddConstant(float f, float* out, unsigned count)
+{
+	for(unsigned i= 0; i < count; ++i)
+	{
+		out[i]+= f;
+	}
+}
 
-	if( fEffects[PlayerOptions::EFFECT_SQUARE_Z] != 0 )
+static void GetXPosBatch( const ArrowEffects::FrameContext &context, const float *fYOffset, float *fOut, unsigned iCount )
+{
+	const PlayerState* pPlayerState = context.m_pPlayerState;
+	const int iColNum = context.m_iCol;
+	const Style* pStyle = context.m_pStyle;
+	const float* fEffects = curr_options->m_fEffects;
+
+	// TODO: Don't index by PlayerNumber.
+	const Style::ColumnInfo* pCols = context.m_pCols;
+	PerPlayerData &data = g_EffectData[pPlayerState->m_PlayerNumber];
+
+	for( unsigned i = 0; i < iCount; ++i )
+		fOut[i] = 0;
+
+	if( context.IsOn(ArrowEffects::FrameContext::MOD_XPOS) )
+	{
+		if( fEffects[PlayerOptions::EFFECT_TORNADO] != 0 )
+			AddTornado( dim_x, iColNum, fEffects[PlayerOptions::EFFECT_TORNADO],
+				fEffects[PlayerOptions::EFFECT_TORNADO_OFFSET],
+				fEffects[PlayerOptions::EFFECT_TORNADO_PERIOD],
+				pCols, pPlayerState->m_NotefieldZoom, data, false, fYOffset, fOut, iCount );
+		if( fEffects[PlayerOptions::EFFECT_TAN_TORNADO] != 0 )
+			AddTornado( dim_x, iColNum, fEffects[PlayerOptions::EFFECT_TAN_TORNADO],
+				fEffects[PlayerOptions::EFFECT_TAN_TORNADO_OFFSET],
+				fEffects[PlayerOptions::EFFECT_TAN_TORNADO_PERIOD],
+				pCols, pPlayerState->m_NotefieldZoom, data, true, fYOffset, fOut, iCount );
+		if( fEffects[PlayerOptions::EFFECT_BUMPY_X] != 0 )
+			AddBumpy( fEffects[PlayerOptions::EFFECT_BUMPY_X],
+				fEffects[PlayerOptions::EFFECT_BUMPY_X_OFFSET],
+				fEffects[PlayerOptions::EFFECT_BUMPY_X_PERIOD], false, fYOffset, fOut, iCount );
+		if( fEffects[PlayerOptions::EFFECT_TAN_BUMPY_X] != 0 )
+			AddBumpy( fEffects[PlayerOptions::EFFECT_TAN_BUMPY_X],
+				fEffects[PlayerOptions::EFFECT_TAN_BUMPY_X_OFFSET],
+				fEffects[PlayerOptions::EFFECT_TAN_BUMPY_X_PERIOD], true, fYOffset, fOut, iCount );
+		if( fEffects[PlayerOptions::EFFECT_DRUNK] != 0 )
+			AddDrunk( fEffects[PlayerOptions::EFFECT_DRUNK], context.m_fModTime, fEffects[PlayerOptions::EFFECT_DRUNK_SPEED], iColNum,
+				fEffects[PlayerOptions::EFFECT_DRUNK_OFFSET], DRUNK_COLUMN_FREQUENCY,
+				fEffects[PlayerOptions::EFFECT_DRUNK_PERIOD], DRUNK_OFFSET_FREQUENCY,
+				DRUNK_ARROW_MAGNITUDE, false, fYOffset, fOut, iCount );
+		if( fEffects[PlayerOptions::EFFECT_TAN_DRUNK] != 0 )
+			AddDrunk( fEffects[PlayerOptions::EFFECT_TAN_DRUNK], context.m_fModTime, fEffects[PlayerOptions::EFFECT_TAN_DRUNK_SPEED], iColNum,
+				fEffects[PlayerOptions::EFFECT_TAN_DRUNK_OFFSET], DRUNK_COLUMN_FREQUENCY,
+				fEffects[PlayerOptions::EFFECT_TAN_DRUNK_PERIOD], DRUNK_OFFSET_FREQUENCY,
+				DRUNK_ARROW_MAGNITUDE, true, fYOffset, fOut, iCount );
+		if( fEffects[PlayerOptions::EFFECT_FLIP] != 0 )
+		{
+			const int iFirstCol = 0;
+			const int iLastCol = pStyle->m_iColsPerPlayer-1;
+			const int iNewCol = SCALE( iColNum, iFirstCol, iLastCol, iLastCol, iFirstCol );
+			const float fOldPixelOffset = pCols[iColNum].fXOffset * pPlayerState->m_NotefieldZoom;
+			const float fNewPixelOffset = pCols[iNewCol].fXOffset * pPlayerState->m_NotefieldZoom;
+			const float fDistance = fNewPixelOffset - fOldPixelOffset;
+			AddConstant( fDistance * fEffects[PlayerOptions::EFFECT_FLIP], fOut, iCount );
+		}
+		if( fEffects[PlayerOptions::EFFECT_INVERT] != 0 )
+			AddConstant( data.m_fInvertDistance[iColNum] * fEffects[PlayerOptions::EFFECT_INVERT], fOut, iCount );
+		if( fEffects[PlayerOptions::EFFECT_BEAT] != 0 )
+			AddBeat( fEffects[PlayerOptions::EFFECT_BEAT], data.m_fBeatFactor[dim_x],
+				fEffects[PlayerOptions::EFFECT_BEAT_PERIOD], BEAT_OFFSET_HEIGHT, BEAT_PI_HEIGHT,
+				fYOffset, fOut, iCount );
+		if( fEffects[PlayerOptions::EFFECT_ZIGZAG] != 0 )
+			AddZigZag( fEffects[PlayerOptions::EFFECT_ZIGZAG], fEffects[PlayerOptions::EFFECT_ZIGZAG_OFFSET],
+				fEffects[PlayerOptions::EFFECT_ZIGZAG_PERIOD], fYOffset, fOut, iCount );
+		if( fEffects[PlayerOptions::EFFECT_SAWTOOTH] != 0 )
+			AddSawtooth( fEffects[PlayerOptions::EFFECT_SAWTOOTH], fEffects[PlayerOptions::EFFECT_SAWTOOTH_PERIOD],
+				fYOffset, fOut, iCount );
+		if( fEffects[PlayerOptions::EFFECT_PARABOLA_X] != 0 )
+			AddParabola( fEffects[PlayerOptions::EFFECT_PARABOLA_X], fYOffset, fOut, iCount );
+		if( fEffects[PlayerOptions::EFFECT_ATTENUATE_X] != 0 )
+			AddAttenuate( fEffects[PlayerOptions::EFFECT_ATTENUATE_X], pCols[iColNum].fXOffset, fYOffset, fOut, iCount );
+		if( fEffects[PlayerOptions::EFFECT_DIGITAL] != 0 )
+			AddDigital( fEffects[PlayerOptions::EFFECT_DIGITAL], fEffects[PlayerOptions::EFFECT_DIGITAL_STEPS],
+				fEffects[PlayerOptions::EFFECT_DIGITAL_OFFSET], fEffects[PlayerOptions::EFFECT_DIGITAL_PERIOD],
+				false, fYOffset, fOut, iCount );
+		if( fEffects[PlayerOptions::EFFECT_TAN_DIGITAL] != 0 )
+			AddDigital( fEffects[PlayerOptions::EFFECT_TAN_DIGITAL], fEffects[PlayerOptions::EFFECT_TAN_DIGITAL_STEPS],
+				fEffects[PlayerOptions::EFFECT_TAN_DIGITAL_OFFSET], fEffects[PlayerOptions::EFFECT_TAN_DIGITAL_PERIOD],
+				true, fYOffset, fOut, iCount );
+		if( fEffects[PlayerOptions::EFFECT_SQUARE] != 0 )
+			AddSquare( fEffects[PlayerOptions::EFFECT_SQUARE], fEffects[PlayerOptions::EFFECT_SQUARE_OFFSET],
+				fEffects[PlayerOptions::EFFECT_SQUARE_PERIOD], fYOffset, fOut, iCount );
+		if( fEffects[PlayerOptions::EFFECT_BOUNCE] != 0 )
+			AddBounce( fEffects[PlayerOptions::EFFECT_BOUNCE], fEffects[PlayerOptions::EFFECT_BOUNCE_OFFSET],
+				fEffects[PlayerOptions::EFFECT_BOUNCE_PERIOD], fYOffset, fOut, iCount );
+
+		if( fEffects[PlayerOptions::EFFECT_XMODE] != 0 )
+		{
+			// See GetXPos for which way each column goes.
+			bool bBackwards = false;
+			switch( pStyle->m_StyleType )
+			{
+				case StyleType_OnePlayerTwoSides:
+				case StyleType_TwoPlayersSharedSides:
+					bBackwards = iColNum > int(std::floor(pStyle->m_iColsPerPlayer/2.0f))-1;
+					break;
+				case StyleType_OnePlayerOneSide:
+				case StyleType_TwoPlayersTwoSides:
+					bBackwards = pPlayerState->m_PlayerNumber == PLAYER_2;
+					break;
+				DEFAULT_FAIL(pStyle->m_StyleType);
+			}
+			const float fXMode = fEffects[PlayerOptions::EFFECT_XMODE];
+			for( unsigned i = 0; i < iCount; ++i )
+				fOut[i] += bBackwards? fXMode*-(fYOffset[i]) : fXMode*fYOffset[i];
+		}
+	}
+
+	AddConstant( pCols[iColNum].fXOffset * pPlayerState->m_NotefieldZoom, fOut, iCount );
+
+	if( fEffects[PlayerOptions::EFFECT_TINY] != 0 )
+	{
+		// Allow Tiny to pull tracks together, but not to push them apart.
+		float fTinyPercent = fEffects[PlayerOptions::EFFECT_TINY];
+		fTinyPercent = std::min( std::pow(TINY_PERCENT_BASE, fTinyPercent), (float)TINY_PERCENT_GATE );
+		for( unsigned i = 0; i < iCount; ++i )
+			fOut[i] *= fTinyPercent;
+	}
+}
+
+static void GetYPosBatch( const ArrowEffects::FrameContext &context, const float *fYOffset, float *fOut, unsigned iCount, bool WithReverse )
+{
+	for( unsigned i = 0; i < iCount; ++i )
+		fOut[i] = fYOffset[i];
+
+	if( WithReverse )
+	{
+		const float fShift = context.m_fReverseShift;
+		const float fScale = context.m_fReverseScale;
+		for( unsigned i = 0; i < iCount; ++i )
+		{
+			fOut[i] *= fScale;
+			fOut[i] += fShift;
+		}
+	}
+
+	const int iCol = context.m_iCol;
+	const Style::ColumnInfo* pCols = context.m_pCols;
+	const float* fEffects = curr_options->m_fEffects;
+
+	PerPlayerData& data= g_EffectData[curr_options->m_pn];
+	AddConstant( fEffects[PlayerOptions::EFFECT_TIPSY] * data.m_tipsy_result[iCol], fOut, iCount );
+	AddConstant( fEffects[PlayerOptions::EFFECT_TAN_TIPSY] * data.m_tan_tipsy_result[iCol], fOut, iCount );
+
+	if( context.IsOn(ArrowEffects::FrameContext::MOD_YPOS) )
 	{
-		float fResult = RageSquare( (PI * (fYOffset+(1.0f*(fEffects[PlayerOptions::EFFECT_SQUARE_Z_OFFSET]))) /
-			(ARROW_SIZE+(fEffects[PlayerOptions::EFFECT_SQUARE_Z_PERIOD]*ARROW_SIZE))) );
-		fZPos += (fEffects[PlayerOptions::EFFECT_SQUARE_Z] * ARROW_SIZE * 0.5f) * fResult;
+		if( fEffects[PlayerOptions::EFFECT_ATTENUATE_Y] != 0 )
+			AddAttenuate( fEffects[PlayerOptions::EFFECT_ATTENUATE_Y], pCols[iCol].fXOffset, fYOffset, fOut, iCount );
+		if( fEffects[PlayerOptions::EFFECT_BEAT_Y] != 0 )
+			AddBeat( fEffects[PlayerOptions::EFFECT_BEAT_Y], data.m_fBeatFactor[dim_y],
+				fEffects[PlayerOptions::EFFECT_BEAT_Y_PERIOD], BEAT_Y_OFFSET_HEIGHT, BEAT_Y_PI_HEIGHT,
+				fYOffset, fOut, iCount );
 	}
 
+	if( QUANTIZE_ARROW_Y )
+	{
+		for( unsigned i = 0; i < iCount; ++i )
+			fOut[i] = std::floor( fOut[i] );
+	}
+}
+
+static void GetZPosBatch( const ArrowEffects::FrameContext &context, const float *fYOffset, float *fOut, unsigned iCount )
+{
+	for( unsigned i = 0; i < iCount; ++i )
+		fOut[i] = 0;
+	if( !context.IsOn(ArrowEffects::FrameContext::MOD_ZPOS) )
+		return;
+
+	const PlayerState* pPlayerState = context.m_pPlayerState;
+	const int iCol = context.m_iCol;
+	const float* fEffects = curr_options->m_fEffects;
+
+	// TODO: Don't index by PlayerNumber.
+	const Style::ColumnInfo* pCols = context.m_pCols;
+	PerPlayerData &data = g_EffectData[pPlayerState->m_PlayerNumber];
+
+	if( fEffects[PlayerOptions::EFFECT_TORNADO_Z] != 0 )
+		AddTornado( dim_z, iCol, fEffects[PlayerOptions::EFFECT_TORNADO_Z],
+			fEffects[PlayerOptions::EFFECT_TORNADO_Z_OFFSET],
+			fEffects[PlayerOptions::EFFECT_TORNADO_Z_PERIOD],
+			pCols, pPlayerState->m_NotefieldZoom, data, false, fYOffset, fOut, iCount );
+	if( fEffects[PlayerOptions::EFFECT_TAN_TORNADO_Z] != 0 )
+		AddTornado( dim_z, iCol, fEffects[PlayerOptions::EFFECT_TAN_TORNADO_Z],
+			fEffects[PlayerOptions::EFFECT_TAN_TORNADO_Z_OFFSET],
+			fEffects[PlayerOptions::EFFECT_TAN_TORNADO_Z_PERIOD],
+			pCols, pPlayerState->m_NotefieldZoom, data, true, fYOffset, fOut, iCount );
+	if( fEffects[PlayerOptions::EFFECT_BUMPY] != 0 )
+		AddBumpy( fEffects[PlayerOptions::EFFECT_BUMPY], fEffects[PlayerOptions::EFFECT_BUMPY_OFFSET],
+			fEffects[PlayerOptions::EFFECT_BUMPY_PERIOD], false, fYOffset, fOut, iCount );
+	if( curr_options->m_fBumpy[iCol] != 0 )
+		AddBumpy( curr_options->m_fBumpy[iCol], fEffects[PlayerOptions::EFFECT_BUMPY_OFFSET],
+			fEffects[PlayerOptions::EFFECT_BUMPY_PERIOD], false, fYOffset, fOut, iCount );
+	if( fEffects[PlayerOptions::EFFECT_TAN_BUMPY] != 0 )
+		AddBumpy( fEffects[PlayerOptions::EFFECT_TAN_BUMPY], fEffects[PlayerOptions::EFFECT_TAN_BUMPY_OFFSET],
+			fEffects[PlayerOptions::EFFECT_TAN_BUMPY_PERIOD], true, fYOffset, fOut, iCount );
+	if( fEffects[PlayerOptions::EFFECT_ZIGZAG_Z] != 0 )
+		AddZigZag( fEffects[PlayerOptions::EFFECT_ZIGZAG_Z], fEffects[PlayerOptions::EFFECT_ZIGZAG_Z_OFFSET],
+			fEffects[PlayerOptions::EFFECT_ZIGZAG_Z_PERIOD], fYOffset, fOut, iCount );
+	if( fEffects[PlayerOptions::EFFECT_SAWTOOTH_Z] != 0 )
+		AddSawtooth( fEffects[PlayerOptions::EFFECT_SAWTOOTH_Z], fEffects[PlayerOptions::EFFECT_SAWTOOTH_Z_PERIOD],
+			fYOffset, fOut, iCount );
+	if( fEffects[PlayerOptions::EFFECT_PARABOLA_Z] != 0 )
+		AddParabola( fEffects[PlayerOptions::EFFECT_PARABOLA_Z], fYOffset, fOut, iCount );
+	if( fEffects[PlayerOptions::EFFECT_ATTENUATE_Z] != 0 )
+		AddAttenuate( fEffects[PlayerOptions::EFFECT_ATTENUATE_Z], pCols[iCol].fXOffset, fYOffset, fOut, iCount );
+	if( fEffects[PlayerOptions::EFFECT_DRUNK_Z] != 0 )
+		AddDrunk( fEffects[PlayerOptions::EFFECT_DRUNK_Z], context.m_fModTime, fEffects[PlayerOptions::EFFECT_DRUNK_Z_SPEED], iCol,
+			fEffects[PlayerOptions::EFFECT_DRUNK_Z_OFFSET], DRUNK_Z_COLUMN_FREQUENCY,
+			fEffects[PlayerOptions::EFFECT_DRUNK_Z_PERIOD], DRUNK_Z_OFFSET_FREQUENCY,
+			DRUNK_Z_ARROW_MAGNITUDE, false, fYOffset, fOut, iCount );
+	if( fEffects[PlayerOptions::EFFECT_TAN_DRUNK_Z] != 0 )
+		AddDrunk( fEffects[PlayerOptions::EFFECT_TAN_DRUNK_Z], context.m_fModTime, fEffects[PlayerOptions::EFFECT_TAN_DRUNK_Z_SPEED], iCol,
+			fEffects[PlayerOptions::EFFECT_TAN_DRUNK_Z_OFFSET], DRUNK_Z_COLUMN_FREQUENCY,
+			fEffects[PlayerOptions::EFFECT_TAN_DRUNK_Z_PERIOD], DRUNK_Z_OFFSET_FREQUENCY,
+			DRUNK_Z_ARROW_MAGNITUDE, true, fYOffset, fOut, iCount );
+	if( fEffects[PlayerOptions::EFFECT_BEAT_Z] != 0 )
+		AddBeat( fEffects[PlayerOptions::EFFECT_BEAT_Z], data.m_fBeatFactor[dim_z],
+			fEffects[PlayerOptions::EFFECT_BEAT_Z_PERIOD], BEAT_Z_OFFSET_HEIGHT, BEAT_Z_PI_HEIGHT,
+			fYOffset, fOut, iCount );
+	if( fEffects[PlayerOptions::EFFECT_DIGITAL_Z] != 0 )
+		AddDigital( fEffects[PlayerOptions::EFFECT_DIGITAL_Z], fEffects[PlayerOptions::EFFECT_DIGITAL_Z_STEPS],
+			fEffects[PlayerOptions::EFFECT_DIGITAL_Z_OFFSET], fEffects[PlayerOptions::EFFECT_DIGITAL_Z_PERIOD],
+			false, fYOffset, fOut, iCount );
+	if( fEffects[PlayerOptions::EFFECT_TAN_DIGITAL_Z] != 0 )
+		AddDigital( fEffects[PlayerOptions::EFFECT_TAN_DIGITAL_Z], fEffects[PlayerOptions::EFFECT_TAN_DIGITAL_Z_STEPS],
+			fEffects[PlayerOptions::EFFECT_TAN_DIGITAL_Z_OFFSET], fEffects[PlayerOptions::EFFECT_TAN_DIGITAL_Z_PERIOD],
+			true, fYOffset, fOut, iCount );
+	if( fEffects[PlayerOptions::EFFECT_SQUARE_Z] != 0 )
+		AddSquare( fEffects[PlayerOptions::EFFECT_SQUARE_Z], fEffects[PlayerOptions::EFFECT_SQUARE_Z_OFFSET],
+			fEffects[PlayerOptions::EFFECT_SQUARE_Z_PERIOD], fYOffset, fOut, iCount );
 	if( fEffects[PlayerOptions::EFFECT_BOUNCE_Z] != 0 )
+		AddBounce( fEffects[PlayerOptions::EFFECT_BOUNCE_Z], fEffects[PlayerOptions::EFFECT_BOUNCE_Z_OFFSET],
+			fEffects[PlayerOptions::EFFECT_BOUNCE_Z_PERIOD], fYOffset, fOut, iCount );
+}
+
+// How much of each note shows through the appearance mods, from 0 to 1.
+static void GetPercentVisibleBatch( const ArrowEffects::FrameContext &context, const float *fYPosWithoutReverse, const float *fYOffset, float *fOut, unsigned iCount )
+{
+	if( !context.IsOn(ArrowEffects::FrameContext::MOD_VISIBILITY) )
 	{
-		float fBounceAmt = std::abs( std::sin( ( (fYOffset + (1.0f * (fEffects[PlayerOptions::EFFECT_BOUNCE_Z_OFFSET]) ) ) /
-			( 60 + (fEffects[PlayerOptions::EFFECT_BOUNCE_Z_PERIOD]*60) ) ) ) );
+		for( unsigned i = 0; i < iCount; ++i )
+			fOut[i] = 1;
+		return;
+	}
 
-		fZPos += fEffects[PlayerOptions::EFFECT_BOUNCE_Z] * ARROW_SIZE * 0.5f * fBounceAmt;
+	const int iCol = context.m_iCol;
+	const float* fAppearances = curr_options->m_fAppearances;
+	const float fCenterLine = context.m_fCenterLine;
+	const float fHiddenStartLine = context.m_fHiddenStartLine;
+	const float fHiddenEndLine = context.m_fHiddenEndLine;
+	const float fSuddenStartLine = context.m_fSuddenStartLine;
+	const float fSuddenEndLine = context.m_fSuddenEndLine;
+	const float fHidden = fAppearances[PlayerOptions::APPEARANCE_HIDDEN];
+	const float fSudden = fAppearances[PlayerOptions::APPEARANCE_SUDDEN];
+	const float fStealth = fAppearances[PlayerOptions::APPEARANCE_STEALTH];
+	const float fColumnStealth = curr_options->m_fStealth[iCol];
+	const float fRandomVanish = fAppearances[PlayerOptions::APPEARANCE_RANDOMVANISH];
+	const bool bStealthType = curr_options->m_bStealthType;
+	const bool bStealthPastReceptors = curr_options->m_bStealthPastReceptors;
+	const bool bBlink = fAppearances[PlayerOptions::APPEARANCE_BLINK] != 0;
+	float fBlinkAdjust = 0;
+	if( bBlink )
+	{
+		float f = std::sin(context.m_fModTime*10);
+		f = Quantize( f, BLINK_MOD_FREQUENCY );
+		fBlinkAdjust = SCALE( f, 0, 1, -1, 0 );
 	}
 
-	return fZPos;
+	for( unsigned i = 0; i < iCount; ++i )
+	{
+		const float fDistFromCenterLine = fYPosWithoutReverse[i] - fCenterLine;
+		const float fYPos = bStealthType? fYOffset[i] : fYPosWithoutReverse[i];
+
+		if( fYPos < 0 && bStealthPastReceptors == false )	// past Gray Arrows
+		{
+			fOut[i] = 1;	// totally visible
+			continue;
+		}
+
+		float fVisibleAdjust = 0;
+		if( fHidden != 0 )
+		{
+			float fHiddenVisibleAdjust = SCALE( fYPos, fHiddenStartLine, fHiddenEndLine, 0, -1 );
+			CLAMP( fHiddenVisibleAdjust, -1, 0 );
+			fVisibleAdjust += fHidden * fHiddenVisibleAdjust;
+		}
+		if( fSudden != 0 )
+		{
+			float fSuddenVisibleAdjust = SCALE( fYPos, fSuddenStartLine, fSuddenEndLine, -1, 0 );
+			CLAMP( fSuddenVisibleAdjust, -1, 0 );
+			fVisibleAdjust += fSudden * fSuddenVisibleAdjust;
+		}
+		if( fStealth != 0 )
+			fVisibleAdjust -= fStealth;
+		if( fColumnStealth != 0 )
+			fVisibleAdjust -= fColumnStealth;
+		if( bBlink )
+			fVisibleAdjust += fBlinkAdjust;
+		if( fRandomVanish != 0 )
+		{
+			const float fRealFadeDist = 80;
+			fVisibleAdjust += SCALE( std::abs(fDistFromCenterLine), fRealFadeDist, 2*fRealFadeDist, -1, 0 )
+				* fRandomVanish;
+		}
+
+		fOut[i] = std::clamp(1 + fVisibleAdjust, 0.0f, 1.0f);
+	}
 }
 
-bool ArrowEffects::NeedZBuffer()
+static void GetRotationXBatch( const ArrowEffects::FrameContext &context, const float *fYOffset, const unsigned char *bIsHoldCap, float *fOut, unsigned iCount )
 {
+	for( unsigned i = 0; i < iCount; ++i )
+		fOut[i] = 0;
+	if( !context.IsOn(ArrowEffects::FrameContext::MOD_ROTATION_X) )
+		return;
+
+	const int iCol = context.m_iCol;
 	const float* fEffects = curr_options->m_fEffects;
-	// We also need to use the Z buffer if twirl is in play, because of
-	// hold modulation. -vyhd (OpenITG r623)
-	if( fEffects[PlayerOptions::EFFECT_BUMPY] != 0 ||
-		fEffects[PlayerOptions::EFFECT_TWIRL] != 0 )
+	if( fEffects[PlayerOptions::EFFECT_CONFUSION_X] != 0 || fEffects[PlayerOptions::EFFECT_CONFUSION_X_OFFSET] != 0 ||
+		curr_options->m_fConfusionX[iCol] != 0 )
+		AddConstant( ArrowEffects::ReceptorGetRotationX(context.m_pPlayerState, iCol), fOut, iCount );
+	if( fEffects[PlayerOptions::EFFECT_ROLL] != 0 )
 	{
-		return true;
+		const float fRoll = fEffects[PlayerOptions::EFFECT_ROLL];
+		for( unsigned i = 0; i < iCount; ++i )
+			if( !bIsHoldCap[i] )
+				fOut[i] += fRoll * fYOffset[i]/2;
 	}
-	if( fEffects[PlayerOptions::EFFECT_BEAT_Z] != 0 ||
-		fEffects[PlayerOptions::EFFECT_DIGITAL_Z] != 0 )
+}
+
+static void GetRotationYBatch( const ArrowEffects::FrameContext &context, const float *fYOffset, float *fOut, unsigned iCount )
+{
+	for( unsigned i = 0; i < iCount; ++i )
+		fOut[i] = 0;
+	if( !context.IsOn(ArrowEffects::FrameContext::MOD_ROTATION_Y) )
+		return;
+
+	const int iCol = context.m_iCol;
+	const float* fEffects = curr_options->m_fEffects;
+	if( fEffects[PlayerOptions::EFFECT_CONFUSION_Y] != 0 || fEffects[PlayerOptions::EFFECT_CONFUSION_Y_OFFSET] != 0 ||
+		curr_options->m_fConfusionY[iCol] != 0 )
+		AddConstant( ArrowEffects::ReceptorGetRotationY(context.m_pPlayerState, iCol), fOut, iCount );
+	if( fEffects[PlayerOptions::EFFECT_TWIRL] != 0 )
 	{
-		return true;
+		const float fTwirl = fEffects[PlayerOptions::EFFECT_TWIRL];
+		for( unsigned i = 0; i < iCount; ++i )
+			fOut[i] += fTwirl * fYOffset[i]/2;
 	}
-	if( fEffects[PlayerOptions::EFFECT_ZIGZAG_Z] != 0 ||
-		fEffects[PlayerOptions::EFFECT_SAWTOOTH_Z] != 0 )
+}
+
+static void GetRotationZBatch( const ArrowEffects::FrameContext &context, const float *fBeat, const unsigned char *bIsHoldHead, float *fOut, unsigned iCount )
+{
+	for( unsigned i = 0; i < iCount; ++i )
+		fOut[i] = 0;
+	if( !context.IsOn(ArrowEffects::FrameContext::MOD_ROTATION_Z) )
+		return;
+
+	const PlayerState* pPlayerState = context.m_pPlayerState;
+	const int iCol = context.m_iCol;
+	const float* fEffects = curr_options->m_fEffects;
+	if( fEffects[PlayerOptions::EFFECT_CONFUSION] != 0 || fEffects[PlayerOptions::EFFECT_CONFUSION_OFFSET] != 0 ||
+		curr_options->m_fConfusionZ[iCol] != 0 )
+		AddConstant( ArrowEffects::ReceptorGetRotationZ(pPlayerState, iCol), fOut, iCount );
+
+	// As usual, enable dizzy hold heads at your own risk. -Wolfman2000
+	if( fEffects[PlayerOptions::EFFECT_DIZZY] != 0 )
 	{
-		return true;
+		const float fSongBeat = pPlayerState->m_Position.m_fSongBeatVisible;
+		const float fDizzy = fEffects[PlayerOptions::EFFECT_DIZZY];
+		const bool bDizzyHolds = curr_options->m_bDizzyHolds;
+		for( unsigned i = 0; i < iCount; ++i )
+		{
+			if( !bDizzyHolds && bIsHoldHead[i] )
+				continue;
+			float fDizzyRotation = fBeat[i] - fSongBeat;
+			fDizzyRotation *= fDizzy;
+			fDizzyRotation = std::fmod( fDizzyRotation, 2*PI );
+			fDizzyRotation *= 180/PI;
+			fOut[i] += fDizzyRotation;
+		}
 	}
-	if( fEffects[PlayerOptions::EFFECT_PARABOLA_Z] != 0 ||
-		fEffects[PlayerOptions::EFFECT_SQUARE_Z] != 0 )
+}
+
+// The part of GetZoom that depends on the note, applied to fZoom.
+static void ApplyZoomVariable( const float *fYOffset, float *fZoom, unsigned iCount )
+{
+	const float* fEffects = curr_options->m_fEffects;
+	if( fEffects[PlayerOptions::EFFECT_PULSE_INNER] != 0 || fEffects[PlayerOptions::EFFECT_PULSE_OUTER] != 0 )
 	{
-		return true;
+		const float fOffset = 100.0f*(fEffects[PlayerOptions::EFFECT_PULSE_OFFSET]);
+		const float fWavelength = 0.4f*(ARROW_SIZE+(fEffects[PlayerOptions::EFFECT_PULSE_PERIOD]*ARROW_SIZE));
+		const float fOuter = fEffects[PlayerOptions::EFFECT_PULSE_OUTER]*0.5f;
+		const float fPulseInner = ArrowEffects::GetPulseInner();
+		for( unsigned i = 0; i < iCount; ++i )
+		{
+			float sine = std::sin(((fYOffset[i]+fOffset)/fWavelength));
+			fZoom[i] *= (sine*fOuter)+fPulseInner;
+		}
 	}
-	if( curr_options->m_bZBuffer ||
-		fEffects[PlayerOptions::EFFECT_ATTENUATE_Z] != 0 )
+	if( fEffects[PlayerOptions::EFFECT_SHRINK_TO_MULT] != 0 )
 	{
-		return true;
+		const float fShrink = fEffects[PlayerOptions::EFFECT_SHRINK_TO_MULT]/100.0f;
+		for( unsigned i = 0; i < iCount; ++i )
+			if( fYOffset[i] >= 0 )
+				fZoom[i] *= 1/(1+(fYOffset[i]*fShrink));
 	}
-	if( fEffects[PlayerOptions::EFFECT_BOUNCE_Z] != 0 )
+	if( fEffects[PlayerOptions::EFFECT_SHRINK_TO_LINEAR] != 0 )
 	{
-		return true;
+		const float fShrink = 0.5f*fEffects[PlayerOptions::EFFECT_SHRINK_TO_LINEAR]/ARROW_SIZE;
+		for( unsigned i = 0; i < iCount; ++i )
+			if( fYOffset[i] >= 0 )
+				fZoom[i] += fYOffset[i]*fShrink;
 	}
-	return false;
 }
 
-float ArrowEffects::GetZoom( const PlayerState* pPlayerState, float fYOffset, int iCol )
+static void GetZoomBatch( const ArrowEffects::FrameContext &context, const float *fYOffset, float *fOut, unsigned iCount )
 {
-	float fZoom = 1.0f;
 	// Design change:  Instead of having a flag in the style that toggles a
 	// fixed zoom (0.6) that is only applied to the columns, ScreenGameplay now
 	// calculates a zoom factor to apply to the notefield and puts it in the
 	// PlayerState. -Kyz
-	fZoom*= pPlayerState->m_NotefieldZoom;
+	for( unsigned i = 0; i < iCount; ++i )
+	{
+		fOut[i] = 1.0f;
+		fOut[i] *= context.m_pPlayerState->m_NotefieldZoom;
+	}
+	if( !context.IsOn(ArrowEffects::FrameContext::MOD_ZOOM) )
+		return;
 
-	fZoom = GetZoomVariable( fYOffset, iCol, fZoom);
+	const int iCol = context.m_iCol;
+	ApplyZoomVariable( fYOffset, fOut, iCount );
 
-	float fTinyPercent = curr_options->m_fEffects[PlayerOptions::EFFECT_TINY];
-	if( fTinyPercent != 0 )
+	if( curr_options->m_fEffects[PlayerOptions::EFFECT_TINY] != 0 )
 	{
-		fTinyPercent = std::pow( 0.5f, fTinyPercent );
-		fZoom *= fTinyPercent;
+		const float fTinyPercent = std::pow( 0.5f, curr_options->m_fEffects[PlayerOptions::EFFECT_TINY] );
+		for( unsigned i = 0; i < iCount; ++i )
+			fOut[i] *= fTinyPercent;
 	}
 	if( curr_options->m_fTiny[iCol] != 0 )
 	{
-		fTinyPercent = std::pow( 0.5f, curr_options->m_fTiny[iCol] );
-		fZoom *= fTinyPercent;
+		const float fTinyPercent = std::pow( 0.5f, curr_options->m_fTiny[iCol] );
+		for( unsigned i = 0; i < iCount; ++i )
+			fOut[i] *= fTinyPercent;
 	}
-	return fZoom;
 }
 
-float ArrowEffects::GetZoomVariable( float fYOffset, int iCol, float fCurZoom )
+/* GetAlpha and GetGlow.  fYPosWithoutReverse and fPercentVisible are scratch
+ * space. */
+static void GetAlphaAndGlowBatch( const ArrowEffects::FrameContext &context, const float *fYOffset, const float *fPercentFadeToFail,
+	float *fYPosWithoutReverse, float *fPercentVisible, float *fAlphaOut, float *fGlowOut, unsigned iCount,
+	float fDrawDistanceBeforeTargetsPixels, float fFadeInPercentOfDrawFar )
 {
-	float fZoom = fCurZoom;
-	if( curr_options->m_fEffects[PlayerOptions::EFFECT_PULSE_INNER] != 0 || curr_options->m_fEffects[PlayerOptions::EFFECT_PULSE_OUTER] != 0 )
+	// Get the YPos without reverse (that is, factor in EFFECT_TIPSY).
+	GetYPosBatch( context, fYOffset, fYPosWithoutReverse, iCount, false );
+	GetPercentVisibleBatch( context, fYPosWithoutReverse, fYOffset, fPercentVisible, iCount );
+	const float fFullAlphaY = fDrawDistanceBeforeTargetsPixels*(1-fFadeInPercentOfDrawFar);
+	for( unsigned i = 0; i < iCount; ++i )
 	{
-		float sine = std::sin(((fYOffset+(100.0f*(curr_options->m_fEffects[PlayerOptions::EFFECT_PULSE_OFFSET])))/(0.4f*(ARROW_SIZE+(curr_options->m_fEffects[PlayerOptions::EFFECT_PULSE_PERIOD]*ARROW_SIZE)))));
+		if( fPercentFadeToFail[i] != -1 )
+			fPercentVisible[i] = 1 - fPercentFadeToFail[i];
+
+		if( fYPosWithoutReverse[i] > fFullAlphaY )
+			fAlphaOut[i] = SCALE( fYPosWithoutReverse[i], fFullAlphaY, fDrawDistanceBeforeTargetsPixels, 1.0f, 0.0f );
+		else
+			fAlphaOut[i] = (fPercentVisible[i]>0.5f) ? 1.0f : 0.0f;
 
-		fZoom *= (sine*(curr_options->m_fEffects[PlayerOptions::EFFECT_PULSE_OUTER]*0.5f))+GetPulseInner();
+		const float fDistFromHalf = std::abs( fPercentVisible[i] - 0.5f );
+		fGlowOut[i] = SCALE( fDistFromHalf, 0, 0.5f, 1.3f, 0 );
 	}
-	if( curr_options->m_fEffects[PlayerOptions::EFFECT_SHRINK_TO_MULT] !=0 && fYOffset >= 0 )
-		fZoom *= 1/(1+(fYOffset*(curr_options->m_fEffects[PlayerOptions::EFFECT_SHRINK_TO_MULT]/100.0f)));
+}
 
-	if( curr_options->m_fEffects[PlayerOptions::EFFECT_SHRINK_TO_LINEAR] !=0 && fYOffset >= 0 )
-		fZoom += fYOffset*(0.5f*curr_options->m_fEffects[PlayerOptions::EFFECT_SHRINK_TO_LINEAR]/ARROW_SIZE);
-	return fZoom;
+void ArrowEffects::GetNoteEffects( const FrameContext &context, NoteBatch &batch, float fDrawDistanceBeforeTargetsPixels, float fFadeInPercentOfDrawFar )
+{
+	const unsigned iCount = batch.Size();
+	if( iCount == 0 )
+		return;
+	const float *fYOffset = batch.m_fYOffset.data();
+	const int iCol = context.m_iCol;
+
+	// GetXYZPos
+	GetXPosBatch( context, fYOffset, batch.m_fX.data(), iCount );
+	GetYPosBatch( context, fYOffset, batch.m_fY.data(), iCount, true );
+	GetZPosBatch( context, fYOffset, batch.m_fZ.data(), iCount );
+	const float fMoveX = GetMoveX(iCol), fMoveY = GetMoveY(iCol), fMoveZ = GetMoveZ(iCol);
+	for( unsigned i = 0; i < iCount; ++i )
+	{
+		batch.m_fX[i] = fMoveX + batch.m_fX[i];
+		batch.m_fY[i] = fMoveY + batch.m_fY[i];
+		batch.m_fZ[i] = fMoveZ + batch.m_fZ[i];
+	}
+
+	GetRotationXBatch( context, fYOffset, batch.m_bIsHoldCap.data(), batch.m_fRotationX.data(), iCount );
+	GetRotationYBatch( context, fYOffset, batch.m_fRotationY.data(), iCount );
+	GetRotationZBatch( context, batch.m_fBeat.data(), batch.m_bIsHoldHead.data(), batch.m_fRotationZ.data(), iCount );
+	GetZoomBatch( context, fYOffset, batch.m_fZoom.data(), iCount );
+	GetAlphaAndGlowBatch( context, fYOffset, batch.m_fPercentFadeToFail.data(),
+		batch.m_fYPosWithoutReverse.data(), batch.m_fTemp.data(), batch.m_fAlpha.data(), batch.m_fGlow.data(), iCount,
+		fDrawDistanceBeforeTargetsPixels, fFadeInPercentOfDrawFar );
 }
 
-float ArrowEffects::GetPulseInner()
+// The per-note functions: the batch functions above for one note.
+
+/* For visibility testing: if bAbsolute is false, random modifiers must return
+ * the minimum possible scroll speed. */
+float ArrowEffects::GetYOffset( const FrameContext &context, float fNoteBeat, float &fPeakYOffsetOut, bool &bIsPastPeakOut, bool bAbsolute )
 {
-	float fPulseInner = 1.0f;
-	if( curr_options->m_fEffects[PlayerOptions::EFFECT_PULSE_INNER] != 0 || curr_options->m_fEffects[PlayerOptions::EFFECT_PULSE_OUTER] != 0 )
-	{
-		fPulseInner = ((curr_options->m_fEffects[PlayerOptions::EFFECT_PULSE_INNER]*0.5f)+1);
-		if (fPulseInner == 0)
-		{
-			fPulseInner = 0.01f;
-		}
-	}
-	return fPulseInner;
+	float fYOffset, fYAdjust;
+	CalculateYOffsets( context, &fNoteBeat, &fYOffset, &fYAdjust, 1, bAbsolute, &fPeakYOffsetOut, &bIsPastPeakOut );
+	return fYOffset;
 }
 
-static ThemeMetric<float>	FRAME_WIDTH_EFFECTS_PIXELS_PER_SECOND( "ArrowEffects", "FrameWidthEffectsPixelsPerSecond" );
-static ThemeMetric<float>	FRAME_WIDTH_EFFECTS_MIN_MULTIPLIER( "ArrowEffects", "FrameWidthEffectsMinMultiplier" );
-static ThemeMetric<float>	FRAME_WIDTH_EFFECTS_MAX_MULTIPLIER( "ArrowEffects", "FrameWidthEffectsMaxMultiplier" );
-static ThemeMetric<bool>	FRAME_WIDTH_LOCK_EFFECTS_TO_OVERLAPPING( "ArrowEffects", "FrameWidthLockEffectsToOverlapping" );
-static ThemeMetric<float>	FRAME_WIDTH_LOCK_EFFECTS_TWEEN_PIXELS( "ArrowEffects", "FrameWidthLockEffectsTweenPixels" );
+float ArrowEffects::GetXPos( const FrameContext &context, float fYOffset )
+{
+	float fXPos;
+	GetXPosBatch( context, &fYOffset, &fXPos, 1 );
+	return fXPos;
+}
 
-float ArrowEffects::GetFrameWidthScale( const PlayerState* pPlayerState, float fYOffset, float fOverlappedTime )
+float ArrowEffects::GetYPos( const FrameContext &context, float fYOffset, bool WithReverse )
 {
-	float fFrameWidthMultiplier = 1.0f;
+	float fYPos;
+	GetYPosBatch( context, &fYOffset, &fYPos, 1, WithReverse );
+	return fYPos;
+}
 
-	float fPixelsPerSecond = FRAME_WIDTH_EFFECTS_PIXELS_PER_SECOND;
-	float fSecond = fYOffset / fPixelsPerSecond;
-	float fWidthEffect = pPlayerState->m_EffectHistory.GetSample( fSecond );
-	if( fWidthEffect != 0 && FRAME_WIDTH_LOCK_EFFECTS_TO_OVERLAPPING )
-	{
-		// Don't display effect data that happened before this hold overlapped the top.
-		float fFromEndOfOverlapped = fOverlappedTime - fSecond;
-		float fTrailingPixels = FRAME_WIDTH_LOCK_EFFECTS_TWEEN_PIXELS;
-		float fTrailingSeconds = fTrailingPixels / fPixelsPerSecond;
-		float fScaleEffect = SCALE( fFromEndOfOverlapped, 0.0f, fTrailingSeconds, 0.0f, 1.0f );
-		CLAMP( fScaleEffect, 0.0f, 1.0f );
-		fWidthEffect *= fScaleEffect;
-	}
+float ArrowEffects::GetZPos( const FrameContext &context, float fYOffset )
+{
+	float fZPos;
+	GetZPosBatch( context, &fYOffset, &fZPos, 1 );
+	return fZPos;
+}
 
-	if( fWidthEffect > 0 )
-		fFrameWidthMultiplier *= SCALE( fWidthEffect, 0.0f, 1.0f, 1.0f, FRAME_WIDTH_EFFECTS_MAX_MULTIPLIER );
-	else if( fWidthEffect < 0 )
-		fFrameWidthMultiplier *= SCALE( fWidthEffect, 0.0f, -1.0f, 1.0f, FRAME_WIDTH_EFFECTS_MIN_MULTIPLIER );
+float ArrowEffects::GetRotationX( const FrameContext &context, float fYOffset, bool bIsHoldCap )
+{
+	const unsigned char bCap = bIsHoldCap;
+	float fRotation;
+	GetRotationXBatch( context, &fYOffset, &bCap, &fRotation, 1 );
+	return fRotation;
+}
 
-	return fFrameWidthMultiplier;
+float ArrowEffects::GetRotationY( const FrameContext &context, float fYOffset )
+{
+	float fRotation;
+	GetRotationYBatch( context, &fYOffset, &fRotation, 1 );
+	return fRotation;
+}
+
+float ArrowEffects::GetRotationZ( const FrameContext &context, float fNoteBeat, bool bIsHoldHead )
+{
+	const unsigned char bHead = bIsHoldHead;
+	float fRotation;
+	GetRotationZBatch( context, &fNoteBeat, &bHead, &fRotation, 1 );
+	return fRotation;
+}
+
+float ArrowEffects::GetZoom( const FrameContext &context, float fYOffset )
+{
+	float fZoom;
+	GetZoomBatch( context, &fYOffset, &fZoom, 1 );
+	return fZoom;
+}
+
+float ArrowEffects::GetZoomVariable( float fYOffset, int iCol, float fCurZoom )
+{
+	ApplyZoomVariable( &fYOffset, &fCurZoom, 1 );
+	return fCurZoom;
+}
+
+float ArrowEffects::GetAlpha( const FrameContext &context, float fYOffset, float fPercentFadeToFail, float fDrawDistanceBeforeTargetsPixels, float fFadeInPercentOfDrawFar )
+{
+	float fYPosWithoutReverse, fPercentVisible, fAlpha, fGlow;
+	GetAlphaAndGlowBatch( context, &fYOffset, &fPercentFadeToFail, &fYPosWithoutReverse, &fPercentVisible, &fAlpha, &fGlow, 1,
+		fDrawDistanceBeforeTargetsPixels, fFadeInPercentOfDrawFar );
+	return fAlpha;
+}
+
+float ArrowEffects::GetGlow( const FrameContext &context, float fYOffset, float fPercentFadeToFail, float fDrawDistanceBeforeTargetsPixels, float fFadeInPercentOfDrawFar )
+{
+	float fYPosWithoutReverse, fPercentVisible, fAlpha, fGlow;
+	GetAlphaAndGlowBatch( context, &fYOffset, &fPercentFadeToFail, &fYPosWithoutReverse, &fPercentVisible, &fAlpha, &fGlow, 1,
+		fDrawDistanceBeforeTargetsPixels, fFadeInPercentOfDrawFar );
+	return fGlow;
 }
 
 // To provide reasonable defaults to methods below.
@@ -1448,15 +1803,23 @@ namespace
 		return fYReverseOffsetPixels;
 	}
 
+	// Sets the current options to ps's and loads a context for iCol.
+	ArrowEffects::FrameContext Context( PlayerState *ps, int iCol, float fYReverseOffsetPixels=0 )
+	{
+		ArrowEffects::SetCurrentOptions(&ps->m_PlayerOptions.GetCurrent());
+		ArrowEffects::FrameContext context;
+		context.Load( ps, iCol, fYReverseOffsetPixels );
+		return context;
+	}
+
 	// ( PlayerState ps, int iCol, float fNoteBeat )
 	int GetYOffset( lua_State *L )
 	{
 		PlayerState *ps = Luna<PlayerState>::check( L, 1 );
-		ArrowEffects::SetCurrentOptions(&ps->m_PlayerOptions.GetCurrent());
 		float fPeakYOffset;
 		bool bIsPastPeak;
 
-		lua_pushnumber( L, ArrowEffects::GetYOffset( ps, IArg(2)-1, FArg(3), fPeakYOffset, bIsPastPeak ) );
+		lua_pushnumber( L, ArrowEffects::GetYOffset( Context(ps, IArg(2)-1), FArg(3), fPeakYOffset, bIsPastPeak ) );
 		lua_pushnumber( L, fPeakYOffset );
 		lua_pushboolean( L, bIsPastPeak );
 		return 3;
@@ -1467,8 +1830,7 @@ namespace
 	{
 		PlayerState *ps = Luna<PlayerState>::check( L, 1 );
 		float fYReverseOffsetPixels = YReverseOffset( L, 4 );
-		ArrowEffects::SetCurrentOptions(&ps->m_PlayerOptions.GetCurrent());
-		lua_pushnumber(L, ArrowEffects::GetYPos(ps, IArg(2)-1, FArg(3), fYReverseOffsetPixels));
+		lua_pushnumber(L, ArrowEffects::GetYPos(Context(ps, IArg(2)-1, fYReverseOffsetPixels), FArg(3)));
 		return 1;
 	}
 
@@ -1476,9 +1838,8 @@ namespace
 	int GetYOffsetFromYPos( lua_State *L )
 	{
 		PlayerState *ps = Luna<PlayerState>::check( L, 1 );
-		ArrowEffects::SetCurrentOptions(&ps->m_PlayerOptions.GetCurrent());
 		float fYReverseOffsetPixels = YReverseOffset( L, 4 );
-		lua_pushnumber(L, ArrowEffects::GetYOffsetFromYPos(IArg(2)-1, FArg(3), fYReverseOffsetPixels));
+		lua_pushnumber(L, ArrowEffects::GetYOffsetFromYPos(Context(ps, IArg(2)-1, fYReverseOffsetPixels), FArg(3)));
 		return 1;
 	}
 
@@ -1486,8 +1847,7 @@ namespace
 	int GetXPos( lua_State *L )
 	{
 		PlayerState *ps = Luna<PlayerState>::check( L, 1 );
-		ArrowEffects::SetCurrentOptions(&ps->m_PlayerOptions.GetCurrent());
-		lua_pushnumber( L, ArrowEffects::GetXPos( ps, IArg(2)-1, FArg(3) ) );
+		lua_pushnumber( L, ArrowEffects::GetXPos( Context(ps, IArg(2)-1), FArg(3) ) );
 		return 1;
 	}
 
@@ -1495,8 +1855,7 @@ namespace
 	int GetZPos( lua_State *L )
 	{
 		PlayerState *ps = Luna<PlayerState>::check( L, 1 );
-		ArrowEffects::SetCurrentOptions(&ps->m_PlayerOptions.GetCurrent());
-		lua_pushnumber(L, ArrowEffects::GetZPos( ps, IArg(2)-1, FArg(3)));
+		lua_pushnumber(L, ArrowEffects::GetZPos( Context(ps, IArg(2)-1), FArg(3)));
 		return 1;
 	}
 
@@ -1504,9 +1863,8 @@ namespace
 	int GetRotationX( lua_State *L )
 	{
 		PlayerState *ps = Luna<PlayerState>::check( L, 1 );
-		ArrowEffects::SetCurrentOptions(&ps->m_PlayerOptions.GetCurrent());
 		bool bIsHoldCap = false;
-		lua_pushnumber(L, ArrowEffects::GetRotationX(ps,FArg(2), bIsHoldCap, IArg(3)-1));
+		lua_pushnumber(L, ArrowEffects::GetRotationX(Context(ps, IArg(3)-1), FArg(2), bIsHoldCap));
 		return 1;
 	}
 
@@ -1514,8 +1872,7 @@ namespace
 	int GetRotationY( lua_State *L )
 	{
 		PlayerState *ps = Luna<PlayerState>::check( L, 1 );
-		ArrowEffects::SetCurrentOptions(&ps->m_PlayerOptions.GetCurrent());
-		lua_pushnumber(L, ArrowEffects::GetRotationY(ps, FArg(2), IArg(3)-1));
+		lua_pushnumber(L, ArrowEffects::GetRotationY(Context(ps, IArg(3)-1), FArg(2)));
 		return 1;
 	}
 
@@ -1523,14 +1880,13 @@ namespace
 	int GetRotationZ( lua_State *L )
 	{
 		PlayerState *ps = Luna<PlayerState>::check( L, 1 );
-		ArrowEffects::SetCurrentOptions(&ps->m_PlayerOptions.GetCurrent());
 		// Make bIsHoldHead optional.
 		bool bIsHoldHead = false;
 		if( lua_gettop(L) >= 3 && !lua_isnil(L, 3) )
 		{
 			bIsHoldHead = BArg(3);
 		}
-		lua_pushnumber( L, ArrowEffects::GetRotationZ( ps, FArg(2), bIsHoldHead, IArg(4)-1 ) );
+		lua_pushnumber( L, ArrowEffects::GetRotationZ( Context(ps, IArg(4)-1), FArg(2), bIsHoldHead ) );
 		return 1;
 	}
 
@@ -1547,7 +1903,6 @@ namespace
 	int GetAlpha( lua_State *L )
 	{
 		PlayerState *ps = Luna<PlayerState>::check( L, 1 );
-		ArrowEffects::SetCurrentOptions(&ps->m_PlayerOptions.GetCurrent());
 		// Provide reasonable default values.
 		float fPercentFadeToFail = -1;
 		float fYReverseOffsetPixels = YReverseOffset( L, 5 );
@@ -1565,7 +1920,7 @@ namespace
 		{
 			fFadeInPercentOfDrawFar = FArg(7);
 		}
-		lua_pushnumber(L, ArrowEffects::GetAlpha(ps, IArg(2)-1, FArg(3), fPercentFadeToFail, fYReverseOffsetPixels, fDrawDistanceBeforeTargetsPixels, fFadeInPercentOfDrawFar));
+		lua_pushnumber(L, ArrowEffects::GetAlpha(Context(ps, IArg(2)-1, fYReverseOffsetPixels), FArg(3), fPercentFadeToFail, fDrawDistanceBeforeTargetsPixels, fFadeInPercentOfDrawFar));
 		return 1;
 	}
 
@@ -1574,7 +1929,6 @@ namespace
 	int GetGlow( lua_State *L )
 	{
 		PlayerState *ps = Luna<PlayerState>::check( L, 1 );
-		ArrowEffects::SetCurrentOptions(&ps->m_PlayerOptions.GetCurrent());
 		// Provide reasonable default values.
 		float fPercentFadeToFail = -1; //
 		float fYReverseOffsetPixels = YReverseOffset( L, 5 );
@@ -1592,7 +1946,7 @@ namespace
 		{
 			fFadeInPercentOfDrawFar = FArg(7);
 		}
-		lua_pushnumber( L, ArrowEffects::GetGlow(ps, IArg(2)-1, FArg(3), fPercentFadeToFail, fYReverseOffsetPixels, fDrawDistanceBeforeTargetsPixels, fFadeInPercentOfDrawFar ) );
+		lua_pushnumber( L, ArrowEffects::GetGlow(Context(ps, IArg(2)-1, fYReverseOffsetPixels), FArg(3), fPercentFadeToFail, fDrawDistanceBeforeTargetsPixels, fFadeInPercentOfDrawFar ) );
 		return 1;
 	}
 
@@ -1618,8 +1972,7 @@ namespace
 	int GetZoom( lua_State *L )
 	{
 		PlayerState *ps = Luna<PlayerState>::check( L, 1 );
-		ArrowEffects::SetCurrentOptions(&ps->m_PlayerOptions.GetCurrent());
-		lua_pushnumber( L, ArrowEffects::GetZoom( ps, FArg(2), IArg(3)-1 ) );
+		lua_pushnumber( L, ArrowEffects::GetZoom( Context(ps, IArg(3)-1), FArg(2) ) );
 		return 1;
 	}
 
@@ -3,9 +3,13 @@
 
 #include "RageTypes.h"
 #include "PlayerNumber.h"
+#include "Style.h"
+
+#include <vector>
 
 class PlayerState;
 class PlayerOptions;
+class TimingData;
 /** @brief Functions that return properties of arrows based on Style and PlayerOptions. */
 class ArrowEffects
 {
@@ -19,49 +23,105 @@ public:
 	// mods later. -Kyz
 	static void SetCurrentOptions(const PlayerOptions* options);
 
+	/* Everything the per-note functions below look up that doesn't depend on
+	 * the note: the song position, the mod timer, the scroll speed, where
+	 * reverse puts the column, the hidden and sudden lines, and which groups
+	 * of mods are on so a function can skip all of its terms at once.  Fill
+	 * one in for each column once a frame, after SetCurrentOptions, and pass
+	 * it to every query about that column. */
+	struct FrameContext
+	{
+		void Load( const PlayerState* pPlayerState, int iCol, float fYReverseOffsetPixels );
+
+		enum
+		{
+			MOD_YOFFSET= 1<<0,	// accels and speed mods in GetYOffset
+			MOD_XPOS= 1<<1,	// everything in GetXPos but the column offset and tiny
+			MOD_YPOS= 1<<2,	// GetYPos terms other than reverse and tipsy
+			MOD_ZPOS= 1<<3,
+			MOD_ROTATION_X= 1<<4,
+			MOD_ROTATION_Y= 1<<5,
+			MOD_ROTATION_Z= 1<<6,
+			MOD_ZOOM= 1<<7,	// everything in GetZoom but the field zoom
+			MOD_VISIBILITY= 1<<8,	// appearances that make ArrowGetPercentVisible return less than 1
+		};
+		bool IsOn( unsigned iMods ) const { return (m_iActiveMods & iMods) != 0; }
+
+		const PlayerState* m_pPlayerState;
+		int m_iCol;
+		const Style* m_pStyle;
+		const Style::ColumnInfo* m_pCols;
+		const TimingData* m_pTiming;
+
+		// The song position from PlayerState::GetDisplayedPosition, and where
+		// it's drawn.  m_fSongDisplayedBeat and m_fSpeedPercent are only
+		// worked out when beat spacing is used outside the editor.
+		float m_fSongBeat;
+		float m_fSongDisplayedBeat;
+		float m_fSpeedPercent;
+		// Time spacing: PlayerState::m_Position's seconds, and beats per second.
+		float m_fSongSeconds;
+		float m_fBPS;
+		// m_fScrollSpeed or what MaxScrollBPM makes it.
+		float m_fScrollSpeed;
+		// GetTime(), for drunk and blink.  The game timer keeps running while
+		// a frame is drawn, so it's read here once and every note in the
+		// column moves with the same time.
+		float m_fModTime;
+
+		float m_fReverseShift;
+		float m_fReverseScale;
+
+		float m_fCenterLine;
+		float m_fHiddenStartLine;
+		float m_fHiddenEndLine;
+		float m_fSuddenStartLine;
+		float m_fSuddenEndLine;
+
+		unsigned m_iActiveMods;
+	};
+
 	// fYOffset is a vertical position in pixels relative to the center
 	// (positive if has not yet been stepped on, negative if has already passed).
 	// The ArrowEffect and ScrollSpeed is applied in this stage.
-	static float GetYOffset( const PlayerState* pPlayerState, int iCol, float fNoteBeat, float &fPeakYOffsetOut, bool &bIsPastPeakYOffset, bool bAbsolute=false );
-	static float GetYOffset( const PlayerState* pPlayerState, int iCol, float fNoteBeat, bool bAbsolute=false )
+	static float GetYOffset( const FrameContext &context, float fNoteBeat, float &fPeakYOffsetOut, bool &bIsPastPeakYOffset, bool bAbsolute=false );
+	static float GetYOffset( const FrameContext &context, float fNoteBeat, bool bAbsolute=false )
 	{
 		float fThrowAway;
 		bool bThrowAway;
-		return GetYOffset( pPlayerState, iCol, fNoteBeat, fThrowAway, bThrowAway, bAbsolute );
+		return GetYOffset( context, fNoteBeat, fThrowAway, bThrowAway, bAbsolute );
 	}
 
-	static void GetXYZPos(const PlayerState* player_state, int col, float y_offset, float y_reverse_offset, RageVector3& ret, bool with_reverse= true)
+	static void GetXYZPos(const FrameContext& context, float y_offset, RageVector3& ret, bool with_reverse= true)
 	{
-		ret.x= GetMoveX(col) + GetXPos(player_state, col, y_offset);
-		ret.y= GetMoveY(col) + GetYPos(player_state, col, y_offset, y_reverse_offset, with_reverse);
-		ret.z= GetMoveZ(col) + GetZPos(player_state, col, y_offset);
+		ret.x= GetMoveX(context.m_iCol) + GetXPos(context, y_offset);
+		ret.y= GetMoveY(context.m_iCol) + GetYPos(context, y_offset, with_reverse);
+		ret.z= GetMoveZ(context.m_iCol) + GetZPos(context, y_offset);
 	}
 
 	/**
 	 * @brief Retrieve the actual display position.
 	 *
 	 * In this case, reverse and post-reverse-effects are factored in (fYOffset -> YPos). 
-	 * @param pPlayerState the Player's state in question, including mods.
-	 * @param iCol the specific arrow column.
+	 * @param context the column, its Player's state and the reverse offset.
 	 * @param fYOffset the original display position.
-	 * @param fYReverseOffsetPixels the amount offset due to reverse.
 	 * @param WithReverse a flag to see if the Reverse mod is on.
 	 * @return the actual display position. */
-	static float GetYPos(const PlayerState* pPlayerState, int iCol, float fYOffset, float fYReverseOffsetPixels, bool WithReverse = true );
+	static float GetYPos(const FrameContext &context, float fYOffset, bool WithReverse = true );
 
 	// Inverse of ArrowGetYPos (YPos -> fYOffset).
-	static float GetYOffsetFromYPos(int iCol, float YPos, float fYReverseOffsetPixels);
+	static float GetYOffsetFromYPos(const FrameContext &context, float YPos);
 
 	// fRotation is Z rotation of an arrow.  This will depend on the column of 
 	// the arrow and possibly the Arrow effect and the fYOffset (in the case of 
 	// EFFECT_DIZZY).
-	static float GetRotationZ(	const PlayerState* pPlayerState, float fNoteBeat, bool bIsHoldHead, int iCol );
+	static float GetRotationZ(	const FrameContext &context, float fNoteBeat, bool bIsHoldHead );
 	static float ReceptorGetRotationZ(	const PlayerState* pPlayerState, int iCol );
 
 	// Due to the handling logic for holds on Twirl, we need to use an offset instead.
 	// It's more intuitive for Roll to be based off offset, so use an offset there too.
-	static float GetRotationX(const PlayerState* pPlayerState, float fYOffset, bool bIsHoldCap, int iCol);
-	static float GetRotationY(const PlayerState* pPlayerState, float fYOffset, int iCol);
+	static float GetRotationX(const FrameContext &context, float fYOffset, bool bIsHoldCap);
+	static float GetRotationY(const FrameContext &context, float fYOffset);
 	
 	static float ReceptorGetRotationX(	const PlayerState* pPlayerState, int iCol);
 	static float ReceptorGetRotationY(	const PlayerState* pPlayerState, int iCol);
@@ -73,28 +133,27 @@ public:
 	// fXPos is a horizontal position in pixels relative to the center of the field.
 	// This depends on the column of the arrow and possibly the Arrow effect and
 	// fYPos (in the case of EFFECT_DRUNK).
-	static float GetXPos( const PlayerState* pPlayerState, int iCol, float fYOffset );
+	static float GetXPos( const FrameContext &context, float fYOffset );
 
 	/**
 	 * @brief Retrieve the Z position.
 	 *
 	 * This is normally 0. This is only visible with perspective modes.
-	 * @param pPlayerState the Player's state, including the mods.
-	 * @param iCol the specific arrow column.
+	 * @param context the column and its Player's state, including the mods.
 	 * @param fYPos the Y position of the arrow.
 	 * @return the Z position. */
-	static float GetZPos( const PlayerState* pPlayerState, int iCol, float fYPos);
+	static float GetZPos( const FrameContext &context, float fYPos);
 
 	// Enable this if any ZPos effects are enabled.
 	static bool NeedZBuffer();
 
 	// fAlpha is the transparency of the arrow.  It depends on fYPos and the 
 	// AppearanceType.
-	static float GetAlpha(const PlayerState* pPlayerState, int iCol, float fYPos, float fPercentFadeToFail, float fYReverseOffsetPixels, float fDrawDistanceBeforeTargetsPixels, float fFadeInPercentOfDrawFar);
+	static float GetAlpha(const FrameContext &context, float fYPos, float fPercentFadeToFail, float fDrawDistanceBeforeTargetsPixels, float fFadeInPercentOfDrawFar);
 
 	// fAlpha is the transparency of the arrow.  It depends on fYPos and the 
 	// AppearanceType.
-	static float GetGlow(const PlayerState* pPlayerState, int iCol, float fYPos, float fPercentFadeToFail, float fYReverseOffsetPixels, float fDrawDistanceBeforeTargetsPixels, float fFadeInPercentOfDrawFar );
+	static float GetGlow(const FrameContext &context, float fYPos, float fPercentFadeToFail, float fDrawDistanceBeforeTargetsPixels, float fFadeInPercentOfDrawFar );
 
 	/**
 	 * @brief Retrieve the current brightness.
@@ -106,11 +165,41 @@ public:
 	static float GetBrightness( const PlayerState* pPlayerState, float fNoteBeat );
 
 	// This is the zoom of the individual tracks, not of the whole Player.
-	static float GetZoom( const PlayerState* pPlayerState, float fYOffset, int iCol );
+	static float GetZoom( const FrameContext &context, float fYOffset );
 	static float GetZoomVariable( float fYOffset, int iCol, float fCurZoom );
 	static float GetPulseInner();
 
 	static float GetFrameWidthScale( const PlayerState* pPlayerState, float fYOffset, float fOverlappedTime );
+
+	/* A run of notes in one column, for working out everything NoteDisplay
+	 * needs to draw them at once.  The caller fills in the beats, fades and
+	 * hold flags; GetYOffsets and GetNoteEffects fill in the rest. */
+	struct NoteBatch
+	{
+		void Resize( unsigned iSize );
+		unsigned Size() const { return m_fBeat.size(); }
+
+		std::vector<float> m_fBeat;
+		std::vector<float> m_fPercentFadeToFail;
+		std::vector<unsigned char> m_bIsHoldHead;
+		std::vector<unsigned char> m_bIsHoldCap;
+
+		std::vector<float> m_fYOffset;
+		// GetXYZPos, with reverse.
+		std::vector<float> m_fX, m_fY, m_fZ;
+		std::vector<float> m_fRotationX, m_fRotationY, m_fRotationZ;
+		std::vector<float> m_fZoom;
+		std::vector<float> m_fAlpha, m_fGlow;
+
+		// Scratch space.
+		std::vector<float> m_fYPosWithoutReverse;
+		std::vector<float> m_fTemp;
+	};
+
+	/* The same as the functions above called for each note, but each mod is
+	 * looked at once for the whole run, and skipped if it's off. */
+	static void GetYOffsets( const FrameContext &context, NoteBatch &batch, bool bAbsolute=false );
+	static void GetNoteEffects( const FrameContext &context, NoteBatch &batch, float fDrawDistanceBeforeTargetsPixels, float fFadeInPercentOfDrawFar );
 };
 
 #endif
@@ -0,0 +1,129 @@
+/* BinaryCache - Reading and writing the values binary cache files are made of. */
+
+#ifndef BinaryCache_H
+#define BinaryCache_H
+
+#include "RageUtil.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+/* Integers and floats are little-endian, strings are a u32 length followed
+ * by the bytes, and arrays are a u32 count followed by the elements. */
+inline void WriteU32( RString &out, uint32_t i )
+{
+	i = Swap32LE( i );
+	out.append( reinterpret_cast<const char *>(&i), sizeof(i) );
+}
+
+inline void WriteI32( RString &out, int i )
+{
+	WriteU32( out, static_cast<uint32_t>(i) );
+}
+
+inline void WriteFloat( RString &out, float f )
+{
+	uint32_t i;
+	std::memcpy( &i, &f, sizeof(i) );
+	WriteU32( out, i );
+}
+
+inline void WriteBool( RString &out, bool b )
+{
+	out += b? '\1':'\0';
+}
+
+inline void WriteString( RString &out, const RString &s )
+{
+	WriteU32( out, s.size() );
+	out.append( s );
+}
+
+inline void WriteStringVector( RString &out, const std::vector<RString> &v )
+{
+	WriteU32( out, v.size() );
+	for( RString const &s : v )
+		WriteString( out, s );
+}
+
+/* Decodes values straight out of the file buffer.  Running off the end sets
+ * a flag and returns zeroes from then on, so callers can read a whole block
+ * and check Failed() once at the end, like FileReading does with sError. */
+class CacheReader
+{
+public:
+	CacheReader( const char *p, size_t iSize ): m_p(p), m_pEnd(p + iSize), m_bFailed(false) { }
+
+	bool Failed() const { return m_bFailed; }
+	bool AtEnd() const { return m_p == m_pEnd; }
+	void Fail() { m_bFailed = true; m_p = m_pEnd; }
+
+	uint32_t U32()
+	{
+		uint32_t i = 0;
+		if( !Need(sizeof(i)) )
+			return 0;
+		std::memcpy( &i, m_p, sizeof(i) );
+		m_p += sizeof(i);
+		return Swap32LE( i );
+	}
+	int I32() { return static_cast<int>( U32() ); }
+	float Float()
+	{
+		uint32_t i = U32();
+		float f;
+		std::memcpy( &f, &i, sizeof(f) );
+		return f;
+	}
+	bool Bool()
+	{
+		if( !Need(1) )
+			return false;
+		return *m_p++ != '\0';
+	}
+	RString String()
+	{
+		uint32_t iLen = U32();
+		if( !Need(iLen) )
+			return RString();
+		RString s( m_p, iLen );
+		m_p += iLen;
+		return s;
+	}
+	void StringVector( std::vector<RString> &out )
+	{
+		uint32_t iCount = Count();
+		out.clear();
+		out.reserve( iCount );
+		for( uint32_t i = 0; i < iCount; ++i )
+			out.push_back( String() );
+	}
+
+	/* An element count.  Every element takes at least one byte, so a count
+	 * larger than what's left is garbage; don't let it drive a huge reserve(). */
+	uint32_t Count()
+	{
+		uint32_t iCount = U32();
+		if( !Need(iCount) )
+			return 0;
+		return iCount;
+	}
+
+private:
+	bool Need( size_t iBytes )
+	{
+		if( m_bFailed || iBytes > static_cast<size_t>(m_pEnd - m_p) )
+		{
+			Fail();
+			return false;
+		}
+		return true;
+	}
+
+	const char *m_p;
+	const char *m_pEnd;
+	bool m_bFailed;
+};
+
+#endif
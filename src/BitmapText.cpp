@@ -12,6 +12,8 @@
 
 #include <cmath>
 #include <cstddef>
+#include <functional>
+#include <unordered_map>
 #include <vector>
 
 
@@ -243,63 +245,124 @@ bool BitmapText::LoadFromTextureAndChars( const RString& sTexturePath, const RSt
 	return true;
 }
 
-void BitmapText::BuildChars()
+// Break sText into lines, wrapped to iWrapWidthPixels unless that's -1.
+static void WrapLines( const Font *pFont, const RString &sText, int iWrapWidthPixels,
+	std::vector<std::wstring> &wTextLines )
 {
-	// If we don't have a font yet, we'll do this when it loads.
-	if( m_pFont == nullptr )
-		return;
+	wTextLines.clear();
+
+	if( iWrapWidthPixels == -1 )
+	{
+		split( RStringToWstring(sText), L"\n", wTextLines, false );
+	}
+	else
+	{
+		// Break sText into lines that don't exceed iWrapWidthPixels. (if only
+		// one word fits on the line, it may be larger than iWrapWidthPixels).
+
+		// This does not work in all languages:
+		/* "...I can add Japanese wrapping, at least. We could handle hyphens
+		 * and soft hyphens and pretty easily, too." -glenn */
+		// TODO: Move this wrapping logic into Font.
+		std::vector<RString> asLines;
+		split( sText, "\n", asLines, false );
+
+		for( unsigned line = 0; line < asLines.size(); ++line )
+		{
+			std::vector<RString> asWords;
+			split( asLines[line], " ", asWords );
+
+			RString sCurLine;
+			int iCurLineWidth = 0;
+
+			for( unsigned i=0; i<asWords.size(); i++ )
+			{
+				const RString &sWord = asWords[i];
+				int iWidthWord = pFont->GetLineWidthInSourcePixels( RStringToWstring(sWord) );
 
+				if( sCurLine.empty() )
+				{
+					sCurLine = sWord;
+					iCurLineWidth = iWidthWord;
+					continue;
+				}
+
+				RString sToAdd = " " + sWord;
+				int iWidthToAdd = pFont->GetLineWidthInSourcePixels(L" ") + iWidthWord;
+				if( iCurLineWidth + iWidthToAdd <= iWrapWidthPixels )	// will fit on current line
+				{
+					sCurLine += sToAdd;
+					iCurLineWidth += iWidthToAdd;
+				}
+				else
+				{
+					wTextLines.push_back( RStringToWstring(sCurLine) );
+					sCurLine = sWord;
+					iCurLineWidth = iWidthWord;
+				}
+			}
+			wTextLines.push_back( RStringToWstring(sCurLine) );
+		}
+	}
+}
+
+/* Work out the widths and size of wTextLines in pFont, and a quad for each
+ * glyph. */
+static void BuildGlyphs( const Font *pFont, const std::vector<std::wstring> &wTextLines,
+	int iVertSpacing, float fHorizAlign, std::vector<int> &iLineWidths, RageVector2 &size,
+	std::vector<RageSpriteVertex> &aVertices, std::vector<FontPageTextures*> &vpFontPageTextures )
+{
 	// calculate line lengths and widths
-	m_size.x = 0;
+	size.x = 0;
 
-	m_iLineWidths.clear();
-	for( unsigned l=0; l<m_wTextLines.size(); l++ ) // for each line
+	iLineWidths.clear();
+	for( unsigned l=0; l<wTextLines.size(); l++ ) // for each line
 	{
-		m_iLineWidths.push_back(m_pFont->GetLineWidthInSourcePixels( m_wTextLines[l] ));
-		m_size.x = std::max( m_size.x, (float) m_iLineWidths.back() );
+		iLineWidths.push_back(pFont->GetLineWidthInSourcePixels( wTextLines[l] ));
+		size.x = std::max( size.x, (float) iLineWidths.back() );
 	}
 
 	/* Ensure that the width is always even. This maintains pixel alignment;
 	 * fX below will always be an integer. */
-	m_size.x = QuantizeUp( m_size.x, 2.0f );
+	size.x = QuantizeUp( size.x, 2.0f );
 
-	m_aVertices.clear();
-	m_vpFontPageTextures.clear();
+	aVertices.clear();
+	vpFontPageTextures.clear();
 
-	if( m_wTextLines.empty() )
+	if( wTextLines.empty() )
 		return;
 
-	m_size.y = float(m_pFont->GetHeight() * m_wTextLines.size());
+	size.y = float(pFont->GetHeight() * wTextLines.size());
 
 	// The height (from the origin to the baseline):
-	int iPadding = m_pFont->GetLineSpacing() - m_pFont->GetHeight();
-	iPadding += m_iVertSpacing;
+	int iPadding = pFont->GetLineSpacing() - pFont->GetHeight();
+	iPadding += iVertSpacing;
 
 	// There's padding between every line:
-	m_size.y += iPadding * int(m_wTextLines.size()-1);
+	size.y += iPadding * int(wTextLines.size()-1);
 
 	// the top position of the first row of characters
-	int iY = std::lrint(-m_size.y/2.0f);
+	int iY = std::lrint(-size.y/2.0f);
 
-	for( unsigned i=0; i<m_wTextLines.size(); i++ ) // foreach line
+	for( unsigned i=0; i<wTextLines.size(); i++ ) // foreach line
 	{
-		iY += m_pFont->GetHeight();
+		iY += pFont->GetHeight();
 
-		std::wstring sLine = m_wTextLines[i];
-		if( m_pFont->IsRightToLeft() )
+		std::wstring sLine = wTextLines[i];
+		if( pFont->IsRightToLeft() )
 			reverse( sLine.begin(), sLine.end() );
-		const int iLineWidth = m_iLineWidths[i];
+		const int iLineWidth = iLineWidths[i];
 
-		float fX = SCALE( m_fHorizAlign, 0.0f, 1.0f, -m_size.x/2.0f, +m_size.x/2.0f - iLineWidth );
+		float fX = SCALE( fHorizAlign, 0.0f, 1.0f, -size.x/2.0f, +size.x/2.0f - iLineWidth );
 		int iX = std::lrint( fX );
 
 		for( unsigned j = 0; j < sLine.size(); ++j )
 		{
 			RageSpriteVertex v[4];
-			const glyph &g = m_pFont->GetGlyph( sLine[j] );
+			const glyph &g = pFont->GetGlyph( sLine[j] );
 
 			// Advance the cursor early for RTL(?)
-			if( m_pFont->IsRightToLeft() )
+			if( pFont->IsRightToLeft() )
 				iX -= g.m_iHadvance;
 
 			// set vertex positions
@@ -309,7 +372,7 @@ void BitmapText::BuildChars()
 			v[3].p = RageVector3( iX+g.m_fHshift+g.m_fWidth,	iY+g.m_pPage->m_fVshift,		0 );	// top right
 
 			// Advance the cursor.
-			if( !m_pFont->IsRightToLeft() )
+			if( !pFont->IsRightToLeft() )
 				iX += g.m_iHadvance;
 
 			// set texture coordinates
@@ -318,13 +381,23 @@ void BitmapText::BuildChars()
 			v[2].t = RageVector2( g.m_TexRect.right,	g.m_TexRect.bottom );
 			v[3].t = RageVector2( g.m_TexRect.right,	g.m_TexRect.top );
 
-			m_aVertices.insert( m_aVertices.end(), &v[0], &v[4] );
-			m_vpFontPageTextures.push_back( g.GetFontPageTextures() );
+			aVertices.insert( aVertices.end(), &v[0], &v[4] );
+			vpFontPageTextures.push_back( g.GetFontPageTextures() );
 		}
 
 		// The amount of padding a line needs:
 		iY += iPadding;
 	}
+}
+
+void BitmapText::BuildChars()
+{
+	// If we don't have a font yet, we'll do this when it loads.
+	if( m_pFont == nullptr )
+		return;
+
+	BuildGlyphs( m_pFont, m_wTextLines, m_iVertSpacing, m_fHorizAlign,
+		m_iLineWidths, m_size, m_aVertices, m_vpFontPageTextures );
 
 	if( m_bUsingDistortion )
 	{
@@ -428,11 +501,12 @@ void BitmapText::DrawChars( bool bUseStrokeTexture )
 		bool bHaveATexture = !bUseStrokeTexture  ||  (bUseStrokeTexture && m_vpFontPageTextures[start]->m_pTextureStroke);
 		if( bHaveATexture )
 		{
-			DISPLAY->ClearAllTextures();
+			// Consecutive texts on the same page are drawn together, so don't
+			// unbind the page in between.
 			if( bUseStrokeTexture )
-				DISPLAY->SetTexture( TextureUnit_1, m_vpFontPageTextures[start]->m_pTextureStroke->GetTexHandle() );
+				DISPLAY->SetSingleTexture( m_vpFontPageTextures[start]->m_pTextureStroke->GetTexHandle() );
 			else
-				DISPLAY->SetTexture( TextureUnit_1, m_vpFontPageTextures[start]->m_pTextureMain->GetTexHandle() );
+				DISPLAY->SetSingleTexture( m_vpFontPageTextures[start]->m_pTextureMain->GetTexHandle() );
 
 			// Don't bother setting texture render states for text. We never go outside of 0..1.
 			/* We should call SetTextureRenderStates because it does more than just setting
@@ -475,66 +549,85 @@ void BitmapText::SetText( const RString& _sText, const RString& _sAlternateText,
 	SetTextInternal();
 }
 
-void BitmapText::SetTextInternal()
-{
-	// Break the string into lines.
+/* Layouts are only kept for text short enough to be a label or a number;
+ * long blocks of text are set once and would only push those out. */
+static const size_t MAX_CACHED_TEXT_LENGTH = 256;
+static const size_t MAX_CACHED_LAYOUTS = 4096;
 
-	m_wTextLines.clear();
+struct GlyphLayoutKey
+{
+	unsigned m_iFontGeneration;
+	RString m_sText;
+	int m_iWrapWidthPixels;
+	int m_iVertSpacing;
+	float m_fHorizAlign;
 
-	if( m_iWrapWidthPixels == -1 )
+	bool operator==( const GlyphLayoutKey &other ) const
 	{
-		split( RStringToWstring(m_sText), L"\n", m_wTextLines, false );
+		return m_iFontGeneration == other.m_iFontGeneration && m_sText == other.m_sText &&
+			m_iWrapWidthPixels == other.m_iWrapWidthPixels && m_iVertSpacing == other.m_iVertSpacing &&
+			m_fHorizAlign == other.m_fHorizAlign;
 	}
-	else
-	{
-		// Break sText into lines that don't exceed iWrapWidthPixels. (if only
-		// one word fits on the line, it may be larger than iWrapWidthPixels).
-
-		// This does not work in all languages:
-		/* "...I can add Japanese wrapping, at least. We could handle hyphens
-		 * and soft hyphens and pretty easily, too." -glenn */
-		// TODO: Move this wrapping logic into Font.
-		std::vector<RString> asLines;
-		split( m_sText, "\n", asLines, false );
-
-		for( unsigned line = 0; line < asLines.size(); ++line )
-		{
-			std::vector<RString> asWords;
-			split( asLines[line], " ", asWords );
+};
 
-			RString sCurLine;
-			int iCurLineWidth = 0;
+struct GlyphLayoutKeyHash
+{
+	size_t operator()( const GlyphLayoutKey &key ) const
+	{
+		// The text tells layouts apart; the rest are nearly always the same.
+		return std::hash<std::string>()( key.m_sText ) ^ (key.m_iFontGeneration * 2654435761u);
+	}
+};
+static std::unordered_map<GlyphLayoutKey, BitmapText::GlyphLayout, GlyphLayoutKeyHash> g_GlyphLayoutCache;
 
-			for( unsigned i=0; i<asWords.size(); i++ )
-			{
-				const RString &sWord = asWords[i];
-				int iWidthWord = m_pFont->GetLineWidthInSourcePixels( RStringToWstring(sWord) );
+void BitmapText::LayOut( const Font *pFont, const RString &sText, int iWrapWidthPixels,
+	int iVertSpacing, float fHorizAlign, GlyphLayout &out )
+{
+	WrapLines( pFont, sText, iWrapWidthPixels, out.m_wTextLines );
+	out.m_size = RageVector2( 0, 0 );
+	BuildGlyphs( pFont, out.m_wTextLines, iVertSpacing, fHorizAlign,
+		out.m_iLineWidths, out.m_size, out.m_aVertices, out.m_vpFontPageTextures );
+}
 
-				if( sCurLine.empty() )
-				{
-					sCurLine = sWord;
-					iCurLineWidth = iWidthWord;
-					continue;
-				}
+const BitmapText::GlyphLayout &BitmapText::GetLayout( const Font *pFont, const RString &sText,
+	int iWrapWidthPixels, int iVertSpacing, float fHorizAlign )
+{
+	const GlyphLayoutKey key = { pFont->GetGeneration(), sText, iWrapWidthPixels, iVertSpacing, fHorizAlign };
+	std::unordered_map<GlyphLayoutKey, GlyphLayout, GlyphLayoutKeyHash>::const_iterator it = g_GlyphLayoutCache.find( key );
+	if( it != g_GlyphLayoutCache.end() )
+		return it->second;
+
+	/* Start over when it fills up, rather than keep track of what was used
+	 * last; the strings that are shown every frame come right back. Layouts
+	 * of fonts that have since been unloaded go the same way. */
+	if( g_GlyphLayoutCache.size() >= MAX_CACHED_LAYOUTS )
+		g_GlyphLayoutCache.clear();
+
+	GlyphLayout &layout = g_GlyphLayoutCache[key];
+	LayOut( pFont, sText, iWrapWidthPixels, iVertSpacing, fHorizAlign, layout );
+	return layout;
+}
 
-				RString sToAdd = " " + sWord;
-				int iWidthToAdd = m_pFont->GetLineWidthInSourcePixels(L" ") + iWidthWord;
-				if( iCurLineWidth + iWidthToAdd <= m_iWrapWidthPixels )	// will fit on current line
-				{
-					sCurLine += sToAdd;
-					iCurLineWidth += iWidthToAdd;
-				}
-				else
-				{
-					m_wTextLines.push_back( RStringToWstring(sCurLine) );
-					sCurLine = sWord;
-					iCurLineWidth = iWidthWord;
-				}
-			}
-			m_wTextLines.push_back( RStringToWstring(sCurLine) );
+void BitmapText::SetTextInternal()
+{
+	// Distortion moves each glyph at random, so those can't be shared.
+	if( !m_bUsingDistortion && m_sText.size() <= MAX_CACHED_TEXT_LENGTH )
+	{
+		const GlyphLayout &layout = GetLayout( m_pFont, m_sText, m_iWrapWidthPixels, m_iVertSpacing, m_fHorizAlign );
+		// With no lines, BuildChars leaves the height alone; let it.
+		if( !layout.m_wTextLines.empty() )
+		{
+			m_wTextLines = layout.m_wTextLines;
+			m_iLineWidths = layout.m_iLineWidths;
+			m_size = layout.m_size;
+			m_aVertices = layout.m_aVertices;
+			m_vpFontPageTextures = layout.m_vpFontPageTextures;
+			UpdateBaseZoom();
+			return;
 		}
 	}
 
+	WrapLines( m_pFont, m_sText, m_iWrapWidthPixels, m_wTextLines );
 	BuildChars();
 	UpdateBaseZoom();
 }
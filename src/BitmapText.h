@@ -110,6 +110,25 @@ public:
 	void AddAttribute( size_t iPos, const Attribute &attr );
 	void ClearAttributes();
 
+	/* What SetText works out from the text: the lines, their widths in
+	 * source pixels, the size, and a quad and page per glyph.  Colors are
+	 * filled in when drawing. */
+	struct GlyphLayout
+	{
+		std::vector<std::wstring>	m_wTextLines;
+		std::vector<int>		m_iLineWidths;
+		RageVector2			m_size;
+		std::vector<RageSpriteVertex>	m_aVertices;
+		std::vector<FontPageTextures*>	m_vpFontPageTextures;
+	};
+	static void LayOut( const Font *pFont, const RString &sText, int iWrapWidthPixels,
+		int iVertSpacing, float fHorizAlign, GlyphLayout &out );
+	/* The same, kept for every BitmapText to share, so that counters and
+	 * the like that go back to a string they've shown before don't lay it
+	 * out again.  The result is good until the next call. */
+	static const GlyphLayout &GetLayout( const Font *pFont, const RString &sText,
+		int iWrapWidthPixels, int iVertSpacing, float fHorizAlign );
+
 	// Commands
 	virtual void PushSelf( lua_State *L ) override;
 
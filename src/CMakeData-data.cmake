@@ -15,11 +15,13 @@ source_group("Data Structures\\\\Lua"
 
 list(APPEND SM_DATA_FONT_SRC
             "Font.cpp"
+            "FontCache.cpp"
             "FontCharAliases.cpp"
             "FontCharmaps.cpp")
 
 list(APPEND SM_DATA_FONT_HPP
             "Font.h"
+            "FontCache.h"
             "FontCharAliases.h"
             "FontCharmaps.h")
 
@@ -53,12 +55,17 @@ list(APPEND SM_DATA_NOTEDATA_SRC
             "NoteData.cpp"
             "NoteDataUtil.cpp"
             "NoteDataWithScoring.cpp"
+            "JudgmentIndex.cpp"
+            "NoteFieldCache.cpp"
             "ColumnCues.cpp")
 
 list(APPEND SM_DATA_NOTEDATA_HPP
             "NoteData.h"
             "NoteDataUtil.h"
             "NoteDataWithScoring.h"
+            "JudgmentIndex.h"
+            "NoteFieldCache.h"
+            "NoteTrack.h"
             "ColumnCues.h")
 
 source_group("Data Structures\\\\Note Data"
@@ -69,6 +76,7 @@ source_group("Data Structures\\\\Note Data"
 list(APPEND SM_DATA_NOTELOAD_SRC
             "NotesLoader.cpp"
             "NotesLoaderBMS.cpp"
+            "NotesLoaderCache.cpp"
             "NotesLoaderDWI.cpp"
             "NotesLoaderJson.cpp"
             "NotesLoaderKSF.cpp"
@@ -79,6 +87,7 @@ list(APPEND SM_DATA_NOTELOAD_SRC
 list(APPEND SM_DATA_NOTELOAD_HPP
             "NotesLoader.h"
             "NotesLoaderBMS.h"
+            "NotesLoaderCache.h"
             "NotesLoaderDWI.h"
             "NotesLoaderJson.h"
             "NotesLoaderKSF.h"
@@ -92,12 +101,14 @@ source_group("Data Structures\\\\Notes Loaders"
              ${SM_DATA_NOTELOAD_HPP})
 
 list(APPEND SM_DATA_NOTEWRITE_SRC
+            "NotesWriterCache.cpp"
             "NotesWriterDWI.cpp"
             "NotesWriterJson.cpp"
             "NotesWriterSM.cpp"
             "NotesWriterSSC.cpp")
 
 list(APPEND SM_DATA_NOTEWRITE_HPP
+            "NotesWriterCache.h"
             "NotesWriterDWI.h"
             "NotesWriterJson.h"
             "NotesWriterSM.h"
@@ -128,6 +139,7 @@ source_group("Data Structures\\\\Score Keepers"
 list(APPEND SM_DATA_SONG_SRC
             "Song.cpp"
             "SongCacheIndex.cpp"
+            "SongFolderWatcher.cpp"
             "SongOptions.cpp"
             "SongPosition.cpp"
             "SongUtil.cpp")
@@ -135,6 +147,7 @@ list(APPEND SM_DATA_SONG_SRC
 list(APPEND SM_DATA_SONG_HPP
             "Song.h"
             "SongCacheIndex.h"
+            "SongFolderWatcher.h"
             "SongOptions.h"
             "SongPosition.h"
             "SongUtil.h")
@@ -145,12 +158,14 @@ source_group("Data Structures\\\\Songs"
              ${SM_DATA_SONG_HPP})
 
 list(APPEND SM_DATA_STEPS_SRC
+            "ChartResidencyManager.cpp"
             "Steps.cpp"
             "StepsUtil.cpp"
             "Style.cpp"
             "StyleUtil.cpp")
 
 list(APPEND SM_DATA_STEPS_HPP
+            "ChartResidencyManager.h"
             "Steps.h"
             "StepsUtil.h"
             "Style.h"
@@ -218,6 +233,7 @@ list(APPEND SM_DATA_REST_HPP
             "Attack.h"
             "AutoKeysounds.h"
             "BackgroundUtil.h"
+            "BinaryCache.h"
             "ImageCache.h"
             "Character.h"
             "CodeDetector.h"
@@ -5,6 +5,7 @@ list(APPEND SMDATA_RAGE_UTILS_SRC
             "RageUtil_BackgroundLoader.cpp"
             "RageUtil_CharConversions.cpp"
             "RageUtil_FileDB.cpp"
+            "RageUtil_ThreadPool.cpp"
             "RageUtil_WorkerThread.cpp")
 
 list(APPEND SMDATA_RAGE_UTILS_HPP
@@ -15,6 +16,7 @@ list(APPEND SMDATA_RAGE_UTILS_HPP
             "RageUtil_CharConversions.h"
             "RageUtil_CircularBuffer.h"
             "RageUtil_FileDB.h"
+            "RageUtil_ThreadPool.h"
             "RageUtil_WorkerThread.h")
 
 source_group("Rage\\\\Utils"
@@ -53,6 +55,7 @@ list(APPEND SMDATA_RAGE_GRAPHICS_SRC
             "RageDisplay_Null.cpp"
             "RageDisplay_OGL.cpp"
             "RageDisplay_OGL_Helpers.cpp"
+            "RageDisplay_OGL_StreamingVertices.cpp"
             "RageModelGeometry.cpp"
             "RageSurface.cpp"
             "RageSurface_Load.cpp"
@@ -69,6 +72,7 @@ list(APPEND SMDATA_RAGE_GRAPHICS_SRC
             "RageSurfaceUtils_Palettize.cpp"
             "RageSurfaceUtils_Zoom.cpp"
             "RageTexture.cpp"
+            "RageTextureAtlas.cpp"
             "RageTextureID.cpp"
             "RageTextureManager.cpp"
             "RageTexturePreloader.cpp"
@@ -80,6 +84,7 @@ list(APPEND SMDATA_RAGE_GRAPHICS_HPP
             "RageDisplay_Null.h"
             "RageDisplay_OGL.h"
             "RageDisplay_OGL_Helpers.h"
+            "RageDisplay_OGL_StreamingVertices.h"
             "RageModelGeometry.h"
             "RageSurface.h"
             "RageSurface_Load.h"
@@ -96,6 +101,7 @@ list(APPEND SMDATA_RAGE_GRAPHICS_HPP
             "RageSurfaceUtils_Palettize.h"
             "RageSurfaceUtils_Zoom.h"
             "RageTexture.h"
+            "RageTextureAtlas.h"
             "RageTextureID.h"
             "RageTextureManager.h"
             "RageTexturePreloader.h"
@@ -0,0 +1,141 @@
+#include "global.h"
+#include "ChartResidencyManager.h"
+#include "GameState.h"
+#include "PrefsManager.h"
+#include "RageLog.h"
+#include "Steps.h"
+
+#include <vector>
+
+ChartResidencyManager *CHARTRESIDENCY = nullptr;	// global and accessible from anywhere in our program
+
+ChartResidencyManager::ChartResidencyManager():
+	m_iResidentBytes( 0 ),
+	m_iHits( 0 ),
+	m_iMisses( 0 ),
+	m_iEvictions( 0 ),
+	m_iThreadID( RageThread::GetCurrentThreadID() ),
+	m_Mutex( "ChartResidencyManager" ),
+	m_bEvicting( false )
+{
+}
+
+ChartResidencyManager::~ChartResidencyManager()
+{
+	LOG->Trace( "Chart residency: %llu hits, %llu misses, %llu evictions; %i charts (%u KB) resident.",
+		(unsigned long long) m_iHits, (unsigned long long) m_iMisses, (unsigned long long) m_iEvictions,
+		GetNumResident(), (unsigned) (m_iResidentBytes / 1024) );
+}
+
+bool ChartResidencyManager::IsOwnThread() const
+{
+	return RageThread::GetCurrentThreadID() == m_iThreadID;
+}
+
+bool ChartResidencyManager::IsPinned( const Steps *pSteps ) const
+{
+	if( GAMESTATE == nullptr )
+		return false;
+	FOREACH_PlayerNumber( pn )
+	{
+		if( GAMESTATE->m_pCurSteps[pn].Get() == pSteps )
+			return true;
+	}
+	return false;
+}
+
+void ChartResidencyManager::Hit( const Steps *pSteps )
+{
+	if( !IsOwnThread() )
+		return;
+
+	LockMut( m_Mutex );
+	std::unordered_map<const Steps *, Entry>::iterator it = m_Entries.find( pSteps );
+	if( it == m_Entries.end() )
+		return;
+	++m_iHits;
+	m_LRU.splice( m_LRU.begin(), m_LRU, it->second.lru );
+}
+
+void ChartResidencyManager::Loaded( const Steps *pSteps, std::size_t iBytes )
+{
+	if( !IsOwnThread() )
+		return;
+
+	{
+		LockMut( m_Mutex );
+		++m_iMisses;
+		std::unordered_map<const Steps *, Entry>::iterator it = m_Entries.find( pSteps );
+		if( it != m_Entries.end() )
+		{
+			m_iResidentBytes -= it->second.iBytes;
+			m_LRU.erase( it->second.lru );
+			m_Entries.erase( it );
+		}
+
+		m_LRU.push_front( pSteps );
+		Entry e = { m_LRU.begin(), iBytes };
+		m_Entries[pSteps] = e;
+		m_iResidentBytes += iBytes;
+	}
+
+	Evict();
+}
+
+void ChartResidencyManager::Released( const Steps *pSteps )
+{
+	LockMut( m_Mutex );
+	std::unordered_map<const Steps *, Entry>::iterator it = m_Entries.find( pSteps );
+	if( it == m_Entries.end() )
+		return;
+	m_iResidentBytes -= it->second.iBytes;
+	m_LRU.erase( it->second.lru );
+	m_Entries.erase( it );
+}
+
+void ChartResidencyManager::Evict()
+{
+	const int iBudgetMB = PREFSMAN->m_iChartMemoryBudgetMB;
+	if( iBudgetMB <= 0 || m_bEvicting )
+		return;
+	// Compress() leaves charts alone in the editor.
+	if( GAMESTATE != nullptr && GAMESTATE->m_bInStepEditor )
+		return;
+	const std::size_t iBudget = std::size_t(iBudgetMB) * 1024 * 1024;
+
+	/* Pick the victims first: Compress() calls back into Released(). */
+	std::vector<const Steps *> vpVictims;
+	{
+		LockMut( m_Mutex );
+		std::size_t iBytes = m_iResidentBytes;
+		/* Never the one just loaded, at the front. */
+		for( std::list<const Steps *>::reverse_iterator it = m_LRU.rbegin();
+			iBytes > iBudget && it != m_LRU.rend() && *it != m_LRU.front(); ++it )
+		{
+			if( IsPinned(*it) )
+				continue;
+			iBytes -= m_Entries[*it].iBytes;
+			vpVictims.push_back( *it );
+		}
+	}
+
+	m_bEvicting = true;
+	for( const Steps *pSteps : vpVictims )
+	{
+		pSteps->Compress();
+		/* Compress() calls Released() when it drops the note data.  Lights
+		 * charts are never compressed; stop tracking them, but they weren't
+		 * evicted. */
+		bool bCompressed;
+		{
+			LockMut( m_Mutex );
+			bCompressed = m_Entries.find( pSteps ) == m_Entries.end();
+		}
+		if( bCompressed )
+			++m_iEvictions;
+		else
+			Released( pSteps );
+	}
+	m_bEvicting = false;
+}
+
@@ -0,0 +1,81 @@
+/* ChartResidencyManager - Keeps decompressed note data within a memory budget. */
+
+#ifndef CHART_RESIDENCY_MANAGER_H
+#define CHART_RESIDENCY_MANAGER_H
+
+#include "RageThreads.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+
+class Steps;
+
+/* Once a chart has been decompressed, it used to stay that way until its
+ * song was unloaded; browsing the wheel for long enough would decompress
+ * everything.  Steps report here when they decompress their note data and
+ * when they let it go, and whenever the total is over ChartMemoryBudgetMB
+ * the least recently used charts are compressed again.
+ *
+ * Only charts that can be decompressed again are tracked: ones filled with
+ * Steps::SetNoteData (the editor, edits being built) are left alone.  The
+ * charts in GAMESTATE->m_pCurSteps are never evicted.  Players work on their
+ * own copy of the note data, so those are the only ones in use.
+ *
+ * Charts are only tracked and evicted on the thread that created this;
+ * songs being loaded on other threads compress their charts when they're
+ * done anyway. */
+class ChartResidencyManager
+{
+public:
+	ChartResidencyManager();
+	~ChartResidencyManager();
+
+	/* pSteps was already decompressed when asked for. */
+	void Hit( const Steps *pSteps );
+	/* pSteps has just decompressed iBytes of note data.  This may compress
+	 * other charts to stay within the budget. */
+	void Loaded( const Steps *pSteps, std::size_t iBytes );
+	/* pSteps has dropped its note data, or is going away. */
+	void Released( const Steps *pSteps );
+
+	/* Shown by ScreenStatsOverlay. */
+	std::size_t GetResidentBytes() const { return m_iResidentBytes; }
+	int GetNumResident() const { return (int) m_Entries.size(); }
+	uint64_t GetHits() const { return m_iHits; }
+	uint64_t GetMisses() const { return m_iMisses; }
+	uint64_t GetEvictions() const { return m_iEvictions; }
+
+private:
+	bool IsOwnThread() const;
+	bool IsPinned( const Steps *pSteps ) const;
+	void Evict();
+
+	struct Entry
+	{
+		std::list<const Steps *>::iterator lru;
+		std::size_t iBytes;
+	};
+	/* Most recently used first. */
+	std::list<const Steps *> m_LRU;
+	std::unordered_map<const Steps *, Entry> m_Entries;
+	std::size_t m_iResidentBytes;
+
+	uint64_t m_iHits;
+	uint64_t m_iMisses;
+	uint64_t m_iEvictions;
+
+	uint64_t m_iThreadID;
+	/* Steps can be deleted on any thread, so Released() takes this. */
+	RageMutex m_Mutex;
+	bool m_bEvicting;
+
+	// Swallow up warnings. If they must be used, define them.
+	ChartResidencyManager& operator=(const ChartResidencyManager& rhs);
+	ChartResidencyManager(const ChartResidencyManager& rhs);
+};
+
+extern ChartResidencyManager *CHARTRESIDENCY;	// global and accessible from anywhere in our program
+
+#endif
@@ -1,8 +1,10 @@
 #include "global.h"
 #include "Font.h"
+#include "FontCache.h"
 #include "IniFile.h"
 
 #include "RageTextureManager.h"
+#include "RageTimer.h"
 #include "RageUtil.h"
 #include "RageLog.h"
 #include "FontManager.h"
@@ -276,10 +278,16 @@ size_t Font::GetGlyphsThatFit(const std::wstring& line, int* width) const
 	return i;
 }
 
+static unsigned g_iNextGeneration = 0;
+
 Font::Font(): m_iRefCount(1), path(""), m_apPages(), m_pDefault(nullptr),
 	m_iCharToGlyph(), m_bRightToLeft(false), m_bDistanceField(false),
 	// strokes aren't shown by default, hence the Color.
-	m_DefaultStrokeColor(RageColor(0,0,0,0)), m_sChars("") {}
+	m_DefaultStrokeColor(RageColor(0,0,0,0)), m_sChars(""),
+	m_iGeneration(++g_iNextGeneration)
+{
+	ZERO( m_iCharToGlyphCache );
+}
 Font::~Font()
 {
 	Unload();
@@ -293,7 +301,9 @@ void Font::Unload()
 	m_apPages.clear();
 
 	m_iCharToGlyph.clear();
+	ZERO( m_iCharToGlyphCache );
 	m_pDefault = nullptr;
+	m_iGeneration = ++g_iNextGeneration;
 
 	/* Don't clear the refcount. We've unloaded, but that doesn't mean things
 	 * aren't still pointing to us. */
@@ -733,6 +743,40 @@ RString FontPageSettings::MapRange( RString sMapping, int iMapOffset, int iGlyph
 	return RString();
 }
 
+/* Read everything Load needs out of the INI, for FontCache to keep. */
+void Font::Compile( const RString &sIniPath, const std::vector<RString> &asTexturePaths, const RString &sChars, CompiledFont &out )
+{
+	IniFile ini;
+	ini.ReadFile( sIniPath );
+	ini.RenameKey("Char Widths", "main");	// backward compat
+	ini.GetValue( "common", "CapitalsOnly", out.m_bCapitalsOnly );
+	ini.GetValue( "common", "RightToLeft", out.m_bRightToLeft );
+	ini.GetValue( "common", "DistanceField", out.m_bDistanceField );
+	RString s;
+	if( ini.GetValue( "common", "DefaultStrokeColor", s ) )
+	{
+		out.m_bHasDefaultStrokeColor = true;
+		out.m_DefaultStrokeColor.FromString( s );
+	}
+
+	RString imports;
+	ini.GetValue( "main", "import", imports );
+	split(imports, ",", out.m_vsImports, true);
+
+	for( unsigned i = 0; i < asTexturePaths.size(); ++i )
+	{
+		const RString &sTexturePath = asTexturePaths[i];
+		if( sTexturePath.find("-stroke") != std::string::npos )
+			continue;
+
+		// Load settings for this page from the INI.
+		FontPageSettings cfg;
+		LoadFontPageSettings( cfg, ini, sTexturePath, "common", sChars );
+		LoadFontPageSettings( cfg, ini, sTexturePath, GetPageNameFromFileName(sTexturePath), sChars );
+		out.m_vPages.push_back( cfg );
+	}
+}
+
 static std::vector<RString> LoadStack;
 
 /* A font set is a set of files, eg:
@@ -788,22 +832,29 @@ void Font::Load( const RString &sIniPath, RString sChars )
 	std::vector<RString> asTexturePaths;
 	GetFontPaths( sIniPath, asTexturePaths );
 
-	bool bCapitalsOnly = false;
-
-	// If we have an INI, load it.
-	IniFile ini;
-	if( !sIniPath.empty() )
+	/* What's in the INI only has to be parsed again when it or the set of
+	 * page files has changed since it was compiled. */
+	RageTimer timer;
+	const unsigned int iHash = FontCache::GetHash( sIniPath, asTexturePaths );
+	const CompiledFont *pCompiled = FontCache::Get( sIniPath, sChars, iHash );
+	if( pCompiled != nullptr )
 	{
-		ini.ReadFile( sIniPath );
-		ini.RenameKey("Char Widths", "main");	// backward compat
-		ini.GetValue( "common", "CapitalsOnly", bCapitalsOnly );
-		ini.GetValue( "common", "RightToLeft", m_bRightToLeft );
-		ini.GetValue( "common", "DistanceField", m_bDistanceField );
-		RString s;
-		if( ini.GetValue( "common", "DefaultStrokeColor", s ) )
-			m_DefaultStrokeColor.FromString( s );
+		FontCache::CountHit( pCompiled->m_fCompileSeconds - timer.GetDeltaTime() );
+	}
+	else
+	{
+		CompiledFont compiled;
+		Compile( sIniPath, asTexturePaths, sChars, compiled );
+		compiled.m_iHash = iHash;
+		compiled.m_fCompileSeconds = timer.GetDeltaTime();
+		pCompiled = FontCache::Add( sIniPath, sChars, compiled );
 	}
 
+	m_bRightToLeft = pCompiled->m_bRightToLeft;
+	m_bDistanceField = pCompiled->m_bDistanceField;
+	if( pCompiled->m_bHasDefaultStrokeColor )
+		m_DefaultStrokeColor = pCompiled->m_DefaultStrokeColor;
+
 	{
 		std::vector<RString> ImportList;
 
@@ -816,9 +867,8 @@ void Font::Load( const RString &sIniPath, RString sChars )
 		/* Check to see if we need to import any other fonts.  Do this
 		 * before loading this font, so any characters in this font
 		 * override imported characters. */
-		RString imports;
-		ini.GetValue( "main", "import", imports );
-		split(imports, ",", ImportList, true);
+		const std::vector<RString> &imports = pCompiled->m_vsImports;
+		ImportList.insert( ImportList.end(), imports.begin(), imports.end() );
 
 		if( bIsTopLevelFont  &&  imports.empty()  &&  asTexturePaths.empty() )
 		{
@@ -843,6 +893,7 @@ void Font::Load( const RString &sIniPath, RString sChars )
 	}
 
 	// Load each font page.
+	std::vector<FontPageSettings>::const_iterator cfg = pCompiled->m_vPages.begin();
 	for( unsigned i = 0; i < asTexturePaths.size(); ++i )
 	{
 		const RString &sTexturePath = asTexturePaths[i];
@@ -857,13 +908,8 @@ void Font::Load( const RString &sIniPath, RString sChars )
 		// Create this down here so it doesn't leak if the continue gets triggered.
 		FontPage *pPage = new FontPage;
 
-		// Load settings for this page from the INI.
-		FontPageSettings cfg;
-		LoadFontPageSettings( cfg, ini, sTexturePath, "common", sChars );
-		LoadFontPageSettings( cfg, ini, sTexturePath, sPagename, sChars );
-
 		// Load.
-		pPage->Load( cfg );
+		pPage->Load( *cfg++ );
 
 		/* Expect at least as many frames as we have premapped characters. */
 		/* Make sure that we don't map characters to frames we don't actually
@@ -893,7 +939,7 @@ void Font::Load( const RString &sIniPath, RString sChars )
 			SetDefaultGlyph( pPage );
 	}
 
-	if( bCapitalsOnly )
+	if( pCompiled->m_bCapitalsOnly )
 		CapsOnly();
 
 	if( m_iCharToGlyph.empty() )
@@ -15,6 +15,7 @@
 class FontPage;
 class RageTexture;
 class IniFile;
+struct CompiledFont;
 
 /** @brief The textures used by the font. */
 struct FontPageTextures
@@ -190,6 +191,10 @@ public:
 	bool IsDistanceField() const { return m_bDistanceField; };
 	const RageColor &GetDefaultStrokeColor() const { return m_DefaultStrokeColor; };
 
+	/* Changes whenever the glyphs may have, and differs between fonts, so
+	 * anything laid out from them can tell whether it's still good. */
+	unsigned GetGeneration() const { return m_iGeneration; }
+
 private:
 	/** @brief List of pages and fonts that we use (and are responsible for freeing). */
 	std::vector<FontPage *> m_apPages;
@@ -220,7 +225,10 @@ private:
 	/** @brief We keep this around only for reloading. */
 	RString m_sChars;
 
+	unsigned m_iGeneration;
+
 	void LoadFontPageSettings( FontPageSettings &cfg, IniFile &ini, const RString &sTexturePath, const RString &PageName, RString sChars );
+	void Compile( const RString &sIniPath, const std::vector<RString> &asTexturePaths, const RString &sChars, CompiledFont &out );
 	static void GetFontPaths( const RString &sFontOrTextureFilePath, std::vector<RString> &sTexturePaths );
 	RString GetPageNameFromFileName( const RString &sFilename );
 
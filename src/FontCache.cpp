@@ -0,0 +1,232 @@
+#include "global.h"
+#include "FontCache.h"
+#include "BinaryCache.h"
+#include "RageFile.h"
+#include "RageFileManager.h"
+#include "RageLog.h"
+#include "RageUtil.h"
+#include "SpecialFiles.h"
+
+#include <cstring>
+#include <map>
+
+#define FONT_CACHE (SpecialFiles::CACHE_DIR + "fonts.cache")
+
+static const char CACHE_MAGIC[4] = { 'S', 'M', 'F', 'C' };
+/* Bump this whenever the layout changes, or Font::Load starts reading
+ * something else out of font INIs. */
+static const uint32_t CACHE_FORMAT_VERSION = 1;
+
+// INI path and sChars, like FontManager's FontName.
+typedef std::pair<RString,RString> FontName;
+static std::map<FontName, CompiledFont> g_mapCompiledFonts;
+static bool g_bRead = false;
+static bool g_bChanged = false;
+static FontCache::Stats g_Stats;
+
+static void WritePage( RString &out, const FontPageSettings &cfg )
+{
+	WriteString( out, cfg.m_sTexturePath );
+	WriteI32( out, cfg.m_iDrawExtraPixelsLeft );
+	WriteI32( out, cfg.m_iDrawExtraPixelsRight );
+	WriteI32( out, cfg.m_iAddToAllWidths );
+	WriteI32( out, cfg.m_iLineSpacing );
+	WriteI32( out, cfg.m_iTop );
+	WriteI32( out, cfg.m_iBaseline );
+	WriteI32( out, cfg.m_iDefaultWidth );
+	WriteI32( out, cfg.m_iAdvanceExtraPixels );
+	WriteFloat( out, cfg.m_fScaleAllWidthsBy );
+	WriteString( out, cfg.m_sTextureHints );
+
+	WriteU32( out, cfg.CharToGlyphNo.size() );
+	for( std::pair<const wchar_t,int> const &m : cfg.CharToGlyphNo )
+	{
+		WriteU32( out, m.first );
+		WriteI32( out, m.second );
+	}
+	WriteU32( out, cfg.m_mapGlyphWidths.size() );
+	for( std::pair<const int,int> const &w : cfg.m_mapGlyphWidths )
+	{
+		WriteI32( out, w.first );
+		WriteI32( out, w.second );
+	}
+}
+
+static void ReadPage( CacheReader &in, FontPageSettings &cfg )
+{
+	cfg.m_sTexturePath = in.String();
+	cfg.m_iDrawExtraPixelsLeft = in.I32();
+	cfg.m_iDrawExtraPixelsRight = in.I32();
+	cfg.m_iAddToAllWidths = in.I32();
+	cfg.m_iLineSpacing = in.I32();
+	cfg.m_iTop = in.I32();
+	cfg.m_iBaseline = in.I32();
+	cfg.m_iDefaultWidth = in.I32();
+	cfg.m_iAdvanceExtraPixels = in.I32();
+	cfg.m_fScaleAllWidthsBy = in.Float();
+	cfg.m_sTextureHints = in.String();
+
+	// Both maps were written in order, so each insert goes at the end.
+	uint32_t iCount = in.Count();
+	for( uint32_t i = 0; i < iCount && !in.Failed(); ++i )
+	{
+		wchar_t c = wchar_t( in.U32() );
+		int iGlyphNo = in.I32();
+		cfg.CharToGlyphNo.emplace_hint( cfg.CharToGlyphNo.end(), c, iGlyphNo );
+	}
+	iCount = in.Count();
+	for( uint32_t i = 0; i < iCount && !in.Failed(); ++i )
+	{
+		int iGlyph = in.I32();
+		int iWidth = in.I32();
+		cfg.m_mapGlyphWidths.emplace_hint( cfg.m_mapGlyphWidths.end(), iGlyph, iWidth );
+	}
+}
+
+static void WriteFont( RString &out, const CompiledFont &font )
+{
+	WriteU32( out, font.m_iHash );
+	WriteFloat( out, font.m_fCompileSeconds );
+	WriteBool( out, font.m_bCapitalsOnly );
+	WriteBool( out, font.m_bRightToLeft );
+	WriteBool( out, font.m_bDistanceField );
+	WriteBool( out, font.m_bHasDefaultStrokeColor );
+	WriteFloat( out, font.m_DefaultStrokeColor.r );
+	WriteFloat( out, font.m_DefaultStrokeColor.g );
+	WriteFloat( out, font.m_DefaultStrokeColor.b );
+	WriteFloat( out, font.m_DefaultStrokeColor.a );
+	WriteStringVector( out, font.m_vsImports );
+	WriteU32( out, font.m_vPages.size() );
+	for( FontPageSettings const &cfg : font.m_vPages )
+		WritePage( out, cfg );
+}
+
+static void ReadFont( CacheReader &in, CompiledFont &font )
+{
+	font.m_iHash = in.U32();
+	font.m_fCompileSeconds = in.Float();
+	font.m_bCapitalsOnly = in.Bool();
+	font.m_bRightToLeft = in.Bool();
+	font.m_bDistanceField = in.Bool();
+	font.m_bHasDefaultStrokeColor = in.Bool();
+	font.m_DefaultStrokeColor.r = in.Float();
+	font.m_DefaultStrokeColor.g = in.Float();
+	font.m_DefaultStrokeColor.b = in.Float();
+	font.m_DefaultStrokeColor.a = in.Float();
+	in.StringVector( font.m_vsImports );
+	uint32_t iPages = in.Count();
+	font.m_vPages.resize( iPages );
+	for( uint32_t i = 0; i < iPages && !in.Failed(); ++i )
+		ReadPage( in, font.m_vPages[i] );
+}
+
+static void ReadCacheFile()
+{
+	g_bRead = true;
+
+	RageFile f;
+	if( !f.Open(FONT_CACHE) )
+		return;
+
+	RString sBuf;
+	if( f.Read(sBuf) == -1 )
+		return;
+	if( sBuf.size() < sizeof(CACHE_MAGIC) || std::memcmp(sBuf.data(), CACHE_MAGIC, sizeof(CACHE_MAGIC)) )
+		return;
+
+	CacheReader in( sBuf.data() + sizeof(CACHE_MAGIC), sBuf.size() - sizeof(CACHE_MAGIC) );
+	if( in.U32() != CACHE_FORMAT_VERSION )
+		return;
+
+	uint32_t iFonts = in.Count();
+	for( uint32_t i = 0; i < iFonts && !in.Failed(); ++i )
+	{
+		FontName name;
+		name.first = in.String();
+		name.second = in.String();
+		ReadFont( in, g_mapCompiledFonts[name] );
+	}
+
+	if( in.Failed() || !in.AtEnd() )
+	{
+		LOG->Trace( "Font cache \"%s\" is damaged.", FONT_CACHE.c_str() );
+		g_mapCompiledFonts.clear();
+	}
+}
+
+/* The frame counts of the pages come from their file names, so the names
+ * are all that matters of them; the INI is hashed by size and time like
+ * song directories are. */
+unsigned int FontCache::GetHash( const RString &sIniPath, const std::vector<RString> &asTexturePaths )
+{
+	unsigned int iHash = FILEMAN->GetFileHash( sIniPath );
+	for( RString const &sPath : asTexturePaths )
+		iHash += GetHashForString( sPath );
+	return iHash;
+}
+
+const CompiledFont *FontCache::Get( const RString &sIniPath, const RString &sChars, unsigned int iHash )
+{
+	if( !g_bRead )
+		ReadCacheFile();
+
+	std::map<FontName, CompiledFont>::const_iterator it = g_mapCompiledFonts.find( FontName(sIniPath, sChars) );
+	if( it == g_mapCompiledFonts.end() || it->second.m_iHash != iHash )
+		return nullptr;
+	return &it->second;
+}
+
+const CompiledFont *FontCache::Add( const RString &sIniPath, const RString &sChars, const CompiledFont &font )
+{
+	CompiledFont &entry = g_mapCompiledFonts[FontName(sIniPath, sChars)];
+	entry = font;
+	g_bChanged = true;
+	++g_Stats.iCompiled;
+	return &entry;
+}
+
+void FontCache::Save()
+{
+	if( !g_bChanged )
+		return;
+	g_bChanged = false;
+
+	RString sBuf( CACHE_MAGIC, sizeof(CACHE_MAGIC) );
+	WriteU32( sBuf, CACHE_FORMAT_VERSION );
+	WriteU32( sBuf, g_mapCompiledFonts.size() );
+	for( std::pair<const FontName, CompiledFont> const &f : g_mapCompiledFonts )
+	{
+		WriteString( sBuf, f.first.first );
+		WriteString( sBuf, f.first.second );
+		WriteFont( sBuf, f.second );
+	}
+
+	RageFile f;
+	if( !f.Open(FONT_CACHE, RageFile::WRITE) )
+	{
+		LOG->UserLog( "Cache file", FONT_CACHE, "couldn't be opened for writing: %s", f.GetError().c_str() );
+		return;
+	}
+	if( f.Write(sBuf) == -1 || f.Flush() == -1 )
+		LOG->UserLog( "Cache file", FONT_CACHE, "couldn't be written: %s", f.GetError().c_str() );
+}
+
+void FontCache::Clear()
+{
+	g_mapCompiledFonts.clear();
+	g_bRead = false;
+	g_bChanged = false;
+}
+
+void FontCache::CountHit( float fSecondsSaved )
+{
+	++g_Stats.iFromCache;
+	g_Stats.fSecondsSaved += fSecondsSaved;
+}
+
+FontCache::Stats FontCache::TakeStats()
+{
+	Stats ret = g_Stats;
+	g_Stats = Stats();
+	return ret;
+}
@@ -0,0 +1,71 @@
+/* FontCache - Keeps what Font::Load reads out of font INIs in a binary file. */
+
+#ifndef FontCache_H
+#define FontCache_H
+
+#include "Font.h"
+
+#include <vector>
+
+/* Everything Font::Load gets from a font's INI and the names of its page
+ * files, before any texture is loaded.  The page textures still go through
+ * TEXTUREMAN, and the glyph metrics depend on their frame sizes, so those
+ * are worked out at load time as before; what a compiled font saves is the
+ * INI parse and building the map and range tables. */
+struct CompiledFont
+{
+	CompiledFont(): m_iHash(0), m_fCompileSeconds(0),
+		m_bCapitalsOnly(false), m_bRightToLeft(false), m_bDistanceField(false),
+		m_bHasDefaultStrokeColor(false), m_DefaultStrokeColor(0,0,0,0) { }
+
+	/* FontCache::GetHash of the files this was compiled from. */
+	unsigned int m_iHash;
+	/* How long compiling took, to tell how much a cache hit saved. */
+	float m_fCompileSeconds;
+
+	bool m_bCapitalsOnly;
+	bool m_bRightToLeft;
+	bool m_bDistanceField;
+	bool m_bHasDefaultStrokeColor;
+	RageColor m_DefaultStrokeColor;
+
+	/* The "import" list from [main], not counting Common default, which
+	 * depends on whether the font is loaded on its own or imported. */
+	std::vector<RString> m_vsImports;
+
+	/* One for each page texture, in listing order, without stroke layers. */
+	std::vector<FontPageSettings> m_vPages;
+};
+
+/* The cache is one file for every font, read the first time a font is
+ * loaded.  Entries are keyed by INI path and sChars, and thrown away when
+ * the INI or the set of page files changes. */
+namespace FontCache
+{
+	unsigned int GetHash( const RString &sIniPath, const std::vector<RString> &asTexturePaths );
+
+	/* Returns nullptr if the font hasn't been compiled from these files.
+	 * The entry stays put until the same font is added again. */
+	const CompiledFont *Get( const RString &sIniPath, const RString &sChars, unsigned int iHash );
+	const CompiledFont *Add( const RString &sIniPath, const RString &sChars, const CompiledFont &font );
+
+	/* Write the file if anything was added since it was read. */
+	void Save();
+	/* Forget what's in memory, including anything not saved yet; the file
+	 * is read again on the next Get.  ThemeManager saves and clears when
+	 * the theme changes or its metrics are reloaded. */
+	void Clear();
+
+	struct Stats
+	{
+		Stats(): iCompiled(0), iFromCache(0), fSecondsSaved(0) { }
+		int iCompiled;
+		int iFromCache;
+		float fSecondsSaved;
+	};
+	void CountHit( float fSecondsSaved );
+	/* Fonts loaded since the last call. */
+	Stats TakeStats();
+};
+
+#endif
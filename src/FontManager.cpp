@@ -1,6 +1,7 @@
 #include "global.h"
 #include "FontManager.h"
 #include "Font.h"
+#include "FontCache.h"
 #include "RageUtil.h"
 #include "RageLog.h"
 #include <map>
@@ -27,6 +28,8 @@ FontManager::~FontManager()
 		}
 		delete pFont;
 	}
+
+	FontCache::Save();
 }
 
 Font* FontManager::LoadFont( const RString &sFontOrTextureFilePath, RString sChars )
@@ -84,6 +87,15 @@ void FontManager::UnloadFont( Font *fp )
 	FAIL_M( ssprintf("Unloaded an unknown font (%p)", static_cast<void*>(fp)) );
 }
 
+void FontManager::SaveCompiledFonts()
+{
+	FontCache::Save();
+
+	const FontCache::Stats stats = FontCache::TakeStats();
+	LOG->Trace( "Fonts: %i compiled, %i from the font cache, %.1fms of compiling saved",
+		stats.iCompiled, stats.iFromCache, stats.fSecondsSaved * 1000 );
+}
+
 /*
 void FontManager::PruneFonts() {
 	for( std::map<FontName, Font*>::iterator i = g_mapPathToFont.begin();i != g_mapPathToFont.end();) {
@@ -15,6 +15,10 @@ public:
 	Font* LoadFont( const RString &sFontOrTextureFilePath, RString sChars = "" );
 	Font *CopyFont( Font *pFont );
 	void UnloadFont( Font *fp );
+
+	/* Write out fonts compiled since the last call, and trace how much
+	 * compiling was saved by the ones that were already cached. */
+	void SaveCompiledFonts();
 	//void PruneFonts();
 };
 
@@ -113,8 +113,10 @@ static ThemeMetric<bool> ARE_STAGE_SONG_MODS_FORCED	("GameState","AreStageSongMo
 static Preference<Premium> g_Premium( "Premium", Premium_DoubleFor1Credit );
 Preference<bool> GameState::m_bAutoJoin( "AutoJoin", false );
 
+/** @brief The TimingData that is used for processing certain functions. */
+static thread_local TimingData *g_pProcessedTiming = nullptr;
+
 GameState::GameState() :
-	processedTiming(nullptr),
 	m_pCurGame(				Message_CurrentGameChanged ),
 	m_pCurStyle(			Message_CurrentStyleChanged ),
 	m_PlayMode(				Message_PlayModeChanged ),
@@ -203,7 +205,7 @@ GameState::~GameState()
 
 	RageUtil::SafeDelete( m_Environment );
 	RageUtil::SafeDelete( g_pImpl );
-	RageUtil::SafeDelete( processedTiming );
+	RageUtil::SafeDelete( g_pProcessedTiming );
 }
 
 PlayerNumber GameState::GetMasterPlayerNumber() const
@@ -218,12 +220,12 @@ void GameState::SetMasterPlayerNumber(const PlayerNumber p)
 
 TimingData * GameState::GetProcessedTimingData() const
 {
-	return this->processedTiming;
+	return g_pProcessedTiming;
 }
 
 void GameState::SetProcessedTimingData(TimingData * t)
 {
-	this->processedTiming = t;
+	g_pProcessedTiming = t;
 }
 
 void GameState::ApplyGameCommand( const RString &sCommand, PlayerNumber pn )
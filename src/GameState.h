@@ -42,8 +42,6 @@ class GameState
 {
 	/** @brief The player number used with Styles where one player controls both sides. */
 	PlayerNumber	masterPlayerNumber;
-	/** @brief The TimingData that is used for processing certain functions. */
-	TimingData * processedTiming;
 public:
 	/** @brief Set up the GameState with initial values. */
 	GameState();
@@ -173,6 +171,9 @@ public:
 
 	/**
 	 * @brief Retrieve the present timing data being processed.
+	 *
+	 * Each thread has its own, since radar values are calculated while
+	 * songs are loading, and songs may load on several threads.
 	 * @return the timing data pointer. */
 	TimingData * GetProcessedTimingData() const;
 
@@ -86,6 +86,13 @@ void ImageCache::Demand( RString sImageDir )
 			continue; /* doesn't exist */
 		}
 
+		LockMut( m_Mutex );
+		if( g_ImagePathToImage.find(sImagePath) != g_ImagePathToImage.end() )
+		{
+			/* Another thread loaded it while we were. */
+			delete pImage;
+			return;
+		}
 		g_ImagePathToImage[sImagePath] = pImage;
 	}
 }
@@ -120,8 +127,11 @@ void ImageCache::LoadImage( RString sImageDir, RString sImagePath )
 
 	for( int tries = 0; tries < 2; ++tries )
 	{
-		if( g_ImagePathToImage.find(sImagePath) != g_ImagePathToImage.end() )
-			return; /* already loaded */
+		{
+			LockMut( m_Mutex );
+			if( g_ImagePathToImage.find(sImagePath) != g_ImagePathToImage.end() )
+				return; /* already loaded */
+		}
 
 		CHECKPOINT_M( ssprintf( "ImageCache::LoadImage: %s", sCachePath.c_str() ) );
 		RageSurface *pImage = RageSurfaceUtils::LoadSurface( sCachePath );
@@ -145,6 +155,13 @@ void ImageCache::LoadImage( RString sImageDir, RString sImagePath )
 			}
 		}
 
+		LockMut( m_Mutex );
+		if( g_ImagePathToImage.find(sImagePath) != g_ImagePathToImage.end() )
+		{
+			/* Another thread loaded it while we were. */
+			delete pImage;
+			return;
+		}
 		g_ImagePathToImage[sImagePath] = pImage;
 	}
 }
@@ -172,7 +189,7 @@ void ImageCache::UnloadAllImages()
 }
 
 ImageCache::ImageCache()
-	: delay_save_cache(false)
+	: delay_save_cache(false), m_Mutex("ImageCache")
 {
 	ReadFromDisk();
 }
@@ -355,6 +372,7 @@ void ImageCache::CacheImage( RString sImageDir, RString sImagePath )
 		{
 			unsigned CurFullHash;
 			const unsigned FullHash = GetHashForFile( sImagePath );
+			LockMut( m_Mutex );
 			if( ImageData.GetValue( sImagePath, "FullHash", CurFullHash ) && CurFullHash == FullHash )
 				bCacheUpToDate = true;
 		}
@@ -439,7 +457,9 @@ void ImageCache::CacheImageInternal( RString sImageDir, RString sImagePath )
 
 	const RString sCachePath = GetImageCachePath(sImageDir,sImagePath);
 	RageSurfaceUtils::SaveSurface( pImage, sCachePath );
+	const unsigned FullHash = GetHashForFile( sImagePath );
 
+	LockMut( m_Mutex );
 	/* If an old image is loaded, free it. */
 	if( g_ImagePathToImage.find(sImagePath) != g_ImagePathToImage.end() )
 	{
@@ -460,13 +480,14 @@ void ImageCache::CacheImageInternal( RString sImageDir, RString sImagePath )
 	ImageData.SetValue( sImagePath, "Path", sCachePath );
 	ImageData.SetValue( sImagePath, "Width", iSourceWidth );
 	ImageData.SetValue( sImagePath, "Height", iSourceHeight );
-	ImageData.SetValue( sImagePath, "FullHash", GetHashForFile( sImagePath ) );
+	ImageData.SetValue( sImagePath, "FullHash", FullHash );
 	if (!delay_save_cache)
 		WriteToDisk();
 }
 
 void ImageCache::WriteToDisk()
 {
+	LockMut( m_Mutex );
 	ImageData.WriteFile(IMAGE_CACHE_INDEX);
 }
 
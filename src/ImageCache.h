@@ -4,6 +4,7 @@
 #include "IniFile.h"
 
 #include "RageTexture.h"
+#include "RageThreads.h"
 
 class LoadingWindow;
 /** @brief Maintains a cache of reduced-quality images. */
@@ -32,6 +33,9 @@ private:
 	void CacheImageInternal( RString sImageDir, RString sImagePath );
 
 	IniFile ImageData;
+	/* Songs may be loaded from several threads at once; this protects
+	 * ImageData and the loaded image map, but not the image conversion. */
+	mutable RageMutex m_Mutex;
 };
 
 extern ImageCache *IMAGECACHE; // global and accessible from anywhere in our program
@@ -0,0 +1,143 @@
+#include "global.h"
+#include "JudgmentIndex.h"
+#include "NoteData.h"
+#include "TimingData.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+void JudgmentIndex::Load( NoteData &nd, const TimingData &td )
+{
+	Clear();
+	m_vColumns.resize( nd.GetNumTracks() );
+	for( Column &col : m_vColumns )
+		col.iCursor = 0;
+
+	int iLastRow = -1;
+	float fSeconds = 0;
+	bool bJudgable = false;
+	for( NoteData::all_tracks_iterator it = nd.GetTapNoteRangeAllTracks(0, MAX_NOTE_ROW); !it.IsAtEnd(); ++it )
+	{
+		const int iRow = it.Row();
+		if( iRow != iLastRow )
+		{
+			fSeconds = td.GetElapsedTimeFromBeat( NoteRowToBeat(iRow) );
+			bJudgable = td.IsJudgableAtRow( iRow );
+			iLastRow = iRow;
+		}
+
+		TapNote &tn = *it;
+		if( tn.type == TapNoteType_HoldHead )
+			m_vHoldHeads.push_back( m_vTimeline.size() );
+		TimelineNote tl = { iRow, it.Track(), fSeconds, bJudgable, &tn };
+		m_vTimeline.push_back( tl );
+
+		// unsure if autoKeysounds should be excluded. -Wolfman2000
+		if( !bJudgable || tn.type == TapNoteType_Empty || tn.type == TapNoteType_AutoKeysound )
+			continue;
+		Note n = { iRow, fSeconds, &tn };
+		m_vColumns[it.Track()].vNotes.push_back( n );
+	}
+}
+
+static bool TimelineNoteBefore( const JudgmentIndex::TimelineNote &tl, const std::pair<int,int> &rowTrack )
+{
+	return tl.iRow < rowTrack.first || (tl.iRow == rowTrack.first && tl.iTrack < rowTrack.second);
+}
+
+unsigned JudgmentIndex::FindInTimeline( int iRow, int iTrack ) const
+{
+	return std::lower_bound( m_vTimeline.begin(), m_vTimeline.end(), std::make_pair(iRow, iTrack), TimelineNoteBefore ) - m_vTimeline.begin();
+}
+
+unsigned JudgmentIndex::FindInHoldHeads( int iRow, int iTrack ) const
+{
+	// The timeline is in the same order, so compare timeline positions.
+	const unsigned iPos = FindInTimeline( iRow, iTrack );
+	return std::lower_bound( m_vHoldHeads.begin(), m_vHoldHeads.end(), iPos ) - m_vHoldHeads.begin();
+}
+
+unsigned JudgmentIndex::LowerBound( const Column &col, int iRow ) const
+{
+	const std::vector<Note> &v = col.vNotes;
+	unsigned i = std::min( col.iCursor, (unsigned) v.size() );
+
+	// Steps come in song order, so try walking from the last answer first.
+	for( int iTries = 0; iTries < 4; ++iTries )
+	{
+		if( i > 0 && v[i-1].iRow >= iRow )
+			--i;
+		else if( i < v.size() && v[i].iRow < iRow )
+			++i;
+		else
+		{
+			col.iCursor = i;
+			return i;
+		}
+	}
+
+	struct RowLess
+	{
+		bool operator()( const Note &n, int iRow ) const { return n.iRow < iRow; }
+	};
+	i = std::lower_bound( v.begin(), v.end(), iRow, RowLess() ) - v.begin();
+	col.iCursor = i;
+	return i;
+}
+
+int JudgmentIndex::GetClosestNoteDirectional( int iCol, int iStartRow, int iEndRow, bool bAllowGraded, bool bForward ) const
+{
+	ASSERT( iCol < (int) m_vColumns.size() );
+	const Column &col = m_vColumns[iCol];
+	const std::vector<Note> &v = col.vNotes;
+
+	// The same bounds NoteData::GetTapNoteRange uses.  Only look up the end
+	// the search starts from, so the cursor stays near the song position.
+	if( iStartRow > iEndRow || iStartRow >= MAX_NOTE_ROW || iEndRow <= 0 )
+		return -1;
+
+	if( bForward )
+	{
+		for( unsigned i = iStartRow <= 0? 0:LowerBound(col, iStartRow); i < v.size(); ++i )
+		{
+			if( iEndRow < MAX_NOTE_ROW && v[i].iRow >= iEndRow )
+				break;
+			if( bAllowGraded || v[i].pTapNote->result.tns == TNS_None )
+				return v[i].iRow;
+		}
+	}
+	else
+	{
+		for( unsigned i = iEndRow >= MAX_NOTE_ROW? v.size():LowerBound(col, iEndRow); i > 0; --i )
+		{
+			if( iStartRow > 0 && v[i-1].iRow < iStartRow )
+				break;
+			if( bAllowGraded || v[i-1].pTapNote->result.tns == TNS_None )
+				return v[i-1].iRow;
+		}
+	}
+	return -1;
+}
+
+int JudgmentIndex::GetClosestNote( int iCol, int iNoteRow, int iMaxRowsAhead, int iMaxRowsBehind, bool bAllowGraded ) const
+{
+	int iNextIndex = GetClosestNoteDirectional( iCol, iNoteRow, iNoteRow+iMaxRowsAhead, bAllowGraded, true );
+	int iPrevIndex = GetClosestNoteDirectional( iCol, iNoteRow-iMaxRowsBehind, iNoteRow, bAllowGraded, false );
+
+	if( iNextIndex == -1 )
+		return iPrevIndex;
+	if( iPrevIndex == -1 )
+		return iNextIndex;
+	if( std::abs(iNoteRow-iNextIndex) > std::abs(iNoteRow-iPrevIndex) )
+		return iPrevIndex;
+	return iNextIndex;
+}
+
+float JudgmentIndex::GetElapsedTimeOfNote( int iCol, int iRow ) const
+{
+	ASSERT( iCol < (int) m_vColumns.size() );
+	const Column &col = m_vColumns[iCol];
+	const unsigned i = LowerBound( col, iRow );
+	ASSERT( i < col.vNotes.size() && col.vNotes[i].iRow == iRow );
+	return col.vNotes[i].fSeconds;
+}
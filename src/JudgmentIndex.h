@@ -0,0 +1,90 @@
+/* JudgmentIndex - The notes Player judges, laid out for quick lookup. */
+
+#ifndef JUDGMENT_INDEX_H
+#define JUDGMENT_INDEX_H
+
+#include <vector>
+
+class NoteData;
+class TimingData;
+struct TapNote;
+
+/* Player looks up the note closest to every step.  Searching the NoteData
+ * for it means a binary search of the track and a timing segment lookup for
+ * every note looked at, which adds up when someone mashes through a dense
+ * chart.  This keeps, for each column, just the notes that can be stepped on,
+ * with their times worked out once, and remembers where the last search
+ * ended; the next one is usually at or next to it.
+ *
+ * Player::Update also walks every note in row order to cross rows, judge
+ * holds and miss old taps.  The timeline has them all in the order an
+ * all_tracks_iterator would visit them, with their times and whether
+ * they're judgable, so Player can keep a plain index into it for each of
+ * those instead of an iterator that searches every track on each step.
+ *
+ * The notes are pointed to, not copied, so that the judgments Player writes
+ * into the NoteData are seen here.  Load() again whenever notes are added or
+ * removed, since that moves them. */
+class JudgmentIndex
+{
+public:
+	JudgmentIndex() {}
+
+	void Load( NoteData &nd, const TimingData &td );
+	void Clear() { m_vColumns.clear(); m_vTimeline.clear(); m_vHoldHeads.clear(); }
+
+	/* Same as searching the NoteData from iStartRow up to (but not
+	 * including) iEndRow for the first (bForward) or last note that's
+	 * judgable, not empty or an autokeysound, and, unless bAllowGraded,
+	 * not judged yet.  Returns its row, or -1. */
+	int GetClosestNoteDirectional( int iCol, int iStartRow, int iEndRow, bool bAllowGraded, bool bForward ) const;
+	/* The nearer of the notes found each way; the later one on a tie. */
+	int GetClosestNote( int iCol, int iNoteRow, int iMaxRowsAhead, int iMaxRowsBehind, bool bAllowGraded ) const;
+
+	/* The time of the note at iRow, which must have been found above. */
+	float GetElapsedTimeOfNote( int iCol, int iRow ) const;
+
+	struct TimelineNote
+	{
+		int iRow;
+		int iTrack;
+		float fSeconds;
+		bool bJudgable;
+		TapNote *pTapNote;
+	};
+	/* Every note, by row and then by track. */
+	const std::vector<TimelineNote> &GetTimeline() const { return m_vTimeline; }
+	/* The timeline positions of just the hold and roll heads. */
+	const std::vector<unsigned> &GetHoldHeads() const { return m_vHoldHeads; }
+	/* The first timeline position at or after iTrack of iRow. */
+	unsigned FindInTimeline( int iRow, int iTrack = 0 ) const;
+	/* The first GetHoldHeads() position at or after iTrack of iRow. */
+	unsigned FindInHoldHeads( int iRow, int iTrack = 0 ) const;
+
+private:
+	struct Note
+	{
+		int iRow;
+		float fSeconds;
+		const TapNote *pTapNote;
+	};
+	struct Column
+	{
+		std::vector<Note> vNotes;
+		// Where the last search started; searches move along with the song.
+		mutable unsigned iCursor;
+	};
+
+	/* The index of the first note at or after iRow. */
+	unsigned LowerBound( const Column &col, int iRow ) const;
+
+	std::vector<Column> m_vColumns;
+	std::vector<TimelineNote> m_vTimeline;
+	std::vector<unsigned> m_vHoldHeads;
+
+	// Swallow up warnings. If they must be used, define them.
+	JudgmentIndex& operator=(const JudgmentIndex& rhs);
+	JudgmentIndex(const JudgmentIndex& rhs);
+};
+
+#endif
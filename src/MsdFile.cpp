@@ -20,22 +20,27 @@
 
 void MsdFile::AddParam( const char *buf, int len )
 {
-	values.back().params.push_back( RString(buf, len) );
+	m_Params.push_back( param_t(buf, len) );
+	++m_Values.back().iNumParams;
 }
 
 void MsdFile::AddValue() /* (no extra charge) */
 {
-	values.push_back( value_t() );
-	values.back().params.reserve( 32 );
+	ValueSpan v = { unsigned(m_Params.size()), 0 };
+	m_Values.push_back( v );
 }
 
-void MsdFile::ReadBuf( const char *buf, int len, bool bUnescape )
+/* Parse in place: the processed text of a parameter never gets ahead of
+ * the text it came from, so it's written back over the buffer, and each
+ * parameter is left as a view of the result. */
+void MsdFile::ReadBuf( char *buf, int len, bool bUnescape )
 {
-	values.reserve( 64 );
+	m_Values.reserve( 64 );
+	m_Params.reserve( 256 );
 
 	bool ReadingValue=false;
 	int i = 0;
-	char *cProcessed = new char[len];
+	char *cProcessed = buf;
 	int iProcessedLen = -1;
 	while( i < len )
 	{
@@ -86,6 +91,7 @@ void MsdFile::ReadBuf( const char *buf, int len, bool bUnescape )
 
 			AddParam( cProcessed, iProcessedLen );
 			iProcessedLen = 0;
+			cProcessed = buf + i;
 			ReadingValue=false;
 		}
 
@@ -114,6 +120,7 @@ void MsdFile::ReadBuf( const char *buf, int len, bool bUnescape )
 		{
 			++i;
 			iProcessedLen = 0;
+			cProcessed = buf + i;
 			continue;
 		}
 
@@ -154,12 +161,31 @@ void MsdFile::ReadBuf( const char *buf, int len, bool bUnescape )
 	/* Add any unterminated value at the very end. */
 	if( ReadingValue )
 		AddParam( cProcessed, iProcessedLen );
+}
+
+void MsdFile::Parse( bool bUnescape, ParseMode mode )
+{
+	m_Values.clear();
+	m_Params.clear();
+	values.clear();
+	if( !m_sBuffer.empty() )
+		ReadBuf( &m_sBuffer[0], m_sBuffer.size(), bUnescape );
 
-	delete [] cProcessed;
+	if( mode == VIEW_PARAMS )
+		return;
+
+	values.resize( m_Values.size() );
+	for( unsigned i = 0; i < m_Values.size(); ++i )
+	{
+		const value_view_t v = GetValueView( i );
+		values[i].params.reserve( v.size() );
+		for( unsigned j = 0; j < v.size(); ++j )
+			values[i].params.push_back( v[j] );
+	}
 }
 
 // returns true if successful, false otherwise
-bool MsdFile::ReadFile( RString sNewPath, bool bUnescape )
+bool MsdFile::ReadFile( RString sNewPath, bool bUnescape, ParseMode mode )
 {
 	error = "";
 
@@ -172,32 +198,33 @@ bool MsdFile::ReadFile( RString sNewPath, bool bUnescape )
 	}
 
 	// allocate a string to hold the file
-	RString FileString;
-	FileString.reserve( f.GetFileSize() );
+	m_sBuffer = RString();
+	m_sBuffer.reserve( f.GetFileSize() );
 
-	int iBytesRead = f.Read( FileString );
+	int iBytesRead = f.Read( m_sBuffer );
 	if( iBytesRead == -1 )
 	{
 		error = f.GetError();
 		return false;
 	}
 
-	ReadBuf( FileString.c_str(), iBytesRead, bUnescape );
+	Parse( bUnescape, mode );
 
 	return true;
 }
 
-void MsdFile::ReadFromString( const RString &sString, bool bUnescape )
+void MsdFile::ReadFromString( const RString &sString, bool bUnescape, ParseMode mode )
 {
-	ReadBuf( sString.c_str(), sString.size(), bUnescape );
+	m_sBuffer = sString;
+	Parse( bUnescape, mode );
 }
 
 RString MsdFile::GetParam(unsigned val, unsigned par) const
 {
-	if( val >= GetNumValues() || par >= GetNumParams(val) )
+	if( val >= GetNumValues() )
 		return RString();
 
-	return values[val].params[par];
+	return GetValueView( val )[par];
 }
 
 /*
@@ -1,6 +1,8 @@
 #ifndef MSDFILE_H
 #define MSDFILE_H
 
+#include <cstddef>
+#include <string_view>
 #include <vector>
 
 
@@ -8,6 +10,18 @@
 class MsdFile
 {
 public:
+	/**
+	 * @brief A parameter: a view into the file buffer.
+	 *
+	 * It converts to RString implicitly, so it can be passed anywhere a
+	 * string is expected; that makes a copy. */
+	struct param_t: public std::string_view
+	{
+		param_t() {}
+		param_t( const char *p, std::size_t n ): std::string_view( p, n ) {}
+		operator RString() const { return RString( data(), size() ); }
+	};
+
 	/**
 	 * @brief The list of params found in the files.
 	 *
@@ -27,6 +41,39 @@ public:
 		RString operator[]( unsigned i ) const { if( i >= params.size() ) return RString(); return params[i]; }
 	};
 
+	/**
+	 * @brief A value's params as views into the file buffer.
+	 *
+	 * Only valid as long as the MsdFile it came from is, and isn't
+	 * read into again. */
+	struct value_view_t
+	{
+		value_view_t(): m_pParams(nullptr), m_iNumParams(0) {}
+		value_view_t( const param_t *p, unsigned n ): m_pParams(p), m_iNumParams(n) {}
+
+		/**
+		 * @brief Access the proper parameter.
+		 * @param i the index.
+		 * @return the proper parameter, or an empty one if there is none.
+		 */
+		param_t operator[]( unsigned i ) const { if( i >= m_iNumParams ) return param_t(); return m_pParams[i]; }
+		/** @brief The number of parameters. */
+		unsigned size() const { return m_iNumParams; }
+
+	private:
+		const param_t *m_pParams;
+		unsigned m_iNumParams;
+	};
+
+	/**
+	 * @brief How to keep what's read.
+	 *
+	 * COPY_PARAMS copies every parameter into its own RString, for
+	 * GetValue().  VIEW_PARAMS only keeps the file buffer, with unescaping
+	 * done in place, and GetValueView() gives views into it: reading a
+	 * file makes a few allocations, however many parameters it has. */
+	enum ParseMode { COPY_PARAMS, VIEW_PARAMS };
+
 	MsdFile(): values(), error("") {}
 
 	/** @brief Remove the MSDFile. */
@@ -36,16 +83,18 @@ public:
 	 * @brief Attempt to read an MSD file.
 	 * @param sFilePath the path to the file.
 	 * @param bUnescape a flag to see if we need to unescape values.
+	 * @param mode whether to copy the parameters out.
 	 * @return its success or failure.
 	 */
-	bool ReadFile( RString sFilePath, bool bUnescape );
+	bool ReadFile( RString sFilePath, bool bUnescape, ParseMode mode = COPY_PARAMS );
 	/**
 	 * @brief Attempt to read an MSD file.
 	 * @param sString the path to the file.
 	 * @param bUnescape a flag to see if we need to unescape values.
+	 * @param mode whether to copy the parameters out.
 	 * @return its success or failure.
 	 */
-	void ReadFromString( const RString &sString, bool bUnescape );
+	void ReadFromString( const RString &sString, bool bUnescape, ParseMode mode = COPY_PARAMS );
 
 	/**
 	 * @brief Should an error take place, have an easy place to get it.
@@ -55,19 +104,31 @@ public:
 	/**
 	 * @brief Retrieve the number of values for each tag.
 	 * @return the nmber of values. */
-	unsigned GetNumValues() const { return values.size(); }
+	unsigned GetNumValues() const { return m_Values.size(); }
 	/**
 	 * @brief Get the number of parameters for the current index.
 	 * @param val the current value index.
 	 * @return the number of params.
 	 */
-	unsigned GetNumParams( unsigned val ) const { if( val >= GetNumValues() ) return 0; return values[val].params.size(); }
+	unsigned GetNumParams( unsigned val ) const { if( val >= GetNumValues() ) return 0; return m_Values[val].iNumParams; }
+	/**
+	 * @brief Get the specified value.  The file must have been read with
+	 * COPY_PARAMS.
+	 * @param val the current value index.
+	 * @return The specified value.
+	 */
+	const value_t &GetValue( unsigned val ) const { ASSERT(val < values.size()); return values[val]; }
 	/**
-	 * @brief Get the specified value.
+	 * @brief Get the specified value as views into the file buffer.
 	 * @param val the current value index.
 	 * @return The specified value.
 	 */
-	const value_t &GetValue( unsigned val ) const { ASSERT(val < GetNumValues()); return values[val]; }
+	value_view_t GetValueView( unsigned val ) const
+	{
+		ASSERT(val < GetNumValues());
+		const ValueSpan &v = m_Values[val];
+		return value_view_t( v.iNumParams? &m_Params[v.iFirstParam]:nullptr, v.iNumParams );
+	}
 	/**
 	 * @brief Retrieve the specified parameter.
 	 * @param val the current value index.
@@ -79,12 +140,18 @@ public:
 
 private:
 	/**
-	 * @brief Attempt to read an MSD file from the buffer.
+	 * @brief Parse m_sBuffer.
+	 * @param bUnescape a flag to see if we need to unescape values.
+	 * @param mode whether to copy the parameters out.
+	 */
+	void Parse( bool bUnescape, ParseMode mode );
+	/**
+	 * @brief Attempt to read an MSD file from the buffer, in place.
 	 * @param buf the buffer containing the MSD file.
 	 * @param len the length of the buffer.
 	 * @param bUnescape a flag to see if we need to unescape values.
 	 */
-	void ReadBuf( const char *buf, int len, bool bUnescape );
+	void ReadBuf( char *buf, int len, bool bUnescape );
 	/**
 	 * @brief Add a new parameter.
 	 * @param buf the new parameter.
@@ -96,10 +163,26 @@ private:
 	 */
 	void AddValue();
 
-	/** @brief The list of values. */
+	struct ValueSpan
+	{
+		unsigned iFirstParam;
+		unsigned iNumParams;
+	};
+
+	/** @brief The file, parsed in place; m_Params point into it. */
+	RString m_sBuffer;
+	/** @brief Every value's params, in order. */
+	std::vector<param_t> m_Params;
+	/** @brief Where each value's params are in m_Params. */
+	std::vector<ValueSpan> m_Values;
+	/** @brief The list of values, if read with COPY_PARAMS. */
 	std::vector<value_t> values;
 	/** @brief The error string. */
 	RString error;
+
+	// m_Params would point into the other file's buffer.
+	MsdFile& operator=(const MsdFile& rhs);
+	MsdFile(const MsdFile& rhs);
 };
 
 #endif
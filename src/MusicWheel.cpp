@@ -139,6 +139,15 @@ void MusicWheel::BeginScreen()
 {
 	RageTimer timer;
 	RString times;
+
+	// Nothing has built item data from the song lists yet this screen, so
+	// this is a safe time to take in songs found by the folder watcher.
+	if( SONGMAN->AddWatchedSongs() )
+	{
+		FOREACH_ENUM( SortOrder, so )
+			m_WheelItemDatasStatus[so] = INVALID;
+	}
+
 	FOREACH_ENUM( SortOrder, so ) {
 		if(m_WheelItemDatasStatus[so]!=INVALID) {
 			m_WheelItemDatasStatus[so]=NEEDREFILTER;
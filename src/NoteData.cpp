@@ -30,11 +30,19 @@ void NoteData::SetNumTracks( int iNewNumTracks )
 	m_TapNotes.resize( iNewNumTracks );
 }
 
+std::size_t NoteData::GetMemoryUsage() const
+{
+	std::size_t iBytes = sizeof(*this) + m_TapNotes.capacity() * sizeof(TrackMap);
+	for( TrackMap const &track : m_TapNotes )
+		iBytes += track.capacity() * sizeof(TrackMap::value_type);
+	return iBytes;
+}
+
 bool NoteData::IsComposite() const
 {
 	for( int track = 0; track < GetNumTracks(); ++track )
 	{
-		for (const std::pair<const int, TapNote>& tn : m_TapNotes[track])
+		for (TrackMap::value_type const &tn : m_TapNotes[track])
 			if( tn.second.pn != PLAYER_INVALID )
 				return true;
 	}
@@ -48,6 +56,7 @@ void NoteData::ClearRangeForTrack( int rowBegin, int rowEnd, int iTrack )
 	if( rowBegin == 0 && rowEnd == MAX_NOTE_ROW )
 	{
 		m_TapNotes[iTrack].clear();
+		TrackRowsMoved();
 		return;
 	}
 
@@ -110,7 +119,11 @@ void NoteData::ClearRangeForTrack( int rowBegin, int rowEnd, int iTrack )
 		GetTapNoteRangeInclusive( iTrack, rowBegin, rowEnd, lBegin, lEnd );
 	}
 
-	m_TapNotes[iTrack].erase( lBegin, lEnd );
+	if( lBegin != lEnd )
+	{
+		m_TapNotes[iTrack].erase( lBegin, lEnd );
+		TrackRowsMoved();
+	}
 }
 
 void NoteData::ClearRange( int rowBegin, int rowEnd )
@@ -335,14 +348,10 @@ void NoteData::AddHoldNote( int iTrack, int iStartRow, int iEndRow, TapNote tn )
 	tn.iDuration = iEndRow - iStartRow;
 
 	// Remove everything in the range.
-	while( lBegin != lEnd )
+	if( lBegin != lEnd )
 	{
-		iterator next = lBegin;
-		++next;
-
-		RemoveTapNote( iTrack, lBegin );
-
-		lBegin = next;
+		m_TapNotes[iTrack].erase( lBegin, lEnd );
+		TrackRowsMoved();
 	}
 
 	/* Additionally, if there's a tap note lying at the end of our range,
@@ -953,19 +962,39 @@ void NoteData::SetTapNote( int track, int row, const TapNote& t )
 	// Any blank space in the map is defined to be empty.
 	// If we're trying to insert an empty at a spot where another note
 	// already exists, then we're really deleting from the map.
+	TrackMap &trackMap = m_TapNotes[track];
 	if( t == TAP_EMPTY )
 	{
-		TrackMap &trackMap = m_TapNotes[track];
 		// remove the element at this position (if any).
 		// This will return either 0 or 1.
-		trackMap.erase( row );
+		if( trackMap.erase(row) )
+			TrackRowsMoved();
 	}
 	else
 	{
-		m_TapNotes[track][row] = t;
+		// Overwriting a note in place doesn't move anything.
+		const std::size_t iOldSize = trackMap.size();
+		trackMap[row] = t;
+		if( trackMap.size() != iOldSize )
+			TrackRowsMoved();
 	}
 }
 
+NoteData::iterator NoteData::RemoveTapNote( unsigned iTrack, iterator it )
+{
+	iterator next = m_TapNotes[iTrack].erase( it );
+	TrackRowsMoved();
+	return next;
+}
+
+void NoteData::SetTrackFromSorted( int track, const std::vector<std::pair<int,TapNote> > &vNotes )
+{
+	DEBUG_ASSERT( track>=0 && track<GetNumTracks() );
+
+	m_TapNotes[track] = TrackMap( vNotes.begin(), vNotes.end() );
+	TrackRowsMoved();
+}
+
 void NoteData::GetTracksHeldAtRow( int row, std::set<int>& addTo )
 {
 	for( int t=0; t<GetNumTracks(); ++t )
@@ -1306,7 +1335,6 @@ template<typename ND, typename iter, typename TN>
 
 		m_vBeginIters.push_back( begin );
 		m_vEndIters.push_back( end );
-		m_PrevCurrentRows.push_back(0);
 
 		iter cur;
 		if( m_bReverse )
@@ -1320,6 +1348,8 @@ template<typename ND, typename iter, typename TN>
 			cur = begin;
 		}
 		m_vCurrentIters.push_back( cur );
+		// Revalidating before the first ++ should find the same note again.
+		m_PrevCurrentRows.push_back( !bReverse && cur != end? cur->first:0 );
 	}
 	m_pNoteData->AddATIToList(this);
 
@@ -2,9 +2,12 @@
 #define NOTE_DATA_H
 
 #include "NoteTypes.h"
+#include "NoteTrack.h"
 
+#include <cstddef>
 #include <map>
 #include <set>
+#include <utility>
 #include <iterator>
 #include <vector>
 
@@ -30,11 +33,11 @@
 class NoteData
 {
 public:
-	typedef std::map<int,TapNote> TrackMap;
-	typedef std::map<int,TapNote>::iterator iterator;
-	typedef std::map<int,TapNote>::const_iterator const_iterator;
-	typedef std::map<int,TapNote>::reverse_iterator reverse_iterator;
-	typedef std::map<int,TapNote>::const_reverse_iterator const_reverse_iterator;
+	typedef NoteTrack TrackMap;
+	typedef NoteTrack::iterator iterator;
+	typedef NoteTrack::const_iterator const_iterator;
+	typedef NoteTrack::reverse_iterator reverse_iterator;
+	typedef NoteTrack::const_reverse_iterator const_reverse_iterator;
 
 	NoteData(): m_TapNotes() {}
 
@@ -160,6 +163,10 @@ private:
 	void AddATIToList(all_tracks_const_iterator* iter) const;
 	void RemoveATIFromList(all_tracks_iterator* iter) const;
 	void RemoveATIFromList(all_tracks_const_iterator* iter) const;
+	/* A row was inserted into or erased from a track, which moves the
+	 * notes after it, so any live all-tracks iterators have to be found
+	 * again.  This is what keeps the edit mode ones valid. */
+	void TrackRowsMoved() { if( !m_atis.empty() || !m_const_atis.empty() ) RevalidateATIs( std::vector<int>(), false ); }
 
 	// Mina stuf (Used for chartkey hashing)
 	std::vector<int> NonEmptyRowVector;
@@ -174,6 +181,8 @@ public:
 	int GetNumTracks() const { return m_TapNotes.size(); }
 	void SetNumTracks( int iNewNumTracks );
 	bool IsComposite() const;
+	/* Rough number of bytes held by the notes, for memory budgets. */
+	std::size_t GetMemoryUsage() const;
 	bool operator==( const NoteData &nd ) const			{ return m_TapNotes == nd.m_TapNotes; }
 	bool operator!=( const NoteData &nd ) const			{ return m_TapNotes != nd.m_TapNotes; }
 
@@ -192,14 +201,16 @@ public:
 
 	inline iterator FindTapNote( unsigned iTrack, int iRow )	{ return m_TapNotes[iTrack].find( iRow ); }
 	inline const_iterator FindTapNote( unsigned iTrack, int iRow ) const { return m_TapNotes[iTrack].find( iRow ); }
-	void RemoveTapNote( unsigned iTrack, iterator it )		{ m_TapNotes[iTrack].erase( it ); }
+	/* Returns the note after it.  Other iterators on the track are invalid
+	 * afterwards. */
+	iterator RemoveTapNote( unsigned iTrack, iterator it );
 
 	/**
 	 * @brief Return an iterator range for [rowBegin,rowEnd).
 	 *
 	 * This can be used to efficiently iterate trackwise over a range of notes.
 	 * It's like FOREACH_NONEMPTY_ROW_IN_TRACK_RANGE, except it only requires
-	 * two map searches (iterating is constant time), but the iterators will
+	 * two binary searches (iterating is constant time), but the iterators will
 	 * become invalid if the notes they represent disappear, so you need to
 	 * pay attention to how you modify the data.
 	 * @param iTrack the column to use.
@@ -261,6 +272,9 @@ public:
 
 	void MoveTapNoteTrack( int dest, int src );
 	void SetTapNote( int track, int row, const TapNote& tn );
+	/* Replace the notes on a track with vNotes, which must be sorted by row
+	 * with no row repeated.  Much quicker than a SetTapNote for each. */
+	void SetTrackFromSorted( int track, const std::vector<std::pair<int,TapNote> > &vNotes );
 	/**
 	 * @brief Add a hold note, merging other overlapping holds and destroying
 	 * tap notes underneath.
@@ -13,6 +13,8 @@
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <iterator>
 #include <utility>
 #include <vector>
 
@@ -59,6 +61,59 @@ NoteType NoteDataUtil::GetSmallestNoteTypeInRange( const NoteData &n, int iStart
 	return NoteType_Invalid;	// well-formed notes created in the editor should never get here
 }
 
+typedef std::vector<std::pair<int, TapNote> > SMTrackNotes;
+
+/* True if the first iNumTracks characters of the line are all '0'.  Most
+ * rows of most charts are, so check eight at a time. */
+static bool IsEmptySMRow( const char *p, const char *pEnd, int iNumTracks )
+{
+	if( pEnd - p < iNumTracks )
+		return false;
+
+	static const char ZEROS[8] = { '0','0','0','0','0','0','0','0' };
+	uint64_t iZeros;
+	std::memcpy( &iZeros, ZEROS, sizeof(iZeros) );
+
+	int i = 0;
+	for( ; i + 8 <= iNumTracks; i += 8 )
+	{
+		uint64_t iWord;
+		std::memcpy( &iWord, p + i, sizeof(iWord) );
+		if( iWord != iZeros )
+			return false;
+	}
+	for( ; i < iNumTracks; ++i )
+		if( p[i] != '0' )
+			return false;
+	return true;
+}
+
+/* NoteData::IsHoldNoteAtRow, on a track that's still being built. */
+static SMTrackNotes::iterator FindSMHoldHead( SMTrackNotes &vNotes, int iRow )
+{
+	SMTrackNotes::iterator it = vNotes.end();
+	while( it != vNotes.begin() )
+	{
+		--it;
+		if( it->first >= iRow )
+			continue;
+		const TapNote &tn = it->second;
+		switch( tn.type )
+		{
+		case TapNoteType_HoldHead:
+			if( tn.iDuration + it->first < iRow )
+				return vNotes.end();
+			return it;
+		case TapNoteType_Empty:
+		case TapNoteType_AutoKeysound:
+			continue;
+		default:
+			return vNotes.end();
+		}
+	}
+	return vNotes.end();
+}
+
 static void LoadFromSMNoteDataStringWithPlayer( NoteData& out, const RString &sSMNoteData, int start,
 						int len, PlayerNumber pn, int iNumTracks )
 {
@@ -68,6 +123,13 @@ static void LoadFromSMNoteDataStringWithPlayer( NoteData& out, const RString &sS
 	int size = -1;
 	const int end = start + len;
 	std::vector<std::pair<const char*, const char*> > aMeasureLines;
+
+	/* Rows only ever increase, so each track's notes are collected in order
+	 * and the tracks are built in one go at the end.  A row that rounds to
+	 * the same place as the one before it replaces it, as it would in the
+	 * map. */
+	std::vector<SMTrackNotes> vTracks( iNumTracks );
+
 	for( unsigned m = 0; true; ++m )
 	{
 		/* XXX Ignoring empty seems wrong for measures. It means that ",,," is treated as
@@ -109,6 +171,10 @@ static void LoadFromSMNoteDataStringWithPlayer( NoteData& out, const RString &sS
 			const char *const beginLine = p;
 			const char *const endLine = aMeasureLines[l].second;
 
+			// Nothing below does anything for a '0'.
+			if( IsEmptySMRow(beginLine, endLine, iNumTracks) )
+				continue;
+
 			const float fPercentIntoMeasure = l/(float)aMeasureLines.size();
 			const float fBeat = (m + fPercentIntoMeasure) * BEATS_PER_MEASURE;
 			const int iIndex = BeatToNoteRow( fBeat );
@@ -144,15 +210,16 @@ static void LoadFromSMNoteDataStringWithPlayer( NoteData& out, const RString &sS
 				case '3':
 				{
 					// This is the end of a hold. Search for the beginning.
-					int iHeadRow;
-					if( !out.IsHoldNoteAtRow( iTrack, iIndex, &iHeadRow ) )
+					SMTrackNotes &vNotes = vTracks[iTrack];
+					SMTrackNotes::iterator head = FindSMHoldHead( vNotes, iIndex );
+					if( head == vNotes.end() )
 					{
 						int n = intptr_t(endLine) - intptr_t(beginLine);
 						LOG->Warn( "Unmatched 3 in \"%.*s\"", n, beginLine );
 					}
 					else
 					{
-						out.FindTapNote( iTrack, iHeadRow )->second.iDuration = iIndex - iHeadRow;
+						head->second.iDuration = iIndex - head->first;
 					}
 
 					// This won't write tn, but keep parsing normally anyway.
@@ -236,13 +303,16 @@ static void LoadFromSMNoteDataStringWithPlayer( NoteData& out, const RString &sS
 				}
 #endif
 
-				/* Optimization: if we pass TAP_EMPTY, NoteData will do a search
-				 * to remove anything in this position.  We know that there's nothing
-				 * there, so avoid the search. */
+				/* Empty notes would only remove what's already at this
+				 * position, and there's nothing there. */
 				if( tn.type != TapNoteType_Empty && ch != '3' )
 				{
 					tn.pn = pn;
-					out.SetTapNote( iTrack, iIndex, tn );
+					SMTrackNotes &vNotes = vTracks[iTrack];
+					if( !vNotes.empty() && vNotes.back().first == iIndex )
+						vNotes.back().second = tn;
+					else
+						vNotes.push_back( std::make_pair(iIndex, tn) );
 				}
 
 				iTrack++;
@@ -251,23 +321,25 @@ static void LoadFromSMNoteDataStringWithPlayer( NoteData& out, const RString &sS
 	}
 
 	// Make sure we don't have any hold notes that didn't find a tail.
-	for( int t=0; t<out.GetNumTracks(); t++ )
+	for( int t=0; t<iNumTracks; t++ )
 	{
-		NoteData::iterator begin = out.begin( t );
-		NoteData::iterator lEnd = out.end( t );
-		while( begin != lEnd )
+		SMTrackNotes &vNotes = vTracks[t];
+		SMTrackNotes::iterator dest = vNotes.begin();
+		for( SMTrackNotes::iterator it = vNotes.begin(); it != vNotes.end(); ++it )
 		{
-			NoteData::iterator next = Increment( begin );
-			const TapNote &tn = begin->second;
+			const TapNote &tn = it->second;
 			if( tn.type == TapNoteType_HoldHead && tn.iDuration == MAX_NOTE_ROW )
 			{
-				int iRow = begin->first;
+				int iRow = it->first;
 				LOG->UserLog( "", "", "While loading .sm/.ssc note data, there was an unmatched 2 at beat %f", NoteRowToBeat(iRow) );
-				out.RemoveTapNote( t, begin );
+				continue;
 			}
-
-			begin = next;
+			if( dest != it )
+				*dest = std::move( *it );
+			++dest;
 		}
+		vNotes.erase( dest, vNotes.end() );
+		out.SetTrackFromSorted( t, vNotes );
 	}
 	out.RevalidateATIs(std::vector<int>(), false);
 }
@@ -327,9 +399,7 @@ void NoteDataUtil::InsertHoldTails( NoteData &inout )
 {
 	for( int t=0; t < inout.GetNumTracks(); t++ )
 	{
-		NoteData::iterator begin = inout.begin(t), end = inout.end(t);
-
-		for( ; begin != end; ++begin )
+		for( NoteData::iterator begin = inout.begin(t); begin != inout.end(t); ++begin )
 		{
 			int iRow = begin->first;
 			const TapNote &tn = begin->second;
@@ -339,11 +409,14 @@ void NoteDataUtil::InsertHoldTails( NoteData &inout )
 			TapNote tail = tn;
 			tail.type = TapNoteType_HoldTail;
 
-			/* If iDuration is 0, we'd end up overwriting the head with the tail
-			 * (and invalidating our iterator). Empty hold notes aren't valid. */
+			/* If iDuration is 0, we'd end up overwriting the head with the tail.
+			 * Empty hold notes aren't valid. */
 			ASSERT( tn.iDuration != 0 );
 
+			// The tail goes after us, but adding it may move the whole track.
+			const int iPos = begin - inout.begin(t);
 			inout.SetTapNote( t, iRow + tn.iDuration, tail );
+			begin = inout.begin(t) + iPos;
 		}
 	}
 }
@@ -436,6 +509,201 @@ void NoteDataUtil::GetSMNoteDataString( const NoteData &in, RString &sRet )
 	}
 }
 
+/* Bump this if the packed layout changes. */
+static const char PACKED_NOTE_DATA_VERSION = 1;
+
+enum
+{
+	PACKED_TYPE_MASK = 0x0F,
+	PACKED_SUBTYPE_SHIFT = 4,
+	PACKED_SUBTYPE_MASK = 0x30,
+	PACKED_HAS_EXTRAS = 0x80,
+
+	PACKED_EXTRA_KEYSOUND = 0x01,
+	PACKED_EXTRA_PLAYER = 0x02,
+	PACKED_EXTRA_ATTACK = 0x04,
+	PACKED_EXTRA_SOURCE = 0x08,
+	PACKED_EXTRA_DURATION = 0x10
+};
+
+static void PutVarint( RString &out, uint32_t i )
+{
+	while( i >= 0x80 )
+	{
+		out.append( 1, char((i & 0x7F) | 0x80) );
+		i >>= 7;
+	}
+	out.append( 1, char(i) );
+}
+
+static bool GetVarint( const char *&p, const char *pEnd, uint32_t &iOut )
+{
+	iOut = 0;
+	for( int iShift = 0; iShift < 35; iShift += 7 )
+	{
+		if( p == pEnd )
+			return false;
+		const uint8_t c = uint8_t( *p++ );
+		iOut |= uint32_t(c & 0x7F) << iShift;
+		if( !(c & 0x80) )
+			return true;
+	}
+	return false;
+}
+
+void NoteDataUtil::GetPackedNoteDataString( const NoteData &in, RString &out )
+{
+	out = RString();
+	out.append( 1, PACKED_NOTE_DATA_VERSION );
+	PutVarint( out, in.GetNumTracks() );
+	for( int t = 0; t < in.GetNumTracks(); ++t )
+	{
+		PutVarint( out, std::distance(in.begin(t), in.end(t)) );
+
+		int iPrevRow = 0;
+		for( NoteData::const_iterator it = in.begin(t); it != in.end(t); ++it )
+		{
+			const TapNote &tn = it->second;
+			PutVarint( out, it->first - iPrevRow );
+			iPrevRow = it->first;
+
+			uint8_t iExtras = 0;
+			if( tn.iKeysoundIndex >= 0 )
+				iExtras |= PACKED_EXTRA_KEYSOUND;
+			if( tn.pn != PLAYER_INVALID )
+				iExtras |= PACKED_EXTRA_PLAYER;
+			if( tn.type == TapNoteType_Attack || !tn.sAttackModifiers.empty() || tn.fAttackDurationSeconds != 0 )
+				iExtras |= PACKED_EXTRA_ATTACK;
+			if( tn.source != TapNoteSource_Original )
+				iExtras |= PACKED_EXTRA_SOURCE;
+			if( tn.type != TapNoteType_HoldHead && tn.iDuration != 0 )
+				iExtras |= PACKED_EXTRA_DURATION;
+
+			uint8_t iPacked = uint8_t( tn.type & PACKED_TYPE_MASK );
+			iPacked |= uint8_t( (tn.subType << PACKED_SUBTYPE_SHIFT) & PACKED_SUBTYPE_MASK );
+			if( iExtras )
+				iPacked |= PACKED_HAS_EXTRAS;
+			out.append( 1, char(iPacked) );
+
+			if( tn.type == TapNoteType_HoldHead )
+				PutVarint( out, tn.iDuration );
+			if( !iExtras )
+				continue;
+
+			out.append( 1, char(iExtras) );
+			if( iExtras & PACKED_EXTRA_KEYSOUND )
+				PutVarint( out, tn.iKeysoundIndex );
+			if( iExtras & PACKED_EXTRA_PLAYER )
+				out.append( 1, char(tn.pn) );
+			if( iExtras & PACKED_EXTRA_ATTACK )
+			{
+				PutVarint( out, tn.sAttackModifiers.size() );
+				out.append( tn.sAttackModifiers );
+				uint32_t iDuration;
+				std::memcpy( &iDuration, &tn.fAttackDurationSeconds, sizeof(iDuration) );
+				PutVarint( out, iDuration );
+			}
+			if( iExtras & PACKED_EXTRA_SOURCE )
+				out.append( 1, char(tn.source) );
+			if( iExtras & PACKED_EXTRA_DURATION )
+				PutVarint( out, tn.iDuration );
+		}
+	}
+}
+
+bool NoteDataUtil::LoadFromPackedNoteDataString( NoteData &out, const RString &sPacked )
+{
+	out.Init();
+
+	const char *p = sPacked.data();
+	const char *pEnd = p + sPacked.size();
+	uint32_t iNumTracks;
+	if( p == pEnd || *p++ != PACKED_NOTE_DATA_VERSION ||
+		!GetVarint(p, pEnd, iNumTracks) || iNumTracks > MAX_NOTE_TRACKS )
+		return false;
+	if( iNumTracks > 0 )
+		out.SetNumTracks( iNumTracks );
+
+	bool bOK = true;
+	for( uint32_t t = 0; t < iNumTracks && bOK; ++t )
+	{
+		uint32_t iNumNotes;
+		bOK = GetVarint( p, pEnd, iNumNotes );
+
+		uint32_t iRow = 0;
+		for( uint32_t n = 0; n < iNumNotes && bOK; ++n )
+		{
+			uint32_t iDelta;
+			if( !GetVarint(p, pEnd, iDelta) || p == pEnd )
+			{
+				bOK = false;
+				break;
+			}
+			iRow += iDelta;
+
+			const uint8_t iPacked = uint8_t( *p++ );
+			TapNote tn;
+			tn.type = TapNoteType( iPacked & PACKED_TYPE_MASK );
+			tn.subType = TapNoteSubType( (iPacked & PACKED_SUBTYPE_MASK) >> PACKED_SUBTYPE_SHIFT );
+
+			uint32_t i;
+			if( tn.type == TapNoteType_HoldHead )
+			{
+				bOK = GetVarint( p, pEnd, i );
+				tn.iDuration = int( i );
+			}
+			if( bOK && (iPacked & PACKED_HAS_EXTRAS) )
+			{
+				const uint8_t iExtras = p == pEnd? 0:uint8_t( *p++ );
+				bOK = iExtras != 0;
+				if( bOK && (iExtras & PACKED_EXTRA_KEYSOUND) )
+				{
+					bOK = GetVarint( p, pEnd, i );
+					tn.iKeysoundIndex = int( i );
+				}
+				if( bOK && (iExtras & PACKED_EXTRA_PLAYER) )
+				{
+					bOK = p != pEnd;
+					if( bOK )
+						tn.pn = PlayerNumber( uint8_t(*p++) );
+				}
+				if( bOK && (iExtras & PACKED_EXTRA_ATTACK) )
+				{
+					bOK = GetVarint( p, pEnd, i ) && i <= uint32_t(pEnd - p);
+					if( bOK )
+					{
+						tn.sAttackModifiers.assign( p, i );
+						p += i;
+						bOK = GetVarint( p, pEnd, i );
+						std::memcpy( &tn.fAttackDurationSeconds, &i, sizeof(i) );
+					}
+				}
+				if( bOK && (iExtras & PACKED_EXTRA_SOURCE) )
+				{
+					bOK = p != pEnd;
+					if( bOK )
+						tn.source = TapNoteSource( uint8_t(*p++) );
+				}
+				if( bOK && (iExtras & PACKED_EXTRA_DURATION) )
+				{
+					bOK = GetVarint( p, pEnd, i );
+					tn.iDuration = int( i );
+				}
+			}
+			if( bOK )
+				out.SetTapNote( t, iRow, tn );
+		}
+	}
+
+	if( !bOK || p != pEnd )
+	{
+		out.Init();
+		return false;
+	}
+	out.RevalidateATIs( std::vector<int>(), false );
+	return true;
+}
+
 void NoteDataUtil::SplitCompositeNoteData( const NoteData &in, std::vector<NoteData> &out )
 {
 	if( !in.IsComposite() )
@@ -1358,7 +1626,7 @@ void NoteDataUtil::RemoveAllButPlayer( NoteData &inout, PlayerNumber pn )
 		while( i != inout.end(track) )
 		{
 			if( i->second.pn != pn && i->second.pn != PLAYER_INVALID )
-				inout.RemoveTapNote( track, i++ );
+				i = inout.RemoveTapNote( track, i );
 			else
 				++i;
 		}
@@ -3197,16 +3465,14 @@ void NoteDataUtil::DeleteRows( NoteData &nd, int iStartIndex, int iRowsToDelete
 
 void NoteDataUtil::RemoveAllTapsOfType( NoteData& ndInOut, TapNoteType typeToRemove )
 {
-	/* Be very careful when deleting the tap notes. Erasing elements from maps using
-	 * iterators invalidates only the iterator that is being erased. To that end,
-	 * increment the iterator before deleting the elment of the map.
-	 */
+	/* Be very careful when deleting the tap notes. Erasing a note moves the ones
+	 * after it, so carry on from the iterator RemoveTapNote returns. */
 	for( int t=0; t<ndInOut.GetNumTracks(); t++ )
 	{
 		for( NoteData::iterator iter = ndInOut.begin(t); iter != ndInOut.end(t); )
 		{
 			if( iter->second.type == typeToRemove )
-				ndInOut.RemoveTapNote( t, iter++ );
+				iter = ndInOut.RemoveTapNote( t, iter );
 			else
 				++iter;
 		}
@@ -3222,7 +3488,7 @@ void NoteDataUtil::RemoveAllTapsExceptForType( NoteData& ndInOut, TapNoteType ty
 		for( NoteData::iterator iter = ndInOut.begin(t); iter != ndInOut.end(t); )
 		{
 			if( iter->second.type != typeToKeep )
-				ndInOut.RemoveTapNote( t, iter++ );
+				iter = ndInOut.RemoveTapNote( t, iter );
 			else
 				++iter;
 		}
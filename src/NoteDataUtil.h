@@ -30,6 +30,23 @@ namespace NoteDataUtil
 	NoteType GetSmallestNoteTypeInRange( const NoteData &nd, int iStartIndex, int iEndIndex );
 	void LoadFromSMNoteDataString( NoteData &out, const RString &sSMNoteData, bool bComposite );
 	void GetSMNoteDataString( const NoteData &in, RString &notes_out );
+	/**
+	 * @brief Pack NoteData into a compact binary string.
+	 *
+	 * Each track is a count followed by its notes: a varint row delta, a
+	 * byte holding the type and subtype, and a varint duration for holds.
+	 * Keysounds, attacks, players and non-original sources are only stored
+	 * for the notes that have them.  Unpacking gives back NoteData equal to
+	 * the input, so it produces the same GetSMNoteDataString.
+	 * @param in the NoteData to pack.
+	 * @param out the packed string. */
+	void GetPackedNoteDataString( const NoteData &in, RString &out );
+	/**
+	 * @brief Unpack a string made by GetPackedNoteDataString.
+	 * @param out the NoteData, which takes the packed track count.
+	 * @param sPacked the packed string.
+	 * @return false if sPacked is damaged; out is left empty. */
+	bool LoadFromPackedNoteDataString( NoteData &out, const RString &sPacked );
 	void SplitCompositeNoteData( const NoteData &in, std::vector<NoteData> &out );
 	void CombineCompositeNoteData( NoteData &out, const std::vector<NoteData> &in );
 	/**
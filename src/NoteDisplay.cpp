@@ -19,6 +19,7 @@
 #include "Sprite.h"
 #include "Style.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstdint>
 #include <vector>
@@ -354,17 +355,16 @@ void NCSplineHandler::MakeWeightedAverage(NCSplineHandler& out,
 		between);
 }
 
-void NoteColumnRenderArgs::spae_pos_for_beat(const PlayerState* player_state,
-	float beat, float y_offset, float y_reverse_offset,
+void NoteColumnRenderArgs::spae_pos_for_beat(float beat, float y_offset,
 	RageVector3& sp_pos, RageVector3& ae_pos) const
 {
 	switch(pos_handler->m_spline_mode)
 	{
 		case NCSM_Disabled:
-			ArrowEffects::GetXYZPos(player_state, column, y_offset, y_reverse_offset, ae_pos);
+			ArrowEffects::GetXYZPos(ae_context, y_offset, ae_pos);
 			break;
 		case NCSM_Offset:
-			ArrowEffects::GetXYZPos(player_state, column, y_offset, y_reverse_offset, ae_pos);
+			ArrowEffects::GetXYZPos(ae_context, y_offset, ae_pos);
 			pos_handler->EvalForBeat(song_beat, beat, sp_pos);
 			break;
 		case NCSM_Position:
@@ -374,16 +374,16 @@ void NoteColumnRenderArgs::spae_pos_for_beat(const PlayerState* player_state,
 			break;
 	}
 }
-void NoteColumnRenderArgs::spae_zoom_for_beat(const PlayerState* state, float beat,
-	RageVector3& sp_zoom, RageVector3& ae_zoom, int col_num, float y_offset) const
+void NoteColumnRenderArgs::spae_zoom_for_beat(float beat,
+	RageVector3& sp_zoom, RageVector3& ae_zoom, float y_offset) const
 {
 	switch(zoom_handler->m_spline_mode)
 	{
 		case NCSM_Disabled:
-			ae_zoom.x= ae_zoom.y= ae_zoom.z= ArrowEffects::GetZoom(state, y_offset, col_num);
+			ae_zoom.x= ae_zoom.y= ae_zoom.z= ArrowEffects::GetZoom(ae_context, y_offset);
 			break;
 		case NCSM_Offset:
-			ae_zoom.x= ae_zoom.y= ae_zoom.z= ArrowEffects::GetZoom(state, y_offset, col_num);
+			ae_zoom.x= ae_zoom.y= ae_zoom.z= ArrowEffects::GetZoom(ae_context, y_offset);
 			zoom_handler->EvalForBeat(song_beat, beat, sp_zoom);
 			break;
 		case NCSM_Position:
@@ -410,6 +410,29 @@ void NoteColumnRenderArgs::SetPRZForActor(Actor* actor,
 }
 
 
+// spae_pos_for_beat and spae_zoom_for_beat for a note in an
+// ArrowEffects::NoteBatch, where the effect part is already worked out.
+static void spline_and_effect(const NCSplineHandler* handler, float song_beat,
+	float beat, const RageVector3& effect, RageVector3& sp_out,
+	RageVector3& ae_out)
+{
+	switch(handler->m_spline_mode)
+	{
+		case NCSM_Disabled:
+			ae_out= effect;
+			break;
+		case NCSM_Offset:
+			ae_out= effect;
+			handler->EvalForBeat(song_beat, beat, sp_out);
+			break;
+		case NCSM_Position:
+			handler->EvalForBeat(song_beat, beat, sp_out);
+			break;
+		default:
+			break;
+	}
+}
+
 NoteDisplay::NoteDisplay()
 {
 	cache = new NoteMetricCache_t;
@@ -459,7 +482,7 @@ inline float NoteRowToVisibleBeat( const PlayerState *pPlayerState, int iRow )
 	return NoteRowToBeat(iRow);
 }
 
-bool NoteDisplay::IsOnScreen( float fBeat, int iCol, int iDrawDistanceAfterTargetsPixels, int iDrawDistanceBeforeTargetsPixels ) const
+bool NoteDisplay::IsOnScreen( const ArrowEffects::FrameContext &context, float fBeat, int iDrawDistanceAfterTargetsPixels, int iDrawDistanceBeforeTargetsPixels ) const
 {
 	// IMPORTANT:  Do not modify this function without also modifying the
 	// version that is in NoteField.cpp or coming up with a good way to
@@ -467,7 +490,7 @@ bool NoteDisplay::IsOnScreen( float fBeat, int iCol, int iDrawDistanceAfterTarge
 	// TRICKY: If boomerang is on, then ones in the range
 	// [iFirstRowToDraw,iLastRowToDraw] aren't necessarily visible.
 	// Test to see if this beat is visible before drawing.
-	float fYOffset = ArrowEffects::GetYOffset( m_pPlayerState, iCol, fBeat );
+	float fYOffset = ArrowEffects::GetYOffset( context, fBeat );
 	if( fYOffset > iDrawDistanceBeforeTargetsPixels )	// off screen
 		return false;
 	if( fYOffset < iDrawDistanceAfterTargetsPixels )	// off screen
@@ -495,10 +518,10 @@ bool NoteDisplay::DrawHoldsInRange(const NoteFieldRenderArgs& field_args,
 		float throw_away;
 		bool start_past_peak = false;
 		bool end_past_peak = false;
-		float start_y	= ArrowEffects::GetYOffset(m_pPlayerState, column_args.column,
+		float start_y	= ArrowEffects::GetYOffset(column_args.ae_context,
 			NoteRowToVisibleBeat(m_pPlayerState, start_row), throw_away,
 			start_past_peak);
-		float end_y	= ArrowEffects::GetYOffset(m_pPlayerState, column_args.column,
+		float end_y	= ArrowEffects::GetYOffset(column_args.ae_context,
 			NoteRowToVisibleBeat(m_pPlayerState, end_row), throw_away,
 			end_past_peak);
 		bool tail_visible = field_args.draw_pixels_after_targets <= end_y &&
@@ -548,20 +571,60 @@ bool NoteDisplay::DrawTapsInRange(const NoteFieldRenderArgs& field_args,
 {
 	bool any_upcoming= false;
 
-	auto loop_body = [this, &field_args, &column_args, &any_upcoming](const NoteData::TrackMap::const_iterator& tapit)
+	// Work out the effects for all of the taps in the column together, then
+	// draw them one at a time from the results.
+	ArrowEffects::NoteBatch& batch= m_tap_batch;
+	batch.Resize(tap_set.size());
+	for(size_t i= 0; i < tap_set.size(); ++i)
 	{
-		int tap_row= tapit->first;
-		const TapNote& tn= tapit->second;
+		batch.m_fBeat[i]= NoteRowToBeat(tap_set[i]->first);
+	}
+	ArrowEffects::GetYOffsets(column_args.ae_context, batch);
+
+	// TRICKY: If boomerang is on, then all notes in the range
+	// [first_row,last_row] aren't necessarily visible.
+	// Test every note to make sure it's on screen before drawing.
+	// This is the same test as IsOnScreen, which takes whole pixels.
+	const int draw_after= field_args.draw_pixels_after_targets;
+	const int draw_before= field_args.draw_pixels_before_targets;
+	m_taps_on_screen.clear();
+	for(size_t i= 0; i < tap_set.size(); ++i)
+	{
+		const float y_offset= batch.m_fYOffset[i];
+		if(y_offset > draw_before || y_offset < draw_after)
+		{
+			continue;
+		}
+		int tap_row= tap_set[i]->first;
+		const TapNote& tn= tap_set[i]->second;
+		size_t on_screen= m_taps_on_screen.size();
 
-		// TRICKY: If boomerang is on, then all notes in the range
-		// [first_row,last_row] aren't necessarily visible.
-		// Test every note to make sure it's on screen before drawing.
-		if(!IsOnScreen(NoteRowToBeat(tap_row), column_args.column,
-				field_args.draw_pixels_after_targets, field_args.draw_pixels_before_targets))
+		bool in_selection_range = false;
+		if(*field_args.selection_begin_marker != -1 && *field_args.selection_end_marker != -1)
 		{
-			return; // skip
+			in_selection_range = *field_args.selection_begin_marker <= tap_row &&
+				tap_row < *field_args.selection_end_marker;
 		}
 
+		batch.m_fBeat[on_screen]= NoteRowToVisibleBeat(m_pPlayerState, tap_row);
+		batch.m_fYOffset[on_screen]= y_offset;
+		batch.m_fPercentFadeToFail[on_screen]= in_selection_range ?
+			field_args.selection_glow : field_args.fail_fade;
+		batch.m_bIsHoldHead[on_screen]= tn.type == TapNoteType_HoldHead;
+		batch.m_bIsHoldCap[on_screen]= tn.type == TapNoteType_HoldHead ||
+			tn.type == TapNoteType_HoldTail;
+		m_taps_on_screen.push_back(tap_set[i]);
+	}
+	batch.Resize(m_taps_on_screen.size());
+	ArrowEffects::GetNoteEffects(column_args.ae_context, batch,
+		field_args.draw_pixels_before_targets, field_args.fade_before_targets);
+
+	auto loop_body = [this, &field_args, &column_args, &any_upcoming, &batch](size_t i)
+	{
+		const NoteData::TrackMap::const_iterator& tapit= m_taps_on_screen[i];
+		int tap_row= tapit->first;
+		const TapNote& tn= tapit->second;
+
 		// Hm, this assert used to pass the first and last rows to draw, when it
 		// was in NoteField, but those aren't available here.
 		// Well, anyone who has to investigate hitting it can use a debugger to
@@ -605,19 +668,10 @@ bool NoteDisplay::DrawTapsInRange(const NoteFieldRenderArgs& field_args,
 			}
 		}
 
-		bool in_selection_range = false;
-		if(*field_args.selection_begin_marker != -1 && *field_args.selection_end_marker != -1)
-		{
-			in_selection_range = *field_args.selection_begin_marker <= tap_row &&
-				tap_row < *field_args.selection_end_marker;
-		}
-
 		bool is_addition = (tn.source == TapNoteSource_Addition);
-		DrawTap(tn, field_args, column_args,
-			NoteRowToVisibleBeat(m_pPlayerState, tap_row),
+		DrawTap(tn, field_args, column_args, batch.m_fBeat[i],
 			hold_begins_on_this_beat, roll_begins_on_this_beat,
-			is_addition,
-			in_selection_range ? field_args.selection_glow : field_args.fail_fade);
+			is_addition, batch.m_fPercentFadeToFail[i], &batch, i);
 
 		any_upcoming |= NoteRowToBeat(tap_row) >
 			m_pPlayerState->GetDisplayedPosition().m_fSongBeat;
@@ -631,12 +685,18 @@ bool NoteDisplay::DrawTapsInRange(const NoteFieldRenderArgs& field_args,
 	if (g_bRenderEarlierNotesOnTop.Get())
 	{
 		// draw notes from closest to furthest
-		std::for_each(tap_set.rbegin(), tap_set.rend(), loop_body);
+		for(size_t i= m_taps_on_screen.size(); i > 0; --i)
+		{
+			loop_body(i - 1);
+		}
 	}
 	else
 	{
 		// draw notes from furthest to closest
-		std::for_each(tap_set.begin(), tap_set.end(), loop_body);
+		for(size_t i= 0; i < m_taps_on_screen.size(); ++i)
+		{
+			loop_body(i);
+		}
 	}
 
 	return any_upcoming;
@@ -652,6 +712,23 @@ bool NoteDisplay::DrawRollHeadForTapsOnSameRow() const
 	return cache->m_bDrawRollHeadForTapsOnSameRow;
 }
 
+void NoteDisplay::GetHoldTextures( std::vector<RageTexture*> &vpOut )
+{
+	FOREACH_HoldType( ht )
+	{
+		FOREACH_ActiveType( at )
+		{
+			NoteColorSprite *parts[] = { &m_HoldTopCap[ht][at], &m_HoldBody[ht][at], &m_HoldBottomCap[ht][at] };
+			for( NoteColorSprite *ncs : parts )
+			{
+				Sprite *pSprite = ncs->Get();
+				if( pSprite != nullptr && pSprite->GetTexture() != nullptr )
+					vpOut.push_back( pSprite->GetTexture() );
+			}
+		}
+	}
+}
+
 void NoteDisplay::Update( float fDeltaTime )
 {
 	/* This function is static: it's called once per game loop, not once per
@@ -715,12 +792,12 @@ Sprite *NoteDisplay::GetHoldSprite( NoteColorSprite ncs[NUM_HoldType][NUM_Active
 	return pSpriteOut;
 }
 
-static float ArrowGetAlphaOrGlow( bool bGlow, const PlayerState* pPlayerState, int iCol, float fYOffset, float fPercentFadeToFail, float fYReverseOffsetPixels, float fDrawDistanceBeforeTargetsPixels, float fFadeInPercentOfDrawFar )
+static float ArrowGetAlphaOrGlow( bool bGlow, const ArrowEffects::FrameContext &context, float fYOffset, float fPercentFadeToFail, float fDrawDistanceBeforeTargetsPixels, float fFadeInPercentOfDrawFar )
 {
 	if( bGlow )
-		return ArrowEffects::GetGlow(pPlayerState, iCol, fYOffset, fPercentFadeToFail, fYReverseOffsetPixels, fDrawDistanceBeforeTargetsPixels, fFadeInPercentOfDrawFar);
+		return ArrowEffects::GetGlow(context, fYOffset, fPercentFadeToFail, fDrawDistanceBeforeTargetsPixels, fFadeInPercentOfDrawFar);
 	else
-		return ArrowEffects::GetAlpha(pPlayerState, iCol, fYOffset, fPercentFadeToFail, fYReverseOffsetPixels, fDrawDistanceBeforeTargetsPixels, fFadeInPercentOfDrawFar);
+		return ArrowEffects::GetAlpha(context, fYOffset, fPercentFadeToFail, fDrawDistanceBeforeTargetsPixels, fFadeInPercentOfDrawFar);
 }
 
 struct StripBuffer
@@ -750,12 +827,33 @@ struct StripBuffer
 	int Free() const { return size - Used(); }
 };
 
-enum hold_part_type
+// Whether every row of a hold strip in this column has the same shape, so
+// that only its y position changes along the hold.
+static bool HoldShapeIsRigid(const NoteColumnRenderArgs& column_args,
+	const PlayerState* player_state)
 {
-	hpt_top,
-	hpt_body,
-	hpt_bottom,
-};
+	typedef ArrowEffects::FrameContext FrameContext;
+	return column_args.pos_handler->m_spline_mode == NCSM_Disabled &&
+		column_args.rot_handler->m_spline_mode == NCSM_Disabled &&
+		column_args.zoom_handler->m_spline_mode == NCSM_Disabled &&
+		!column_args.ae_context.IsOn(FrameContext::MOD_XPOS |
+			FrameContext::MOD_ZPOS | FrameContext::MOD_ROTATION_Y |
+			FrameContext::MOD_ZOOM) &&
+		player_state->m_EffectHistory.IsAllZero();
+}
+
+// Whether ArrowGetAlphaOrGlow is linear in the y position along a hold,
+// apart from the start and end of the fade in.  A hold that has faded past
+// half way is invisible up to the fade in and jumps to full alpha there,
+// which only a row every step draws the way it always has.
+static bool HoldAlphaIsLinear(const ArrowEffects::FrameContext& context,
+	const PlayerState* player_state, float percent_fade_to_fail)
+{
+	typedef ArrowEffects::FrameContext FrameContext;
+	return !context.IsOn(FrameContext::MOD_VISIBILITY | FrameContext::MOD_YPOS) &&
+		(percent_fade_to_fail == -1 || 1 - percent_fade_to_fail > 0.5f) &&
+		player_state->m_PlayerOptions.GetCurrent().m_fEffects[PlayerOptions::EFFECT_PARABOLA_Y] == 0;
+}
 
 void NoteDisplay::DrawHoldPart(std::vector<Sprite*> &vpSpr,
 	const NoteFieldRenderArgs& field_args,
@@ -764,7 +862,7 @@ void NoteDisplay::DrawHoldPart(std::vector<Sprite*> &vpSpr,
 {
 	ASSERT(!vpSpr.empty());
 
-	float ae_zoom= ArrowEffects::GetZoom(m_pPlayerState, 0, column_args.column);
+	float ae_zoom= ArrowEffects::GetZoom(column_args.ae_context, 0);
 	Sprite *pSprite = vpSpr.front();
 
 	// draw manually in small segments
@@ -848,8 +946,55 @@ void NoteDisplay::DrawHoldPart(std::vector<Sprite*> &vpSpr,
 	// pos_z_vec will be used later to orient the hold.  Read below. -Kyz
 	static const RageVector3 pos_z_vec(0.0f, 0.0f, 1.0f);
 	static const RageVector3 pos_y_vec(0.0f, 1.0f, 0.0f);
+	// When nothing bends, twists or widens the hold, every row of the strip
+	// has the same cross-section moved down to fY, so the ArrowEffects that
+	// shape it only need to be asked about the first row.
+	const bool rigid= !part_args.sample_every_step &&
+		HoldShapeIsRigid(column_args, field_args.player_state);
+	// If the alpha is also a straight line down the hold, apart from where
+	// the fade in starts and ends, the rows in between add nothing and the
+	// strip only needs a row at each of those points and at each end.
+	float alpha_breaks[4];
+	int num_alpha_breaks= 0;
+	const bool coarse= rigid && HoldAlphaIsLinear(column_args.ae_context,
+		field_args.player_state, part_args.percent_fade_to_fail);
+	if(coarse)
+	{
+		const float start_alpha_y= ArrowEffects::GetYPos(column_args.ae_context,
+			ArrowEffects::GetYOffsetFromYPos(column_args.ae_context, y_start_pos), false);
+		const float end_alpha_y= ArrowEffects::GetYPos(column_args.ae_context,
+			ArrowEffects::GetYOffsetFromYPos(column_args.ae_context, y_end_pos), false);
+		const float fade_ys[2]= {
+			field_args.draw_pixels_before_targets * (1 - field_args.fade_before_targets),
+			field_args.draw_pixels_before_targets};
+		// With no fade in, the alpha drops straight from full to nothing, so
+		// put a row half a pixel to either side of the drop instead of one on it.
+		const float step_half_width= fade_ys[0] == fade_ys[1] ? .5f : 0;
+		for(int i= 0; i < 2 && start_alpha_y != end_alpha_y; ++i)
+		{
+			const float break_y= SCALE(fade_ys[i], start_alpha_y, end_alpha_y, y_start_pos, y_end_pos);
+			const float ys[2]= {break_y - step_half_width, break_y + step_half_width};
+			for(int j= 0; j < (step_half_width != 0 ? 2 : 1); ++j)
+			{
+				if(ys[j] > y_start_pos && ys[j] < y_end_pos)
+				{
+					alpha_breaks[num_alpha_breaks++]= ys[j];
+				}
+			}
+		}
+		std::sort(alpha_breaks, alpha_breaks + num_alpha_breaks);
+	}
+	int next_alpha_break= 0;
+
+	const float move_y= ArrowEffects::GetMoveY(column_args.column);
+	RageVector3 row_center;
+	RageVector3 render_forward;
+	RageVector3 render_left;
+	float fVariableZoom= 1;
+
 	StripBuffer queue;
-	for(float fY = y_start_pos; !last_vert_set; fY += part_args.y_step)
+	float fY= y_start_pos;
+	while(!last_vert_set)
 	{
 		if(fY >= y_end_pos)
 		{
@@ -857,124 +1002,152 @@ void NoteDisplay::DrawHoldPart(std::vector<Sprite*> &vpSpr,
 			last_vert_set = true;
 		}
 
-		const float fYOffset= ArrowEffects::GetYOffsetFromYPos(column_args.column, fY, m_fYReverseOffsetPixels);
-
-		ae_zoom = ArrowEffects::GetZoom(m_pPlayerState, fYOffset, column_args.column);
+		const float fYOffset= ArrowEffects::GetYOffsetFromYPos(column_args.ae_context, fY);
 
-		float cur_beat= part_args.top_beat;
-		if(part_args.top_beat != part_args.bottom_beat)
+		if(rigid && !first_vert_set)
 		{
-			cur_beat= SCALE(fY, part_args.y_top, part_args.y_bottom, part_args.top_beat, part_args.bottom_beat);
+			row_center.y= fY + move_y;
 		}
-
-		// Fun times ahead with vector math.  If the notes are being moved by the
-		// position spline, the vectors used to position the edges of the strip
-		// need to be adjusted or the hold will vanish when the notes move
-		// horizontally.
-		// To accomplish this, we use the derivative at the current point from
-		// AE and the position spline.  That gives us the forward vector for the
-		// strip, pointing to where the next center vert will be. (step 1)
-		// The vectors pointing left and right to the edges of the strip are
-		// obtained from the cross product of the forward vector and pos_z_vec.
-		// (unless the forward vec is too close to pos_z_vec or -pos_z_vec, in
-		// which case pos_y_vec is used)  The result of a cross product is a
-		// vector perpendicular to both, so forward crossed with pos_z_vec gives
-		// us the left vector.  Right is of course -left. (step 2)
-		// After that step, the left and right vectors need to be rotated around
-		// the forward vector axis by the y rotation value, to allow the hold to
-		// twist. (step 3)
-		// Steps will be labeled where they occur below. -Kyz
-		// TODO:  Figure out whether it's worth the time investment to figure out
-		// a way to skip the complex vector handling if the spline is disabled.
-
-		RageVector3 sp_pos;
-		RageVector3 sp_pos_forward;
-		RageVector3 sp_rot;
-		RageVector3 sp_zoom;
-		RageVector3 ae_pos;
-		RageVector3 ae_rot;
-
-		// (step 1 of vector handling, part 1)
-		// ArrowEffects only contributes to the Y component of the vector to
-		// maintain the old behavior of how holds are drawn when they wave back
-		// and forth. -Kyz
-		RageVector3 render_forward(0.0f, 1.0f, 0.0f);
-		column_args.spae_pos_for_beat(m_pPlayerState, cur_beat,
-			fYOffset, m_fYReverseOffsetPixels, sp_pos, ae_pos);
-		// fX and fZ are sp_pos.x + ae_pos.x and sp_pos.z + ae_pos.z. -Kyz
-		// fY is the actual y position that should be used, not whatever spae
-		// fetched from ArrowEffects. -Kyz
-		switch(column_args.pos_handler->m_spline_mode)
+		else
 		{
-			case NCSM_Disabled:
-				ae_pos.y= fY + ArrowEffects::GetMoveY(column_args.column);
-				break;
-			case NCSM_Offset:
-				ae_pos.y= fY + ArrowEffects::GetMoveY(column_args.column);
-				column_args.pos_handler->EvalDerivForBeat(column_args.song_beat, cur_beat, sp_pos_forward);
-				RageVec3Normalize(&sp_pos_forward, &sp_pos_forward);
-				break;
-			case NCSM_Position:
-				ae_pos.y= 0.0f;
-				render_forward.y= 0.0f;
-				column_args.pos_handler->EvalDerivForBeat(column_args.song_beat, cur_beat, sp_pos_forward);
-				RageVec3Normalize(&sp_pos_forward, &sp_pos_forward);
-				break;
-			default:
-				break;
-		}
+			ae_zoom = ArrowEffects::GetZoom(column_args.ae_context, fYOffset);
 
-		render_forward.x+= sp_pos_forward.x;
-		render_forward.y+= sp_pos_forward.y;
-		render_forward.z+= sp_pos_forward.z;
-		// Normalize the vector so it'll be easy to test when determining whether
-		// to use pos_z_vec or pos_y_vec for the cross product in step 2.
-		RageVec3Normalize(&render_forward, &render_forward);
-
-		// Holds are only affected by the x axis of the zoom spline because they
-		// are flat sprites. -Kyz
-		float render_width= fFrameWidth;
-		switch(column_args.zoom_handler->m_spline_mode)
-		{
-			case NCSM_Disabled:
-				render_width= fFrameWidth * ae_zoom;
-				break;
-			case NCSM_Offset:
-				column_args.zoom_handler->EvalForBeat(column_args.song_beat, cur_beat, sp_zoom);
-				render_width= fFrameWidth * (ae_zoom + sp_zoom.x);
-				break;
-			case NCSM_Position:
-				column_args.zoom_handler->EvalForBeat(column_args.song_beat, cur_beat, sp_zoom);
-				render_width= fFrameWidth * sp_zoom.x;
-				break;
-			default:
-				break;
-		}
+			float cur_beat= part_args.top_beat;
+			if(part_args.top_beat != part_args.bottom_beat)
+			{
+				cur_beat= SCALE(fY, part_args.y_top, part_args.y_bottom, part_args.top_beat, part_args.bottom_beat);
+			}
 
-		const float fFrameWidthScale	= ArrowEffects::GetFrameWidthScale(m_pPlayerState, fYOffset, part_args.overlapped_time);
-		const float fScaledFrameWidth	= render_width * fFrameWidthScale;
+			// Fun times ahead with vector math.  If the notes are being moved by the
+			// position spline, the vectors used to position the edges of the strip
+			// need to be adjusted or the hold will vanish when the notes move
+			// horizontally.
+			// To accomplish this, we use the derivative at the current point from
+			// AE and the position spline.  That gives us the forward vector for the
+			// strip, pointing to where the next center vert will be. (step 1)
+			// The vectors pointing left and right to the edges of the strip are
+			// obtained from the cross product of the forward vector and pos_z_vec.
+			// (unless the forward vec is too close to pos_z_vec or -pos_z_vec, in
+			// which case pos_y_vec is used)  The result of a cross product is a
+			// vector perpendicular to both, so forward crossed with pos_z_vec gives
+			// us the left vector.  Right is of course -left. (step 2)
+			// After that step, the left and right vectors need to be rotated around
+			// the forward vector axis by the y rotation value, to allow the hold to
+			// twist. (step 3)
+			// Steps will be labeled where they occur below. -Kyz
+
+			RageVector3 sp_pos;
+			RageVector3 sp_pos_forward;
+			RageVector3 sp_rot;
+			RageVector3 sp_zoom;
+			RageVector3 ae_pos;
+			RageVector3 ae_rot;
+
+			// (step 1 of vector handling, part 1)
+			// ArrowEffects only contributes to the Y component of the vector to
+			// maintain the old behavior of how holds are drawn when they wave back
+			// and forth. -Kyz
+			render_forward= RageVector3(0.0f, 1.0f, 0.0f);
+			column_args.spae_pos_for_beat(cur_beat, fYOffset, sp_pos, ae_pos);
+			// fX and fZ are sp_pos.x + ae_pos.x and sp_pos.z + ae_pos.z. -Kyz
+			// fY is the actual y position that should be used, not whatever spae
+			// fetched from ArrowEffects. -Kyz
+			switch(column_args.pos_handler->m_spline_mode)
+			{
+				case NCSM_Disabled:
+					ae_pos.y= fY + move_y;
+					break;
+				case NCSM_Offset:
+					ae_pos.y= fY + move_y;
+					column_args.pos_handler->EvalDerivForBeat(column_args.song_beat, cur_beat, sp_pos_forward);
+					RageVec3Normalize(&sp_pos_forward, &sp_pos_forward);
+					break;
+				case NCSM_Position:
+					ae_pos.y= 0.0f;
+					render_forward.y= 0.0f;
+					column_args.pos_handler->EvalDerivForBeat(column_args.song_beat, cur_beat, sp_pos_forward);
+					RageVec3Normalize(&sp_pos_forward, &sp_pos_forward);
+					break;
+				default:
+					break;
+			}
 
-		// Can't use the same code as for taps because hold bodies can only rotate
-		// around the y axis. -Kyz
-		switch(column_args.rot_handler->m_spline_mode)
-		{
-			case NCSM_Disabled:
-				// XXX: Actor rotations use degrees, Math uses radians. Convert here.
-				ae_rot.y= ArrowEffects::GetRotationY(m_pPlayerState, fYOffset, column_args.column) * -PI_180;
-				break;
-			case NCSM_Offset:
-				ae_rot.y= ArrowEffects::GetRotationY(m_pPlayerState, fYOffset, column_args.column) * -PI_180;
-				column_args.rot_handler->EvalForBeat(column_args.song_beat, cur_beat, sp_rot);
-				break;
-			case NCSM_Position:
-				column_args.rot_handler->EvalForBeat(column_args.song_beat, cur_beat, sp_rot);
-				break;
-			default:
-				break;
+			render_forward.x+= sp_pos_forward.x;
+			render_forward.y+= sp_pos_forward.y;
+			render_forward.z+= sp_pos_forward.z;
+			// Normalize the vector so it'll be easy to test when determining whether
+			// to use pos_z_vec or pos_y_vec for the cross product in step 2.
+			RageVec3Normalize(&render_forward, &render_forward);
+
+			// Holds are only affected by the x axis of the zoom spline because they
+			// are flat sprites. -Kyz
+			float render_width= fFrameWidth;
+			switch(column_args.zoom_handler->m_spline_mode)
+			{
+				case NCSM_Disabled:
+					render_width= fFrameWidth * ae_zoom;
+					break;
+				case NCSM_Offset:
+					column_args.zoom_handler->EvalForBeat(column_args.song_beat, cur_beat, sp_zoom);
+					render_width= fFrameWidth * (ae_zoom + sp_zoom.x);
+					break;
+				case NCSM_Position:
+					column_args.zoom_handler->EvalForBeat(column_args.song_beat, cur_beat, sp_zoom);
+					render_width= fFrameWidth * sp_zoom.x;
+					break;
+				default:
+					break;
+			}
+
+			const float fFrameWidthScale	= ArrowEffects::GetFrameWidthScale(field_args.player_state, fYOffset, part_args.overlapped_time);
+			const float fScaledFrameWidth	= render_width * fFrameWidthScale;
+
+			// Can't use the same code as for taps because hold bodies can only rotate
+			// around the y axis. -Kyz
+			switch(column_args.rot_handler->m_spline_mode)
+			{
+				case NCSM_Disabled:
+					// XXX: Actor rotations use degrees, Math uses radians. Convert here.
+					ae_rot.y= ArrowEffects::GetRotationY(column_args.ae_context, fYOffset) * -PI_180;
+					break;
+				case NCSM_Offset:
+					ae_rot.y= ArrowEffects::GetRotationY(column_args.ae_context, fYOffset) * -PI_180;
+					column_args.rot_handler->EvalForBeat(column_args.song_beat, cur_beat, sp_rot);
+					break;
+				case NCSM_Position:
+					column_args.rot_handler->EvalForBeat(column_args.song_beat, cur_beat, sp_rot);
+					break;
+				default:
+					break;
+			}
+
+			row_center= RageVector3(sp_pos.x + ae_pos.x,
+				sp_pos.y + ae_pos.y, sp_pos.z + ae_pos.z);
+
+			const float render_roty= (sp_rot.y + ae_rot.y);
+
+			// (step 2 of vector handling)
+			if(std::abs(render_forward.z) > 0.9f) // 0.9 arbitrariliy picked.
+			{
+				RageVec3Cross(&render_left, &pos_y_vec, &render_forward);
+			}
+			else
+			{
+				RageVec3Cross(&render_left, &pos_z_vec, &render_forward);
+			}
+			RageAARotate(&render_left, &render_forward, render_roty);
+			const float half_width= fScaledFrameWidth * .5f;
+			render_left.x*= half_width;
+			render_left.y*= half_width;
+			render_left.z*= half_width;
+
+			// Hack: because some mods mess with the zoom, we need to compensate accordingly,
+			// or else hold ends don't look right.
+			const float fPulseInnerAdj	= ArrowEffects::GetPulseInner();
+			fVariableZoom			= ArrowEffects::GetZoomVariable(fYOffset, column_args.column, 1) / fPulseInnerAdj;
 		}
 
-		RageVector3 center_vert(sp_pos.x + ae_pos.x,
-			sp_pos.y + ae_pos.y, sp_pos.z + ae_pos.z);
+		RageVector3 center_vert= row_center;
 
 		// Special case for hold caps, which have the same top and bottom beat.
 		if(part_args.top_beat == part_args.bottom_beat && !first_vert_set)
@@ -984,39 +1157,16 @@ void NoteDisplay::DrawHoldPart(std::vector<Sprite*> &vpSpr,
 			center_vert.z+= render_forward.z;
 		}
 
-		const float render_roty= (sp_rot.y + ae_rot.y);
-
-		// (step 2 of vector handling)
-		RageVector3 render_left;
-		if(std::abs(render_forward.z) > 0.9f) // 0.9 arbitrariliy picked.
-		{
-			RageVec3Cross(&render_left, &pos_y_vec, &render_forward);
-		}
-		else
-		{
-			RageVec3Cross(&render_left, &pos_z_vec, &render_forward);
-		}
-		RageAARotate(&render_left, &render_forward, render_roty);
-		const float half_width= fScaledFrameWidth * .5f;
-		render_left.x*= half_width;
-		render_left.y*= half_width;
-		render_left.z*= half_width;
-
 		const RageVector3 left_vert(center_vert.x + render_left.x,
 			center_vert.y + render_left.y, center_vert.z + render_left.z);
 		const RageVector3 right_vert(center_vert.x - render_left.x,
 			center_vert.y - render_left.y, center_vert.z - render_left.z);
 
-		// Hack: because some mods mess with the zoom, we need to compensate accordingly,
-		// or else hold ends don't look right.
-		const float fPulseInnerAdj	= ArrowEffects::GetPulseInner();
-		const float fVariableZoom	= ArrowEffects::GetZoomVariable(fYOffset, column_args.column, 1) / fPulseInnerAdj;
-
 		const float fDistFromTop	= (fY - y_start_pos) / ae_zoom;
 		float fTexCoordTop		= SCALE(fDistFromTop, 0, unzoomed_frame_height, rect.top, rect.bottom * fVariableZoom);
 		fTexCoordTop += add_to_tex_coord;
 
-		const float fAlpha		= ArrowGetAlphaOrGlow(glow, m_pPlayerState, column_args.column, fYOffset, part_args.percent_fade_to_fail, m_fYReverseOffsetPixels, field_args.draw_pixels_before_targets, field_args.fade_before_targets);
+		const float fAlpha		= ArrowGetAlphaOrGlow(glow, column_args.ae_context, fYOffset, part_args.percent_fade_to_fail, field_args.draw_pixels_before_targets, field_args.fade_before_targets);
 		const RageColor color= RageColor(
 			column_args.diffuse.r * color_scale,
 			column_args.diffuse.g * color_scale,
@@ -1033,8 +1183,8 @@ void NoteDisplay::DrawHoldPart(std::vector<Sprite*> &vpSpr,
 
 		if(queue.Free() < 3 || last_vert_set)
 		{
-			/* The queue is full.  Render it, clear the buffer, and move back a step to
-			 * start off the strip again. */
+			/* The queue is full.  Render it, clear the buffer, and start the
+			 * strip off again from this row. */
 			if(!bAllAreTransparent)
 			{
 				int i = 0;
@@ -1050,7 +1200,24 @@ void NoteDisplay::DrawHoldPart(std::vector<Sprite*> &vpSpr,
 			}
 			queue.Init();
 			bAllAreTransparent = true;
-			fY -= part_args.y_step;
+		}
+		else if(coarse)
+		{
+			while(next_alpha_break < num_alpha_breaks && alpha_breaks[next_alpha_break] <= fY)
+			{
+				++next_alpha_break;
+			}
+			fY= next_alpha_break < num_alpha_breaks ? alpha_breaks[next_alpha_break] : y_end_pos;
+			// A cap's rows after the first are pushed along by render_forward,
+			// so the second row has to stay one step down, where it always was.
+			if(first_vert_set && part_args.top_beat == part_args.bottom_beat)
+			{
+				fY= std::min(fY, y_start_pos + part_args.y_step);
+			}
+		}
+		else
+		{
+			fY+= part_args.y_step;
 		}
 		first_vert_set= false;
 	}
@@ -1098,6 +1265,7 @@ void NoteDisplay::DrawHoldBody(const TapNote& tn,
 	part_args.percent_fade_to_fail= percent_fade_to_fail;
 	part_args.color_scale= color_scale;
 	part_args.overlapped_time= tn.HoldResult.fOverlappedTime;
+	part_args.sample_every_step= false;
 	std::vector<Sprite*> vpSprTop;
 	Sprite *pSpriteTop = GetHoldSprite( m_HoldTopCap, NotePart_HoldTopCap, beat, tn.subType == TapNoteSubType_Roll, being_held && !cache->m_bHoldActiveIsAddLayer );
 	vpSprTop.push_back( pSpriteTop );
@@ -1146,14 +1314,14 @@ void NoteDisplay::DrawHoldBody(const TapNote& tn,
 		y_tail += cache->m_iStopDrawingHoldBodyOffsetFromTail;
 	}
 
-	float ae_zoom= ArrowEffects::GetZoom(m_pPlayerState, 0, column_args.column);
+	float ae_zoom= ArrowEffects::GetZoom(column_args.ae_context, 0);
 	const float frame_height_top= pSpriteTop->GetUnzoomedHeight() * ae_zoom;
 	const float frame_height_bottom= pSpriteBottom->GetUnzoomedHeight() * ae_zoom;
 
-	part_args.y_start_pos= ArrowEffects::GetYPos(m_pPlayerState, column_args.column,
-		field_args.draw_pixels_after_targets, m_fYReverseOffsetPixels);
-	part_args.y_end_pos= ArrowEffects::GetYPos(m_pPlayerState, column_args.column,
-		field_args.draw_pixels_before_targets, m_fYReverseOffsetPixels);
+	part_args.y_start_pos= ArrowEffects::GetYPos(column_args.ae_context,
+		field_args.draw_pixels_after_targets);
+	part_args.y_end_pos= ArrowEffects::GetYPos(column_args.ae_context,
+		field_args.draw_pixels_before_targets);
 	if(reverse)
 	{
 		std::swap(part_args.y_start_pos, part_args.y_end_pos);
@@ -1203,11 +1371,11 @@ void NoteDisplay::DrawHold(const TapNote& tn,
 	if( tn.HoldResult.bActive  &&  tn.HoldResult.fLife > 0 )
 		;	// use the default values filled in above
 	else
-		fStartYOffset = ArrowEffects::GetYOffset( m_pPlayerState, column_args.column, fStartBeat, fThrowAway, bStartIsPastPeak );
+		fStartYOffset = ArrowEffects::GetYOffset( column_args.ae_context, fStartBeat, fThrowAway, bStartIsPastPeak );
 
 	float fEndPeakYOffset	= 0;
 	bool bEndIsPastPeak = false;
-	float fEndYOffset	= ArrowEffects::GetYOffset( m_pPlayerState, column_args.column, NoteRowToBeat(iEndRow), fEndPeakYOffset, bEndIsPastPeak );
+	float fEndYOffset	= ArrowEffects::GetYOffset( column_args.ae_context, NoteRowToBeat(iEndRow), fEndPeakYOffset, bEndIsPastPeak );
 
 	// In boomerang, the arrows reverse direction at Y offset value fPeakAtYOffset.
 	// If fPeakAtYOffset lies inside of the hold we're drawing, then the we
@@ -1220,8 +1388,8 @@ void NoteDisplay::DrawHold(const TapNote& tn,
 	if( bReverse )
 		std::swap( fStartYOffset, fEndYOffset );
 
-	const float fYHead= ArrowEffects::GetYPos(m_pPlayerState, column_args.column, fStartYOffset, m_fYReverseOffsetPixels);
-	const float fYTail= ArrowEffects::GetYPos(m_pPlayerState, column_args.column, fEndYOffset, m_fYReverseOffsetPixels);
+	const float fYHead= ArrowEffects::GetYPos(column_args.ae_context, fStartYOffset);
+	const float fYTail= ArrowEffects::GetYPos(column_args.ae_context, fEndYOffset);
 
 	const float fColorScale		= SCALE( tn.HoldResult.fLife, 0.0f, 1.0f, cache->m_fHoldLetGoGrayPercent, 1.0f );
 
@@ -1266,7 +1434,8 @@ void NoteDisplay::DrawHold(const TapNote& tn,
 void NoteDisplay::DrawActor(const TapNote& tn, Actor* pActor, NotePart part,
 	const NoteFieldRenderArgs& field_args, const NoteColumnRenderArgs& column_args, float fYOffset, float fBeat,
 	bool bIsAddition, float fPercentFadeToFail, float fColorScale,
-	bool is_being_held)
+	bool is_being_held, const ArrowEffects::NoteBatch* batch,
+	size_t batch_index)
 {
 	if (tn.type == TapNoteType_AutoKeysound && !GAMESTATE->m_bInStepEditor) return;
 	if(fYOffset < field_args.draw_pixels_after_targets ||
@@ -1277,8 +1446,10 @@ void NoteDisplay::DrawActor(const TapNote& tn, Actor* pActor, NotePart part,
 	float spline_beat= fBeat;
 	if(is_being_held) { spline_beat= column_args.song_beat; }
 
-	const float fAlpha= ArrowEffects::GetAlpha(m_pPlayerState, column_args.column, fYOffset, fPercentFadeToFail, m_fYReverseOffsetPixels, field_args.draw_pixels_before_targets, field_args.fade_before_targets);
-	const float fGlow= ArrowEffects::GetGlow(m_pPlayerState, column_args.column, fYOffset, fPercentFadeToFail, m_fYReverseOffsetPixels, field_args.draw_pixels_before_targets, field_args.fade_before_targets);
+	const float fAlpha= batch != nullptr ? batch->m_fAlpha[batch_index] :
+		ArrowEffects::GetAlpha(column_args.ae_context, fYOffset, fPercentFadeToFail, field_args.draw_pixels_before_targets, field_args.fade_before_targets);
+	const float fGlow= batch != nullptr ? batch->m_fGlow[batch_index] :
+		ArrowEffects::GetGlow(column_args.ae_context, fYOffset, fPercentFadeToFail, field_args.draw_pixels_before_targets, field_args.fade_before_targets);
 	const RageColor diffuse	= RageColor(
 		column_args.diffuse.r * fColorScale,
 		column_args.diffuse.g * fColorScale,
@@ -1315,29 +1486,46 @@ void NoteDisplay::DrawActor(const TapNote& tn, Actor* pActor, NotePart part,
 	RageVector3 ae_pos;
 	RageVector3 ae_rot;
 	RageVector3 ae_zoom;
-	column_args.spae_pos_for_beat(m_pPlayerState, spline_beat,
-		fYOffset, m_fYReverseOffsetPixels, sp_pos, ae_pos);
-
-	switch(column_args.rot_handler->m_spline_mode)
+	if(batch != nullptr)
 	{
-		case NCSM_Disabled:
-			ae_rot.x= ArrowEffects::GetRotationX(m_pPlayerState, fYOffset, bIsHoldCap, column_args.column);
-			ae_rot.y= ArrowEffects::GetRotationY(m_pPlayerState, fYOffset, column_args.column);
-			ae_rot.z= ArrowEffects::GetRotationZ(m_pPlayerState, fBeat, bIsHoldHead, column_args.column);
-			break;
-		case NCSM_Offset:
-			ae_rot.x= ArrowEffects::GetRotationX(m_pPlayerState, fYOffset, bIsHoldCap, column_args.column);
-			ae_rot.y= ArrowEffects::GetRotationY(m_pPlayerState, fYOffset, column_args.column);
-			ae_rot.z= ArrowEffects::GetRotationZ(m_pPlayerState, fBeat, bIsHoldHead, column_args.column);
-			column_args.rot_handler->EvalForBeat(column_args.song_beat, spline_beat, sp_rot);
-			break;
-		case NCSM_Position:
-			column_args.rot_handler->EvalForBeat(column_args.song_beat, spline_beat, sp_rot);
-			break;
-		default:
-			break;
+		const size_t i= batch_index;
+		spline_and_effect(column_args.pos_handler, column_args.song_beat,
+			spline_beat, RageVector3(batch->m_fX[i], batch->m_fY[i], batch->m_fZ[i]),
+			sp_pos, ae_pos);
+		spline_and_effect(column_args.rot_handler, column_args.song_beat,
+			spline_beat, RageVector3(batch->m_fRotationX[i],
+				batch->m_fRotationY[i], batch->m_fRotationZ[i]),
+			sp_rot, ae_rot);
+		spline_and_effect(column_args.zoom_handler, column_args.song_beat,
+			spline_beat, RageVector3(batch->m_fZoom[i], batch->m_fZoom[i],
+				batch->m_fZoom[i]),
+			sp_zoom, ae_zoom);
+	}
+	else
+	{
+		column_args.spae_pos_for_beat(spline_beat, fYOffset, sp_pos, ae_pos);
+
+		switch(column_args.rot_handler->m_spline_mode)
+		{
+			case NCSM_Disabled:
+				ae_rot.x= ArrowEffects::GetRotationX(column_args.ae_context, fYOffset, bIsHoldCap);
+				ae_rot.y= ArrowEffects::GetRotationY(column_args.ae_context, fYOffset);
+				ae_rot.z= ArrowEffects::GetRotationZ(column_args.ae_context, fBeat, bIsHoldHead);
+				break;
+			case NCSM_Offset:
+				ae_rot.x= ArrowEffects::GetRotationX(column_args.ae_context, fYOffset, bIsHoldCap);
+				ae_rot.y= ArrowEffects::GetRotationY(column_args.ae_context, fYOffset);
+				ae_rot.z= ArrowEffects::GetRotationZ(column_args.ae_context, fBeat, bIsHoldHead);
+				column_args.rot_handler->EvalForBeat(column_args.song_beat, spline_beat, sp_rot);
+				break;
+			case NCSM_Position:
+				column_args.rot_handler->EvalForBeat(column_args.song_beat, spline_beat, sp_rot);
+				break;
+			default:
+				break;
+		}
+		column_args.spae_zoom_for_beat(spline_beat, sp_zoom, ae_zoom, fYOffset);
 	}
-	column_args.spae_zoom_for_beat(m_pPlayerState, spline_beat, sp_zoom, ae_zoom, column_args.column, fYOffset);
 	column_args.SetPRZForActor(pActor, sp_pos, ae_pos, sp_rot, ae_rot, sp_zoom, ae_zoom);
 	// [AJ] this two lines (and how they're handled) piss off many people:
 	pActor->SetDiffuse( diffuse );
@@ -1385,7 +1573,8 @@ void NoteDisplay::DrawTap(const TapNote& tn,
 	const NoteFieldRenderArgs& field_args,
 	const NoteColumnRenderArgs& column_args, float fBeat,
 	bool bOnSameRowAsHoldStart, bool bOnSameRowAsRollStart,
-	bool bIsAddition, float fPercentFadeToFail)
+	bool bIsAddition, float fPercentFadeToFail,
+	const ArrowEffects::NoteBatch* batch, size_t batch_index)
 {
 	Actor* pActor = nullptr;
 	NotePart part = NotePart_Tap;
@@ -1457,9 +1646,10 @@ void NoteDisplay::DrawTap(const TapNote& tn,
 		pActor->HandleMessage( msg );
 	}
 
-	const float fYOffset = ArrowEffects::GetYOffset( m_pPlayerState, column_args.column, fBeat );
+	const float fYOffset = batch != nullptr ? batch->m_fYOffset[batch_index] :
+		ArrowEffects::GetYOffset( column_args.ae_context, fBeat );
 	// this is the line that forces the (1,1,1,x) part of the noteskin diffuse -aj
-	DrawActor(tn, pActor, part, field_args, column_args, fYOffset, fBeat, bIsAddition, fPercentFadeToFail, 1.0f, false);
+	DrawActor(tn, pActor, part, field_args, column_args, fYOffset, fBeat, bIsAddition, fPercentFadeToFail, 1.0f, false, batch, batch_index);
 
 	if( tn.type == TapNoteType_Attack )
 		pActor->PlayCommand( "UnsetAttack" );
@@ -1469,6 +1659,10 @@ void NoteColumnRenderer::UpdateReceptorGhostStuff(Actor* receptor) const
 {
 	const PlayerState* player_state= m_field_render_args->player_state;
 	float song_beat= player_state->GetDisplayedPosition().m_fSongBeatVisible;
+	// The rows update their receptors before the column draws, so the
+	// column's context may not be this frame's yet.
+	ArrowEffects::FrameContext ae_context;
+	ae_context.Load(player_state, m_column, m_field_render_args->reverse_offset_pixels);
 	// sp_* will be filled with the settings from the splines.
 	// ae_* will be filled with the settings from ArrowEffects.
 	// The two together will be applied to the actor.
@@ -1484,10 +1678,10 @@ void NoteColumnRenderer::UpdateReceptorGhostStuff(Actor* receptor) const
 	switch(NCR_current.m_pos_handler.m_spline_mode)
 	{
 		case NCSM_Disabled:
-			ArrowEffects::GetXYZPos(player_state, m_column, 0, m_field_render_args->reverse_offset_pixels, ae_pos);
+			ArrowEffects::GetXYZPos(ae_context, 0, ae_pos);
 			break;
 		case NCSM_Offset:
-			ArrowEffects::GetXYZPos(player_state, m_column, 0, m_field_render_args->reverse_offset_pixels, ae_pos);
+			ArrowEffects::GetXYZPos(ae_context, 0, ae_pos);
 			NCR_current.m_pos_handler.EvalForReceptor(song_beat, sp_pos);
 			break;
 		case NCSM_Position:
@@ -1518,10 +1712,10 @@ void NoteColumnRenderer::UpdateReceptorGhostStuff(Actor* receptor) const
 	switch(NCR_current.m_zoom_handler.m_spline_mode)
 	{
 		case NCSM_Disabled:
-			ae_zoom.x= ae_zoom.y= ae_zoom.z= ArrowEffects::GetZoom(player_state, 0, m_column);
+			ae_zoom.x= ae_zoom.y= ae_zoom.z= ArrowEffects::GetZoom(ae_context, 0);
 			break;
 		case NCSM_Offset:
-			ae_zoom.x= ae_zoom.y= ae_zoom.z= ArrowEffects::GetZoom(player_state, 0, m_column);
+			ae_zoom.x= ae_zoom.y= ae_zoom.z= ArrowEffects::GetZoom(ae_context, 0);
 			NCR_current.m_zoom_handler.EvalForReceptor(song_beat, sp_zoom);
 			break;
 		case NCSM_Position:
@@ -1538,6 +1732,8 @@ void NoteColumnRenderer::UpdateReceptorGhostStuff(Actor* receptor) const
 void NoteColumnRenderer::DrawPrimitives()
 {
 	m_column_render_args.song_beat= m_field_render_args->player_state->GetDisplayedPosition().m_fSongBeatVisible;
+	m_column_render_args.ae_context.Load(m_field_render_args->player_state,
+		m_column, m_field_render_args->reverse_offset_pixels);
 	m_column_render_args.pos_handler= &NCR_current.m_pos_handler;
 	m_column_render_args.rot_handler= &NCR_current.m_rot_handler;
 	m_column_render_args.zoom_handler= &NCR_current.m_zoom_handler;
@@ -2,6 +2,7 @@
 #define NOTE_DISPLAY_H
 
 #include "ActorFrame.h"
+#include "ArrowEffects.h"
 #include "CubicSpline.h"
 #include "NoteData.h"
 #include "PlayerNumber.h"
@@ -11,6 +12,7 @@
 
 
 class Sprite;
+class RageTexture;
 class Model;
 class PlayerState;
 class GhostArrowRow;
@@ -157,11 +159,10 @@ struct NCSplineHandler
 
 struct NoteColumnRenderArgs
 {
-	void spae_pos_for_beat(const PlayerState* player_state,
-		float beat, float y_offset, float y_reverse_offset,
+	void spae_pos_for_beat(float beat, float y_offset,
 		RageVector3& sp_pos, RageVector3& ae_pos) const;
-	void spae_zoom_for_beat(const PlayerState* state, float beat,
-		RageVector3& sp_zoom, RageVector3& ae_zoom, int col_num, float y_offset) const;
+	void spae_zoom_for_beat(float beat,
+		RageVector3& sp_zoom, RageVector3& ae_zoom, float y_offset) const;
 	void SetPRZForActor(Actor* actor,
 		const RageVector3& sp_pos, const RageVector3& ae_pos,
 		const RageVector3& sp_rot, const RageVector3& ae_rot,
@@ -173,6 +174,9 @@ struct NoteColumnRenderArgs
 	RageColor glow;
 	float song_beat;
 	int column;
+	// Loaded by NoteColumnRenderer::DrawPrimitives each frame, and passed to
+	// every ArrowEffects call about a note in the column.
+	ArrowEffects::FrameContext ae_context;
 };
 
 /** @brief Draws TapNotes and HoldNotes. */
@@ -186,7 +190,7 @@ public:
 
 	static void Update( float fDeltaTime );
 
-	bool IsOnScreen( float fBeat, int iCol, int iDrawDistanceAfterTargetsPixels, int iDrawDistanceBeforeTargetsPixels ) const;
+	bool IsOnScreen( const ArrowEffects::FrameContext &context, float fBeat, int iDrawDistanceAfterTargetsPixels, int iDrawDistanceBeforeTargetsPixels ) const;
 
 	bool DrawHoldsInRange(const NoteFieldRenderArgs& field_args,
 		const NoteColumnRenderArgs& column_args,
@@ -206,11 +210,14 @@ public:
 	 * @param fReverseOffsetPixels How are the notes adjusted on Reverse?
 	 * @param fDrawDistanceAfterTargetsPixels how much to draw after the receptors.
 	 * @param fDrawDistanceBeforeTargetsPixels how much ot draw before the receptors.
-	 * @param fFadeInPercentOfDrawFar when to start fading in. */
+	 * @param fFadeInPercentOfDrawFar when to start fading in.
+	 * @param batch if not null, the effects already worked out for this note.
+	 * @param batch_index where this note is in batch. */
 	void DrawTap(const TapNote& tn, const NoteFieldRenderArgs& field_args,
 		const NoteColumnRenderArgs& column_args, float fBeat,
 		bool bOnSameRowAsHoldStart,
-		bool bOnSameRowAsRollBeat, bool bIsAddition, float fPercentFadeToFail);
+		bool bOnSameRowAsRollBeat, bool bIsAddition, float fPercentFadeToFail,
+		const ArrowEffects::NoteBatch* batch= nullptr, size_t batch_index= 0);
 	void DrawHold(const TapNote& tn, const NoteFieldRenderArgs& field_args,
 		const NoteColumnRenderArgs& column_args, int iRow, bool bIsBeingHeld,
 		const HoldNoteResult &Result,
@@ -219,11 +226,16 @@ public:
 	bool DrawHoldHeadForTapsOnSameRow() const;
 	bool DrawRollHeadForTapsOnSameRow() const;
 
-private:
-	void SetActiveFrame( float fNoteBeat, Actor &actorToSet, float fAnimationLength, bool bVivid );
-	Actor *GetTapActor( NoteColorActor &nca, NotePart part, float fNoteBeat );
-	Actor *GetHoldActor( NoteColorActor nca[NUM_HoldType][NUM_ActiveType], NotePart part, float fNoteBeat, bool bIsRoll, bool bIsBeingHeld );
-	Sprite *GetHoldSprite( NoteColorSprite ncs[NUM_HoldType][NUM_ActiveType], NotePart part, float fNoteBeat, bool bIsRoll, bool bIsBeingHeld );
+	/* Append the textures of the hold caps and bodies, which DrawHoldPart
+	 * binds directly with wrapping. */
+	void GetHoldTextures( std::vector<RageTexture*> &vpOut );
+
+	enum hold_part_type
+	{
+		hpt_top,
+		hpt_body,
+		hpt_bottom,
+	};
 
 	struct draw_hold_part_args
 	{
@@ -240,17 +252,31 @@ private:
 		bool wrapping;
 		bool anchor_to_top;
 		bool flip_texture_vertically;
+		// Work out every row y_step pixels apart from scratch, even when
+		// fewer rows would draw the same strip.  test_hold_strips draws
+		// both ways to compare them.
+		bool sample_every_step;
 	};
 
+	/* Draw one part of a hold as a strip down the column, with the same
+	 * sprite texture on each layer in vpSpr. */
+	static void DrawHoldPart(std::vector<Sprite*> &vpSpr,
+		const NoteFieldRenderArgs& field_args,
+		const NoteColumnRenderArgs& column_args,
+		const draw_hold_part_args& part_args, bool glow, int part_type);
+
+private:
+	void SetActiveFrame( float fNoteBeat, Actor &actorToSet, float fAnimationLength, bool bVivid );
+	Actor *GetTapActor( NoteColorActor &nca, NotePart part, float fNoteBeat );
+	Actor *GetHoldActor( NoteColorActor nca[NUM_HoldType][NUM_ActiveType], NotePart part, float fNoteBeat, bool bIsRoll, bool bIsBeingHeld );
+	Sprite *GetHoldSprite( NoteColorSprite ncs[NUM_HoldType][NUM_ActiveType], NotePart part, float fNoteBeat, bool bIsRoll, bool bIsBeingHeld );
+
 	void DrawActor(const TapNote& tn, Actor* pActor, NotePart part,
 		const NoteFieldRenderArgs& field_args,
 		const NoteColumnRenderArgs& column_args, float fYOffset, float fBeat,
 		bool bIsAddition, float fPercentFadeToFail, float fColorScale,
-		bool is_being_held);
-	void DrawHoldPart(std::vector<Sprite*> &vpSpr,
-		const NoteFieldRenderArgs& field_args,
-		const NoteColumnRenderArgs& column_args,
-		const draw_hold_part_args& part_args, bool glow, int part_type);
+		bool is_being_held, const ArrowEffects::NoteBatch* batch= nullptr,
+		size_t batch_index= 0);
 	void DrawHoldBodyInternal(std::vector<Sprite*>& sprite_top,
 		std::vector<Sprite*>& sprite_body, std::vector<Sprite*>& sprite_bottom,
 		const NoteFieldRenderArgs& field_args,
@@ -277,6 +303,10 @@ private:
 	NoteColorSprite		m_HoldBottomCap[NUM_HoldType][NUM_ActiveType];
 	NoteColorActor		m_HoldTail[NUM_HoldType][NUM_ActiveType];
 	float			m_fYReverseOffsetPixels;
+
+	// Kept between frames so DrawTapsInRange doesn't allocate every frame.
+	ArrowEffects::NoteBatch	m_tap_batch;
+	std::vector<NoteData::TrackMap::const_iterator> m_taps_on_screen;
 };
 
 // So, this is a bit screwy, and it's partly because routine forces rendering
@@ -12,21 +12,25 @@
 #include "Song.h"
 #include "ScreenDimensions.h"
 #include "PlayerState.h"
+#include "NoteFieldCache.h"
 #include "Style.h"
 #include "CommonMetrics.h"
 #include "BackgroundUtil.h"
 #include "Course.h"
 #include "NoteData.h"
 #include "RageDisplay.h"
+#include "RageTextureManager.h"
+#include "Preference.h"
 
+#include <algorithm>
 #include <cfloat>
 #include <cmath>
 #include <cstddef>
 #include <vector>
 
 
-float FindFirstDisplayedBeat( const PlayerState* pPlayerState, int iDrawDistanceAfterTargetsPixels );
-float FindLastDisplayedBeat( const PlayerState* pPlayerState, int iDrawDistanceBeforeTargetsPixels );
+float FindFirstDisplayedBeat( const ArrowEffects::FrameContext &context, int iDrawDistanceAfterTargetsPixels );
+float FindLastDisplayedBeat( const ArrowEffects::FrameContext &context, int iDrawDistanceBeforeTargetsPixels );
 
 static ThemeMetric<bool> SHOW_BOARD( "NoteField", "ShowBoard" );
 static ThemeMetric<bool> SHOW_BEAT_BARS( "NoteField", "ShowBeatBars" );
@@ -37,6 +41,10 @@ static ThemeMetric<float> BAR_8TH_ALPHA( "NoteField", "Bar8thAlpha" );
 static ThemeMetric<float> BAR_16TH_ALPHA( "NoteField", "Bar16thAlpha" );
 static ThemeMetric<float> FADE_FAIL_TIME( "NoteField", "FadeFailTime" );
 
+/* Copy each note skin's textures into a few shared pages so a whole column
+ * of notes draws from one texture. */
+static Preference<bool> g_bNoteSkinTextureAtlas( "NoteSkinTextureAtlas", true );
+
 static RString RoutineNoteSkinName( size_t i ) { return ssprintf("RoutineNoteSkinP%i",int(i+1)); }
 static ThemeMetric1D<RString> ROUTINE_NOTESKIN( "NoteField", RoutineNoteSkinName, NUM_PLAYERS );
 
@@ -131,10 +139,28 @@ void NoteField::CacheNoteSkin( const RString &sNoteSkin_ )
 	LOG->Trace("NoteField::CacheNoteSkin: cache %s", sNoteSkinLower.c_str() );
 	NoteDisplayCols *nd = new NoteDisplayCols( GAMESTATE->GetCurrentStyle(m_pPlayerState->m_PlayerNumber)->m_iColsPerPlayer );
 
+	std::vector<RageTexture*> vpTextures;
+	TEXTUREMAN->BeginRecordingLoads( &vpTextures );
 	for( int c=0; c<GAMESTATE->GetCurrentStyle(m_pPlayerState->m_PlayerNumber)->m_iColsPerPlayer; c++ )
 		nd->display[c].Load( c, m_pPlayerState, m_fYReverseOffsetPixels );
 	nd->m_ReceptorArrowRow.Load( m_pPlayerState, m_fYReverseOffsetPixels );
 	nd->m_GhostArrowRow.Load( m_pPlayerState, m_fYReverseOffsetPixels );
+	TEXTUREMAN->EndRecordingLoads();
+
+	if( g_bNoteSkinTextureAtlas )
+	{
+		// Holds are drawn from their own textures, so don't take up page space with them.
+		std::vector<RageTexture*> vpHoldTextures;
+		for( int c=0; c<GAMESTATE->GetCurrentStyle(m_pPlayerState->m_PlayerNumber)->m_iColsPerPlayer; c++ )
+			nd->display[c].GetHoldTextures( vpHoldTextures );
+		vpTextures.erase( std::remove_if(vpTextures.begin(), vpTextures.end(), [&]( RageTexture *pTexture ) {
+			return std::find( vpHoldTextures.begin(), vpHoldTextures.end(), pTexture ) != vpHoldTextures.end();
+		}), vpTextures.end() );
+
+		nd->m_Atlas.Build( vpTextures );
+		LOG->Trace( "NoteField::CacheNoteSkin: packed %i textures into %i atlas pages",
+			nd->m_Atlas.GetNumTextures(), nd->m_Atlas.GetNumPages() );
+	}
 
 	m_NoteDisplays[ sNoteSkinLower ] = nd;
 }
@@ -338,6 +364,7 @@ void NoteField::Update( float fDeltaTime )
 
 	ActorFrame::Update( fDeltaTime );
 	ArrowEffects::SetCurrentOptions(&m_pPlayerState->m_PlayerOptions.GetCurrent());
+	m_FieldContext.Load( m_pPlayerState, 0, m_fYReverseOffsetPixels );
 
 	for(size_t c= 0; c < m_ColumnRenderers.size(); ++c)
 	{
@@ -349,8 +376,8 @@ void NoteField::Update( float fDeltaTime )
 	bool bTweeningOn = m_sprBoard->GetCurrentDiffuseAlpha() >= 0.98  &&  m_sprBoard->GetCurrentDiffuseAlpha() < 1.00;	// HACK
 	if( !bTweeningOn  &&  m_fCurrentBeatLastUpdate != -1 )
 	{
-		const float fYOffsetLast	= ArrowEffects::GetYOffset(m_pPlayerState, 0, m_fCurrentBeatLastUpdate);
-		const float fYPosLast= ArrowEffects::GetYPos(m_pPlayerState, 0, fYOffsetLast, m_fYReverseOffsetPixels);
+		const float fYOffsetLast	= ArrowEffects::GetYOffset(m_FieldContext, m_fCurrentBeatLastUpdate);
+		const float fYPosLast= ArrowEffects::GetYPos(m_FieldContext, fYOffsetLast);
 		const float fPixelDifference = fYPosLast - m_fYPosCurrentBeatLastUpdate;
 
 		//LOG->Trace( "speed = %f, %f, %f, %f, %f, %f", fSpeed, fYOffsetAtCurrent, fYOffsetAtNext, fSecondsAtCurrent, fSecondsAtNext, fPixelDifference, fSecondsDifference );
@@ -359,8 +386,8 @@ void NoteField::Update( float fDeltaTime )
 		wrap( m_fBoardOffsetPixels, m_sprBoard->GetUnzoomedHeight() );
 	}
 	m_fCurrentBeatLastUpdate = fCurrentBeat;
-	const float fYOffsetCurrent	= ArrowEffects::GetYOffset( m_pPlayerState, 0, m_fCurrentBeatLastUpdate );
-	m_fYPosCurrentBeatLastUpdate= ArrowEffects::GetYPos(m_pPlayerState, 0, fYOffsetCurrent, m_fYReverseOffsetPixels);
+	const float fYOffsetCurrent	= ArrowEffects::GetYOffset( m_FieldContext, m_fCurrentBeatLastUpdate );
+	m_fYPosCurrentBeatLastUpdate= ArrowEffects::GetYPos(m_FieldContext, fYOffsetCurrent);
 
 	m_rectMarkerBar.Update( fDeltaTime );
 
@@ -392,7 +419,7 @@ float NoteField::GetWidth() const
 	// TODO: Remove use of PlayerNumber.
 	pStyle->GetMinAndMaxColX( m_pPlayerState->m_PlayerNumber, fMinX, fMaxX );
 
-	const float fYZoom	= ArrowEffects::GetZoom( m_pPlayerState, 0, 0 );
+	const float fYZoom	= ArrowEffects::GetZoom( m_FieldContext, 0 );
 	return (fMaxX - fMinX + ARROW_SIZE) * fYZoom;
 }
 
@@ -400,8 +427,8 @@ void NoteField::DrawBeatBar( const float fBeat, BeatBarType type, int iMeasureIn
 {
 	bool bIsMeasure = type == measure;
 
-	const float fYOffset	= ArrowEffects::GetYOffset( m_pPlayerState, 0, fBeat );
-	const float fYPos= ArrowEffects::GetYPos(m_pPlayerState, 0, fYOffset, m_fYReverseOffsetPixels);
+	const float fYOffset	= ArrowEffects::GetYOffset( m_FieldContext, fBeat );
+	const float fYPos= ArrowEffects::GetYPos(m_FieldContext, fYOffset);
 
 	float fAlpha;
 	int iState;
@@ -480,7 +507,7 @@ void NoteField::DrawBoard( int iDrawDistanceAfterTargetsPixels, int iDrawDistanc
 	{
 		// Draw the board centered on fYPosAt0 so that the board doesn't slide as
 		// the draw distance changes with modifiers.
-		const float fYPosAt0= ArrowEffects::GetYPos(m_pPlayerState, 0, 0, m_fYReverseOffsetPixels);
+		const float fYPosAt0= ArrowEffects::GetYPos(m_FieldContext, 0);
 
 		RectF rect = *pSprite->GetCurrentTextureCoordRect();
 		const float fBoardGraphicHeightPixels = pSprite->GetUnzoomedHeight();
@@ -506,8 +533,8 @@ void NoteField::DrawBoard( int iDrawDistanceAfterTargetsPixels, int iDrawDistanc
 void NoteField::DrawMarkerBar( int iBeat )
 {
 	float fBeat = NoteRowToBeat( iBeat );
-	const float fYOffset	= ArrowEffects::GetYOffset( m_pPlayerState, 0, fBeat );
-	const float fYPos	= ArrowEffects::GetYPos(m_pPlayerState, 0, fYOffset, m_fYReverseOffsetPixels);
+	const float fYOffset	= ArrowEffects::GetYOffset( m_FieldContext, fBeat );
+	const float fYPos	= ArrowEffects::GetYPos(m_FieldContext, fYOffset);
 
 	m_rectMarkerBar.StretchTo( RectF(-GetWidth()/2, fYPos-ARROW_SIZE/2, GetWidth()/2, fYPos+ARROW_SIZE/2) );
 	m_rectMarkerBar.Draw();
@@ -518,10 +545,10 @@ void NoteField::DrawAreaHighlight( int iStartBeat, int iEndBeat )
 {
 	float fStartBeat = NoteRowToBeat( iStartBeat );
 	float fEndBeat = NoteRowToBeat( iEndBeat );
-	float fDrawDistanceAfterTargetsPixels	= ArrowEffects::GetYOffset( m_pPlayerState, 0, fStartBeat );
-	float fYStartPos	= ArrowEffects::GetYPos(m_pPlayerState, 0, fDrawDistanceAfterTargetsPixels, m_fYReverseOffsetPixels);
-	float fDrawDistanceBeforeTargetsPixels	= ArrowEffects::GetYOffset( m_pPlayerState, 0, fEndBeat );
-	float fYEndPos= ArrowEffects::GetYPos(m_pPlayerState, 0, fDrawDistanceBeforeTargetsPixels, m_fYReverseOffsetPixels);
+	float fDrawDistanceAfterTargetsPixels	= ArrowEffects::GetYOffset( m_FieldContext, fStartBeat );
+	float fYStartPos	= ArrowEffects::GetYPos(m_FieldContext, fDrawDistanceAfterTargetsPixels);
+	float fDrawDistanceBeforeTargetsPixels	= ArrowEffects::GetYOffset( m_FieldContext, fEndBeat );
+	float fYEndPos= ArrowEffects::GetYPos(m_FieldContext, fDrawDistanceBeforeTargetsPixels);
 
 	// The caller should have clamped these to reasonable values
 	ASSERT( fYStartPos > -1000 );
@@ -572,9 +599,9 @@ void NoteField::set_text_measure_number_for_draw(
 	const float beat, const float side_sign, float x_offset,
 	const float horiz_align, const RageColor& color, const RageColor& glow)
 {
-	const float y_offset= ArrowEffects::GetYOffset(m_pPlayerState, 0, beat);
-	const float y_pos= ArrowEffects::GetYPos(m_pPlayerState, 0, y_offset, m_fYReverseOffsetPixels);
-	const float zoom= ArrowEffects::GetZoom(m_pPlayerState, y_offset, 0);
+	const float y_offset= ArrowEffects::GetYOffset(m_FieldContext, beat);
+	const float y_pos= ArrowEffects::GetYPos(m_FieldContext, y_offset);
+	const float zoom= ArrowEffects::GetZoom(m_FieldContext, y_offset);
 	const float x_base= GetWidth() * .5f;
 	x_offset*= zoom;
 
@@ -613,46 +640,14 @@ void NoteField::DrawBGChangeText(const float beat, const RString new_bg_name,
 	m_textMeasureNumber.Draw();
 }
 
-static CacheNoteStat GetNumNotesFromBeginning( const PlayerState *pPlayerState, float beat )
-{
-	// XXX: I realized that I have copied and pasted my binary search code 3 times already.
-	//      how can we abstract this?
-	const std::vector<CacheNoteStat> &data = pPlayerState->m_CacheNoteStat;
-	int max = data.size() - 1;
-	int l = 0, r = max;
-	while( l <= r )
-	{
-		int m = ( l + r ) / 2;
-		if( ( m == 0 || data[m].beat <= beat ) && ( m == max || beat < data[m + 1].beat ) )
-		{
-			return data[m];
-		}
-		else if( data[m].beat <= beat )
-		{
-			l = m + 1;
-		}
-		else
-		{
-			r = m - 1;
-		}
-	}
-	CacheNoteStat dummy = { 0, 0, 0 };
-	return dummy;
-}
-
-static int GetNumNotesRange( const PlayerState* pPlayerState, float fLow, float fHigh )
-{
-	CacheNoteStat low  = GetNumNotesFromBeginning( pPlayerState, fLow );
-	CacheNoteStat high = GetNumNotesFromBeginning( pPlayerState, fHigh );
-	return high.notesUpper - low.notesLower;
-}
-
-float FindFirstDisplayedBeat( const PlayerState* pPlayerState, int iDrawDistanceAfterTargetsPixels )
+float FindFirstDisplayedBeat( const ArrowEffects::FrameContext &context, int iDrawDistanceAfterTargetsPixels )
 {
+	const PlayerState *pPlayerState = context.m_pPlayerState;
 
 	float fLow = 0, fHigh = pPlayerState->GetDisplayedPosition().m_fSongBeat;
 
-	bool bHasCache = pPlayerState->m_CacheNoteStat.size() > 0;
+	const NoteFieldCache *pCache = pPlayerState->m_pNoteFieldCache.get();
+	bool bHasCache = pCache && pCache->HasNotes();
 
 	if( !bHasCache )
 	{
@@ -671,9 +666,9 @@ float FindFirstDisplayedBeat( const PlayerState* pPlayerState, int iDrawDistance
 
 		bool bIsPastPeakYOffset;
 		float fPeakYOffset;
-		float fYOffset = ArrowEffects::GetYOffset( pPlayerState, 0, fMid, fPeakYOffset, bIsPastPeakYOffset, true );
+		float fYOffset = ArrowEffects::GetYOffset( context, fMid, fPeakYOffset, bIsPastPeakYOffset, true );
 
-		if( fYOffset < iDrawDistanceAfterTargetsPixels || ( bHasCache && GetNumNotesRange( pPlayerState, fMid, pPlayerState->GetDisplayedPosition().m_fSongBeat ) > MAX_NOTES_AFTER ) ) // off screen / too many notes
+		if( fYOffset < iDrawDistanceAfterTargetsPixels || ( bHasCache && pCache->GetNumNotesInRange( fMid, pPlayerState->GetDisplayedPosition().m_fSongBeat ) > MAX_NOTES_AFTER ) ) // off screen / too many notes
 		{
 			fFirstBeatToDraw = fMid; // move towards fSongBeat
 			fLow = fMid;
@@ -689,8 +684,9 @@ float FindFirstDisplayedBeat( const PlayerState* pPlayerState, int iDrawDistance
 
 }
 
-float FindLastDisplayedBeat( const PlayerState* pPlayerState, int iDrawDistanceBeforeTargetsPixels )
+float FindLastDisplayedBeat( const ArrowEffects::FrameContext &context, int iDrawDistanceBeforeTargetsPixels )
 {
+	const PlayerState *pPlayerState = context.m_pPlayerState;
 	// Probe for last note to draw. Worst case is 0.25x + boost.
 	// Adjust search distance so that notes don't pop onto the screen.
 	float fSearchDistance = 10;
@@ -709,7 +705,7 @@ float FindLastDisplayedBeat( const PlayerState* pPlayerState, int iDrawDistanceB
 	{
 		bool bIsPastPeakYOffset;
 		float fPeakYOffset;
-		float fYOffset = ArrowEffects::GetYOffset( pPlayerState, 0, fLastBeatToDraw, fPeakYOffset, bIsPastPeakYOffset, true );
+		float fYOffset = ArrowEffects::GetYOffset( context, fLastBeatToDraw, fPeakYOffset, bIsPastPeakYOffset, true );
 
 		if( bBoomerang && !bIsPastPeakYOffset )
 			fLastBeatToDraw += fSearchDistance;
@@ -729,7 +725,7 @@ float FindLastDisplayedBeat( const PlayerState* pPlayerState, int iDrawDistanceB
 	return fLastBeatToDraw;
 }
 
-bool NoteField::IsOnScreen( float fBeat, int iCol, int iDrawDistanceAfterTargetsPixels, int iDrawDistanceBeforeTargetsPixels ) const
+bool NoteField::IsOnScreen( const ArrowEffects::FrameContext &context, float fBeat, int iDrawDistanceAfterTargetsPixels, int iDrawDistanceBeforeTargetsPixels ) const
 {
 	// IMPORTANT:  Do not modify this function without also modifying the
 	// version that is in NoteDisplay.cpp or coming up with a good way to
@@ -737,7 +733,7 @@ bool NoteField::IsOnScreen( float fBeat, int iCol, int iDrawDistanceAfterTargets
 	// TRICKY: If boomerang is on, then ones in the range
 	// [iFirstRowToDraw,iLastRowToDraw] aren't necessarily visible.
 	// Test to see if this beat is visible before drawing.
-	float fYOffset = ArrowEffects::GetYOffset( m_pPlayerState, iCol, fBeat );
+	float fYOffset = ArrowEffects::GetYOffset( context, fBeat );
 	if( fYOffset > iDrawDistanceBeforeTargetsPixels )	// off screen
 		return false;
 	if( fYOffset < iDrawDistanceAfterTargetsPixels )	// off screen
@@ -791,14 +787,15 @@ void NoteField::DrawPrimitives()
 	// Some might prefer an else block, instead of returning from the if, but I
 	// don't want to bump the indent on the entire remaining section. -Kyz
 	ArrowEffects::SetCurrentOptions(&m_pPlayerState->m_PlayerOptions.GetCurrent());
+	m_FieldContext.Load( m_pPlayerState, 0, m_fYReverseOffsetPixels );
 
 	CalcPixelsBeforeAndAfterTargets();
 	NoteDisplayCols *cur = m_pCurDisplay;
 	// Probe for first and last notes on the screen
 	float first_beat_to_draw= FindFirstDisplayedBeat(
-		m_pPlayerState, m_FieldRenderArgs.draw_pixels_after_targets);
+		m_FieldContext, m_FieldRenderArgs.draw_pixels_after_targets);
 	float last_beat_to_draw= FindLastDisplayedBeat(
-		m_pPlayerState, m_FieldRenderArgs.draw_pixels_before_targets);
+		m_FieldContext, m_FieldRenderArgs.draw_pixels_before_targets);
 
 	m_pPlayerState->m_fLastDrawnBeat = last_beat_to_draw;
 
@@ -808,7 +805,7 @@ void NoteField::DrawPrimitives()
 	//LOG->Trace( "start = %f.1, end = %f.1", first_beat_to_draw-fSongBeat, last_beat_to_draw-fSongBeat );
 	//LOG->Trace( "Drawing elements %d through %d", m_FieldRenderArgs.first_row, m_FieldRenderArgs.last_row );
 
-#define IS_ON_SCREEN(fBeat)  (first_beat_to_draw <= (fBeat) && (fBeat) <= last_beat_to_draw && IsOnScreen(fBeat, 0, m_FieldRenderArgs.draw_pixels_after_targets, m_FieldRenderArgs.draw_pixels_before_targets))
+#define IS_ON_SCREEN(fBeat)  (first_beat_to_draw <= (fBeat) && (fBeat) <= last_beat_to_draw && IsOnScreen(m_FieldContext, fBeat, m_FieldRenderArgs.draw_pixels_after_targets, m_FieldRenderArgs.draw_pixels_before_targets))
 
 	// Draw Receptors
 	{
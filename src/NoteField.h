@@ -10,6 +10,7 @@
 #include "NoteDisplay.h"
 #include "ReceptorArrowRow.h"
 #include "GhostArrowRow.h"
+#include "RageTextureAtlas.h"
 
 #include <vector>
 
@@ -75,7 +76,7 @@ protected:
 	void CacheNoteSkin( const RString &sNoteSkin );
 	void UncacheNoteSkin( const RString &sNoteSkin );
 
-	bool IsOnScreen( float fBeat, int iCol, int iDrawDistanceAfterTargetsPixels, int iDrawDistanceBeforeTargetsPixels ) const;
+	bool IsOnScreen( const ArrowEffects::FrameContext &context, float fBeat, int iDrawDistanceAfterTargetsPixels, int iDrawDistanceBeforeTargetsPixels ) const;
 
 	void DrawBoard( int iDrawDistanceAfterTargetsPixels, int iDrawDistanceBeforeTargetsPixels );
 
@@ -99,6 +100,9 @@ protected:
 	int			m_iDrawDistanceAfterTargetsPixels;	// this should be a negative number
 	int			m_iDrawDistanceBeforeTargetsPixels;	// this should be a positive number
 	float		m_fYReverseOffsetPixels;
+	// The ArrowEffects terms for column 0, loaded once per Update and Draw
+	// for the beat bars, board and timing text.
+	ArrowEffects::FrameContext m_FieldContext;
 
 	// This exists so that the board can be drawn underneath combo/judge. -Kyz
 	bool m_drawing_board_primitive;
@@ -109,6 +113,7 @@ protected:
 		NoteDisplay		*display;
 		ReceptorArrowRow	m_ReceptorArrowRow;
 		GhostArrowRow		m_GhostArrowRow;
+		RageTextureAtlas	m_Atlas;	// the textures loaded by the above
 		NoteDisplayCols( int iNumCols ) { display = new NoteDisplay[iNumCols]; }
 		~NoteDisplayCols() { delete [] display; }
 	};
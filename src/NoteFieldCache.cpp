@@ -0,0 +1,181 @@
+#include "global.h"
+#include "NoteFieldCache.h"
+#include "NoteData.h"
+#include "TimingData.h"
+
+#include <algorithm>
+
+/* Calls f( fBeat, fDisplayedBeat, fVelocity ) for each scroll segment, in
+ * order, until it returns false. */
+template<class F>
+static bool ForEachDisplayedBeat( const TimingData &timing, F f )
+{
+	float fDisplayedBeat = 0.0f;
+	float fLastRealBeat = 0.0f;
+	float fLastRatio = 1.0f;
+	for( const ScrollSegment &seg : timing.GetScrollSegments() )
+	{
+		fDisplayedBeat += ( seg.GetBeat() - fLastRealBeat ) * fLastRatio;
+		fLastRealBeat = seg.GetBeat();
+		fLastRatio = seg.GetRatio();
+		if( !f(seg.GetBeat(), fDisplayedBeat, seg.GetRatio()) )
+			return false;
+	}
+	return true;
+}
+
+/* Calls f( iRow, iNotesThrough ) for each row with notes, in order, with the
+ * number of notes on it and every row before it, until it returns false.
+ * The iterator goes a row at a time, so each note is looked at once and a
+ * row is done when the next one starts. */
+template<class F>
+static bool ForEachNoteRow( const NoteData &notes, F f )
+{
+	int iCount = 0;
+	int iLastRow = -1;
+	for( NoteData::all_tracks_const_iterator it = notes.GetTapNoteRangeAllTracks(0, MAX_NOTE_ROW, true); !it.IsAtEnd(); ++it )
+	{
+		if( *it == TAP_EMPTY )
+			continue;
+		if( it.Row() != iLastRow && iLastRow != -1 && !f(iLastRow, iCount) )
+			return false;
+		iLastRow = it.Row();
+		++iCount;
+	}
+	return iLastRow == -1 || f( iLastRow, iCount );
+}
+
+template<class T>
+static void HashValue( uint64_t &iHash, T value )
+{
+	// FNV-1a.
+	const unsigned char *p = reinterpret_cast<const unsigned char *>( &value );
+	for( unsigned i = 0; i < sizeof(value); ++i )
+		iHash = (iHash ^ p[i]) * 1099511628211ull;
+}
+
+std::shared_ptr<const NoteFieldCache> NoteFieldCache::Get( const TimingData &timing, const NoteData &notes )
+{
+	// Every cache handed out that someone still holds.  Both players on the
+	// same chart end up with the same tables, so keep one copy of them.
+	static std::vector<std::weak_ptr<const NoteFieldCache>> s_vLive;
+
+	// Find a match by hashing what the tables would hold, and only build
+	// them if there isn't one.
+	const uint64_t iHash = Hash( timing, notes );
+	std::shared_ptr<const NoteFieldCache> pFound;
+	for( unsigned i = 0; i < s_vLive.size(); )
+	{
+		std::shared_ptr<const NoteFieldCache> p = s_vLive[i].lock();
+		if( !p )
+		{
+			s_vLive.erase( s_vLive.begin()+i );
+			continue;
+		}
+		if( !pFound && p->m_iHash == iHash && p->Matches(timing, notes) )
+			pFound = p;
+		++i;
+	}
+	if( pFound )
+		return pFound;
+
+	std::shared_ptr<NoteFieldCache> pNew( new NoteFieldCache );
+	pNew->Load( timing, notes );
+	pNew->m_iHash = iHash;
+	s_vLive.push_back( pNew );
+	return pNew;
+}
+
+uint64_t NoteFieldCache::Hash( const TimingData &timing, const NoteData &notes )
+{
+	uint64_t iHash = 14695981039346656037ull;
+	ForEachDisplayedBeat( timing, [&]( float fBeat, float fDisplayedBeat, float fVelocity ) {
+		HashValue( iHash, fBeat );
+		HashValue( iHash, fDisplayedBeat );
+		HashValue( iHash, fVelocity );
+		return true;
+	} );
+	// Keep the scroll segments apart from the rows.
+	HashValue( iHash, -1 );
+	ForEachNoteRow( notes, [&]( int iRow, int iNotesThrough ) {
+		HashValue( iHash, iRow );
+		HashValue( iHash, iNotesThrough );
+		return true;
+	} );
+	return iHash;
+}
+
+void NoteFieldCache::Load( const TimingData &timing, const NoteData &notes )
+{
+	m_vDisplayedBeats.clear();
+	m_vDisplayedBeats.reserve( timing.GetScrollSegments().size() );
+	ForEachDisplayedBeat( timing, [this]( float fBeat, float fDisplayedBeat, float fVelocity ) {
+		DisplayedBeat d = { fBeat, fDisplayedBeat, fVelocity };
+		m_vDisplayedBeats.push_back( d );
+		return true;
+	} );
+
+	m_vNoteBeats.clear();
+	m_vNotesThrough.clear();
+	ForEachNoteRow( notes, [this]( int iRow, int iNotesThrough ) {
+		m_vNoteBeats.push_back( NoteRowToBeat(iRow) );
+		m_vNotesThrough.push_back( iNotesThrough );
+		return true;
+	} );
+}
+
+bool NoteFieldCache::Matches( const TimingData &timing, const NoteData &notes ) const
+{
+	unsigned i = 0;
+	const bool bSameScrolls = ForEachDisplayedBeat( timing, [&]( float fBeat, float fDisplayedBeat, float fVelocity ) {
+		if( i == m_vDisplayedBeats.size() )
+			return false;
+		const DisplayedBeat &d = m_vDisplayedBeats[i++];
+		return d.fBeat == fBeat && d.fDisplayedBeat == fDisplayedBeat && d.fVelocity == fVelocity;
+	} );
+	if( !bSameScrolls || i != m_vDisplayedBeats.size() )
+		return false;
+
+	i = 0;
+	const bool bSameRows = ForEachNoteRow( notes, [&]( int iRow, int iNotesThrough ) {
+		if( i == m_vNoteBeats.size() )
+			return false;
+		const bool bSame = m_vNoteBeats[i] == NoteRowToBeat(iRow) && m_vNotesThrough[i] == iNotesThrough;
+		++i;
+		return bSame;
+	} );
+	return bSameRows && i == m_vNoteBeats.size();
+}
+
+float NoteFieldCache::GetDisplayedBeat( float fBeat ) const
+{
+	if( m_vDisplayedBeats.empty() )
+		return fBeat;
+
+	struct BeatLess
+	{
+		bool operator()( float fBeat, const DisplayedBeat &d ) const { return fBeat < d.fBeat; }
+	};
+	std::vector<DisplayedBeat>::const_iterator it =
+		std::upper_bound( m_vDisplayedBeats.begin(), m_vDisplayedBeats.end(), fBeat, BeatLess() );
+	// Beats before the first segment go by it.
+	if( it != m_vDisplayedBeats.begin() )
+		--it;
+	return it->fDisplayedBeat + it->fVelocity * (fBeat - it->fBeat);
+}
+
+unsigned NoteFieldCache::GetNoteRowIndex( float fBeat ) const
+{
+	unsigned i = std::upper_bound( m_vNoteBeats.begin(), m_vNoteBeats.end(), fBeat ) - m_vNoteBeats.begin();
+	return i == 0? 0:i-1;
+}
+
+int NoteFieldCache::GetNumNotesInRange( float fLow, float fHigh ) const
+{
+	if( m_vNoteBeats.empty() )
+		return 0;
+	const unsigned iLow = GetNoteRowIndex( fLow );
+	const unsigned iHigh = GetNoteRowIndex( fHigh );
+	const int iBefore = iLow == 0? 0:m_vNotesThrough[iLow-1];
+	return m_vNotesThrough[iHigh] - iBefore;
+}
@@ -0,0 +1,66 @@
+/* NoteFieldCache - Per-chart tables NoteField and ArrowEffects look up while drawing. */
+
+#ifndef NOTE_FIELD_CACHE_H
+#define NOTE_FIELD_CACHE_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class NoteData;
+class TimingData;
+
+/* ArrowEffects turns every note's beat into the beat it's drawn at, which
+ * depends on the scroll segments before it, and NoteField counts the notes
+ * between two beats to decide how far back to draw.  Both are looked up
+ * many times a frame, so this works them out once per chart: the displayed
+ * beat at each scroll segment, and the number of notes up to each row.
+ *
+ * Players on the same chart get the same cache; see Get(). */
+class NoteFieldCache
+{
+public:
+	/* Returns a cache already in use that has the same tables as this chart,
+	 * or builds them. */
+	static std::shared_ptr<const NoteFieldCache> Get( const TimingData &timing, const NoteData &notes );
+
+	/* Same as TimingData::GetDisplayedBeat. */
+	float GetDisplayedBeat( float fBeat ) const;
+
+	bool HasNotes() const { return !m_vNoteBeats.empty(); }
+	/* The notes on rows from the last one at or before fLow through the last
+	 * one at or before fHigh.  Beats before the first note count from it. */
+	int GetNumNotesInRange( float fLow, float fHigh ) const;
+
+private:
+	NoteFieldCache() {}
+	void Load( const TimingData &timing, const NoteData &notes );
+
+	/* A hash of the tables Load would build, without building them. */
+	static uint64_t Hash( const TimingData &timing, const NoteData &notes );
+	/* Whether Load would build these tables. */
+	bool Matches( const TimingData &timing, const NoteData &notes ) const;
+	uint64_t m_iHash;
+
+	/* The row with a note at or before fBeat, or the first one. */
+	unsigned GetNoteRowIndex( float fBeat ) const;
+
+	struct DisplayedBeat
+	{
+		float fBeat;
+		float fDisplayedBeat;
+		float fVelocity;
+	};
+	std::vector<DisplayedBeat> m_vDisplayedBeats;
+
+	// One entry for each row with notes on it: its beat, and the number of
+	// notes on it and every row before it.
+	std::vector<float> m_vNoteBeats;
+	std::vector<int> m_vNotesThrough;
+
+	// Swallow up warnings. If they must be used, define them.
+	NoteFieldCache& operator=(const NoteFieldCache& rhs);
+	NoteFieldCache(const NoteFieldCache& rhs);
+};
+
+#endif
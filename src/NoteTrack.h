@@ -0,0 +1,115 @@
+/* NoteTrack - The notes of one NoteData track, kept in a sorted vector. */
+
+#ifndef NOTE_TRACK_H
+#define NOTE_TRACK_H
+
+#include "NoteTypes.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/* This has the parts of the std::map<int,TapNote> interface that NoteData
+ * uses, with the notes stored contiguously.  Walking a track and finding a
+ * row are much quicker than with map nodes scattered over the heap, which
+ * is what every judging, drawing and radar loop does.
+ *
+ * The catch is that, unlike a map, inserting or erasing a row moves the
+ * rows after it, so it invalidates iterators (and TapNote references) past
+ * that point.  Overwriting a row that's already there doesn't.  erase()
+ * returns the iterator to carry on from. */
+class NoteTrack
+{
+public:
+	typedef int key_type;
+	typedef TapNote mapped_type;
+	typedef std::pair<int,TapNote> value_type;
+	typedef std::vector<value_type>::size_type size_type;
+	typedef std::vector<value_type>::iterator iterator;
+	typedef std::vector<value_type>::const_iterator const_iterator;
+	typedef std::vector<value_type>::reverse_iterator reverse_iterator;
+	typedef std::vector<value_type>::const_reverse_iterator const_reverse_iterator;
+
+	NoteTrack() {}
+	/* [first,last) must be sorted by row, with no row repeated. */
+	template<typename It>
+	NoteTrack( It first, It last ): m_Notes( first, last ) {}
+
+	iterator begin()				{ return m_Notes.begin(); }
+	const_iterator begin() const			{ return m_Notes.begin(); }
+	iterator end()					{ return m_Notes.end(); }
+	const_iterator end() const			{ return m_Notes.end(); }
+	reverse_iterator rbegin()			{ return m_Notes.rbegin(); }
+	const_reverse_iterator rbegin() const		{ return m_Notes.rbegin(); }
+	reverse_iterator rend()				{ return m_Notes.rend(); }
+	const_reverse_iterator rend() const		{ return m_Notes.rend(); }
+
+	bool empty() const				{ return m_Notes.empty(); }
+	size_type size() const				{ return m_Notes.size(); }
+	size_type capacity() const			{ return m_Notes.capacity(); }
+	void reserve( size_type n )			{ m_Notes.reserve( n ); }
+	void clear()					{ m_Notes.clear(); }
+	void swap( NoteTrack &other )			{ m_Notes.swap( other.m_Notes ); }
+
+	iterator lower_bound( int iRow )		{ return std::lower_bound( m_Notes.begin(), m_Notes.end(), iRow, RowLess ); }
+	const_iterator lower_bound( int iRow ) const	{ return std::lower_bound( m_Notes.begin(), m_Notes.end(), iRow, RowLess ); }
+	iterator upper_bound( int iRow )		{ return std::upper_bound( m_Notes.begin(), m_Notes.end(), iRow, LessRow ); }
+	const_iterator upper_bound( int iRow ) const	{ return std::upper_bound( m_Notes.begin(), m_Notes.end(), iRow, LessRow ); }
+
+	iterator find( int iRow )
+	{
+		iterator it = lower_bound( iRow );
+		return it != m_Notes.end() && it->first == iRow? it:m_Notes.end();
+	}
+	const_iterator find( int iRow ) const
+	{
+		const_iterator it = lower_bound( iRow );
+		return it != m_Notes.end() && it->first == iRow? it:m_Notes.end();
+	}
+	size_type count( int iRow ) const		{ return find(iRow) != m_Notes.end()? 1:0; }
+
+	TapNote &operator[]( int iRow )
+	{
+		// Loaders and transforms mostly write in order; don't search for those.
+		if( m_Notes.empty() || m_Notes.back().first < iRow )
+		{
+			m_Notes.push_back( value_type(iRow, TapNote()) );
+			return m_Notes.back().second;
+		}
+		iterator it = lower_bound( iRow );
+		if( it->first != iRow )
+			it = m_Notes.insert( it, value_type(iRow, TapNote()) );
+		return it->second;
+	}
+
+	std::pair<iterator,bool> insert( const value_type &v )
+	{
+		iterator it = lower_bound( v.first );
+		if( it != m_Notes.end() && it->first == v.first )
+			return std::make_pair( it, false );
+		return std::make_pair( m_Notes.insert(it, v), true );
+	}
+
+	iterator erase( const_iterator it )			{ return m_Notes.erase( it ); }
+	iterator erase( const_iterator first, const_iterator last )	{ return m_Notes.erase( first, last ); }
+	size_type erase( int iRow )
+	{
+		iterator it = find( iRow );
+		if( it == m_Notes.end() )
+			return 0;
+		m_Notes.erase( it );
+		return 1;
+	}
+
+	bool operator==( const NoteTrack &other ) const	{ return m_Notes == other.m_Notes; }
+	bool operator!=( const NoteTrack &other ) const	{ return m_Notes != other.m_Notes; }
+
+private:
+	static bool RowLess( const value_type &v, int iRow )	{ return v.first < iRow; }
+	static bool LessRow( int iRow, const value_type &v )	{ return iRow < v.first; }
+
+	std::vector<value_type> m_Notes;
+};
+
+#endif
@@ -0,0 +1,288 @@
+#include "global.h"
+#include "NotesLoaderCache.h"
+#include "BinaryCache.h"
+#include "BackgroundUtil.h"
+#include "GameManager.h"
+#include "RageFile.h"
+#include "RageLog.h"
+#include "RageUtil.h"
+#include "Song.h"
+#include "Steps.h"
+#include "TimingData.h"
+
+#include <cstring>
+
+static void ReadTiming( CacheReader &in, TimingData &out )
+{
+	out = TimingData( in.Float() );
+	FOREACH_TimingSegmentType( tst )
+	{
+		uint32_t iCount = in.Count();
+		for( uint32_t i = 0; i < iCount && !in.Failed(); ++i )
+		{
+			int iRow = in.I32();
+			switch( tst )
+			{
+			case SEGMENT_BPM:
+			{
+				BPMSegment seg( iRow );
+				seg.SetBPS( in.Float() );
+				out.AddSegment( seg );
+				break;
+			}
+			case SEGMENT_STOP:	out.AddSegment( StopSegment(iRow, in.Float()) ); break;
+			case SEGMENT_DELAY:	out.AddSegment( DelaySegment(iRow, in.Float()) ); break;
+			case SEGMENT_TIME_SIG:
+			{
+				int iNum = in.I32();
+				int iDen = in.I32();
+				out.AddSegment( TimeSignatureSegment(iRow, iNum, iDen) );
+				break;
+			}
+			case SEGMENT_WARP:	out.AddSegment( WarpSegment(iRow, in.I32()) ); break;
+			case SEGMENT_LABEL:	out.AddSegment( LabelSegment(iRow, in.String()) ); break;
+			case SEGMENT_TICKCOUNT:	out.AddSegment( TickcountSegment(iRow, in.I32()) ); break;
+			case SEGMENT_COMBO:
+			{
+				int iCombo = in.I32();
+				int iMissCombo = in.I32();
+				out.AddSegment( ComboSegment(iRow, iCombo, iMissCombo) );
+				break;
+			}
+			case SEGMENT_SPEED:
+			{
+				float fRatio = in.Float();
+				float fDelay = in.Float();
+				int iUnit = in.I32();
+				out.AddSegment( SpeedSegment(iRow, fRatio, fDelay, static_cast<SpeedSegment::BaseUnit>(iUnit)) );
+				break;
+			}
+			case SEGMENT_SCROLL:	out.AddSegment( ScrollSegment(iRow, in.Float()) ); break;
+			case SEGMENT_FAKE:	out.AddSegment( FakeSegment(iRow, in.I32()) ); break;
+			default: FAIL_M( ssprintf("Invalid timing segment type %i", tst) );
+			}
+		}
+	}
+}
+
+static void ReadBackgroundChanges( CacheReader &in, std::vector<BackgroundChange> &out )
+{
+	uint32_t iCount = in.Count();
+	out.clear();
+	out.reserve( iCount );
+	for( uint32_t i = 0; i < iCount; ++i )
+	{
+		BackgroundChange bgc;
+		bgc.m_def.m_sEffect = in.String();
+		bgc.m_def.m_sFile1 = in.String();
+		bgc.m_def.m_sFile2 = in.String();
+		bgc.m_def.m_sColor1 = in.String();
+		bgc.m_def.m_sColor2 = in.String();
+		bgc.m_fStartBeat = in.Float();
+		bgc.m_fRate = in.Float();
+		bgc.m_sTransition = in.String();
+		out.push_back( bgc );
+	}
+}
+
+static void ReadAttacks( CacheReader &in, AttackArray &attacks, std::vector<RString> &vsAttackString )
+{
+	in.StringVector( vsAttackString );
+	uint32_t iCount = in.Count();
+	attacks.clear();
+	for( uint32_t i = 0; i < iCount; ++i )
+	{
+		Attack a;
+		a.fStartSecond = in.Float();
+		a.fSecsRemaining = in.Float();
+		a.sModifiers = in.String();
+		attacks.push_back( a );
+	}
+}
+
+static void ReadSongBlock( CacheReader &in, Song &out )
+{
+	out.m_sMainTitle = in.String();
+	out.m_sSubTitle = in.String();
+	out.m_sArtist = in.String();
+	out.m_sMainTitleTranslit = in.String();
+	out.m_sSubTitleTranslit = in.String();
+	out.m_sArtistTranslit = in.String();
+	out.m_sGenre = in.String();
+	out.m_sOrigin = in.String();
+	out.m_sCredit = in.String();
+	out.m_sBannerFile = in.String();
+	out.m_sBackgroundFile = in.String();
+	out.m_sPreviewVidFile = in.String();
+	out.m_sJacketFile = in.String();
+	out.m_sCDFile = in.String();
+	out.m_sDiscFile = in.String();
+	out.m_sLyricsFile = in.String();
+	out.m_sCDTitleFile = in.String();
+	out.m_sMusicFile = in.String();
+	out.m_PreviewFile = in.String();
+	FOREACH_ENUM( InstrumentTrack, it )
+		out.m_sInstrumentTrackFile[it] = in.String();
+
+	out.m_fMusicSampleStartSeconds = in.Float();
+	out.m_fMusicSampleLengthSeconds = in.Float();
+	out.m_SelectionDisplay = static_cast<Song::SelectionDisplay>( in.I32() );
+	out.m_DisplayBPMType = static_cast<DisplayBPM>( in.I32() );
+	out.m_fSpecifiedBPMMin = in.Float();
+	out.m_fSpecifiedBPMMax = in.Float();
+	out.SetSpecifiedLastSecond( in.Float() );
+
+	ReadTiming( in, out.m_SongTiming );
+
+	FOREACH_BackgroundLayer( bl )
+		ReadBackgroundChanges( in, out.GetBackgroundChanges(bl) );
+	ReadBackgroundChanges( in, out.GetForegroundChanges() );
+
+	in.StringVector( out.m_vsKeysoundFile );
+	ReadAttacks( in, out.m_Attacks, out.m_sAttackString );
+
+	// cache tags
+	out.SetFirstSecond( in.Float() );
+	out.SetLastSecond( in.Float() );
+	out.m_sSongFileName = in.String();
+	out.m_bHasMusic = in.Bool();
+	out.m_bHasBanner = in.Bool();
+	out.m_fMusicLengthSeconds = in.Float();
+}
+
+static void ReadStepsBlock( CacheReader &in, uint32_t iNoteBlockStart, uint32_t iNoteBlockSize, Steps &out )
+{
+	out.SetChartName( in.String() );
+	RString sStepsType = in.String();
+	out.m_StepsType = GAMEMAN->StringToStepsType( sStepsType );
+	out.m_StepsTypeStr = sStepsType;
+	RString sDescription = in.String();
+	out.SetChartStyle( in.String() );
+	Difficulty dc = static_cast<Difficulty>( in.I32() );
+	out.SetDifficultyAndDescription( dc, sDescription );
+	out.SetMeter( in.I32() );
+	out.SetMusicFile( in.String() );
+	out.SetCredit( in.String() );
+
+	if( in.U32() != NUM_RadarCategory )
+	{
+		// Written by a build with different radar categories.
+		in.Fail();
+		return;
+	}
+	RadarValues v[NUM_PLAYERS];
+	FOREACH_PlayerNumber( pn )
+		FOREACH_ENUM( RadarCategory, rc )
+			v[pn][rc] = in.Float();
+	out.SetCachedRadarValues( v );
+
+	if( in.Bool() )
+		ReadTiming( in, out.m_Timing );
+
+	ReadAttacks( in, out.m_Attacks, out.m_sAttackString );
+
+	out.SetDisplayBPM( static_cast<DisplayBPM>(in.I32()) );
+	out.SetMinBPM( in.Float() );
+	out.SetMaxBPM( in.Float() );
+
+	out.SetFilename( in.String() );
+
+	// The note data itself stays on disk until the chart is used.
+	uint32_t iNoteOffset = in.U32();
+	uint32_t iNoteSize = in.U32();
+	uint32_t iPackedHash = in.U32();
+	uint32_t iNoteHash = in.U32();
+	if( iNoteOffset > iNoteBlockSize || iNoteSize > iNoteBlockSize - iNoteOffset )
+		in.Fail();
+	else if( iNoteSize != 0 )
+		out.SetCacheNoteData( iNoteBlockStart + iNoteOffset, iNoteSize, iPackedHash, iNoteHash );
+}
+
+static bool ReadHeader( RageFile &f, uint32_t &iSongBlockSize, uint32_t &iNoteBlockSize )
+{
+	char header[NotesLoaderCache::CACHE_HEADER_SIZE];
+	if( f.Read(header, sizeof(header)) != sizeof(header) )
+		return false;
+	if( std::memcmp(header, NotesLoaderCache::CACHE_MAGIC, sizeof(NotesLoaderCache::CACHE_MAGIC)) )
+		return false;
+
+	CacheReader in( header + sizeof(NotesLoaderCache::CACHE_MAGIC), sizeof(header) - sizeof(NotesLoaderCache::CACHE_MAGIC) );
+	uint32_t iFormatVersion = in.U32();
+	int iCacheVersion = in.I32();
+	iSongBlockSize = in.U32();
+	iNoteBlockSize = in.U32();
+	return iFormatVersion == NotesLoaderCache::CACHE_FORMAT_VERSION && iCacheVersion == FILE_CACHE_VERSION;
+}
+
+bool NotesLoaderCache::IsCacheFile( const RString &sPath )
+{
+	RageFile f;
+	if( !f.Open(sPath) )
+		return false;
+	char magic[sizeof(CACHE_MAGIC)];
+	if( f.Read(magic, sizeof(magic)) != sizeof(magic) )
+		return false;
+	return !std::memcmp( magic, CACHE_MAGIC, sizeof(magic) );
+}
+
+bool NotesLoaderCache::LoadFromCacheFile( const RString &sPath, Song &out )
+{
+	RageFile f;
+	if( !f.Open(sPath) )
+		return false;
+
+	uint32_t iSongBlockSize, iNoteBlockSize;
+	if( !ReadHeader(f, iSongBlockSize, iNoteBlockSize) )
+		return false;
+
+	// A short file is a write that didn't finish.
+	if( static_cast<uint64_t>(f.GetFileSize()) != uint64_t(CACHE_HEADER_SIZE) + iSongBlockSize + iNoteBlockSize )
+	{
+		LOG->Trace( "Cache file \"%s\" is truncated.", sPath.c_str() );
+		return false;
+	}
+
+	/* RageFile drivers don't expose a mapping, so read the song block in one
+	 * go and decode in place; the note block isn't read at all. */
+	RString sBuf;
+	if( f.Read(sBuf, iSongBlockSize) != static_cast<int>(iSongBlockSize) )
+		return false;
+
+	CacheReader in( sBuf.data(), sBuf.size() );
+	ReadSongBlock( in, out );
+
+	std::vector<Steps *> vpSteps;
+	uint32_t iNumSteps = in.Count();
+	for( uint32_t i = 0; i < iNumSteps && !in.Failed(); ++i )
+	{
+		Steps *pSteps = out.CreateSteps();
+		vpSteps.push_back( pSteps );
+		ReadStepsBlock( in, CACHE_HEADER_SIZE + iSongBlockSize, iNoteBlockSize, *pSteps );
+	}
+
+	if( in.Failed() || !in.AtEnd() )
+	{
+		LOG->Trace( "Cache file \"%s\" is damaged.", sPath.c_str() );
+		for( Steps *pSteps : vpSteps )
+			delete pSteps;
+
+		/* The caller reloads the song from its directory, and the loaders
+		 * append to these rather than replacing them. */
+		out.m_SongTiming = TimingData();
+		FOREACH_BackgroundLayer( bl )
+			out.GetBackgroundChanges(bl).clear();
+		out.GetForegroundChanges().clear();
+		out.m_vsKeysoundFile.clear();
+		out.m_Attacks.clear();
+		out.m_sAttackString.clear();
+		return false;
+	}
+
+	for( Steps *pSteps : vpSteps )
+		out.AddSteps( pSteps );
+
+	out.m_SongTiming.m_sFile = sPath; // songs still have their fallback timing.
+	out.m_fVersion = STEPFILE_VERSION_NUMBER;
+	out.TidyUpData( true, true );
+	return true;
+}
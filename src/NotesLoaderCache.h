@@ -0,0 +1,46 @@
+/* NotesLoaderCache - Reads a Song from a binary song cache file. */
+
+#ifndef NotesLoaderCache_H
+#define NotesLoaderCache_H
+
+#include <cstdint>
+
+class Song;
+
+/* Song cache files used to be .ssc files, reparsed with MsdFile on every
+ * boot.  They are now a flat binary image of what the SSC loader would have
+ * produced, so a cache hit is one read and a walk over the buffer.
+ *
+ * Layout (all integers and floats little-endian):
+ *
+ *   header     magic "SMSC", format version, FILE_CACHE_VERSION,
+ *              song block size, note block size
+ *   song block song metadata, song TimingData, background changes, then
+ *              every Steps' metadata, radar values and TimingData
+ *   note block each Steps' note data in NoteDataUtil's packed format, at
+ *              the offset and size recorded in its Steps entry, with a hash
+ *              of the packed data and the chart's Steps::GetHash().  A size
+ *              of 0 means the notes have to be read from the Steps' simfile.
+ *
+ * Strings are a u32 length followed by the bytes; arrays are a u32 count
+ * followed by the elements.  Loading only reads the header and the song
+ * block; each Steps keeps its note data location, and reads just that when
+ * it is first decompressed. */
+namespace NotesLoaderCache
+{
+	const char CACHE_MAGIC[4] = { 'S', 'M', 'S', 'C' };
+	/* Bump this whenever the layout changes.  FILE_CACHE_VERSION is checked
+	 * too, so changes to what the song loaders produce are covered by that. */
+	const uint32_t CACHE_FORMAT_VERSION = 3;
+	const int CACHE_HEADER_SIZE = 20;
+
+	/* Returns false if the file isn't a binary cache file of this version or
+	 * is damaged; the caller falls back to the old SSC cache path. */
+	bool LoadFromCacheFile( const RString &sPath, Song &out );
+
+	/* True if sPath starts with the binary cache magic, whatever its
+	 * version. */
+	bool IsCacheFile( const RString &sPath );
+};
+
+#endif
@@ -26,7 +26,7 @@ struct SMSongTagInfo
 {
 	SMLoader* loader;
 	Song* song;
-	const MsdFile::value_t* params;
+	const MsdFile::value_view_t* params;
 	const RString& path;
 	std::vector<std::pair<float, float>> BPMChanges, Stops;
 	SMSongTagInfo(SMLoader* l, Song* s, const RString& p)
@@ -146,23 +146,24 @@ void SMSetDisplayBPM(SMSongTagInfo& info)
 }
 void SMSetSelectable(SMSongTagInfo& info)
 {
-	if((*info.params)[1].EqualsNoCase("YES"))
+	const RString sValue = (*info.params)[1];
+	if(sValue.EqualsNoCase("YES"))
 	{ info.song->m_SelectionDisplay = info.song->SHOW_ALWAYS; }
-	else if((*info.params)[1].EqualsNoCase("NO"))
+	else if(sValue.EqualsNoCase("NO"))
 	{ info.song->m_SelectionDisplay = info.song->SHOW_NEVER; }
 	// ROULETTE from 3.9. It was removed since UnlockManager can serve
 	// the same purpose somehow. This, of course, assumes you're using
 	// unlocks. -aj
-	else if((*info.params)[1].EqualsNoCase("ROULETTE"))
+	else if(sValue.EqualsNoCase("ROULETTE"))
 	{ info.song->m_SelectionDisplay = info.song->SHOW_ALWAYS; }
 	/* The following two cases are just fixes to make sure simfiles that
 	 * used 3.9+ features are not excluded here */
-	else if((*info.params)[1].EqualsNoCase("ES") || (*info.params)[1].EqualsNoCase("OMES"))
+	else if(sValue.EqualsNoCase("ES") || sValue.EqualsNoCase("OMES"))
 	{ info.song->m_SelectionDisplay = info.song->SHOW_ALWAYS; }
-	else if(StringToInt((*info.params)[1]) > 0)
+	else if(StringToInt(sValue) > 0)
 	{ info.song->m_SelectionDisplay = info.song->SHOW_ALWAYS; }
 	else
-	{ LOG->UserLog("Song file", info.path, "has an unknown #SELECTABLE value, \"%s\"; ignored.", (*info.params)[1].c_str()); }
+	{ LOG->UserLog("Song file", info.path, "has an unknown #SELECTABLE value, \"%s\"; ignored.", sValue.c_str()); }
 }
 void SMSetBGChanges(SMSongTagInfo& info)
 {
@@ -372,9 +373,9 @@ void SMLoader::ProcessBGChanges( Song &out, const RString &sValueName, const RSt
 	}
 }
 
-void SMLoader::ProcessAttackString( std::vector<RString> & attacks, MsdFile::value_t params )
+void SMLoader::ProcessAttackString( std::vector<RString> & attacks, const MsdFile::value_view_t &params )
 {
-	for( unsigned s=1; s < params.params.size(); ++s )
+	for( unsigned s=1; s < params.size(); ++s )
 	{
 		RString tmp = params[s];
 		Trim(tmp);
@@ -383,12 +384,12 @@ void SMLoader::ProcessAttackString( std::vector<RString> & attacks, MsdFile::val
 	}
 }
 
-void SMLoader::ProcessAttacks( AttackArray &attacks, MsdFile::value_t params )
+void SMLoader::ProcessAttacks( AttackArray &attacks, const MsdFile::value_view_t &params )
 {
 	Attack attack;
 	float end = -9999;
 
-	for( unsigned j=1; j < params.params.size(); ++j )
+	for( unsigned j=1; j < params.size(); ++j )
 	{
 		std::vector<RString> sBits;
 		split( params[j], "=", sBits, false );
@@ -1040,7 +1041,7 @@ bool SMLoader::LoadFromBGChangesVector( BackgroundChange &change, std::vector<RS
 bool SMLoader::LoadNoteDataFromSimfile( const RString &path, Steps &out )
 {
 	MsdFile msd;
-	if( !msd.ReadFile( path, true ) )  // unescape
+	if( !msd.ReadFile( path, true, MsdFile::VIEW_PARAMS ) )  // unescape
 	{
 		LOG->UserLog("Song file",
 			     path,
@@ -1051,7 +1052,7 @@ bool SMLoader::LoadNoteDataFromSimfile( const RString &path, Steps &out )
 	for (unsigned i = 0; i<msd.GetNumValues(); i++)
 	{
 		int iNumParams = msd.GetNumParams(i);
-		const MsdFile::value_t &sParams = msd.GetValue(i);
+		const MsdFile::value_view_t sParams = msd.GetValueView(i);
 		RString sValueName = sParams[0];
 		sValueName.MakeUpper();
 
@@ -1119,7 +1120,7 @@ bool SMLoader::LoadFromSimfile( const RString &sPath, Song &out, bool bFromCache
 	//LOG->Trace( "Song::LoadFromSMFile(%s)", sPath.c_str() );
 
 	MsdFile msd;
-	if( !msd.ReadFile( sPath, true ) )  // unescape
+	if( !msd.ReadFile( sPath, true, MsdFile::VIEW_PARAMS ) )  // unescape
 	{
 		LOG->UserLog( "Song file", sPath, "couldn't be opened: %s", msd.GetError().c_str() );
 		return false;
@@ -1133,7 +1134,7 @@ bool SMLoader::LoadFromSimfile( const RString &sPath, Song &out, bool bFromCache
 	for( unsigned i=0; i<msd.GetNumValues(); i++ )
 	{
 		int iNumParams = msd.GetNumParams(i);
-		const MsdFile::value_t &sParams = msd.GetValue(i);
+		const MsdFile::value_view_t sParams = msd.GetValueView(i);
 		RString sValueName = sParams[0];
 		sValueName.MakeUpper();
 
@@ -1196,7 +1197,7 @@ bool SMLoader::LoadEditFromFile( RString sEditFilePath, ProfileSlot slot, bool b
 	}
 
 	MsdFile msd;
-	if( !msd.ReadFile( sEditFilePath, true ) ) // unescape
+	if( !msd.ReadFile( sEditFilePath, true, MsdFile::VIEW_PARAMS ) ) // unescape
 	{
 		LOG->UserLog( "Edit file", sEditFilePath, "couldn't be opened: %s", msd.GetError().c_str() );
 		return false;
@@ -1208,7 +1209,7 @@ bool SMLoader::LoadEditFromFile( RString sEditFilePath, ProfileSlot slot, bool b
 bool SMLoader::LoadEditFromBuffer( const RString &sBuffer, const RString &sEditFilePath, ProfileSlot slot, Song *givenSong )
 {
 	MsdFile msd;
-	msd.ReadFromString( sBuffer, true ); // unescape
+	msd.ReadFromString( sBuffer, true, MsdFile::VIEW_PARAMS ); // unescape
 	return LoadEditFromMsd( msd, sEditFilePath, slot, true, givenSong );
 }
 
@@ -1219,7 +1220,7 @@ bool SMLoader::LoadEditFromMsd( const MsdFile &msd, const RString &sEditFilePath
 	for( unsigned i=0; i<msd.GetNumValues(); i++ )
 	{
 		int iNumParams = msd.GetNumParams(i);
-		const MsdFile::value_t &sParams = msd.GetValue(i);
+		const MsdFile::value_view_t sParams = msd.GetValueView(i);
 		RString sValueName = sParams[0];
 		sValueName.MakeUpper();
 
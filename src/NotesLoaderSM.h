@@ -162,13 +162,13 @@ struct SMLoader
 	 * @brief Put the attacks in the attacks string.
 	 * @param attacks the attack string.
 	 * @param params the params from the simfile. */
-	virtual void ProcessAttackString(std::vector<RString> &attacks, MsdFile::value_t params);
+	virtual void ProcessAttackString(std::vector<RString> &attacks, const MsdFile::value_view_t &params);
 
 	/**
 	 * @brief Put the attacks in the attacks array.
 	 * @param attacks the attacks array.
 	 * @param params the params from the simfile. */
-	void ProcessAttacks( AttackArray &attacks, MsdFile::value_t params );
+	void ProcessAttacks( AttackArray &attacks, const MsdFile::value_view_t &params );
 	void ProcessInstrumentTracks( Song &out, const RString &sParam );
 
 	/**
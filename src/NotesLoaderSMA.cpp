@@ -435,8 +435,8 @@ bool SMALoader::LoadFromSimfile( const RString &sPath, Song &out, bool bFromCach
 		// Attacks loaded from file
 		else if( sValueName=="ATTACKS" )
 		{
-			ProcessAttackString(out.m_sAttackString, sParams);
-			ProcessAttacks(out.m_Attacks, sParams);
+			ProcessAttackString(out.m_sAttackString, msd.GetValueView(i));
+			ProcessAttacks(out.m_Attacks, msd.GetValueView(i));
 		}
 
 		else if( sValueName=="NOTES" || sValueName=="NOTES2" )
@@ -29,7 +29,7 @@ struct StepsTagInfo
 	Song* song;
 	Steps* steps;
 	TimingData* timing;
-	const MsdFile::value_t* params;
+	const MsdFile::value_view_t* params;
 	const RString& path;
 	bool has_own_timing;
 	bool ssc_format;
@@ -44,7 +44,7 @@ struct SongTagInfo
 {
 	SSCLoader* loader;
 	Song* song;
-	const MsdFile::value_t* params;
+	const MsdFile::value_view_t* params;
 	const RString& path;
 	bool from_cache;
 	SongTagInfo(SSCLoader* l, Song* s, const RString& p, bool fc)
@@ -192,21 +192,22 @@ void SetDisplayBPM(SongTagInfo& info)
 }
 void SetSelectable(SongTagInfo& info)
 {
-	if((*info.params)[1].EqualsNoCase("YES"))
+	const RString sValue = (*info.params)[1];
+	if(sValue.EqualsNoCase("YES"))
 	{ info.song->m_SelectionDisplay = info.song->SHOW_ALWAYS; }
-	else if((*info.params)[1].EqualsNoCase("NO"))
+	else if(sValue.EqualsNoCase("NO"))
 	{ info.song->m_SelectionDisplay = info.song->SHOW_NEVER; }
 	// ROULETTE from 3.9 is no longer in use.
-	else if((*info.params)[1].EqualsNoCase("ROULETTE"))
+	else if(sValue.EqualsNoCase("ROULETTE"))
 	{ info.song->m_SelectionDisplay = info.song->SHOW_ALWAYS; }
 	/* The following two cases are just fixes to make sure simfiles that
 	 * used 3.9+ features are not excluded here */
-	else if((*info.params)[1].EqualsNoCase("ES") || (*info.params)[1].EqualsNoCase("OMES"))
+	else if(sValue.EqualsNoCase("ES") || sValue.EqualsNoCase("OMES"))
 	{ info.song->m_SelectionDisplay = info.song->SHOW_ALWAYS; }
-	else if(StringToInt((*info.params)[1]) > 0)
+	else if(StringToInt(sValue) > 0)
 	{ info.song->m_SelectionDisplay = info.song->SHOW_ALWAYS; }
 	else
-	{ LOG->UserLog("Song file", info.path, "has an unknown #SELECTABLE value, \"%s\"; ignored.", (*info.params)[1].c_str()); }
+	{ LOG->UserLog("Song file", info.path, "has an unknown #SELECTABLE value, \"%s\"; ignored.", sValue.c_str()); }
 }
 void SetBGChanges(SongTagInfo& info)
 {
@@ -847,7 +848,7 @@ bool SSCLoader::LoadNoteDataFromSimfile( const RString & cachePath, Steps &out )
 	LOG->Trace( "Loading notes from %s", cachePath.c_str() );
 
 	MsdFile msd;
-	if (!msd.ReadFile(cachePath, true))
+	if (!msd.ReadFile(cachePath, true, MsdFile::VIEW_PARAMS))
 	{
 		LOG->UserLog("Unable to load any notes from",
 			     cachePath,
@@ -862,16 +863,22 @@ bool SSCLoader::LoadNoteDataFromSimfile( const RString & cachePath, Steps &out )
 
 	for (unsigned i = 0; i < values; i++)
 	{
-		const MsdFile::value_t &params = msd.GetValue(i);
+		const MsdFile::value_view_t params = msd.GetValueView(i);
 		RString valueName = params[0];
 		valueName.MakeUpper();
-		RString matcher = params[1]; // mainly for debugging.
-		Trim(matcher);
 
 		load_note_data_handler_map_t::iterator handler=
 			parser_helper.load_note_data_handlers.find(valueName);
 		if(handler != parser_helper.load_note_data_handlers.end())
 		{
+			// Only copied out for the tags that are looked at, so other charts'
+			// notes stay in the file buffer.
+			RString matcher;
+			if(tryingSteps || handler->second == LNDID_version)
+			{
+				matcher = params[1];
+				Trim(matcher);
+			}
 			if(tryingSteps)
 			{
 				switch(handler->second)
@@ -955,7 +962,7 @@ bool SSCLoader::LoadFromSimfile( const RString &sPath, Song &out, bool bFromCach
 	//LOG->Trace( "Song::LoadFromSSCFile(%s)", sPath.c_str() );
 
 	MsdFile msd;
-	if( !msd.ReadFile( sPath, true ) )
+	if( !msd.ReadFile( sPath, true, MsdFile::VIEW_PARAMS ) )
 	{
 		LOG->UserLog( "Song file", sPath, "couldn't be opened: %s", msd.GetError().c_str() );
 		return false;
@@ -974,7 +981,7 @@ bool SSCLoader::LoadFromSimfile( const RString &sPath, Song &out, bool bFromCach
 
 	for( unsigned i = 0; i < values; i++ )
 	{
-		const MsdFile::value_t &sParams = msd.GetValue(i);
+		const MsdFile::value_view_t sParams = msd.GetValueView(i);
 		RString sValueName = sParams[0];
 		sValueName.MakeUpper();
 
@@ -1065,7 +1072,7 @@ bool SSCLoader::LoadEditFromFile( RString sEditFilePath, ProfileSlot slot, bool
 	}
 
 	MsdFile msd;
-	if( !msd.ReadFile( sEditFilePath, true ) ) // unescape
+	if( !msd.ReadFile( sEditFilePath, true, MsdFile::VIEW_PARAMS ) ) // unescape
 	{
 		LOG->UserLog("Edit file",
 			     sEditFilePath,
@@ -1093,7 +1100,7 @@ bool SSCLoader::LoadEditFromMsd(const MsdFile &msd,
 	for(unsigned int i = 0; i < msd.GetNumValues(); ++i)
 	{
 		int iNumParams = msd.GetNumParams(i);
-		const MsdFile::value_t &sParams = msd.GetValue(i);
+		const MsdFile::value_view_t sParams = msd.GetValueView(i);
 		RString sValueName = sParams[0];
 		sValueName.MakeUpper();
 
@@ -0,0 +1,219 @@
+#include "global.h"
+#include "NotesWriterCache.h"
+#include "NotesLoaderCache.h"
+#include "BinaryCache.h"
+#include "BackgroundUtil.h"
+#include "RageFile.h"
+#include "RageLog.h"
+#include "RageUtil.h"
+#include "Song.h"
+#include "Steps.h"
+#include "TimingData.h"
+
+#include <cstring>
+
+static void WriteTiming( RString &out, const TimingData &timing )
+{
+	WriteFloat( out, timing.m_fBeat0OffsetInSeconds );
+	FOREACH_TimingSegmentType( tst )
+	{
+		const std::vector<TimingSegment *> &segs = timing.GetTimingSegments( tst );
+		WriteU32( out, segs.size() );
+		for( const TimingSegment *seg : segs )
+		{
+			WriteI32( out, seg->GetRow() );
+			switch( tst )
+			{
+			case SEGMENT_BPM:	WriteFloat( out, ToBPM(seg)->GetBPS() ); break;
+			case SEGMENT_STOP:	WriteFloat( out, ToStop(seg)->GetPause() ); break;
+			case SEGMENT_DELAY:	WriteFloat( out, ToDelay(seg)->GetPause() ); break;
+			case SEGMENT_TIME_SIG:
+				WriteI32( out, ToTimeSignature(seg)->GetNum() );
+				WriteI32( out, ToTimeSignature(seg)->GetDen() );
+				break;
+			case SEGMENT_WARP:	WriteI32( out, ToWarp(seg)->GetLengthRows() ); break;
+			case SEGMENT_LABEL:	WriteString( out, ToLabel(seg)->GetLabel() ); break;
+			case SEGMENT_TICKCOUNT:	WriteI32( out, ToTickcount(seg)->GetTicks() ); break;
+			case SEGMENT_COMBO:
+				WriteI32( out, ToCombo(seg)->GetCombo() );
+				WriteI32( out, ToCombo(seg)->GetMissCombo() );
+				break;
+			case SEGMENT_SPEED:
+				WriteFloat( out, ToSpeed(seg)->GetRatio() );
+				WriteFloat( out, ToSpeed(seg)->GetDelay() );
+				WriteI32( out, ToSpeed(seg)->GetUnit() );
+				break;
+			case SEGMENT_SCROLL:	WriteFloat( out, ToScroll(seg)->GetRatio() ); break;
+			case SEGMENT_FAKE:	WriteI32( out, ToFake(seg)->GetLengthRows() ); break;
+			default: FAIL_M( ssprintf("Invalid timing segment type %i", tst) );
+			}
+		}
+	}
+}
+
+static void WriteBackgroundChanges( RString &out, const std::vector<BackgroundChange> &changes )
+{
+	WriteU32( out, changes.size() );
+	for( BackgroundChange const &bgc : changes )
+	{
+		WriteString( out, bgc.m_def.m_sEffect );
+		WriteString( out, bgc.m_def.m_sFile1 );
+		WriteString( out, bgc.m_def.m_sFile2 );
+		WriteString( out, bgc.m_def.m_sColor1 );
+		WriteString( out, bgc.m_def.m_sColor2 );
+		WriteFloat( out, bgc.m_fStartBeat );
+		WriteFloat( out, bgc.m_fRate );
+		WriteString( out, bgc.m_sTransition );
+	}
+}
+
+static void WriteAttacks( RString &out, const AttackArray &attacks, const std::vector<RString> &vsAttackString )
+{
+	WriteStringVector( out, vsAttackString );
+	WriteU32( out, attacks.size() );
+	for( Attack const &a : attacks )
+	{
+		WriteFloat( out, a.fStartSecond );
+		WriteFloat( out, a.fSecsRemaining );
+		WriteString( out, a.sModifiers );
+	}
+}
+
+static void WriteSongBlock( RString &out, const Song &song )
+{
+	WriteString( out, song.m_sMainTitle );
+	WriteString( out, song.m_sSubTitle );
+	WriteString( out, song.m_sArtist );
+	WriteString( out, song.m_sMainTitleTranslit );
+	WriteString( out, song.m_sSubTitleTranslit );
+	WriteString( out, song.m_sArtistTranslit );
+	WriteString( out, song.m_sGenre );
+	WriteString( out, song.m_sOrigin );
+	WriteString( out, song.m_sCredit );
+	WriteString( out, song.m_sBannerFile );
+	WriteString( out, song.m_sBackgroundFile );
+	WriteString( out, song.m_sPreviewVidFile );
+	WriteString( out, song.m_sJacketFile );
+	WriteString( out, song.m_sCDFile );
+	WriteString( out, song.m_sDiscFile );
+	WriteString( out, song.m_sLyricsFile );
+	WriteString( out, song.m_sCDTitleFile );
+	WriteString( out, song.m_sMusicFile );
+	WriteString( out, song.m_PreviewFile );
+	FOREACH_ENUM( InstrumentTrack, it )
+		WriteString( out, song.m_sInstrumentTrackFile[it] );
+
+	WriteFloat( out, song.m_fMusicSampleStartSeconds );
+	WriteFloat( out, song.m_fMusicSampleLengthSeconds );
+	WriteI32( out, song.m_SelectionDisplay );
+	WriteI32( out, song.m_DisplayBPMType );
+	WriteFloat( out, song.m_fSpecifiedBPMMin );
+	WriteFloat( out, song.m_fSpecifiedBPMMax );
+	WriteFloat( out, song.GetSpecifiedLastSecond() );
+
+	WriteTiming( out, song.m_SongTiming );
+
+	/* These are written after the "-nosongbg-" hack has been applied, so
+	 * they're loaded back as they are. */
+	FOREACH_BackgroundLayer( bl )
+		WriteBackgroundChanges( out, song.GetBackgroundChanges(bl) );
+	WriteBackgroundChanges( out, song.GetForegroundChanges() );
+
+	WriteStringVector( out, song.m_vsKeysoundFile );
+	WriteAttacks( out, song.m_Attacks, song.m_sAttackString );
+
+	// cache tags
+	WriteFloat( out, song.GetFirstSecond() );
+	WriteFloat( out, song.GetLastSecond() );
+	WriteString( out, song.m_sSongFileName );
+	WriteBool( out, song.m_bHasMusic );
+	WriteBool( out, song.m_bHasBanner );
+	WriteFloat( out, song.m_fMusicLengthSeconds );
+}
+
+static void WriteStepsBlock( RString &out, RString &sNoteBlock, const Song &song, const Steps &in, uint32_t &iNoteOffsetOut, uint32_t &iPackedHashOut )
+{
+	WriteString( out, in.GetChartName() );
+	WriteString( out, in.m_StepsTypeStr );
+	WriteString( out, in.GetDescription() );
+	WriteString( out, in.GetChartStyle() );
+	WriteI32( out, in.GetDifficulty() );
+	WriteI32( out, in.GetMeter() );
+	WriteString( out, in.GetMusicFile() );
+	WriteString( out, in.GetCredit() );
+
+	WriteU32( out, NUM_RadarCategory );
+	FOREACH_PlayerNumber( pn )
+	{
+		const RadarValues &rv = in.GetRadarValues( pn );
+		FOREACH_ENUM( RadarCategory, rc )
+			WriteFloat( out, rv[rc] );
+	}
+
+	// Same rules as the SSC cache: only write what differs from the song.
+	WriteBool( out, !in.m_Timing.empty() );
+	if( !in.m_Timing.empty() )
+		WriteTiming( out, in.m_Timing );
+
+	if( song.GetAttackString() != in.GetAttackString() )
+		WriteAttacks( out, in.m_Attacks, in.m_sAttackString );
+	else
+		WriteAttacks( out, AttackArray(), std::vector<RString>() );
+
+	WriteI32( out, in.GetDisplayBPM() );
+	WriteFloat( out, in.GetMinBPM() );
+	WriteFloat( out, in.GetMaxBPM() );
+
+	WriteString( out, in.GetFilename() );
+
+	RString sNoteData;
+	in.GetPackedNoteData( sNoteData );
+	iNoteOffsetOut = sNoteBlock.size();
+	iPackedHashOut = GetHashForString( sNoteData );
+	WriteU32( out, iNoteOffsetOut );
+	WriteU32( out, sNoteData.size() );
+	WriteU32( out, iPackedHashOut );
+	WriteU32( out, in.GetHash() );
+	sNoteBlock.append( sNoteData );
+}
+
+bool NotesWriterCache::Write( const RString &sPath, const Song &out, const std::vector<Steps*> &vpStepsToSave )
+{
+	RString sSongBlock;
+	RString sNoteBlock;
+	std::vector<uint32_t> viNoteOffset( vpStepsToSave.size() ), viPackedHash( vpStepsToSave.size() );
+	WriteSongBlock( sSongBlock, out );
+	WriteU32( sSongBlock, vpStepsToSave.size() );
+	for( std::size_t i = 0; i < vpStepsToSave.size(); ++i )
+		WriteStepsBlock( sSongBlock, sNoteBlock, out, *vpStepsToSave[i], viNoteOffset[i], viPackedHash[i] );
+
+	RString sHeader( NotesLoaderCache::CACHE_MAGIC, sizeof(NotesLoaderCache::CACHE_MAGIC) );
+	WriteU32( sHeader, NotesLoaderCache::CACHE_FORMAT_VERSION );
+	WriteI32( sHeader, FILE_CACHE_VERSION );
+	WriteU32( sHeader, sSongBlock.size() );
+	WriteU32( sHeader, sNoteBlock.size() );
+	ASSERT( sHeader.size() == NotesLoaderCache::CACHE_HEADER_SIZE );
+
+	RageFile f;
+	if( !f.Open(sPath, RageFile::WRITE) )
+	{
+		LOG->UserLog( "Cache file", sPath, "couldn't be opened for writing: %s", f.GetError().c_str() );
+		return false;
+	}
+
+	if( f.Write(sHeader) == -1 || f.Write(sSongBlock) == -1 || f.Write(sNoteBlock) == -1 || f.Flush() == -1 )
+	{
+		LOG->UserLog( "Cache file", sPath, "couldn't be written: %s", f.GetError().c_str() );
+		return false;
+	}
+
+	/* Anything read from the old file is at a different place now. */
+	const uint32_t iNoteBlockStart = sHeader.size() + sSongBlock.size();
+	for( std::size_t i = 0; i < vpStepsToSave.size(); ++i )
+	{
+		const uint32_t iEnd = i+1 < vpStepsToSave.size()? viNoteOffset[i+1]:sNoteBlock.size();
+		vpStepsToSave[i]->SetCacheNoteData( iNoteBlockStart + viNoteOffset[i], iEnd - viNoteOffset[i], viPackedHash[i], vpStepsToSave[i]->GetHash() );
+	}
+
+	return true;
+}
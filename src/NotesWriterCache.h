@@ -0,0 +1,17 @@
+/* NotesWriterCache - Writes a Song to a binary song cache file. */
+
+#ifndef NotesWriterCache_H
+#define NotesWriterCache_H
+
+#include <vector>
+
+class Song;
+class Steps;
+
+/* See NotesLoaderCache.h for the file layout. */
+namespace NotesWriterCache
+{
+	bool Write( const RString &sPath, const Song &out, const std::vector<Steps*> &vpStepsToSave );
+};
+
+#endif
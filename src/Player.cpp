@@ -17,6 +17,7 @@
 #include "PlayerAI.h"
 #include "NoteField.h"
 #include "NoteDataUtil.h"
+#include "NoteFieldCache.h"
 #include "ScreenMessage.h"
 #include "ScreenManager.h"
 #include "StageStats.h"
@@ -168,6 +169,7 @@ static Preference<float> m_fMaxInputLatencySeconds	( "MaxInputLatencySeconds",	0
 static Preference<bool> g_bEnableAttackSoundPlayback	( "EnableAttackSounds", true );
 static Preference<bool> g_bEnableMineSoundPlayback	( "EnableMineHitSound", true );
 static Preference<TapNoteScore> g_MinTNSToScoreNotes	( "MinTNSToScoreNotes", TNS_None, ValidateMinTNSToScoreNotes );  // Default to great and above.
+static Preference<bool> g_bLogJudgingTimes	( "LogJudgingTimes", false );
 
 /** @brief How much life is in a hold note when you start on it? */
 ThemeMetric<float> INITIAL_HOLD_LIFE		( "Player", "InitialHoldLife" );
@@ -268,9 +270,12 @@ Player::Player( NoteData &nd, bool bVisibleParts ) : m_NoteData(nd)
 	m_pPrimaryScoreKeeper = nullptr;
 	m_pSecondaryScoreKeeper = nullptr;
 	m_pInventory = nullptr;
-	m_pIterNeedsTapJudging = nullptr;
-	m_pIterNeedsHoldJudging = nullptr;
-	m_pIterUncrossedRows = nullptr;
+	m_iNeedsTapJudging = 0;
+	m_iUncrossed = 0;
+	m_iNeedsHoldJudging = 0;
+	m_iSyncChanges = 0;
+	m_fHoldJudgingSeconds = m_fCrossedRowsSeconds = m_fTapJudgingSeconds = 0;
+	m_iJudgingFramesTimed = 0;
 	m_pIterUnjudgedRows = nullptr;
 	m_pIterUnjudgedMineRows = nullptr;
 
@@ -304,9 +309,6 @@ Player::~Player()
 	for( unsigned i = 0; i < m_vpHoldJudgment.size(); ++i )
 		RageUtil::SafeDelete( m_vpHoldJudgment[i] );
 	RageUtil::SafeDelete( m_pJudgedRows );
-	RageUtil::SafeDelete( m_pIterNeedsTapJudging );
-	RageUtil::SafeDelete( m_pIterNeedsHoldJudging );
-	RageUtil::SafeDelete( m_pIterUncrossedRows );
 	RageUtil::SafeDelete( m_pIterUnjudgedRows );
 	RageUtil::SafeDelete( m_pIterUnjudgedMineRows );
 
@@ -616,42 +618,6 @@ static bool NeedsHoldJudging( const TapNote &tn )
 	}
 }
 
-static void GenerateCacheDataStructure(PlayerState *pPlayerState, const NoteData &notes) {
-
-	pPlayerState->m_CacheDisplayedBeat.clear();
-
-	const std::vector<TimingSegment*> vScrolls = pPlayerState->GetDisplayedTiming().GetTimingSegments( SEGMENT_SCROLL );
-
-	float displayedBeat = 0.0f;
-	float lastRealBeat = 0.0f;
-	float lastRatio = 1.0f;
-	for ( unsigned i = 0; i < vScrolls.size(); i++ )
-	{
-		ScrollSegment *seg = ToScroll( vScrolls[i] );
-		displayedBeat += ( seg->GetBeat() - lastRealBeat ) * lastRatio;
-		lastRealBeat = seg->GetBeat();
-		lastRatio = seg->GetRatio();
-		CacheDisplayedBeat c = { seg->GetBeat(), displayedBeat, seg->GetRatio() };
-		pPlayerState->m_CacheDisplayedBeat.push_back( c );
-	}
-
-	pPlayerState->m_CacheNoteStat.clear();
-
-	NoteData::all_tracks_const_iterator it = notes.GetTapNoteRangeAllTracks( 0, MAX_NOTE_ROW, true );
-	int count = 0, lastCount = 0;
-	for( ; !it.IsAtEnd(); ++it )
-	{
-		for( int t = 0; t < notes.GetNumTracks(); t++ )
-		{
-			if( notes.GetTapNote( t, it.Row() ) != TAP_EMPTY ) count ++;
-		}
-		CacheNoteStat c = { NoteRowToBeat(it.Row()), lastCount, count  };
-		lastCount = count;
-		pPlayerState->m_CacheNoteStat.push_back(c);
-	}
-
-}
-
 void Player::Load()
 {
 	m_bLoaded = true;
@@ -696,8 +662,7 @@ void Player::Load()
 
 	const Song* pSong = GAMESTATE->m_pCurSong;
 
-	// Generate some cache data structure.
-	GenerateCacheDataStructure(m_pPlayerState, m_NoteData);
+	m_pPlayerState->m_pNoteFieldCache = NoteFieldCache::Get( m_pPlayerState->GetDisplayedTiming(), m_NoteData );
 
 	switch( GAMESTATE->m_PlayMode )
 	{
@@ -737,6 +702,9 @@ void Player::Load()
 		default: break;
 	}
 
+	m_JudgmentIndex.Load( m_NoteData, *m_Timing );
+	m_iSyncChanges = AdjustSync::s_iSyncChanges;
+
 	int iDrawDistanceAfterTargetsPixels = GAMESTATE->IsEditing() ? -100 : DRAW_DISTANCE_AFTER_TARGET_PIXELS;
 	int iDrawDistanceBeforeTargetsPixels = GAMESTATE->IsEditing() ? 400 : DRAW_DISTANCE_BEFORE_TARGET_PIXELS;
 
@@ -788,14 +756,9 @@ void Player::Load()
 	if( m_pPlayerStageStats )
 		SendComboMessages( m_pPlayerStageStats->m_iCurCombo, m_pPlayerStageStats->m_iCurMissCombo );
 
-	RageUtil::SafeDelete( m_pIterNeedsTapJudging );
-	m_pIterNeedsTapJudging = new NoteData::all_tracks_iterator( m_NoteData.GetTapNoteRangeAllTracks(iNoteRow, MAX_NOTE_ROW) );
-
-	RageUtil::SafeDelete( m_pIterNeedsHoldJudging );
-	m_pIterNeedsHoldJudging = new NoteData::all_tracks_iterator( m_NoteData.GetTapNoteRangeAllTracks(iNoteRow, MAX_NOTE_ROW ) );
-
-	RageUtil::SafeDelete( m_pIterUncrossedRows );
-	m_pIterUncrossedRows = new NoteData::all_tracks_iterator( m_NoteData.GetTapNoteRangeAllTracks(iNoteRow, MAX_NOTE_ROW ) );
+	m_iNeedsTapJudging = m_JudgmentIndex.FindInTimeline( iNoteRow );
+	m_iUncrossed = m_JudgmentIndex.FindInTimeline( iNoteRow );
+	m_iNeedsHoldJudging = m_JudgmentIndex.FindInHoldHeads( iNoteRow );
 
 	RageUtil::SafeDelete( m_pIterUnjudgedRows );
 	m_pIterUnjudgedRows = new NoteData::all_tracks_iterator( m_NoteData.GetTapNoteRangeAllTracks(iNoteRow, MAX_NOTE_ROW ) );
@@ -858,6 +821,9 @@ void Player::Update( float fDeltaTime )
 	const float fSongBeat = m_pPlayerState->m_Position.m_fSongBeat;
 	const int iSongRow = BeatToNoteRow( fSongBeat );
 
+	// The passes below compare the timeline's note times to m_Position.
+	ReloadJudgmentIndexIfSyncChanged();
+
 	ArrowEffects::SetCurrentOptions(&m_pPlayerState->m_PlayerOptions.GetCurrent());
 
 	// Optimization: Don't spend time processing the things below that won't show
@@ -909,8 +875,10 @@ void Player::Update( float fDeltaTime )
 				float fHoldJudgeYPos = SCALE( fPercentReverse, 0.f, 1.f, HOLD_JUDGMENT_Y_STANDARD, HOLD_JUDGMENT_Y_REVERSE );
 				//float fGrayYPos = SCALE( fPercentReverse, 0.f, 1.f, GRAY_ARROWS_Y_STANDARD, GRAY_ARROWS_Y_REVERSE );
 
-				float fX = ArrowEffects::GetXPos( m_pPlayerState, c, 0 );
-				const float fZ = ArrowEffects::GetZPos( m_pPlayerState, c, 0);
+				ArrowEffects::FrameContext context;
+				context.Load( m_pPlayerState, c, 0 );
+				float fX = ArrowEffects::GetXPos( context, 0 );
+				const float fZ = ArrowEffects::GetZPos( context, 0 );
 				fX *= ( 1 - fMiniPercent * 0.5f );
 
 				m_vpHoldJudgment[c]->SetX( fX );
@@ -1020,6 +988,7 @@ void Player::Update( float fDeltaTime )
 	// be a miss or a hit, so we have to track for all notes whether they
 	// were held at some point before getting judged.
 	{
+		RageTimer timer;
 		float largestWindow = 0.0f;
 		const auto &disabledWindows = m_pPlayerState->m_PlayerOptions.GetCurrent().m_twDisabledWindows;
 		if (!disabledWindows[TW_W1])
@@ -1046,22 +1015,27 @@ void Player::Update( float fDeltaTime )
 		// keep track for which tracks we have already seen an unjudged
 		// note.
 		std::vector<bool> seenTracks(m_NoteData.GetNumTracks(), false);
+		int numSeenTracks = 0;
 
-		for(auto iter = *m_pIterNeedsTapJudging; !iter.IsAtEnd() && iter.Row() <= lastCheckRow; ++iter)
+		const std::vector<JudgmentIndex::TimelineNote> &timeline = m_JudgmentIndex.GetTimeline();
+		for(unsigned i = m_iNeedsTapJudging; i < timeline.size() && timeline[i].iRow <= lastCheckRow; ++i)
 		{
-			TapNote &tn = *iter;
-			const int row = iter.Row();
-			const int track = iter.Track();
+			// Nothing past here can change anything.
+			if (numSeenTracks == m_NoteData.GetNumTracks())
+				break;
+
+			TapNote &tn = *timeline[i].pTapNote;
+			const int track = timeline[i].iTrack;
 
 			// Skip over warp and fake segments
-			if (!m_Timing->IsJudgableAtRow(row))
+			if (!timeline[i].bJudgable)
 				continue;
 
 			// Held misses only apply to tap notes
 			if (tn.type != TapNoteType_Tap && tn.type != TapNoteType_HoldHead)
 				continue;
 
-			const float notePosition = m_Timing->GetElapsedTimeFromBeat(NoteRowToBeat(row));
+			const float notePosition = timeline[i].fSeconds;
 			const float offset = std::abs((notePosition - musicPosition) / rate);
 
 			// Skip if we are outside of the largest timing window
@@ -1073,6 +1047,7 @@ void Player::Update( float fDeltaTime )
 			    continue;
 
 			seenTracks[track] = true;
+			++numSeenTracks;
 
 			if (!tn.result.bHeld)
 			{
@@ -1083,29 +1058,33 @@ void Player::Update( float fDeltaTime )
 				tn.result.bHeld = INPUTMAPPER->IsBeingPressed(input, m_pPlayerState->m_mp);
 			}
 		}
+		m_fTapJudgingSeconds += timer.GetDeltaTime();
 	}
 
 	// update HoldNotes logic
 	{
+		RageTimer timer;
+		const std::vector<JudgmentIndex::TimelineNote> &vTimeline = m_JudgmentIndex.GetTimeline();
+		const std::vector<unsigned> &vHoldHeads = m_JudgmentIndex.GetHoldHeads();
 
 		// Fast forward to the first that needs hold judging.
+		while( m_iNeedsHoldJudging < vHoldHeads.size() )
 		{
-			NoteData::all_tracks_iterator &iter = *m_pIterNeedsHoldJudging;
-			while( !iter.IsAtEnd()  &&  iter.Row() <= iSongRow  &&  !NeedsHoldJudging(*iter) )
-				++iter;
+			const JudgmentIndex::TimelineNote &tl = vTimeline[vHoldHeads[m_iNeedsHoldJudging]];
+			if( tl.iRow > iSongRow  ||  NeedsHoldJudging(*tl.pTapNote) )
+				break;
+			++m_iNeedsHoldJudging;
 		}
 
 		std::vector<TrackRowTapNote> vHoldNotesToGradeTogether;
 		int iRowOfLastHoldNote = -1;
-		NoteData::all_tracks_iterator iter = *m_pIterNeedsHoldJudging;	// copy
-		for( ; !iter.IsAtEnd() &&  iter.Row() <= iSongRow; ++iter )
+		for( unsigned i = m_iNeedsHoldJudging; i < vHoldHeads.size() && vTimeline[vHoldHeads[i]].iRow <= iSongRow; ++i )
 		{
-			TapNote &tn = *iter;
-			if( tn.type != TapNoteType_HoldHead )
-				continue;
+			const JudgmentIndex::TimelineNote &tl = vTimeline[vHoldHeads[i]];
+			TapNote &tn = *tl.pTapNote;
 
-			int iTrack = iter.Track();
-			int iRow = iter.Row();
+			int iTrack = tl.iTrack;
+			int iRow = tl.iRow;
 			TrackRowTapNote trtn = { iTrack, iRow, &tn };
 
 			/* All holds must be of the same subType because fLife is handled
@@ -1148,9 +1127,11 @@ void Player::Update( float fDeltaTime )
 			UpdateHoldNotes( iSongRow, fDeltaTime, vHoldNotesToGradeTogether );
 			vHoldNotesToGradeTogether.clear();
  		}
+		m_fHoldJudgingSeconds += timer.GetDeltaTime();
 	}
 
 	{
+		RageTimer timer;
 		// Why was this originally "BeatToNoteRowNotRounded"? It should be rounded. -Chris
 		/* We want to send the crossed row message exactly when we cross the row--not
 		 * .5 before the row. Use a very slow song (around 2 BPM) as a test case: without
@@ -1182,6 +1163,7 @@ void Player::Update( float fDeltaTime )
 				}
 			}
 		}
+		m_fCrossedRowsSeconds += timer.GetDeltaTime();
 	}
 
 	// Check for completely judged rows.
@@ -1190,12 +1172,33 @@ void Player::Update( float fDeltaTime )
 	// Check for TapNote misses
 	if (!GAMESTATE->m_bInStepEditor)
 	{
+		RageTimer timer;
 		UpdateTapNotesMissedOlderThan( GetMaxStepDistanceSeconds() );
+		m_fTapJudgingSeconds += timer.GetDeltaTime();
 	}
+
+	++m_iJudgingFramesTimed;
+	if( m_LastJudgingTimesLog.PeekDeltaTime() >= 1.0f )
+		LogJudgingTimes();
+
 	// process transforms that are waiting to be applied
 	ApplyWaitingTransforms();
 }
 
+void Player::LogJudgingTimes()
+{
+	if( g_bLogJudgingTimes )
+	{
+		const float fScale = 1000000.0f / m_iJudgingFramesTimed;
+		LOG->Trace( "Player %i judging, us/frame over %i frames: holds %.1f, crossed rows %.1f, taps %.1f",
+			m_pPlayerState->m_PlayerNumber+1, m_iJudgingFramesTimed,
+			m_fHoldJudgingSeconds * fScale, m_fCrossedRowsSeconds * fScale, m_fTapJudgingSeconds * fScale );
+	}
+	m_fHoldJudgingSeconds = m_fCrossedRowsSeconds = m_fTapJudgingSeconds = 0;
+	m_iJudgingFramesTimed = 0;
+	m_LastJudgingTimesLog.Touch();
+}
+
 // Update a group of holds with shared scoring/life. All of these holds will have the same start row.
 void Player::UpdateHoldNotes( int iSongRow, float fDeltaTime, std::vector<TrackRowTapNote> &vTN )
 {
@@ -1613,9 +1616,44 @@ void Player::ApplyWaitingTransforms()
 
 		NoteDataUtil::TransformNoteData(m_NoteData, *m_Timing, po, GAMESTATE->GetCurrentStyle(GetPlayerState()->m_PlayerNumber)->m_StepsType, BeatToNoteRow(fStartBeat), BeatToNoteRow(fEndBeat));
 	}
+	if( !m_pPlayerState->m_ModsToApply.empty() )
+		ReloadJudgmentIndex();
 	m_pPlayerState->m_ModsToApply.clear();
 }
 
+/* The transforms may have added and removed notes.  Leave each position
+ * in the index at the same row and track it was at before. */
+void Player::ReloadJudgmentIndex()
+{
+	const std::vector<JudgmentIndex::TimelineNote> &vTimeline = m_JudgmentIndex.GetTimeline();
+	const std::vector<unsigned> &vHoldHeads = m_JudgmentIndex.GetHoldHeads();
+	auto RowAndTrack = [&vTimeline]( unsigned i ) {
+		if( i < vTimeline.size() )
+			return std::make_pair( vTimeline[i].iRow, vTimeline[i].iTrack );
+		if( vTimeline.empty() )
+			return std::make_pair( 0, 0 );
+		return std::make_pair( vTimeline.back().iRow, vTimeline.back().iTrack+1 );
+	};
+	const std::pair<int,int> needsTapJudging = RowAndTrack( m_iNeedsTapJudging );
+	const std::pair<int,int> uncrossed = RowAndTrack( m_iUncrossed );
+	const std::pair<int,int> needsHoldJudging = RowAndTrack( m_iNeedsHoldJudging < vHoldHeads.size()? vHoldHeads[m_iNeedsHoldJudging]:vTimeline.size() );
+
+	m_JudgmentIndex.Load( m_NoteData, *m_Timing );
+	m_iSyncChanges = AdjustSync::s_iSyncChanges;
+
+	m_iNeedsTapJudging = m_JudgmentIndex.FindInTimeline( needsTapJudging.first, needsTapJudging.second );
+	m_iUncrossed = m_JudgmentIndex.FindInTimeline( uncrossed.first, uncrossed.second );
+	m_iNeedsHoldJudging = m_JudgmentIndex.FindInHoldHeads( needsHoldJudging.first, needsHoldJudging.second );
+}
+
+/* The index has the notes' times worked out with the offsets and tempo as
+ * they were; the sync overlay and autosync can change them mid-song. */
+void Player::ReloadJudgmentIndexIfSyncChanged()
+{
+	if( m_bLoaded && m_iSyncChanges != AdjustSync::s_iSyncChanges )
+		ReloadJudgmentIndex();
+}
+
 void Player::DrawPrimitives()
 {
 	// TODO: Remove use of PlayerNumber.
@@ -1859,57 +1897,13 @@ void Player::ChangeLifeRecord()
 
 int Player::GetClosestNoteDirectional( int col, int iStartRow, int iEndRow, bool bAllowGraded, bool bForward ) const
 {
-	NoteData::const_iterator begin, end;
-	m_NoteData.GetTapNoteRange( col, iStartRow, iEndRow, begin, end );
-
-	if( !bForward )
-		swap( begin, end );
-
-	while( begin != end )
-	{
-		if( !bForward )
-			--begin;
-
-		// Is this the row we want?
-		do {
-			const TapNote &tn = begin->second;
-			if (!m_Timing->IsJudgableAtRow( begin->first ))
-				break;
-			// unsure if autoKeysounds should be excluded. -Wolfman2000
-			if( tn.type == TapNoteType_Empty || tn.type == TapNoteType_AutoKeysound )
-				break;
-			if( !bAllowGraded && tn.result.tns != TNS_None )
-				break;
-
-			return begin->first;
-		} while(0);
-
-		if( bForward )
-			++begin;
-	}
-
-	return -1;
+	return m_JudgmentIndex.GetClosestNoteDirectional( col, iStartRow, iEndRow, bAllowGraded, bForward );
 }
 
 // Find the closest note to fBeat.
 int Player::GetClosestNote( int col, int iNoteRow, int iMaxRowsAhead, int iMaxRowsBehind, bool bAllowGraded ) const
 {
-	// Start at iIndexStartLookingAt and search outward.
-	int iNextIndex = GetClosestNoteDirectional( col, iNoteRow, iNoteRow+iMaxRowsAhead, bAllowGraded, true );
-	int iPrevIndex = GetClosestNoteDirectional( col, iNoteRow-iMaxRowsBehind, iNoteRow, bAllowGraded, false );
-
-	if( iNextIndex == -1 && iPrevIndex == -1 )
-		return -1;
-	if( iNextIndex == -1 )
-		return iPrevIndex;
-	if( iPrevIndex == -1 )
-		return iNextIndex;
-
-	/* Figure out which row is closer. */
-	if( std::abs(iNoteRow-iNextIndex) > std::abs(iNoteRow-iPrevIndex) )
-		return iPrevIndex;
-	else
-		return iNextIndex;
+	return m_JudgmentIndex.GetClosestNote( col, iNoteRow, iMaxRowsAhead, iMaxRowsBehind, bAllowGraded );
 }
 
 int Player::GetClosestNonEmptyRowDirectional( int iStartRow, int iEndRow, bool /* bAllowGraded */, bool bForward ) const
@@ -2080,6 +2074,7 @@ void Player::Step( int col, int row, const RageTimer &tm, bool bHeld, bool bRele
 {
 	if( IsOniDead() )
 		return;
+	ReloadJudgmentIndexIfSyncChanged();
 
 	// Do everything that depends on a RageTimer here;
 	// set your breakpoints somewhere after this block.
@@ -2239,8 +2234,11 @@ void Player::Step( int col, int row, const RageTimer &tm, bool bHeld, bool bRele
 		// compute the score for this hit
 		float fNoteOffset = 0.0f;
 		// we need this later if we are autosyncing
-		const float fStepBeat = NoteRowToBeat( iRowOfOverlappingNoteOrRow );
-		const float fStepSeconds = m_Timing->GetElapsedTimeFromBeat(fStepBeat);
+		float fStepSeconds;
+		if( row == -1 )
+			fStepSeconds = m_JudgmentIndex.GetElapsedTimeOfNote( col, iRowOfOverlappingNoteOrRow );
+		else
+			fStepSeconds = m_Timing->GetElapsedTimeFromBeat( NoteRowToBeat(iRowOfOverlappingNoteOrRow) );
 
 		if( row == -1 )
 		{
@@ -2645,17 +2643,16 @@ void Player::UpdateTapNotesMissedOlderThan( float fMissIfOlderThanSeconds )
 		}
 	}
 
-	NoteData::all_tracks_iterator &iter = *m_pIterNeedsTapJudging;
-
-	for( ; !iter.IsAtEnd() && iter.Row() < iMissIfOlderThanThisRow; ++iter )
+	const std::vector<JudgmentIndex::TimelineNote> &vTimeline = m_JudgmentIndex.GetTimeline();
+	for( ; m_iNeedsTapJudging < vTimeline.size() && vTimeline[m_iNeedsTapJudging].iRow < iMissIfOlderThanThisRow; ++m_iNeedsTapJudging )
 	{
-		TapNote &tn = *iter;
+		TapNote &tn = *vTimeline[m_iNeedsTapJudging].pTapNote;
 
 		if( !NeedsTapJudging(tn) )
 			continue;
 
 		// Ignore all notes in WarpSegments or FakeSegments.
-		if (!m_Timing->IsJudgableAtRow(iter.Row()))
+		if (!vTimeline[m_iNeedsTapJudging].bJudgable)
 			continue;
 
 		if( tn.type == TapNoteType_Mine )
@@ -2861,14 +2858,15 @@ void Player::CrossedRows( int iLastRowCrossed, const RageTimer &now )
 {
 	//LOG->Trace( "Player::CrossedRows   %d    %d", iFirstRowCrossed, iLastRowCrossed );
 
-	NoteData::all_tracks_iterator &iter = *m_pIterUncrossedRows;
+	const std::vector<JudgmentIndex::TimelineNote> &vTimeline = m_JudgmentIndex.GetTimeline();
 	int iLastSeenRow = -1;
-	for( ; !iter.IsAtEnd()  &&  iter.Row() <= iLastRowCrossed; ++iter )
+	for( ; m_iUncrossed < vTimeline.size()  &&  vTimeline[m_iUncrossed].iRow <= iLastRowCrossed; ++m_iUncrossed )
 	{
 		// Apply InitialHoldLife.
-		TapNote &tn = *iter;
-		int iRow = iter.Row();
-		int iTrack = iter.Track();
+		TapNote &tn = *vTimeline[m_iUncrossed].pTapNote;
+		int iRow = vTimeline[m_iUncrossed].iRow;
+		int iTrack = vTimeline[m_iUncrossed].iTrack;
+		const bool bJudgable = vTimeline[m_iUncrossed].bJudgable;
 		switch( tn.type )
 		{
 			case TapNoteType_HoldHead:
@@ -2934,7 +2932,7 @@ void Player::CrossedRows( int iLastRowCrossed, const RageTimer &now )
 				tn.type != TapNoteType_Fake &&
 				tn.type != TapNoteType_AutoKeysound &&
 				tn.result.tns == TNS_None &&
-				this->m_Timing->IsJudgableAtRow(iRow) )
+				bJudgable )
 			{
 				Step( iTrack, iRow, now, false, false );
 				if( m_pPlayerState->m_PlayerController == PC_AUTOPLAY )
@@ -10,6 +10,8 @@
 #include "ScreenMessage.h"
 #include "ThemeMetric.h"
 #include "InputEventPlus.h"
+#include "JudgmentIndex.h"
+#include "RageTimer.h"
 #include "TimingData.h"
 
 #include <vector>
@@ -20,7 +22,6 @@ class LifeMeter;
 class CombinedLifeMeter;
 class ScoreKeeper;
 class Inventory;
-class RageTimer;
 class NoteField;
 class PlayerStageStats;
 class JudgedRows;
@@ -144,6 +145,9 @@ public:
 protected:
 	void UpdateTapNotesMissedOlderThan( float fMissIfOlderThanThisBeat );
 	void UpdateJudgedRows();
+	void ReloadJudgmentIndex();
+	void ReloadJudgmentIndexIfSyncChanged();
+	void LogJudgingTimes();
 	void FlashGhostRow( int iRow );
 	void HandleTapRowScore( unsigned row );
 	void HandleHoldScore( const TapNote &tn );
@@ -214,14 +218,28 @@ protected:
 	Inventory		*m_pInventory;
 
 	int			m_iFirstUncrossedRow;	// used by hold checkpoints logic
-	NoteData::all_tracks_iterator *m_pIterNeedsTapJudging;
-	NoteData::all_tracks_iterator *m_pIterNeedsHoldJudging;
-	NoteData::all_tracks_iterator *m_pIterUncrossedRows;
 	NoteData::all_tracks_iterator *m_pIterUnjudgedRows;
 	NoteData::all_tracks_iterator *m_pIterUnjudgedMineRows;
 	unsigned int	m_iLastSeenCombo;
 	bool	m_bSeenComboYet;
 	JudgedRows		*m_pJudgedRows;
+	// Rebuilt whenever m_NoteData gains or loses notes, or the sync changes.
+	JudgmentIndex		m_JudgmentIndex;
+	// AdjustSync::s_iSyncChanges as of the last rebuild.
+	int			m_iSyncChanges;
+	// Positions in m_JudgmentIndex.GetTimeline(), which only move forward.
+	unsigned		m_iNeedsTapJudging;
+	unsigned		m_iUncrossed;
+	// Position in m_JudgmentIndex.GetHoldHeads().
+	unsigned		m_iNeedsHoldJudging;
+
+	// Time spent on each judging pass in Update, logged every second or
+	// so when LogJudgingTimes is on.
+	float			m_fHoldJudgingSeconds;
+	float			m_fCrossedRowsSeconds;
+	float			m_fTapJudgingSeconds;
+	int			m_iJudgingFramesTimed;
+	RageTimer		m_LastJudgingTimesLog;
 
 	RageSound		m_soundMine;
 	RageSound		m_soundAttackLaunch;
@@ -11,22 +11,12 @@
 #include "RageTimer.h"
 #include "SampleHistory.h"
 
+#include <memory>
 #include <vector>
 
 
 struct lua_State;
-
-struct CacheDisplayedBeat {
-	float beat;
-	float displayedBeat;
-	float velocity;
-};
-
-struct CacheNoteStat {
-	float beat;
-	int notesLower;
-	int notesUpper;
-};
+class NoteFieldCache;
 
 /** @brief The player's indivdual state. */
 class PlayerState
@@ -68,19 +58,13 @@ public:
 	const TimingData   &GetDisplayedTiming()   const;
 
 	/**
-	 * @brief Holds a vector sorted by real beat, the beat that would be displayed
-	 *        in the NoteField (because they are affected by scroll segments), and
-	 *        also the velocity.
-	 *        This vector will be populated on Player::Load() be used a lot in
-	 *        ArrowEffects to determine the target beat in O(log N).
-	 */
-	std::vector<CacheDisplayedBeat> m_CacheDisplayedBeat;
-
-	/**
-	 * @brief Holds a vector sorted by beat, the cumulative number of notes from
-	 *        the start of the song. This will be used by [insert more description here]
+	 * @brief The displayed beats and note counts of the chart being played.
+	 *
+	 * This is set on Player::Load() and used a lot by ArrowEffects and the
+	 * NoteField to find the displayed beat and how far back to draw in
+	 * O(log N).  Players on the same chart share one.  May be null.
 	 */
-	std::vector<CacheNoteStat> m_CacheNoteStat;
+	std::shared_ptr<const NoteFieldCache> m_pNoteFieldCache;
 
 	/**
 	 * @brief Change the PlayerOptions to their default.
@@ -188,6 +188,9 @@ PrefsManager::PrefsManager() :
 	m_ImageCache			( "ImageCache",			IMGCACHE_LOW_RES_PRELOAD ),
 	m_bFastLoad			( "FastLoad",			true ),
 	m_NeverCacheList		( "NeverCacheList", ""),
+	m_iSongLoadThreads		( "SongLoadThreads",		1 ),
+	m_bWatchSongFolders		( "WatchSongFolders",		false ),
+	m_iChartMemoryBudgetMB		( "ChartMemoryBudgetMB",	32 ),
 
 	m_bOnlyDedicatedMenuButtons	( "OnlyDedicatedMenuButtons",	false ),
 	m_bMenuTimer			( "MenuTimer",			false ),
@@ -187,6 +187,15 @@ public:
 	Preference<ImageCacheMode>		m_ImageCache;
 	Preference<bool>	m_bFastLoad;
 	Preference<RString> m_NeverCacheList;
+	// Number of threads used to load song folders. 1 loads them one at a
+	// time on the main thread; 0 uses one thread per CPU core.
+	Preference<int>	m_iSongLoadThreads;
+	// Load song folders copied into Songs while the game is running, without
+	// a reload.  Only supported on Linux.
+	Preference<bool>	m_bWatchSongFolders;
+	// Decompressed charts beyond this many megabytes are compressed again,
+	// least recently used first.  0 keeps everything.
+	Preference<int>	m_iChartMemoryBudgetMB;
 
 	Preference<bool>	m_bOnlyDedicatedMenuButtons;
 	Preference<bool>	m_bMenuTimer;
@@ -18,21 +18,30 @@
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <vector>
 
 
 // Statistics stuff
 RageTimer	g_LastCheckTimer;
 int		g_iNumVerts;
-int		g_iFPS, g_iVPF, g_iCFPS;
+int		g_iFPS, g_iVPF, g_iCFPS, g_iQPF, g_iBPF, g_iUPF, g_iTPF;
 
 int RageDisplay::GetFPS() const { return g_iFPS; }
 int RageDisplay::GetVPF() const { return g_iVPF; }
 int RageDisplay::GetCumFPS() const { return g_iCFPS; }
+int RageDisplay::GetQPF() const { return g_iQPF; }
+int RageDisplay::GetBPF() const { return g_iBPF; }
+int RageDisplay::GetUPF() const { return g_iUPF; }
+int RageDisplay::GetTPF() const { return g_iTPF; }
 
 static int g_iFramesRenderedSinceLastCheck,
 	   g_iFramesRenderedSinceLastReset,
 	   g_iVertsRenderedSinceLastCheck,
+	   g_iQuadsSinceLastCheck,
+	   g_iQuadBatchesSinceLastCheck,
+	   g_iUploadBytesSinceLastCheck,
+	   g_iTextureBindsSinceLastCheck,
 	   g_iNumChecksSinceLastReset;
 static RageTimer g_LastFrameEndedAt( RageZeroTimer );
 
@@ -143,7 +152,13 @@ void RageDisplay::ProcessStatsOnFlip()
 		g_iCFPS = g_iFramesRenderedSinceLastReset / g_iNumChecksSinceLastReset;
 		g_iCFPS = std::lrint( g_iCFPS / fActualTime );
 		g_iVPF = g_iVertsRenderedSinceLastCheck / g_iFramesRenderedSinceLastCheck;
+		g_iQPF = g_iQuadsSinceLastCheck / g_iFramesRenderedSinceLastCheck;
+		g_iBPF = g_iQuadBatchesSinceLastCheck / g_iFramesRenderedSinceLastCheck;
+		g_iUPF = g_iUploadBytesSinceLastCheck / g_iFramesRenderedSinceLastCheck;
+		g_iTPF = g_iTextureBindsSinceLastCheck / g_iFramesRenderedSinceLastCheck;
 		g_iFramesRenderedSinceLastCheck = g_iVertsRenderedSinceLastCheck = 0;
+		g_iQuadsSinceLastCheck = g_iQuadBatchesSinceLastCheck = g_iUploadBytesSinceLastCheck = 0;
+		g_iTextureBindsSinceLastCheck = 0;
 		if( LOG_FPS )
 		{
 			RString sStats = GetStats();
@@ -155,10 +170,12 @@ void RageDisplay::ProcessStatsOnFlip()
 
 void RageDisplay::ResetStats()
 {
-	g_iFPS = g_iVPF = 0;
+	g_iFPS = g_iVPF = g_iQPF = g_iBPF = g_iUPF = g_iTPF = 0;
 	g_iFramesRenderedSinceLastCheck = g_iFramesRenderedSinceLastReset = 0;
 	g_iNumChecksSinceLastReset = 0;
 	g_iVertsRenderedSinceLastCheck = 0;
+	g_iQuadsSinceLastCheck = g_iQuadBatchesSinceLastCheck = g_iUploadBytesSinceLastCheck = 0;
+	g_iTextureBindsSinceLastCheck = 0;
 	g_LastCheckTimer.GetDeltaTime();
 }
 
@@ -170,6 +187,11 @@ RString RageDisplay::GetStats() const
 		s = "-- FPS\n-- av FPS\n-- VPF";
 
 	s = ssprintf( "%i FPS\n%i av FPS\n%i VPF", GetFPS(), GetCumFPS(), GetVPF() );
+	s += ssprintf( "\n%i QPF in %i batches", GetQPF(), GetBPF() );
+	if( GetUPF() )
+		s += ssprintf( "\n%i KB vertex upload per frame", GetUPF() / 1024 );
+	if( GetTPF() )
+		s += ssprintf( "\n%i texture binds per frame", GetTPF() );
 
 //	#if defined(_WIN32)
 	s += "\n"+this->GetApiDescription();
@@ -180,6 +202,7 @@ RString RageDisplay::GetStats() const
 
 bool RageDisplay::BeginFrame()
 {
+	InvalidateQuadBatchState();
 	this->SetDefaultRenderStates();
 
 	return true;
@@ -187,15 +210,18 @@ bool RageDisplay::BeginFrame()
 
 void RageDisplay::EndFrame()
 {
+	FlushQuadBatch();
 	ProcessStatsOnFlip();
 }
 
 void RageDisplay::BeginConcurrentRendering()
 {
+	InvalidateQuadBatchState();
 	this->SetDefaultRenderStates();
 }
 
 void RageDisplay::StatsAddVerts( int iNumVertsRendered ) { g_iVertsRenderedSinceLastCheck += iNumVertsRendered; }
+void RageDisplay::StatsAddUploadBytes( int iBytes ) { g_iUploadBytesSinceLastCheck += iBytes; }
 
 /* Draw a line as a quad.  GL_LINES with SmoothLines off can draw line
  * ends at odd angles--they're forced to axis-alignment regardless of the
@@ -446,6 +472,7 @@ RageDisplay::RageDisplay()
 	g_ViewStack = MatrixStack();
 	g_WorldStack = MatrixStack();
 	g_TextureStack = MatrixStack();
+	InvalidateQuadBatchState();
 
 	// Register with Lua.
 	{
@@ -569,6 +596,11 @@ void RageDisplay::TextureTranslate( float x, float y )
 	g_TextureStack.TranslateLocal(x, y, 0);
 }
 
+void RageDisplay::TextureLoadIdentity()
+{
+	g_TextureStack.LoadIdentity();
+}
+
 
 void RageDisplay::LoadMenuPerspective( float fovDegrees, float fWidth, float fHeight, float fVanishPointX, float fVanishPointY )
 {
@@ -835,6 +867,129 @@ bool RageDisplay::SaveScreenshot( RString sPath, GraphicsFileFormat format )
 	return true;
 }
 
+void RageDisplay::SetSingleTexture( uintptr_t iTexture )
+{
+	// The first unit goes last, leaving it the active one as ClearAllTextures does.
+	for( int tu = NUM_TextureUnit-1; tu > TextureUnit_1; --tu )
+		SetTexture( (TextureUnit) tu, 0 );
+	SetTexture( TextureUnit_1, iTexture );
+}
+
+/* The matrices a quad batch was queued under, other than the world matrix,
+ * which is applied to the vertices as they're queued. */
+struct QuadBatchCamera
+{
+	RageMatrix m_Centering, m_Projection, m_View, m_Texture;
+	bool operator==( const QuadBatchCamera &other ) const { return memcmp( this, &other, sizeof(*this) ) == 0; }
+};
+
+static std::vector<RageSpriteVertex> g_vQuadBatch;
+static QuadBatchCamera g_QuadBatchCamera;
+
+/* The last value each state was set to, per texture unit for the texture
+ * states; unknown until set. */
+static const uintptr_t QUAD_BATCH_STATE_UNKNOWN = ~uintptr_t(0);
+static uintptr_t g_iQuadBatchState[NUM_QuadBatchState][NUM_TextureUnit];
+/* The last texture each unit had bound, so that clearing a unit and binding
+ * the same texture again doesn't count as a texture change. */
+static uintptr_t g_iLastBoundTexture[NUM_TextureUnit];
+
+static QuadBatchCamera GetQuadBatchCamera()
+{
+	QuadBatchCamera c;
+	c.m_Centering = g_CenteringMatrix;
+	c.m_Projection = *g_ProjectionStack.GetTop();
+	c.m_View = *g_ViewStack.GetTop();
+	c.m_Texture = *g_TextureStack.GetTop();
+	return c;
+}
+
+static void SetQuadBatchCamera( const QuadBatchCamera &c )
+{
+	g_CenteringMatrix = c.m_Centering;
+	g_ProjectionStack.SetTop( c.m_Projection );
+	g_ViewStack.SetTop( c.m_View );
+	g_TextureStack.SetTop( c.m_Texture );
+}
+
+/* Normals aren't transformed when quads are batched, so don't batch while
+ * anything reads them.  These are only ever turned on around model draws,
+ * so a state nobody has set since the last invalidate is off. */
+static bool QuadBatchStateIsOn( QuadBatchState state, TextureUnit tu = TextureUnit_1 )
+{
+	const uintptr_t iValue = g_iQuadBatchState[state][tu];
+	return iValue != 0 && iValue != QUAD_BATCH_STATE_UNKNOWN;
+}
+
+static bool QuadBatchStateUsesNormals()
+{
+	if( QuadBatchStateIsOn(QuadBatchState_Lighting) || QuadBatchStateIsOn(QuadBatchState_CelShaded) )
+		return true;
+	FOREACH_ENUM( TextureUnit, tu )
+		if( QuadBatchStateIsOn(QuadBatchState_SphereEnvironmentMapping, tu) )
+			return true;
+	return false;
+}
+
+void RageDisplay::SetQuadBatchState( QuadBatchState state, uintptr_t iValue, TextureUnit tu )
+{
+	uintptr_t &iCurrent = g_iQuadBatchState[state][tu];
+	if( iCurrent == iValue )
+		return;
+	FlushQuadBatch();
+	iCurrent = iValue;
+
+	// Wrapping and filtering belong to the texture in OpenGL, not the unit.
+	if( state == QuadBatchState_Texture )
+	{
+		if( iValue != 0 && iValue != g_iLastBoundTexture[tu] )
+		{
+			++g_iTextureBindsSinceLastCheck;
+			g_iLastBoundTexture[tu] = iValue;
+		}
+		g_iQuadBatchState[QuadBatchState_TextureWrapping][tu] = QUAD_BATCH_STATE_UNKNOWN;
+		g_iQuadBatchState[QuadBatchState_TextureFiltering][tu] = QUAD_BATCH_STATE_UNKNOWN;
+	}
+}
+
+uintptr_t RageDisplay::QuadBatchValue( float f )
+{
+	uint32_t i;
+	memcpy( &i, &f, sizeof(i) );
+	return i;
+}
+
+void RageDisplay::InvalidateQuadBatchState()
+{
+	FlushQuadBatch();
+	FOREACH_ENUM( QuadBatchState, state )
+		FOREACH_ENUM( TextureUnit, tu )
+			g_iQuadBatchState[state][tu] = QUAD_BATCH_STATE_UNKNOWN;
+}
+
+void RageDisplay::FlushQuadBatch()
+{
+	if( g_vQuadBatch.empty() )
+		return;
+
+	// Take the vertices first, in case drawing them sets state.
+	static std::vector<RageSpriteVertex> vVerts;
+	vVerts.swap( g_vQuadBatch );
+
+	const QuadBatchCamera camera = GetQuadBatchCamera();
+	SetQuadBatchCamera( g_QuadBatchCamera );
+	g_WorldStack.Push();
+	g_WorldStack.LoadIdentity();
+
+	this->DrawQuadsInternal( &vVerts[0], vVerts.size() );
+	++g_iQuadBatchesSinceLastCheck;
+
+	g_WorldStack.Pop();
+	SetQuadBatchCamera( camera );
+	vVerts.clear();
+	vVerts.swap( g_vQuadBatch );
+}
+
 void RageDisplay::DrawQuads( const RageSpriteVertex v[], int iNumVerts )
 {
 	ASSERT( (iNumVerts%4) == 0 );
@@ -842,13 +997,42 @@ void RageDisplay::DrawQuads( const RageSpriteVertex v[], int iNumVerts )
 	if(!iNumVerts)
 		return;
 
-	this->DrawQuadsInternal(v,iNumVerts);
-
 	StatsAddVerts(iNumVerts);
+	g_iQuadsSinceLastCheck += iNumVerts/4;
+
+	// A projective world matrix can't be applied before the camera's.
+	const RageMatrix m = *g_WorldStack.GetTop();
+	const bool bAffine = m.m[0][3] == 0 && m.m[1][3] == 0 && m.m[2][3] == 0 && m.m[3][3] == 1;
+	if( !SupportsQuadBatching() || !bAffine || QuadBatchStateUsesNormals() )
+	{
+		FlushQuadBatch();
+		this->DrawQuadsInternal(v,iNumVerts);
+		++g_iQuadBatchesSinceLastCheck;
+		return;
+	}
+
+	const QuadBatchCamera camera = GetQuadBatchCamera();
+	if( !g_vQuadBatch.empty() && !(camera == g_QuadBatchCamera) )
+		FlushQuadBatch();
+	if( g_vQuadBatch.empty() )
+		g_QuadBatchCamera = camera;
+
+	const size_t iStart = g_vQuadBatch.size();
+	g_vQuadBatch.insert( g_vQuadBatch.end(), v, v+iNumVerts );
+	for( size_t i = iStart; i < g_vQuadBatch.size(); ++i )
+	{
+		RageVector3 &p = g_vQuadBatch[i].p;
+		p = RageVector3(
+			m.m[0][0]*p.x + m.m[1][0]*p.y + m.m[2][0]*p.z + m.m[3][0],
+			m.m[0][1]*p.x + m.m[1][1]*p.y + m.m[2][1]*p.z + m.m[3][1],
+			m.m[0][2]*p.x + m.m[1][2]*p.y + m.m[2][2]*p.z + m.m[3][2] );
+	}
 }
 
 void RageDisplay::DrawQuadStrip( const RageSpriteVertex v[], int iNumVerts )
 {
+	FlushQuadBatch();
+
 	ASSERT( (iNumVerts%2) == 0 );
 
 	if(iNumVerts < 4)
@@ -861,6 +1045,8 @@ void RageDisplay::DrawQuadStrip( const RageSpriteVertex v[], int iNumVerts )
 
 void RageDisplay::DrawFan( const RageSpriteVertex v[], int iNumVerts )
 {
+	FlushQuadBatch();
+
 	ASSERT( iNumVerts >= 3 );
 
 	this->DrawFanInternal(v,iNumVerts);
@@ -870,6 +1056,8 @@ void RageDisplay::DrawFan( const RageSpriteVertex v[], int iNumVerts )
 
 void RageDisplay::DrawStrip( const RageSpriteVertex v[], int iNumVerts )
 {
+	FlushQuadBatch();
+
 	ASSERT( iNumVerts >= 3 );
 
 	this->DrawStripInternal(v,iNumVerts);
@@ -879,6 +1067,8 @@ void RageDisplay::DrawStrip( const RageSpriteVertex v[], int iNumVerts )
 
 void RageDisplay::DrawTriangles( const RageSpriteVertex v[], int iNumVerts )
 {
+	FlushQuadBatch();
+
 	if( iNumVerts == 0 )
 		return;
 
@@ -891,6 +1081,8 @@ void RageDisplay::DrawTriangles( const RageSpriteVertex v[], int iNumVerts )
 
 void RageDisplay::DrawCompiledGeometry( const RageCompiledGeometry *p, int iMeshIndex, const std::vector<msMesh> &vMeshes )
 {
+	FlushQuadBatch();
+
 	this->DrawCompiledGeometryInternal( p, iMeshIndex );
 
 	StatsAddVerts( vMeshes[iMeshIndex].Triangles.size() );
@@ -898,6 +1090,8 @@ void RageDisplay::DrawCompiledGeometry( const RageCompiledGeometry *p, int iMesh
 
 void RageDisplay::DrawLineStrip( const RageSpriteVertex v[], int iNumVerts, float LineWidth )
 {
+	FlushQuadBatch();
+
 	ASSERT( iNumVerts >= 2 );
 
 	this->DrawLineStripInternal( v, iNumVerts, LineWidth );
@@ -917,6 +1111,8 @@ void RageDisplay::DrawLineStrip( const RageSpriteVertex v[], int iNumVerts, floa
 
 void RageDisplay::DrawSymmetricQuadStrip( const RageSpriteVertex v[], int iNumVerts )
 {
+	FlushQuadBatch();
+
 	ASSERT( iNumVerts >= 3 );
 
 	if( iNumVerts < 6 )
@@ -929,6 +1125,8 @@ void RageDisplay::DrawSymmetricQuadStrip( const RageSpriteVertex v[], int iNumVe
 
 void RageDisplay::DrawCircle( const RageSpriteVertex &v, float radius )
 {
+	FlushQuadBatch();
+
 	this->DrawCircleInternal( v, radius );
 }
 
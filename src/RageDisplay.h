@@ -26,6 +26,28 @@ enum TextureUnit
 	NUM_TextureUnit
 };
 
+// Render state a backend that batches quads reports to RageDisplay.
+enum QuadBatchState
+{
+	QuadBatchState_Texture,
+	QuadBatchState_TextureMode,
+	QuadBatchState_TextureWrapping,
+	QuadBatchState_TextureFiltering,
+	QuadBatchState_SphereEnvironmentMapping,
+	QuadBatchState_BlendMode,
+	QuadBatchState_EffectMode,
+	QuadBatchState_ZWrite,
+	QuadBatchState_ZTestMode,
+	QuadBatchState_ZBias,
+	QuadBatchState_CullMode,
+	QuadBatchState_AlphaTest,
+	QuadBatchState_Lighting,
+	QuadBatchState_CelShaded,
+	QuadBatchState_PolygonMode,
+	QuadBatchState_LineWidth,
+	NUM_QuadBatchState
+};
+
 // RageCompiledGeometry holds vertex data in a format that is most efficient
 // for the graphics API.
 class RageCompiledGeometry
@@ -276,6 +298,10 @@ public:
 	virtual void ClearAllTextures() = 0;
 	virtual int GetNumTextureUnits() = 0;
 	virtual void SetTexture( TextureUnit, uintptr_t /* iTexture */ ) = 0;
+	/* Bind iTexture to the first unit and clear the others.  Unlike
+	 * ClearAllTextures followed by SetTexture, the first unit isn't cleared
+	 * in between, so a quad batch on the same texture carries on. */
+	void SetSingleTexture( uintptr_t iTexture );
 	virtual void SetTextureMode( TextureUnit, TextureMode ) = 0;
 	virtual void SetTextureWrapping( TextureUnit, bool ) = 0;
 	virtual int GetMaxTextureSize() const = 0;
@@ -349,6 +375,10 @@ public:
 
 	void DrawQuad( const RageSpriteVertex v[] ) { DrawQuads(v,4); } /* alias. upper-left, upper-right, lower-left, lower-right */
 
+	/* Draw any quads DrawQuads is holding for a batch.  Anything that talks
+	 * to the graphics API directly has to call this first. */
+	void FlushQuadBatch();
+
 	// hacks for cell-shaded models
 	virtual void SetPolygonMode( PolygonMode ) {}
 	virtual void SetLineWidth( float ) {}
@@ -377,6 +407,17 @@ protected:
 	virtual void DrawSymmetricQuadStripInternal( const RageSpriteVertex v[], int iNumVerts ) = 0;
 	virtual void DrawCircleInternal( const RageSpriteVertex &v, float radius );
 
+	/* Quad batching.  If a backend returns true here, consecutive DrawQuads
+	 * calls under the same render state and camera are transformed by their
+	 * world matrix on the CPU and sent as one DrawQuadsInternal call.  The
+	 * backend has to report every render state it sets with SetQuadBatchState
+	 * (which draws the pending quads if the value changed), and call
+	 * InvalidateQuadBatchState before changing state any other way. */
+	virtual bool SupportsQuadBatching() const { return false; }
+	void SetQuadBatchState( QuadBatchState state, uintptr_t iValue, TextureUnit tu = TextureUnit_1 );
+	static uintptr_t QuadBatchValue( float f );
+	void InvalidateQuadBatchState();
+
 	// return RString() if mode change was successful, an error message otherwise.
 	// bNewDeviceOut is set true if a new device was created and textures
 	// need to be reloaded.
@@ -392,10 +433,15 @@ public:
 	int GetFPS() const;
 	int GetVPF() const;
 	int GetCumFPS() const; // average FPS since last reset
+	int GetQPF() const; // quads submitted per frame
+	int GetBPF() const; // draw calls those quads took per frame
+	int GetUPF() const; // vertex bytes sent to the driver per frame
+	int GetTPF() const; // texture changes per frame, on backends that batch quads
 	virtual void ResetStats();
 	virtual void ProcessStatsOnFlip();
 	virtual RString GetStats() const;
 	void StatsAddVerts( int iNumVertsRendered );
+	void StatsAddUploadBytes( int iBytes );
 
 	// World matrix stack functions.
 	void PushMatrix();
@@ -418,6 +464,8 @@ public:
 	void TexturePopMatrix();
 	void TextureTranslate( float x, float y );
 	void TextureTranslate( const RageVector2 &v ) { this->TextureTranslate( v.x, v.y ); }
+	void TextureLoadIdentity();
+	const RageMatrix* GetTextureTop() const;
 
 	// Projection and View matrix stack functions.
 	void CameraPushMatrix();
@@ -452,7 +500,6 @@ protected:
 	const RageMatrix* GetProjectionTop() const;
 	const RageMatrix* GetViewTop() const;
 	const RageMatrix* GetWorldTop() const;
-	const RageMatrix* GetTextureTop() const;
 
 	// To limit the framerate, call FrameLimitBeforeVsync before waiting
 	// for vsync and FrameLimitAfterVsync after.
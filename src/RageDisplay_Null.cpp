@@ -124,6 +124,7 @@ RageMatrix RageDisplay_Null::GetOrthoMatrix( float l, float r, float b, float t,
 
 void RageDisplay_Null::EndFrame()
 {
+	FlushQuadBatch();
 	ProcessStatsOnFlip();
 }
 
@@ -15,10 +15,10 @@ public:
 	virtual void GetDisplaySpecs(DisplaySpecs &out) const;
 	const RagePixelFormatDesc *GetPixelFormatDesc(RagePixelFormat pf) const;
 
-	bool BeginFrame() { return true; }
+	bool BeginFrame() { return RageDisplay::BeginFrame(); }
 	void EndFrame();
 	ActualVideoModeParams GetActualVideoModeParams() const { return m_Params; }
-	void SetBlendMode( BlendMode ) { }
+	void SetBlendMode( BlendMode mode ) { SetQuadBatchState( QuadBatchState_BlendMode, mode ); }
 	bool SupportsTextureFormat( RagePixelFormat, bool /* realtime */ =false ) { return true; }
 	bool SupportsPerVertexMatrixScale() { return false; }
 	uintptr_t CreateTexture(
@@ -31,21 +31,22 @@ public:
 		int /* xoffset */, int /* yoffset */, int /* width */, int /* height */
 		) { }
 	void DeleteTexture( uintptr_t /* iTexHandle */ ) { }
-	void ClearAllTextures() { }
+	void ClearAllTextures() { FOREACH_ENUM( TextureUnit, tu ) SetTexture( tu, 0 ); }
 	int GetNumTextureUnits() { return 1; }
-	void SetTexture( TextureUnit, uintptr_t /* iTexture */ ) { }
-	void SetTextureMode( TextureUnit, TextureMode ) { }
-	void SetTextureWrapping( TextureUnit, bool ) { }
+	void SetTexture( TextureUnit tu, uintptr_t iTexture ) { SetQuadBatchState( QuadBatchState_Texture, iTexture, tu ); }
+	void SetTextureMode( TextureUnit tu, TextureMode tm ) { SetQuadBatchState( QuadBatchState_TextureMode, tm, tu ); }
+	void SetTextureWrapping( TextureUnit tu, bool b ) { SetQuadBatchState( QuadBatchState_TextureWrapping, b, tu ); }
 	int GetMaxTextureSize() const { return 2048; }
-	void SetTextureFiltering( TextureUnit, bool ) { }
+	void SetTextureFiltering( TextureUnit tu, bool b ) { SetQuadBatchState( QuadBatchState_TextureFiltering, b, tu ); }
+	void SetEffectMode( EffectMode effect ) { SetQuadBatchState( QuadBatchState_EffectMode, effect ); }
 	bool IsZWriteEnabled() const { return false; }
 	bool IsZTestEnabled() const { return false; }
-	void SetZWrite( bool ) { }
-	void SetZBias( float ) { }
-	void SetZTestMode( ZTestMode ) { }
-	void ClearZBuffer() { }
-	void SetCullMode( CullMode ) { }
-	void SetAlphaTest( bool ) { }
+	void SetZWrite( bool b ) { SetQuadBatchState( QuadBatchState_ZWrite, b ); }
+	void SetZBias( float f ) { SetQuadBatchState( QuadBatchState_ZBias, QuadBatchValue(f) ); }
+	void SetZTestMode( ZTestMode mode ) { SetQuadBatchState( QuadBatchState_ZTestMode, mode ); }
+	void ClearZBuffer() { FlushQuadBatch(); }
+	void SetCullMode( CullMode mode ) { SetQuadBatchState( QuadBatchState_CullMode, mode ); }
+	void SetAlphaTest( bool b ) { SetQuadBatchState( QuadBatchState_AlphaTest, b ); }
 	void SetMaterial(
 		const RageColor & /* unreferenced: emissive */,
 		const RageColor & /* unreferenced: ambient */,
@@ -53,7 +54,7 @@ public:
 		const RageColor & /* unreferenced: specular */,
 		float /* unreferenced: shininess */
 		) { }
-	void SetLighting( bool ) { }
+	void SetLighting( bool b ) { SetQuadBatchState( QuadBatchState_Lighting, b ); }
 	void SetLightOff( int /* index */ ) { }
 	void SetLightDirectional(
 		int /* index */,
@@ -62,13 +63,17 @@ public:
 		const RageColor & /* unreferenced: specular */,
 		const RageVector3 & /* unreferenced: dir */ ) { }
 
-	void SetSphereEnvironmentMapping( TextureUnit /* tu */, bool /* b */ ) { }
-	void SetCelShaded( int /* stage */ ) { }
+	void SetSphereEnvironmentMapping( TextureUnit tu, bool b ) { SetQuadBatchState( QuadBatchState_SphereEnvironmentMapping, b, tu ); }
+	void SetCelShaded( int stage ) { SetQuadBatchState( QuadBatchState_CelShaded, stage ); }
+	void SetPolygonMode( PolygonMode pm ) { SetQuadBatchState( QuadBatchState_PolygonMode, pm ); }
+	void SetLineWidth( float fWidth ) { SetQuadBatchState( QuadBatchState_LineWidth, QuadBatchValue(fWidth) ); }
 
 	RageCompiledGeometry* CreateCompiledGeometry();
 	void DeleteCompiledGeometry( RageCompiledGeometry* );
 
 protected:
+	// Batch like the real renderers do, so draw counts here match theirs.
+	bool SupportsQuadBatching() const { return true; }
 	void DrawQuadsInternal( const RageSpriteVertex v[], int /* iNumVerts */ ) { }
 	void DrawQuadStripInternal( const RageSpriteVertex v[], int /* iNumVerts */ ) { }
 	void DrawFanInternal( const RageSpriteVertex v[], int /* iNumVerts */ ) { }
@@ -2,6 +2,7 @@
 
 #include "RageDisplay_OGL.h"
 #include "RageDisplay_OGL_Helpers.h"
+#include "RageDisplay_OGL_StreamingVertices.h"
 using namespace RageDisplay_Legacy_Helpers;
 
 #include "RageFile.h"
@@ -74,6 +75,7 @@ static LowLevelWindow *g_pWind;
 static bool g_bInvertY = false;
 
 static void InvalidateObjects();
+static void FreeStreamingVertices();
 
 static RageDisplay::RagePixelFormatDesc PIXEL_FORMAT_DESC[NUM_RagePixelFormat] = {
 	{
@@ -567,6 +569,7 @@ RString RageDisplay_Legacy::Init( const VideoModeParams &p, bool bAllowUnacceler
 
 RageDisplay_Legacy::~RageDisplay_Legacy()
 {
+	FreeStreamingVertices();
 	delete g_pWind;
 }
 
@@ -760,6 +763,8 @@ void RageDisplay_Legacy::ResolutionChanged()
 {
 	//LOG->Warn( "RageDisplay_Legacy::ResolutionChanged" );
 
+	InvalidateQuadBatchState();
+
 	/* Clear any junk that's in the framebuffer. */
 	if (BeginFrame())
 		EndFrame();
@@ -781,6 +786,8 @@ RString RageDisplay_Legacy::TryVideoMode( const VideoModeParams &p, bool &bNewDe
 {
 	//LOG->Warn( "RageDisplay_Legacy::TryVideoMode( %d, %d, %d, %d, %d, %d )", p.windowed, p.width, p.height, p.bpp, p.rate, p.vsync );
 
+	InvalidateQuadBatchState();
+
 	RString err;
 	err = g_pWind->TryVideoMode( p, bNewDeviceOut );
 	if (err != "")
@@ -855,6 +862,7 @@ bool RageDisplay_Legacy::BeginFrame()
 
 void RageDisplay_Legacy::EndFrame()
 {
+	InvalidateQuadBatchState();
 	if (UseOffscreenRenderTarget())
 	{
 		offscreenRenderTarget->FinishRenderingTo();
@@ -872,6 +880,7 @@ void RageDisplay_Legacy::EndFrame()
 		fullscreenSprite.Draw();
 		CameraPopMatrix();
 	}
+	FlushQuadBatch();
 
 	FrameLimitBeforeVsync( g_pWind->GetActualVideoModeParams().rate );
 	g_pWind->SwapBuffers();
@@ -895,6 +904,7 @@ void RageDisplay_Legacy::EndFrame()
 
 RageSurface* RageDisplay_Legacy::CreateScreenshot()
 {
+	InvalidateQuadBatchState();
 	int width = g_pWind->GetActualVideoModeParams().width;
 	int height = g_pWind->GetActualVideoModeParams().height;
 
@@ -929,6 +939,7 @@ RageSurface* RageDisplay_Legacy::CreateScreenshot()
 
 RageSurface *RageDisplay_Legacy::GetTexture( uintptr_t iTexture )
 {
+	InvalidateQuadBatchState();
 	if (iTexture == 0)
 		return nullptr; // XXX
 
@@ -956,60 +967,6 @@ ActualVideoModeParams RageDisplay_Legacy::GetActualVideoModeParams() const
 	return g_pWind->GetActualVideoModeParams();
 }
 
-static void SetupVertices( const RageSpriteVertex v[], int iNumVerts )
-{
-	static float *Vertex, *Texture, *Normal;
-	static GLubyte *Color;
-	static int Size = 0;
-	if (iNumVerts > Size)
-	{
-		Size = iNumVerts;
-		delete [] Vertex;
-		delete [] Color;
-		delete [] Texture;
-		delete [] Normal;
-		Vertex = new float[Size*3];
-		Color = new GLubyte[Size*4];
-		Texture = new float[Size*2];
-		Normal = new float[Size*3];
-	}
-
-	for( unsigned i = 0; i < unsigned(iNumVerts); ++i )
-	{
-		Vertex[i*3+0]  = v[i].p[0];
-		Vertex[i*3+1]  = v[i].p[1];
-		Vertex[i*3+2]  = v[i].p[2];
-		Color[i*4+0]   = v[i].c.r;
-		Color[i*4+1]   = v[i].c.g;
-		Color[i*4+2]   = v[i].c.b;
-		Color[i*4+3]   = v[i].c.a;
-		Texture[i*2+0] = v[i].t[0];
-		Texture[i*2+1] = v[i].t[1];
-		Normal[i*3+0] = v[i].n[0];
-		Normal[i*3+1] = v[i].n[1];
-		Normal[i*3+2] = v[i].n[2];
-	}
-	glEnableClientState( GL_VERTEX_ARRAY );
-	glVertexPointer( 3, GL_FLOAT, 0, Vertex );
-
-	glEnableClientState( GL_COLOR_ARRAY );
-	glColorPointer( 4, GL_UNSIGNED_BYTE, 0, Color );
-
-	glEnableClientState( GL_TEXTURE_COORD_ARRAY );
-	glTexCoordPointer( 2, GL_FLOAT, 0, Texture );
-
-	if (GLEW_ARB_multitexture)
-	{
-		glClientActiveTextureARB( GL_TEXTURE1_ARB );
-		glEnableClientState( GL_TEXTURE_COORD_ARRAY );
-		glTexCoordPointer( 2, GL_FLOAT, 0, Texture );
-		glClientActiveTextureARB( GL_TEXTURE0_ARB );
-	}
-
-	glEnableClientState( GL_NORMAL_ARRAY );
-	glNormalPointer( GL_FLOAT, 0, Normal );
-}
-
 void RageDisplay_Legacy::SendCurrentMatrices()
 {
 	RageMatrix projection;
@@ -1488,6 +1445,83 @@ void RageDisplay_Legacy::DeleteCompiledGeometry( RageCompiledGeometry* p )
 	delete p;
 }
 
+/* Hooks the streaming buffer up to InvalidateObjects. */
+class StreamingVertexObject: public InvalidateObject
+{
+public:
+	void Invalidate() { m_Buffer.Invalidate(); }
+	StreamingVertexBuffer m_Buffer;
+};
+static StreamingVertexObject g_StreamingVertices;
+
+static void FreeStreamingVertices()
+{
+	g_StreamingVertices.m_Buffer.Free();
+}
+
+static void SetupVertices( const RageSpriteVertex v[], int iNumVerts )
+{
+	DISPLAY->StatsAddUploadBytes( iNumVerts * sizeof(StreamingVertex) );
+
+	StreamingVertexBuffer &buf = g_StreamingVertices.m_Buffer;
+	const bool bMapFailed = buf.MapFailed();
+	if (buf.SetupVertices( v, iNumVerts ))
+		return;
+	if (buf.MapFailed() && !bMapFailed)
+		LOG->Warn( "Couldn't map a persistent vertex buffer; drawing from client memory" );
+
+	static float *Vertex, *Texture, *Normal;
+	static GLubyte *Color;
+	static int Size = 0;
+	if (iNumVerts > Size)
+	{
+		Size = iNumVerts;
+		delete [] Vertex;
+		delete [] Color;
+		delete [] Texture;
+		delete [] Normal;
+		Vertex = new float[Size*3];
+		Color = new GLubyte[Size*4];
+		Texture = new float[Size*2];
+		Normal = new float[Size*3];
+	}
+
+	for( unsigned i = 0; i < unsigned(iNumVerts); ++i )
+	{
+		Vertex[i*3+0]  = v[i].p[0];
+		Vertex[i*3+1]  = v[i].p[1];
+		Vertex[i*3+2]  = v[i].p[2];
+		Color[i*4+0]   = v[i].c.r;
+		Color[i*4+1]   = v[i].c.g;
+		Color[i*4+2]   = v[i].c.b;
+		Color[i*4+3]   = v[i].c.a;
+		Texture[i*2+0] = v[i].t[0];
+		Texture[i*2+1] = v[i].t[1];
+		Normal[i*3+0] = v[i].n[0];
+		Normal[i*3+1] = v[i].n[1];
+		Normal[i*3+2] = v[i].n[2];
+	}
+	glEnableClientState( GL_VERTEX_ARRAY );
+	glVertexPointer( 3, GL_FLOAT, 0, Vertex );
+
+	glEnableClientState( GL_COLOR_ARRAY );
+	glColorPointer( 4, GL_UNSIGNED_BYTE, 0, Color );
+
+	glEnableClientState( GL_TEXTURE_COORD_ARRAY );
+	glTexCoordPointer( 2, GL_FLOAT, 0, Texture );
+
+	if (GLEW_ARB_multitexture)
+	{
+		glClientActiveTextureARB( GL_TEXTURE1_ARB );
+		glEnableClientState( GL_TEXTURE_COORD_ARRAY );
+		glTexCoordPointer( 2, GL_FLOAT, 0, Texture );
+		glClientActiveTextureARB( GL_TEXTURE0_ARB );
+	}
+
+	glEnableClientState( GL_NORMAL_ARRAY );
+	glNormalPointer( GL_FLOAT, 0, Normal );
+}
+
 void RageDisplay_Legacy::DrawQuadsInternal( const RageSpriteVertex v[], int iNumVerts )
 {
 	TurnOffHardwareVBO();
@@ -1689,6 +1723,7 @@ int RageDisplay_Legacy::GetNumTextureUnits()
 
 void RageDisplay_Legacy::SetTexture( TextureUnit tu, uintptr_t iTexture )
 {
+	SetQuadBatchState( QuadBatchState_Texture, iTexture, tu );
 	if (!SetTextureUnit( tu ))
 		return;
 
@@ -1705,6 +1740,7 @@ void RageDisplay_Legacy::SetTexture( TextureUnit tu, uintptr_t iTexture )
 
 void RageDisplay_Legacy::SetTextureMode( TextureUnit tu, TextureMode tm )
 {
+	SetQuadBatchState( QuadBatchState_TextureMode, tm, tu );
 	if (!SetTextureUnit( tu ))
 		return;
 
@@ -1746,6 +1782,7 @@ void RageDisplay_Legacy::SetTextureMode( TextureUnit tu, TextureMode tm )
 
 void RageDisplay_Legacy::SetTextureFiltering( TextureUnit tu, bool b )
 {
+	SetQuadBatchState( QuadBatchState_TextureFiltering, b, tu );
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, b ? GL_LINEAR : GL_NEAREST);
 
 	GLint iMinFilter;
@@ -1778,6 +1815,7 @@ void RageDisplay_Legacy::SetTextureFiltering( TextureUnit tu, bool b )
 
 void RageDisplay_Legacy::SetEffectMode( EffectMode effect )
 {
+	SetQuadBatchState( QuadBatchState_EffectMode, effect );
 	if (!GLEW_ARB_fragment_program || !GLEW_ARB_shading_language_100 || !GLEW_ARB_shader_objects)
 		return;
 
@@ -1868,6 +1906,7 @@ bool RageDisplay_Legacy::IsEffectModeSupported( EffectMode effect )
 
 void RageDisplay_Legacy::SetBlendMode( BlendMode mode )
 {
+	SetQuadBatchState( QuadBatchState_BlendMode, mode );
 	glEnable(GL_BLEND);
 
 	if (glBlendEquation != nullptr)
@@ -1949,6 +1988,7 @@ bool RageDisplay_Legacy::IsZTestEnabled() const
 
 void RageDisplay_Legacy::ClearZBuffer()
 {
+	FlushQuadBatch();
 	bool write = IsZWriteEnabled();
 	SetZWrite( true );
 	glClear( GL_DEPTH_BUFFER_BIT );
@@ -1957,11 +1997,13 @@ void RageDisplay_Legacy::ClearZBuffer()
 
 void RageDisplay_Legacy::SetZWrite( bool b )
 {
+	SetQuadBatchState( QuadBatchState_ZWrite, b );
 	glDepthMask( b );
 }
 
 void RageDisplay_Legacy::SetZBias( float f )
 {
+	SetQuadBatchState( QuadBatchState_ZBias, QuadBatchValue(f) );
 	float fNear = SCALE( f, 0.0f, 1.0f, 0.05f, 0.0f );
 	float fFar = SCALE( f, 0.0f, 1.0f, 1.0f, 0.95f );
 
@@ -1970,6 +2012,7 @@ void RageDisplay_Legacy::SetZBias( float f )
 
 void RageDisplay_Legacy::SetZTestMode( ZTestMode mode )
 {
+	SetQuadBatchState( QuadBatchState_ZTestMode, mode );
 	glEnable( GL_DEPTH_TEST );
 	switch( mode )
 	{
@@ -1983,6 +2026,7 @@ void RageDisplay_Legacy::SetZTestMode( ZTestMode mode )
 
 void RageDisplay_Legacy::SetTextureWrapping( TextureUnit tu, bool b )
 {
+	SetQuadBatchState( QuadBatchState_TextureWrapping, b, tu );
 	/* This should be per-texture-unit state, but it's per-texture state in OpenGl,
 	 * so we'll behave incorrectly if the same texture is used in more than one texture
 	 * unit simultaneously with different wrapping. */
@@ -2001,6 +2045,7 @@ void RageDisplay_Legacy::SetMaterial(
 	float shininess
 	)
 {
+	FlushQuadBatch();
 	// TRICKY:  If lighting is off, then setting the material
 	// will have no effect.  Even if lighting is off, we still
 	// want Models to have basic color and transparency.
@@ -2029,6 +2074,7 @@ void RageDisplay_Legacy::SetMaterial(
 
 void RageDisplay_Legacy::SetLighting( bool b )
 {
+	SetQuadBatchState( QuadBatchState_Lighting, b );
 	if (b)
 		glEnable(GL_LIGHTING);
 	else
@@ -2037,6 +2083,7 @@ void RageDisplay_Legacy::SetLighting( bool b )
 
 void RageDisplay_Legacy::SetLightOff( int index )
 {
+	FlushQuadBatch();
 	glDisable( GL_LIGHT0+index );
 }
 
@@ -2047,6 +2094,7 @@ void RageDisplay_Legacy::SetLightDirectional(
 	const RageColor &specular,
 	const RageVector3 &dir )
 {
+	FlushQuadBatch();
 	// Light coordinates are transformed by the modelview matrix, but
 	// we are being passed in world-space coords.
 	glPushMatrix();
@@ -2064,6 +2112,7 @@ void RageDisplay_Legacy::SetLightDirectional(
 
 void RageDisplay_Legacy::SetCullMode( CullMode mode )
 {
+	SetQuadBatchState( QuadBatchState_CullMode, mode );
 	if (mode != CULL_NONE)
 		glEnable(GL_CULL_FACE);
 	switch( mode )
@@ -2095,27 +2144,34 @@ bool RageDisplay_Legacy::SupportsThreadedRendering()
 
 void RageDisplay_Legacy::BeginConcurrentRenderingMainThread()
 {
+	InvalidateQuadBatchState();
 	g_pWind->BeginConcurrentRenderingMainThread();
 }
 
 void RageDisplay_Legacy::EndConcurrentRenderingMainThread()
 {
+	InvalidateQuadBatchState();
 	g_pWind->EndConcurrentRenderingMainThread();
 }
 
 void RageDisplay_Legacy::BeginConcurrentRendering()
 {
+	InvalidateQuadBatchState();
+	g_StreamingVertices.m_Buffer.Restart();
 	g_pWind->BeginConcurrentRendering();
 	RageDisplay::BeginConcurrentRendering();
 }
 
 void RageDisplay_Legacy::EndConcurrentRendering()
 {
+	InvalidateQuadBatchState();
+	g_StreamingVertices.m_Buffer.Restart();
 	g_pWind->EndConcurrentRendering();
 }
 
 void RageDisplay_Legacy::DeleteTexture( uintptr_t iTexture )
 {
+	InvalidateQuadBatchState();
 	if (iTexture == 0)
 		return;
 
@@ -2204,6 +2260,7 @@ uintptr_t RageDisplay_Legacy::CreateTexture(
 	RageSurface* pImg,
 	bool bGenerateMipMaps )
 {
+	InvalidateQuadBatchState();
 	ASSERT( pixfmt < NUM_RagePixelFormat );
 
 
@@ -2414,6 +2471,7 @@ void RageDisplay_Legacy::UpdateTexture(
 	RageSurface* pImg,
 	int iXOffset, int iYOffset, int iWidth, int iHeight )
 {
+	InvalidateQuadBatchState();
 	glBindTexture( GL_TEXTURE_2D, static_cast<GLuint>(iTexHandle) );
 
 	bool bFreeImg;
@@ -2586,6 +2644,7 @@ bool RageDisplay_Legacy::SupportsFullscreenBorderlessWindow() const
 
 uintptr_t RageDisplay_Legacy::CreateRenderTarget( const RenderTargetParam &param, int &iTextureWidthOut, int &iTextureHeightOut )
 {
+	InvalidateQuadBatchState();
 	RenderTarget *pTarget;
 	if (GLEW_EXT_framebuffer_object)
 		pTarget = new RenderTarget_FramebufferObject;
@@ -2611,6 +2670,7 @@ uintptr_t RageDisplay_Legacy::GetRenderTarget()
 
 void RageDisplay_Legacy::SetRenderTarget( uintptr_t iTexture, bool bPreserveTexture )
 {
+	InvalidateQuadBatchState();
 	if (iTexture == 0)
 	{
 		g_bInvertY = false;
@@ -2672,6 +2732,7 @@ void RageDisplay_Legacy::SetRenderTarget( uintptr_t iTexture, bool bPreserveText
 
 void RageDisplay_Legacy::SetPolygonMode(PolygonMode pm)
 {
+	SetQuadBatchState( QuadBatchState_PolygonMode, pm );
 	GLenum m;
 	switch (pm)
 	{
@@ -2685,6 +2746,7 @@ void RageDisplay_Legacy::SetPolygonMode(PolygonMode pm)
 
 void RageDisplay_Legacy::SetLineWidth(float fWidth)
 {
+	SetQuadBatchState( QuadBatchState_LineWidth, QuadBatchValue(fWidth) );
 	glLineWidth(fWidth);
 }
 
@@ -2727,6 +2789,7 @@ RString RageDisplay_Legacy::GetTextureDiagnostics(uintptr_t iTexture) const
  */
 void RageDisplay_Legacy::SetAlphaTest(bool b)
 {
+	SetQuadBatchState( QuadBatchState_AlphaTest, b );
 	// Previously this was 0.01, rather than 0x01.
 	glAlphaFunc(GL_GREATER, 0.00390625 /* 1/256 */);
 	if (b)
@@ -2791,6 +2854,7 @@ bool RageDisplay_Legacy::SupportsPerVertexMatrixScale()
 
 void RageDisplay_Legacy::SetSphereEnvironmentMapping(TextureUnit tu, bool b)
 {
+	SetQuadBatchState( QuadBatchState_SphereEnvironmentMapping, b, tu );
 	if (!SetTextureUnit(tu))
 		return;
 
@@ -2812,6 +2876,7 @@ GLint iCelTexture1, iCelTexture2 = 0;
 
 void RageDisplay_Legacy::SetCelShaded( int stage )
 {
+	SetQuadBatchState( QuadBatchState_CelShaded, stage );
 	if (!GLEW_ARB_fragment_program && !GL_ARB_shading_language_100)
 		return; // not supported
 
@@ -0,0 +1,134 @@
+#include "global.h"
+#include "RageDisplay_OGL_StreamingVertices.h"
+
+#include <cstddef>
+
+#define BUFFER_OFFSET(o) ((char*)(o))
+
+void StreamingVertexBuffer::Invalidate()
+{
+	m_iBuffer = 0;
+	m_pMapped = nullptr;
+	m_iOffset = 0;
+	m_iSection = 0;
+	m_bRestart = true;
+	m_bUnavailable = false;
+	for( int i = 0; i < NUM_SECTIONS; ++i )
+		m_Fences[i] = nullptr;
+}
+
+void StreamingVertexBuffer::Free()
+{
+	if (m_pMapped != nullptr)
+	{
+		glBindBufferARB( GL_ARRAY_BUFFER_ARB, m_iBuffer );
+		glUnmapBufferARB( GL_ARRAY_BUFFER_ARB );
+		glBindBufferARB( GL_ARRAY_BUFFER_ARB, 0 );
+	}
+	for( int i = 0; i < NUM_SECTIONS; ++i )
+		if (m_Fences[i] != nullptr)
+			glDeleteSync( m_Fences[i] );
+	if (m_iBuffer != 0)
+		glDeleteBuffersARB( 1, &m_iBuffer );
+	Invalidate();
+}
+
+bool StreamingVertexBuffer::SetupVertices( const RageSpriteVertex v[], int iNumVerts )
+{
+	const int iOffset = Write( v, iNumVerts );
+	if (iOffset == -1)
+		return false;
+
+	const GLsizei iStride = sizeof(StreamingVertex);
+	glEnableClientState( GL_VERTEX_ARRAY );
+	glVertexPointer( 3, GL_FLOAT, iStride, BUFFER_OFFSET(iOffset + offsetof(StreamingVertex, p)) );
+
+	glEnableClientState( GL_COLOR_ARRAY );
+	glColorPointer( 4, GL_UNSIGNED_BYTE, iStride, BUFFER_OFFSET(iOffset + offsetof(StreamingVertex, c)) );
+
+	glEnableClientState( GL_TEXTURE_COORD_ARRAY );
+	glTexCoordPointer( 2, GL_FLOAT, iStride, BUFFER_OFFSET(iOffset + offsetof(StreamingVertex, t)) );
+
+	if (GLEW_ARB_multitexture)
+	{
+		glClientActiveTextureARB( GL_TEXTURE1_ARB );
+		glEnableClientState( GL_TEXTURE_COORD_ARRAY );
+		glTexCoordPointer( 2, GL_FLOAT, iStride, BUFFER_OFFSET(iOffset + offsetof(StreamingVertex, t)) );
+		glClientActiveTextureARB( GL_TEXTURE0_ARB );
+	}
+
+	glEnableClientState( GL_NORMAL_ARRAY );
+	glNormalPointer( GL_FLOAT, iStride, BUFFER_OFFSET(iOffset + offsetof(StreamingVertex, n)) );
+	return true;
+}
+
+int StreamingVertexBuffer::Write( const RageSpriteVertex v[], int iNumVerts )
+{
+	const int iBytes = iNumVerts * sizeof(StreamingVertex);
+	if (m_bUnavailable || iBytes > SECTION_SIZE || !GLEW_ARB_buffer_storage || !GLEW_ARB_sync)
+		return -1;
+
+	if (m_iBuffer == 0 && !Allocate())
+		return -1;
+	glBindBufferARB( GL_ARRAY_BUFFER_ARB, m_iBuffer );
+
+	// Draws never straddle sections, so a section's fence covers all of its draws.
+	if (m_bRestart || m_iOffset + iBytes > (m_iSection+1) * SECTION_SIZE)
+		EnterSection( (m_iSection+1) % NUM_SECTIONS );
+	m_bRestart = false;
+
+	StreamingVertex *pOut = (StreamingVertex *) (m_pMapped + m_iOffset);
+
+	for( int i = 0; i < iNumVerts; ++i )
+	{
+		StreamingVertex &out = pOut[i];
+		out.p[0] = v[i].p[0];
+		out.p[1] = v[i].p[1];
+		out.p[2] = v[i].p[2];
+		out.n[0] = v[i].n[0];
+		out.n[1] = v[i].n[1];
+		out.n[2] = v[i].n[2];
+		out.c[0] = v[i].c.r;
+		out.c[1] = v[i].c.g;
+		out.c[2] = v[i].c.b;
+		out.c[3] = v[i].c.a;
+		out.t[0] = v[i].t[0];
+		out.t[1] = v[i].t[1];
+	}
+
+	const int iOffset = m_iOffset;
+	m_iOffset += iBytes;
+	return iOffset;
+}
+
+bool StreamingVertexBuffer::Allocate()
+{
+	glGenBuffersARB( 1, &m_iBuffer );
+	glBindBufferARB( GL_ARRAY_BUFFER_ARB, m_iBuffer );
+	const GLbitfield iFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glBufferStorage( GL_ARRAY_BUFFER_ARB, BUFFER_SIZE, nullptr, iFlags );
+	m_pMapped = (char *) glMapBufferRange( GL_ARRAY_BUFFER_ARB, 0, BUFFER_SIZE, iFlags );
+	glBindBufferARB( GL_ARRAY_BUFFER_ARB, 0 );
+	if (m_pMapped != nullptr)
+		return true;
+
+	glDeleteBuffersARB( 1, &m_iBuffer );
+	m_iBuffer = 0;
+	m_bUnavailable = true;
+	return false;
+}
+
+void StreamingVertexBuffer::EnterSection( int iSection )
+{
+	m_Fences[m_iSection] = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+	m_iSection = iSection;
+	m_iOffset = iSection * SECTION_SIZE;
+
+	GLsync fence = m_Fences[iSection];
+	if (fence == nullptr)
+		return;
+	while (glClientWaitSync( fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000 ) == GL_TIMEOUT_EXPIRED)
+		;
+	glDeleteSync( fence );
+	m_Fences[iSection] = nullptr;
+}
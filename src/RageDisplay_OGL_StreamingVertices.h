@@ -0,0 +1,68 @@
+/* StreamingVertexBuffer - The buffer RageDisplay_Legacy's dynamic draws take their vertices from. */
+
+#ifndef RAGE_DISPLAY_OGL_STREAMING_VERTICES_H
+#define RAGE_DISPLAY_OGL_STREAMING_VERTICES_H
+
+#include "RageDisplay_OGL_Helpers.h"
+
+/* Vertices for the dynamic draws are written front to back into one buffer
+ * object, rather than passed from client memory on every draw.  The buffer is
+ * mapped once for good and split into sections; each section gets a fence
+ * when we move past it, and we wait on that fence before writing it again.
+ *
+ * This needs ARB_buffer_storage and ARB_sync.  Without them, vertices come
+ * from client memory as before: mapping or updating an orphaned buffer on
+ * every draw is slower than that on some drivers (Mesa's llvmpipe among them),
+ * and most of our draws are a single quad.
+ *
+ * This only depends on GL, so tests/test_streaming_vertices can check it
+ * against client arrays without the rest of RageDisplay. */
+struct StreamingVertex
+{
+	float p[3];
+	float n[3];
+	GLubyte c[4];
+	float t[2];
+};
+
+class StreamingVertexBuffer
+{
+public:
+	static const int NUM_SECTIONS = 4;
+	static const int SECTION_SIZE = 1024*1024;
+	static const int BUFFER_SIZE = NUM_SECTIONS * SECTION_SIZE;
+
+	StreamingVertexBuffer() { Invalidate(); }
+
+	/* Forget the buffer without freeing it, for when the context is gone. */
+	void Invalidate();
+	void Free();
+
+	/* Move on to the next section, fencing everything drawn so far.  Call
+	 * this when another context may draw from the buffer next. */
+	void Restart() { m_bRestart = true; }
+
+	/* Copy the vertices into the buffer and point the vertex, color, normal
+	 * and texture coordinate arrays at them, leaving the buffer bound.
+	 * Returns false if they have to be drawn from client memory. */
+	bool SetupVertices( const RageSpriteVertex v[], int iNumVerts );
+
+	/* True once the buffer couldn't be mapped in this context. */
+	bool MapFailed() const { return m_bUnavailable; }
+
+private:
+	/* Returns the byte offset the vertices were written at, or -1. */
+	int Write( const RageSpriteVertex v[], int iNumVerts );
+	bool Allocate();
+	void EnterSection( int iSection );
+
+	GLuint m_iBuffer;
+	char *m_pMapped;
+	int m_iOffset;
+	int m_iSection;
+	bool m_bRestart;
+	bool m_bUnavailable;
+	GLsync m_Fences[NUM_SECTIONS];
+};
+
+#endif
@@ -28,7 +28,12 @@ public:
 
 		/* Flush the file to disk on close.  Combined with not streaming, this results
 		 * in very safe writes, but is slow. */
-		SLOW_FLUSH	= 0x8
+		SLOW_FLUSH	= 0x8,
+
+		/* Add to the end of the file instead of replacing it.  Must be combined
+		 * with WRITE and STREAMED.  Only the direct driver supports it; Open
+		 * fails on the others, so have a way to write the whole file instead. */
+		APPEND		= 0x10
 	};
 
 	RageFile();
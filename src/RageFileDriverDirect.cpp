@@ -74,8 +74,11 @@ static RageFileObjDirect *MakeFileObjDirect( RString sPath, int iMode, int &iErr
 		else
 			sOut = MakeTempFilename(sPath);
 
+		/* Appending to a temporary file would lose what's already there. */
+		ASSERT( !(iMode & RageFile::APPEND) || (iMode & RageFile::STREAMED) );
+
 		/* Open a temporary file for writing. */
-		iFD = DoOpen( sOut, O_BINARY|O_WRONLY|O_CREAT|O_TRUNC, 0666 );
+		iFD = DoOpen( sOut, O_BINARY|O_WRONLY|O_CREAT|((iMode & RageFile::APPEND)? O_APPEND:O_TRUNC), 0666 );
 	}
 
 	if( iFD == -1 )
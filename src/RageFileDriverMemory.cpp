@@ -134,6 +134,13 @@ RageFileBasic *RageFileDriverMem::Open( const RString &sPath, int mode, int &err
 {
 	LockMut(m_Mutex);
 
+	/* Memory files are only ever written from the start. */
+	if( mode & RageFile::APPEND )
+	{
+		err = ERROR_WRITING_NOT_SUPPORTED;
+		return nullptr;
+	}
+
 	if( mode == RageFile::WRITE )
 	{
 		/* If the file exists, delete it. */
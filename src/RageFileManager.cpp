@@ -2,6 +2,7 @@
 #include "RageFileManager.h"
 #include "RageFileDriver.h"
 #include "RageFile.h"
+#include "RageFileDriverDirectHelpers.h"
 #include "RageUtil.h"
 #include "RageUtil_FileDB.h"
 #include "RageLog.h"
@@ -22,6 +23,7 @@
 #include <paths.h>
 #include <sys/types.h>
 #endif
+#include <sys/stat.h>
 
 #include <miniz.h>
 
@@ -1259,6 +1261,31 @@ unsigned int GetHashForDirectory( const RString &sDir )
 	return hash;
 }
 
+bool GetStampForDirectory( const RString &sDir, const std::vector<RString> &vsFiles, unsigned int &iStampOut )
+{
+	ASSERT( sDir.Right(1) == "/" );
+
+	/* The parent's listing already holds the directory's own mtime and size,
+	 * which change whenever an entry is added, removed or renamed. */
+	int iDirHash = FILEMAN->GetFileHash( sDir.Left(sDir.size()-1) );
+	if( iDirHash == -1 )
+		return false;
+
+	/* Files edited in place don't touch the directory.  Stat the ones we
+	 * care about directly; asking FILEMAN would list the whole directory. */
+	unsigned int iStamp = iDirHash;
+	for( RString const &sFile : vsFiles )
+	{
+		struct stat st;
+		if( DoStat(FILEMAN->ResolvePath(sFile), &st) == -1 )
+			return false;
+		iStamp += GetHashForString( sFile ) + static_cast<unsigned int>( st.st_mtime ) + static_cast<unsigned int>( st.st_size );
+	}
+
+	iStampOut = iStamp;
+	return true;
+}
+
 // lua start
 #include "LuaBinding.h"
 
@@ -9,7 +9,7 @@
 
 
 RageTexture::RageTexture( RageTextureID name ):
-	m_iRefCount(1), m_bWasUsed(false), m_ID(name),
+	m_iRefCount(1), m_bWasUsed(false), m_ID(name), m_pAtlasPage(nullptr), m_iAtlasRefCount(0),
 	m_iSourceWidth(0), m_iSourceHeight(0),
 	m_iTextureWidth(0), m_iTextureHeight(0),
 	m_iImageWidth(0), m_iImageHeight(0),
@@ -21,6 +21,16 @@ RageTexture::~RageTexture()
 
 }
 
+void RageTexture::ReleaseAtlasPlacement()
+{
+	ASSERT( m_iAtlasRefCount > 0 );
+	if( --m_iAtlasRefCount == 0 )
+	{
+		m_pAtlasPage = nullptr;
+		m_AtlasRect = RectF();
+	}
+}
+
 
 void RageTexture::CreateFrameRects()
 {
@@ -65,6 +65,17 @@ public:
 	// The ID that we were asked to load:
 	const RageTextureID &GetID() const { return m_ID; }
 
+	/* If a RageTextureAtlas copied this texture's image into one of its pages,
+	 * the page and the image's rect on it, in the page's texture coords. */
+	RageTexture *GetAtlasPage() const { return m_pAtlasPage; }
+	const RectF &GetAtlasRect() const { return m_AtlasRect; }
+	/* Every atlas holding this texture shares its placement: the first one
+	 * sets it, the others add a reference, and it's cleared when the last
+	 * one lets go. */
+	void SetAtlasPlacement( RageTexture *pPage, const RectF &rect ) { m_pAtlasPage = pPage; m_AtlasRect = rect; m_iAtlasRefCount = 1; }
+	void AddAtlasReference() { ASSERT( m_pAtlasPage != nullptr ); ++m_iAtlasRefCount; }
+	void ReleaseAtlasPlacement();
+
 	static void GetFrameDimensionsFromFileName( RString sPath, int* puFramesWide, int* puFramesHigh, int source_width= 0, int source_height= 0 );
 
 	// Lua
@@ -75,6 +86,10 @@ private:
 	 * limitations, etc). The data actually loaded is here: */
 	RageTextureID m_ID;
 
+	RageTexture	*m_pAtlasPage;
+	RectF		m_AtlasRect;
+	int		m_iAtlasRefCount;
+
 protected:
 
 	int		m_iSourceWidth,		m_iSourceHeight;	// dimensions of the original image loaded from disk
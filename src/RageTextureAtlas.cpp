@@ -0,0 +1,263 @@
+#include "global.h"
+#include "RageTextureAtlas.h"
+#include "RageBitmapTexture.h"
+#include "RageTextureManager.h"
+#include "RageDisplay.h"
+#include "RageSurface.h"
+#include "RageSurfaceUtils.h"
+#include "RageUtil.h"
+
+#include <algorithm>
+#include <cstring>
+
+/* Pages are kept to a size every card we run on can sample from quickly,
+ * and anything that doesn't fit on one is better off as its own texture. */
+static const int MAX_PAGE_SIZE = 2048;
+
+/* Two pixels of edge around each image covers bilinear filtering at the
+ * edge even when the sprite is zoomed down a little. */
+static const int GUTTER = 2;
+
+/* A page keeps its image so that it can be sent again when textures are
+ * reloaded or the device is lost. */
+class RageTextureAtlasPage: public RageTexture
+{
+public:
+	RageTextureAtlasPage( RageTextureID ID, RageSurface *pImage ):
+		RageTexture( ID ), m_pImage( pImage ), m_uTexHandle( 0 )
+	{
+		m_iSourceWidth = m_iTextureWidth = m_iImageWidth = pImage->w;
+		m_iSourceHeight = m_iTextureHeight = m_iImageHeight = pImage->h;
+		CreateFrameRects();
+		Create();
+	}
+	~RageTextureAtlasPage()
+	{
+		DISPLAY->DeleteTexture( m_uTexHandle );
+		delete m_pImage;
+	}
+	void Invalidate() { m_uTexHandle = 0; }
+	void Reload()
+	{
+		DISPLAY->DeleteTexture( m_uTexHandle );
+		Create();
+	}
+	uintptr_t GetTexHandle() const { return m_uTexHandle; }
+
+private:
+	void Create() { m_uTexHandle = DISPLAY->CreateTexture( RagePixelFormat_RGBA8, m_pImage, false ); }
+
+	RageSurface *m_pImage;
+	uintptr_t m_uTexHandle;
+};
+
+/* Only plain images are copied: movies and render targets change after
+ * they're copied, and a page has no mipmaps to give. */
+static bool CanPlace( const RageTexture *pTexture )
+{
+	if( pTexture == nullptr )
+		return false;
+	if( dynamic_cast<const RageBitmapTexture *>(pTexture) == nullptr )
+		return false;
+	return !pTexture->GetID().bMipMaps && pTexture->GetTexHandle() != 0;
+}
+
+void RageTextureAtlas::Build( const std::vector<RageTexture*> &vpTextures )
+{
+	Clear();
+
+	if( !DISPLAY->SupportsTextureFormat(RagePixelFormat_RGBA8) )
+		return;
+	const RageDisplay::RagePixelFormatDesc *pfd = DISPLAY->GetPixelFormatDesc( RagePixelFormat_RGBA8 );
+	const int iPageSize = std::min( MAX_PAGE_SIZE, DISPLAY->GetMaxTextureSize() );
+
+	// Read back what each texture actually holds, after any resizing and dithering.
+	std::vector<RageTexture*> vpCandidates;
+	std::vector<RageSurface*> vpImages;
+	std::vector<Placement> vPlacements;
+	for( RageTexture *pTexture : vpTextures )
+	{
+		if( !CanPlace(pTexture) || find(vpCandidates.begin(), vpCandidates.end(), pTexture) != vpCandidates.end() )
+			continue;
+
+		// Another atlas (another player's copy of the same skin) already has it.
+		if( pTexture->GetAtlasPage() != nullptr )
+		{
+			if( find(m_vpTextures.begin(), m_vpTextures.end(), pTexture) != m_vpTextures.end() )
+				continue;
+			RageTexture *pPage = pTexture->GetAtlasPage();
+			if( find(m_vpPages.begin(), m_vpPages.end(), pPage) == m_vpPages.end() )
+				m_vpPages.push_back( TEXTUREMAN->CopyTexture(pPage) );
+			pTexture->AddAtlasReference();
+			m_vpTextures.push_back( TEXTUREMAN->CopyTexture(pTexture) );
+			continue;
+		}
+
+		RageSurface *pImage = DISPLAY->GetTexture( pTexture->GetTexHandle() );
+		if( pImage == nullptr )
+		{
+			// This renderer can't read textures back, so nothing can be placed.
+			for( RageSurface *p : vpImages )
+				delete p;
+			Clear();
+			return;
+		}
+		if( pImage->w < pTexture->GetImageWidth() || pImage->h < pTexture->GetImageHeight() )
+		{
+			delete pImage;
+			continue;
+		}
+		RageSurfaceUtils::ConvertSurface( pImage, pImage->w, pImage->h,
+			pfd->bpp, pfd->masks[0], pfd->masks[1], pfd->masks[2], pfd->masks[3] );
+
+		Placement p;
+		p.iWidth = pTexture->GetImageWidth();
+		p.iHeight = pTexture->GetImageHeight();
+		vpCandidates.push_back( pTexture );
+		vpImages.push_back( pImage );
+		vPlacements.push_back( p );
+	}
+
+	Pack( vPlacements, iPageSize, GUTTER );
+
+	// Trim each page to the power of two that holds its last shelf.
+	std::vector<int> viPageHeight;
+	for( const Placement &p : vPlacements )
+	{
+		if( p.iPage == -1 )
+			continue;
+		if( p.iPage >= int(viPageHeight.size()) )
+			viPageHeight.resize( p.iPage+1, 0 );
+		viPageHeight[p.iPage] = std::max( viPageHeight[p.iPage], p.iY + p.iHeight + GUTTER );
+	}
+
+	std::vector<RageSurface*> vpPageImages;
+	for( int iHeight : viPageHeight )
+	{
+		RageSurface *pPage = CreateSurface( iPageSize, std::min(power_of_two(iHeight), iPageSize),
+			pfd->bpp, pfd->masks[0], pfd->masks[1], pfd->masks[2], pfd->masks[3] );
+		memset( pPage->pixels, 0, pPage->pitch * pPage->h );
+		vpPageImages.push_back( pPage );
+	}
+
+	for( unsigned i = 0; i < vPlacements.size(); ++i )
+	{
+		const Placement &p = vPlacements[i];
+		if( p.iPage != -1 )
+			Compose( vpPageImages[p.iPage], vpImages[i], p.iX, p.iY, p.iWidth, p.iHeight, GUTTER );
+		delete vpImages[i];
+	}
+
+	static int s_iNextPage = 0;
+	std::vector<RageTexture*> vpNewPages;
+	for( RageSurface *pImage : vpPageImages )
+	{
+		RageTextureID ID( ssprintf("__atlas__ #%i", s_iNextPage++) );
+		RageTexture *pPage = new RageTextureAtlasPage( ID, pImage );
+		pPage->GetPolicy() = RageTextureID::TEX_VOLATILE;
+		pPage->m_bWasUsed = true;
+		TEXTUREMAN->RegisterTexture( ID, pPage );
+		vpNewPages.push_back( pPage );
+		m_vpPages.push_back( pPage );
+	}
+
+	for( unsigned i = 0; i < vPlacements.size(); ++i )
+	{
+		const Placement &p = vPlacements[i];
+		if( p.iPage == -1 )
+			continue;
+		RageTexture *pPage = vpNewPages[p.iPage];
+		const float fWidth = float(pPage->GetTextureWidth());
+		const float fHeight = float(pPage->GetTextureHeight());
+		RageTexture *pTexture = TEXTUREMAN->CopyTexture( vpCandidates[i] );
+		pTexture->SetAtlasPlacement( pPage, RectF(p.iX / fWidth, p.iY / fHeight,
+			(p.iX + p.iWidth) / fWidth, (p.iY + p.iHeight) / fHeight) );
+		m_vpTextures.push_back( pTexture );
+	}
+}
+
+void RageTextureAtlas::Clear()
+{
+	for( RageTexture *pTexture : m_vpTextures )
+	{
+		pTexture->ReleaseAtlasPlacement();
+		TEXTUREMAN->UnloadTexture( pTexture );
+	}
+	m_vpTextures.clear();
+
+	for( RageTexture *pPage : m_vpPages )
+		TEXTUREMAN->UnloadTexture( pPage );
+	m_vpPages.clear();
+}
+
+void RageTextureAtlas::Pack( std::vector<Placement> &vPlacements, int iPageSize, int iGutter )
+{
+	// Tallest first, so each shelf is as tall as its first image.
+	std::vector<int> viOrder;
+	for( unsigned i = 0; i < vPlacements.size(); ++i )
+		viOrder.push_back( i );
+	std::stable_sort( viOrder.begin(), viOrder.end(), [&]( int a, int b ) {
+		return vPlacements[a].iHeight > vPlacements[b].iHeight;
+	} );
+
+	int iPage = 0, iShelfX = 0, iShelfY = 0, iShelfHeight = 0;
+	for( int i : viOrder )
+	{
+		Placement &p = vPlacements[i];
+		const int iCellWidth = p.iWidth + iGutter*2;
+		const int iCellHeight = p.iHeight + iGutter*2;
+		if( p.iWidth <= 0 || p.iHeight <= 0 || iCellWidth > iPageSize || iCellHeight > iPageSize )
+		{
+			p.iPage = -1;
+			continue;
+		}
+
+		if( iShelfX + iCellWidth > iPageSize )
+		{
+			iShelfY += iShelfHeight;
+			iShelfX = iShelfHeight = 0;
+		}
+		if( iShelfY + iCellHeight > iPageSize )
+		{
+			++iPage;
+			iShelfX = iShelfY = iShelfHeight = 0;
+		}
+
+		p.iPage = iPage;
+		p.iX = iShelfX + iGutter;
+		p.iY = iShelfY + iGutter;
+		iShelfX += iCellWidth;
+		iShelfHeight = std::max( iShelfHeight, iCellHeight );
+	}
+}
+
+void RageTextureAtlas::Compose( RageSurface *pPage, const RageSurface *pImage, int iX, int iY, int iWidth, int iHeight, int iGutter )
+{
+	ASSERT( pPage->fmt.BytesPerPixel == 4 && pImage->fmt.BytesPerPixel == 4 );
+	ASSERT( iX >= iGutter && iY >= iGutter );
+	ASSERT( iX + iWidth + iGutter <= pPage->w && iY + iHeight + iGutter <= pPage->h );
+	ASSERT( iWidth <= pImage->w && iHeight <= pImage->h );
+
+	const int iBpp = 4;
+	for( int y = 0; y < iHeight; ++y )
+	{
+		const uint8_t *pSrc = pImage->pixels + y*pImage->pitch;
+		uint8_t *pDst = pPage->pixels + (iY+y)*pPage->pitch + iX*iBpp;
+		memcpy( pDst, pSrc, iWidth*iBpp );
+		for( int i = 1; i <= iGutter; ++i )
+		{
+			memcpy( pDst - i*iBpp, pDst, iBpp );
+			memcpy( pDst + (iWidth-1+i)*iBpp, pDst + (iWidth-1)*iBpp, iBpp );
+		}
+	}
+
+	// Then the rows above and below, corners included.
+	const int iRowBytes = (iWidth + iGutter*2) * iBpp;
+	uint8_t *pTop = pPage->pixels + iY*pPage->pitch + (iX-iGutter)*iBpp;
+	uint8_t *pBottom = pTop + (iHeight-1)*pPage->pitch;
+	for( int i = 1; i <= iGutter; ++i )
+	{
+		memcpy( pTop - i*pPage->pitch, pTop, iRowBytes );
+		memcpy( pBottom + i*pPage->pitch, pBottom, iRowBytes );
+	}
+}
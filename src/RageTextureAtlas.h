@@ -0,0 +1,50 @@
+/* RageTextureAtlas - Copies a set of static textures into a few shared pages. */
+
+#ifndef RAGE_TEXTURE_ATLAS_H
+#define RAGE_TEXTURE_ATLAS_H
+
+#include <vector>
+
+class RageTexture;
+struct RageSurface;
+
+/* Sprites drawing a placed texture bind its page instead, so everything
+ * drawn from one atlas can share a texture and a quad batch.  The original
+ * textures stay loaded and untouched for anything that wants them directly. */
+class RageTextureAtlas
+{
+public:
+	RageTextureAtlas() { }
+	~RageTextureAtlas() { Clear(); }
+
+	/* Place every texture that can be; the rest are left alone.  Textures
+	 * another atlas has already placed stay where they are, shared. */
+	void Build( const std::vector<RageTexture*> &vpTextures );
+	void Clear();
+
+	int GetNumTextures() const { return m_vpTextures.size(); }
+	int GetNumPages() const { return m_vpPages.size(); }
+
+	struct Placement
+	{
+		int iWidth, iHeight;	// of the image, not counting the gutter
+		int iPage;		// -1 if it doesn't fit on a page at all
+		int iX, iY;		// top left of the image on its page
+	};
+
+	/* Shelf-pack images onto square pages of iPageSize, leaving iGutter
+	 * pixels around each. Fills in iPage, iX and iY. */
+	static void Pack( std::vector<Placement> &vPlacements, int iPageSize, int iGutter );
+
+	/* Copy the top-left iWidth x iHeight of pImage to (iX,iY) on pPage and
+	 * repeat its edge pixels iGutter pixels outward, so filtering at the
+	 * edge of the image sees what clamping the original texture would.
+	 * Both surfaces must have the same 32-bit format. */
+	static void Compose( RageSurface *pPage, const RageSurface *pImage, int iX, int iY, int iWidth, int iHeight, int iGutter );
+
+private:
+	std::vector<RageTexture*> m_vpTextures;
+	std::vector<RageTexture*> m_vpPages;
+};
+
+#endif
@@ -41,7 +41,8 @@ namespace
 
 RageTextureManager::RageTextureManager():
 	m_iNoWarnAboutOddDimensions(0),
-	m_TexturePolicy(RageTextureID::TEX_DEFAULT) {}
+	m_TexturePolicy(RageTextureID::TEX_DEFAULT),
+	m_pvpRecordedLoads(nullptr) {}
 
 RageTextureManager::~RageTextureManager()
 {
@@ -184,7 +185,11 @@ RageTexture* RageTextureManager::LoadTexture( RageTextureID ID )
 {
 	RageTexture* pTexture = LoadTextureInternal( ID );
 	if( pTexture )
+	{
 		pTexture->m_bWasUsed = true;
+		if( m_pvpRecordedLoads != nullptr )
+			m_pvpRecordedLoads->push_back( pTexture );
+	}
 	return pTexture;
 }
 
@@ -62,6 +62,11 @@ public:
 
 	void RegisterTextureForUpdating(RageTextureID id, RageTexture* tex);
 
+	/* Append every texture LoadTexture returns to pvpOut until
+	 * EndRecordingLoads.  No references are taken. */
+	void BeginRecordingLoads( std::vector<RageTexture*> *pvpOut ) { m_pvpRecordedLoads = pvpOut; }
+	void EndRecordingLoads() { m_pvpRecordedLoads = nullptr; }
+
 	bool SetPrefs( RageTextureManagerPrefs prefs );
 	RageTextureManagerPrefs GetPrefs() { return m_Prefs; };
 
@@ -96,6 +101,7 @@ private:
 	RageTextureManagerPrefs m_Prefs;
 	int m_iNoWarnAboutOddDimensions;
 	RageTextureID::TexPolicy m_TexturePolicy;
+	std::vector<RageTexture*> *m_pvpRecordedLoads;
 };
 
 extern RageTextureManager*	TEXTUREMAN;	// global and accessible from anywhere in our program
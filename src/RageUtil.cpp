@@ -1153,31 +1153,35 @@ RString GetCwd()
  */
 void CRC32( unsigned int &iCRC, const void *pVoidBuffer, size_t iSize )
 {
-	static unsigned tab[256];
-	static bool initted = false;
-	if( !initted )
+	/* Built by a static initializer, so threads hashing at the same time
+	 * can't see a half-filled table. */
+	struct CRC32Table
 	{
-		initted = true;
-		const unsigned POLY = 0xEDB88320;
-
-		for( int i = 0; i < 256; ++i )
+		unsigned tab[256];
+		CRC32Table()
 		{
-			tab[i] = i;
-			for( int j = 0; j < 8; ++j )
+			const unsigned POLY = 0xEDB88320;
+
+			for( int i = 0; i < 256; ++i )
 			{
-				if( tab[i] & 1 )
-					tab[i] = (tab[i] >> 1) ^ POLY;
-				else
-					tab[i] >>= 1;
+				tab[i] = i;
+				for( int j = 0; j < 8; ++j )
+				{
+					if( tab[i] & 1 )
+						tab[i] = (tab[i] >> 1) ^ POLY;
+					else
+						tab[i] >>= 1;
+				}
 			}
 		}
-	}
+	};
+	static const CRC32Table table;
 
 	iCRC ^= 0xFFFFFFFF;
 
 	const char *pBuffer = (const char *) pVoidBuffer;
 	for( unsigned i = 0; i < iSize; ++i )
-		iCRC = (iCRC >> 8) ^ tab[(iCRC ^ pBuffer[i]) & 0xFF];
+		iCRC = (iCRC >> 8) ^ table.tab[(iCRC ^ pBuffer[i]) & 0xFF];
 
 	iCRC ^= 0xFFFFFFFF;
 }
@@ -459,6 +459,10 @@ void CRC32( unsigned int &iCRC, const void *pBuffer, size_t iSize );
 unsigned int GetHashForString( const RString &s );
 unsigned int GetHashForFile( const RString &sPath );
 unsigned int GetHashForDirectory( const RString &sDir );	// a hash value that remains the same as long as nothing in the directory has changed
+/* A cheap stand-in for GetHashForDirectory that doesn't list sDir: it changes
+ * when files are added to or removed from sDir, or when one of vsFiles (full
+ * paths) is modified.  Returns false if it can't tell. */
+bool GetStampForDirectory( const RString &sDir, const std::vector<RString> &vsFiles, unsigned int &iStampOut );
 bool DirectoryIsEmpty( const RString &sPath );
 
 bool CompareRStringsAsc( const RString &sStr1, const RString &sStr2 );
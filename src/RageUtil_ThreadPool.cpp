@@ -0,0 +1,122 @@
+#include "global.h"
+#include "RageUtil_ThreadPool.h"
+#include "RageUtil.h"
+#include "RageLog.h"
+
+#include <algorithm>
+#include <thread>
+
+/* RageThread slots are a fixed resource; don't let a large core count eat
+ * all of them. */
+static const int MAX_POOL_THREADS = 32;
+
+static thread_local bool g_bIsWorkerThread = false;
+
+RageThreadPool::RageThreadPool( const RString &sName, int iNumThreads ):
+	m_Event( "\"" + sName + "\" thread pool" )
+{
+	m_sName = sName;
+	if( iNumThreads <= 0 )
+		iNumThreads = GetNumHardwareThreads();
+	m_iNumThreads = std::clamp( iNumThreads, 1, MAX_POOL_THREADS );
+	if( IsWorkerThread() )
+		m_iNumThreads = 1;
+
+	m_pJob = nullptr;
+	m_iNumJobs = 0;
+	m_iNextJob = 0;
+	m_iFinishedJobs = 0;
+}
+
+RageThreadPool::~RageThreadPool()
+{
+	/* Run() doesn't return until its workers have exited. */
+	ASSERT( m_pJob == nullptr );
+}
+
+int RageThreadPool::GetNumHardwareThreads()
+{
+	unsigned iThreads = std::thread::hardware_concurrency();
+	return iThreads == 0? 1:static_cast<int>(iThreads);
+}
+
+bool RageThreadPool::IsWorkerThread()
+{
+	return g_bIsWorkerThread;
+}
+
+void RageThreadPool::Run( std::size_t iNumJobs,
+	const std::function<void(std::size_t)> &Job,
+	const std::function<void(std::size_t)> &Progress )
+{
+	if( iNumJobs == 0 )
+		return;
+
+	const int iNumWorkers = static_cast<int>( std::min<std::size_t>(m_iNumThreads, iNumJobs) );
+	if( iNumWorkers <= 1 )
+	{
+		for( std::size_t i = 0; i < iNumJobs; ++i )
+		{
+			Job( i );
+			if( Progress )
+				Progress( i+1 );
+		}
+		return;
+	}
+
+	m_Event.Lock();
+	m_pJob = &Job;
+	m_iNumJobs = iNumJobs;
+	m_iNextJob = 0;
+	m_iFinishedJobs = 0;
+	m_Event.Unlock();
+
+	std::vector<RageThread> vWorkers( iNumWorkers );
+	for( int i = 0; i < iNumWorkers; ++i )
+	{
+		vWorkers[i].SetName( ssprintf("%s worker %i", m_sName.c_str(), i) );
+		vWorkers[i].Create( StartWorkerMain, this );
+	}
+
+	m_Event.Lock();
+	std::size_t iReported = 0;
+	while( m_iFinishedJobs < m_iNumJobs )
+	{
+		m_Event.Wait();
+		if( Progress && iReported != m_iFinishedJobs )
+		{
+			iReported = m_iFinishedJobs;
+			/* Don't hold the lock while the caller updates the screen. */
+			m_Event.Unlock();
+			Progress( iReported );
+			m_Event.Lock();
+		}
+	}
+	m_pJob = nullptr;
+	m_Event.Unlock();
+
+	for( RageThread &t : vWorkers )
+		t.Wait();
+
+	if( Progress && iReported != iNumJobs )
+		Progress( iNumJobs );
+}
+
+void RageThreadPool::WorkerMain()
+{
+	g_bIsWorkerThread = true;
+	m_Event.Lock();
+	while( m_iNextJob < m_iNumJobs )
+	{
+		const std::size_t i = m_iNextJob++;
+		const std::function<void(std::size_t)> &Job = *m_pJob;
+		m_Event.Unlock();
+
+		Job( i );
+
+		m_Event.Lock();
+		++m_iFinishedJobs;
+		m_Event.Signal();
+	}
+	m_Event.Unlock();
+}
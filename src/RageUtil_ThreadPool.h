@@ -0,0 +1,56 @@
+/* RageThreadPool - run a batch of independent jobs across several threads. */
+
+#ifndef RAGE_UTIL_THREAD_POOL_H
+#define RAGE_UTIL_THREAD_POOL_H
+
+#include "RageThreads.h"
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+class RageThreadPool
+{
+public:
+	/* iNumThreads <= 0 means one thread per hardware thread.  A pool of one
+	 * thread runs every job on the calling thread.  So does a pool created
+	 * by a job of another pool, so nesting them doesn't multiply threads. */
+	RageThreadPool( const RString &sName, int iNumThreads );
+	~RageThreadPool();
+
+	int GetNumThreads() const { return m_iNumThreads; }
+
+	/* Call Job(i) for each i in [0, iNumJobs), and return once all of them
+	 * have finished.  Jobs are handed out in index order, but may complete
+	 * in any order; write results into a slot owned by i and merge them
+	 * afterwards if the result must be deterministic.  If Progress is set,
+	 * it is called on the calling thread with the number of finished jobs
+	 * each time that number changes. */
+	void Run( std::size_t iNumJobs,
+		const std::function<void(std::size_t)> &Job,
+		const std::function<void(std::size_t)> &Progress = nullptr );
+
+	static int GetNumHardwareThreads();
+	/* True on a thread that's running a pool's jobs. */
+	static bool IsWorkerThread();
+
+private:
+	static int StartWorkerMain( void *pThis ) { ((RageThreadPool *) (pThis))->WorkerMain(); return 0; }
+	void WorkerMain();
+
+	RString m_sName;
+	int m_iNumThreads;
+
+	/* Protects everything below, and is signalled whenever a job finishes. */
+	RageEvent m_Event;
+	const std::function<void(std::size_t)> *m_pJob;
+	std::size_t m_iNumJobs;
+	std::size_t m_iNextJob;
+	std::size_t m_iFinishedJobs;
+
+	// Swallow up warnings. If they must be used, define them.
+	RageThreadPool& operator=(const RageThreadPool& rhs);
+	RageThreadPool(const RageThreadPool& rhs);
+};
+
+#endif
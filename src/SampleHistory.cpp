@@ -14,6 +14,7 @@ inline float sample_step_size(int samples_per_second)
 SampleHistory::SampleHistory()
 {
 	m_iLastHistory = 0;
+	m_iNonZeroSamples = 0;
 	m_iHistorySamplesPerSecond = 60;
 	m_fHistorySeconds = 0.0f;
 	m_fToSample = sample_step_size(m_iHistorySamplesPerSecond);
@@ -65,7 +66,9 @@ void SampleHistory::AddSample( float fSample, float fDeltaTime )
 			m_fToSample += sample_step_size(m_iHistorySamplesPerSecond);
 		}
 
-		m_afHistory[m_iLastHistory] = fSample;
+		float &fSlot = m_afHistory[m_iLastHistory];
+		m_iNonZeroSamples += (fSample != 0) - (fSlot != 0);
+		fSlot = fSample;
 	}
 }
 
@@ -11,12 +11,15 @@ public:
 	SampleHistory();
 	void AddSample( float fSample, float fDeltaTime );
 	float GetSample( float fSecondsAgo ) const;
+	// True if GetSample returns 0 for any time.
+	bool IsAllZero() const { return m_iNonZeroSamples == 0; }
 
 private:
 	float GetSampleNum( float fSamplesAgo ) const;
 
 	std::vector<float> m_afHistory;
 	int m_iLastHistory;
+	int m_iNonZeroSamples;
 	int m_iHistorySamplesPerSecond;
 	float m_fHistorySeconds;
 	float m_fToSample;
@@ -2593,10 +2593,9 @@ bool ScreenEdit::InputEdit( const InputEventPlus &input, EditButton EditB )
 			}
 			else
 			{
-				std::vector<TimingSegment *> &stops = timing.GetTimingSegments(SEGMENT_STOP);
 				seg->SetPause(seg->GetPause() + fDelta);
 				if( seg->GetPause() <= 0 )
-					stops.erase( stops.begin()+i, stops.begin()+i+1);
+					timing.EraseSegment( SEGMENT_STOP, i );
 			}
 
 			(fDelta>0 ? m_soundValueIncrease : m_soundValueDecrease).Play(true);
@@ -2639,10 +2638,9 @@ bool ScreenEdit::InputEdit( const InputEventPlus &input, EditButton EditB )
 			}
 			else
 			{
-				std::vector<TimingSegment *> &stops = timing.GetTimingSegments(SEGMENT_DELAY);
 				seg->SetPause(seg->GetPause() + fDelta);
 				if( seg->GetPause() <= 0 )
-					stops.erase( stops.begin()+i, stops.begin()+i+1);
+					timing.EraseSegment( SEGMENT_DELAY, i );
 			}
 
 			(fDelta>0 ? m_soundValueIncrease : m_soundValueDecrease).Play(true);
@@ -1462,6 +1462,8 @@ void ScreenGameplay::StartPlayingSong( float fMinTimeToNotes, float fMinTimeToMu
 	UpdateSongPosition(0);
 
 	ASSERT( GAMESTATE->m_Position.m_fMusicSeconds > -4000 ); /* make sure the "fake timer" code doesn't trigger */
+	// The song's timing gives the position everything else goes by.
+	GAMESTATE->m_pCurSong->m_SongTiming.PrepareLookup();
 	FOREACH_EnabledPlayer(pn)
 	{
 		if(GAMESTATE->m_pCurSteps[pn])
@@ -2567,6 +2569,7 @@ void ScreenGameplay::SaveStats()
 
 void ScreenGameplay::SongFinished()
 {
+	GAMESTATE->m_pCurSong->m_SongTiming.ReleaseLookup();
 	FOREACH_EnabledPlayer(pn)
 	{
 		if(GAMESTATE->m_pCurSteps[pn])
@@ -300,6 +300,9 @@ void ScreenManager::ThemeChanged()
 
 	ReloadOverlayScreens();
 
+	// The overlay screens have loaded their fonts by now.
+	FONT->SaveCompiledFonts();
+
 	// force recreate of new BGA
 	RageUtil::SafeDelete( g_pSharedBGA );
 	g_pSharedBGA = new Actor;
@@ -749,6 +749,12 @@ static void CustomSongsMaxMegabytes(int& sel, bool to_sel, const ConfOption* con
 	int mapping[]= {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 20, 30, 1000};
 	MoveMap(sel, conf_option, to_sel, mapping, ARRAYLEN(mapping));
 }
+
+static void ChartMemoryBudgetMB(int& sel, bool to_sel, const ConfOption* conf_option)
+{
+	int mapping[]= {0, 8, 16, 32, 64, 128, 256};
+	MoveMap(sel, conf_option, to_sel, mapping, ARRAYLEN(mapping));
+}
 static std::vector<ConfOption> g_ConfOptions;
 static void InitializeConfOptions()
 {
@@ -796,6 +802,7 @@ static void InitializeConfOptions()
 
 	ADD( ConfOption( "AutogenGroupCourses",		MovePref<bool>,		"Off","On" ) );
 	ADD( ConfOption( "FastLoad",			MovePref<bool>,		"Off","On" ) );
+	ADD( ConfOption( "ChartMemoryBudgetMB",		ChartMemoryBudgetMB,	"Off","8","16","32","64","128","256" ) );
 	{
 		ConfOption c("EditRecordModeLeadIn", EditRecordModeLeadIn);
 		for(int i= 0; i < 32; ++i)
@@ -1,6 +1,7 @@
 #include "global.h"
 #include "ScreenStatsOverlay.h"
 #include "ActorUtil.h"
+#include "ChartResidencyManager.h"
 #include "PrefsManager.h"
 #include "RageDisplay.h"
 #include "RageLog.h"
@@ -77,7 +78,13 @@ void ScreenStatsOverlay::Update( float fDeltaTime )
 	this->SetVisible( PREFSMAN->m_bShowStats );
 	if( PREFSMAN->m_bShowStats )
 	{
-		m_textStats.SetText( DISPLAY->GetStats() );
+		RString sStats = DISPLAY->GetStats();
+		if( CHARTRESIDENCY && PREFSMAN->m_iChartMemoryBudgetMB > 0 )
+			sStats += ssprintf( "\n%i charts (%u KB) in memory\n%llu hits, %llu misses, %llu evicted",
+				CHARTRESIDENCY->GetNumResident(), (unsigned) (CHARTRESIDENCY->GetResidentBytes() / 1024),
+				(unsigned long long) CHARTRESIDENCY->GetHits(), (unsigned long long) CHARTRESIDENCY->GetMisses(),
+				(unsigned long long) CHARTRESIDENCY->GetEvictions() );
+		m_textStats.SetText( sStats );
 		if ( SHOW_SKIPS )
 			UpdateSkips();
 	}
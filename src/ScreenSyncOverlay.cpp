@@ -173,6 +173,10 @@ bool ScreenSyncOverlay::Input( const InputEventPlus &input )
 	// changing the timing data invalidates them. -Kyz
 	if(a != Action_Invalid)
 	{
+		if(GAMESTATE->m_pCurSong != nullptr)
+		{
+			GAMESTATE->m_pCurSong->m_SongTiming.ReleaseLookup();
+		}
 		FOREACH_EnabledPlayer(pn)
 		{
 			if(GAMESTATE->m_pCurSteps[pn])
@@ -285,6 +289,7 @@ bool ScreenSyncOverlay::Input( const InputEventPlus &input )
 	default:
 		FAIL_M(ssprintf("Invalid sync action choice: %i", a));
 	}
+	++AdjustSync::s_iSyncChanges;
 
 	ShowHelp();
 	UpdateText();
@@ -471,6 +471,9 @@ public:
 	void PushSelf( lua_State *L );
 
 private:
+	/** @brief Write the cache file, without touching the cache index. */
+	bool WriteCacheFile( const RString &sPath );
+
 	bool m_loaded_from_autosave;
 	/** @brief the Steps that belong to this Song. */
 	std::vector<Steps*> m_vpSteps;
@@ -1,14 +1,17 @@
 #include "global.h"
 
 #include "SongCacheIndex.h"
+#include "BinaryCache.h"
 #include "RageLog.h"
 #include "RageUtil.h"
+#include "RageFile.h"
 #include "RageFileManager.h"
+#include "IniFile.h"
 #include "Song.h"
 #include "SpecialFiles.h"
 #include "CommonMetrics.h"
 
-#include <cstddef>
+#include <cstring>
 #include <vector>
 
 /*
@@ -27,8 +30,20 @@
  * Another advantage of this system is that we can load songs from cache given only their
  * path; we don't have to actually look in the directory (to find out the directory hash)
  * in order to find the cache file.
+ *
+ * The index is kept as a log: a header holding FILE_CACHE_VERSION, followed by
+ * (hash, path) records.  Changing one song appends one record instead of
+ * rewriting the whole index, and the log is compacted when it has collected
+ * too many stale records.
  */
-#define CACHE_INDEX SpecialFiles::CACHE_DIR + "index.cache"
+#define CACHE_INDEX_LOG (SpecialFiles::CACHE_DIR + "index.log")
+/* The IniFile index used by older versions; imported once, then removed. */
+#define CACHE_INDEX_INI (SpecialFiles::CACHE_DIR + "index.cache")
+
+static const char INDEX_MAGIC[4] = { 'S', 'C', 'I', 'X' };
+/* Bump this when the record layout changes. */
+static const uint32_t INDEX_FORMAT_VERSION = 1;
+static const std::size_t INDEX_HEADER_SIZE = sizeof(INDEX_MAGIC) + 8;
 
 
 SongCacheIndex *SONGINDEX; // global and accessible from anywhere in our program
@@ -57,7 +72,8 @@ RString SongCacheIndex::GetCacheFilePath( const RString &sGroup, const RString &
 	return ssprintf( "%s%s/%s", SpecialFiles::CACHE_DIR.c_str(), sGroup.c_str(), s.c_str() );
 }
 
-SongCacheIndex::SongCacheIndex()
+SongCacheIndex::SongCacheIndex():
+	m_iNumRecords( 0 ), m_Mutex( "SongCacheIndex" ), delay_save_cache( false )
 {
 	ReadCacheIndex();
 }
@@ -85,67 +101,246 @@ static void EmptyDir( RString dir )
 	}
 }
 
-void SongCacheIndex::ReadCacheIndex()
+/* A record is: hash, stamp flag, stamp, path, file count, files. */
+static void PutRecord( RString &out, const RString &sPath, unsigned iHash, bool bHasStamp, unsigned iStamp, const std::vector<RString> &vsFiles )
+{
+	WriteU32( out, iHash );
+	WriteU32( out, bHasStamp? 1:0 );
+	WriteU32( out, iStamp );
+	WriteString( out, sPath );
+	WriteStringVector( out, vsFiles );
+}
+
+/* Fill m_Entries from the log, and return the cache version it was written
+ * for, or -1 if it isn't a log of this format.  A record cut short by a crash
+ * is dropped, and bNeedRewrite is set so new records don't land behind it. */
+int SongCacheIndex::ReadLog( bool &bNeedRewrite )
+{
+	RageFile f;
+	RString sBuf;
+	if( !f.Open(CACHE_INDEX_LOG) || f.Read(sBuf) == -1 )
+		return -1;
+	if( sBuf.size() < INDEX_HEADER_SIZE || std::memcmp(sBuf.data(), INDEX_MAGIC, sizeof(INDEX_MAGIC)) )
+		return -1;
+
+	CacheReader in( sBuf.data() + sizeof(INDEX_MAGIC), sBuf.size() - sizeof(INDEX_MAGIC) );
+	if( in.U32() != INDEX_FORMAT_VERSION )
+		return -1;
+	const int iCacheVersion = in.I32();
+
+	while( !in.AtEnd() )
+	{
+		CacheEntry entry;
+		entry.iHash = in.U32();
+		entry.bHasStamp = in.U32() != 0;
+		entry.iStamp = in.U32();
+		RString sPath = in.String();
+		in.StringVector( entry.vsFiles );
+
+		if( in.Failed() )
+		{
+			bNeedRewrite = true;
+			break;
+		}
+		m_Entries[sPath] = entry;
+		++m_iNumRecords;
+	}
+	return iCacheVersion;
+}
+
+/* Fill m_Entries from an index written by an older version, and return the
+ * cache version it was written for. */
+int SongCacheIndex::ImportIniIndex()
 {
-	CacheIndex.ReadFile( CACHE_INDEX );	// don't care if this fails
+	IniFile ini;
+	if( !ini.ReadFile(CACHE_INDEX_INI) )
+		return -1;
 
 	int iCacheVersion = -1;
-	CacheIndex.GetValue( "Cache", "CacheVersion", iCacheVersion );
-	if( iCacheVersion == FILE_CACHE_VERSION )
-		return; // OK
+	ini.GetValue( "Cache", "CacheVersion", iCacheVersion );
+	const XNode *pNode = ini.GetChild( "Cache" );
+	if( pNode == nullptr )
+		return iCacheVersion;
+
+	/* The INI couldn't hold '=', so paths containing it were stored without
+	 * it.  Those songs will miss the index once and be cached again. */
+	FOREACH_CONST_Attr( pNode, pAttr )
+	{
+		if( pAttr->first == "CacheVersion" )
+			continue;
+		CacheEntry entry;
+		entry.iHash = pAttr->second->GetValue<unsigned>();
+		if( entry.iHash != 0 )
+			m_Entries[pAttr->first] = entry;
+	}
+	LOG->Trace( "Imported %i entries from the old song cache index.", (int) m_Entries.size() );
+	return iCacheVersion;
+}
+
+/* Replace the log with one record per entry. */
+void SongCacheIndex::WriteLog()
+{
+	RString sBuf( INDEX_MAGIC, sizeof(INDEX_MAGIC) );
+	WriteU32( sBuf, INDEX_FORMAT_VERSION );
+	WriteU32( sBuf, FILE_CACHE_VERSION );
+	for( auto const &it : m_Entries )
+		PutRecord( sBuf, it.first, it.second.iHash, it.second.bHasStamp, it.second.iStamp, it.second.vsFiles );
+
+	m_sPendingRecords = RString();
+	m_iNumRecords = m_Entries.size();
+
+	RageFile f;
+	if( !f.Open(CACHE_INDEX_LOG, RageFile::WRITE) || f.Write(sBuf) == -1 || f.Flush() == -1 )
+		LOG->Warn( "Couldn't write the song cache index \"%s\": %s", CACHE_INDEX_LOG.c_str(), f.GetError().c_str() );
+}
+
+void SongCacheIndex::FlushPendingRecords()
+{
+	if( m_sPendingRecords.empty() )
+		return;
+
+	RageFile f;
+	if( !f.Open(CACHE_INDEX_LOG, RageFile::WRITE|RageFile::STREAMED|RageFile::APPEND) )
+	{
+		/* The cache is on a driver that can't append; the map already holds
+		 * the pending records, so write the whole log from it. */
+		WriteLog();
+		return;
+	}
+	if( f.Write(m_sPendingRecords) == -1 || f.Flush() == -1 )
+		LOG->Warn( "Couldn't append to the song cache index \"%s\": %s", CACHE_INDEX_LOG.c_str(), f.GetError().c_str() );
+	m_sPendingRecords = RString();
+}
+
+static bool LogNeedsCompaction( std::size_t iNumRecords, std::size_t iNumEntries )
+{
+	return iNumRecords > iNumEntries*2 + 1024;
+}
+
+void SongCacheIndex::ReadCacheIndex()
+{
+	LockMut( m_Mutex );
+	m_Entries.clear();
+	m_sPendingRecords = RString();
+	m_iNumRecords = 0;
 
-	LOG->Trace( "Cache format is out of date.  Deleting all cache files." );
-	EmptyDir( SpecialFiles::CACHE_DIR );
-	EmptyDir( SpecialFiles::CACHE_DIR+"Songs/" );
-	EmptyDir( SpecialFiles::CACHE_DIR+"Courses/" );
+	bool bNeedRewrite = false;
+	bool bImported = false;
+	int iCacheVersion = ReadLog( bNeedRewrite );
+	if( iCacheVersion == -1 && DoesFileExist(CACHE_INDEX_INI) )
+	{
+		iCacheVersion = ImportIniIndex();
+		bImported = true;
+		bNeedRewrite = true;
+	}
+
+	if( iCacheVersion != FILE_CACHE_VERSION )
+	{
+		LOG->Trace( "Cache format is out of date.  Deleting all cache files." );
+		EmptyDir( SpecialFiles::CACHE_DIR );
+		EmptyDir( SpecialFiles::CACHE_DIR+"Songs/" );
+		EmptyDir( SpecialFiles::CACHE_DIR+"Courses/" );
 
-	std::vector<RString> ImageDir;
-	split( CommonMetrics::IMAGES_TO_CACHE, ",", ImageDir );
-	for( unsigned c=0; c<ImageDir.size(); c++ )
-		EmptyDir( SpecialFiles::CACHE_DIR+ImageDir[c]+"/" );
+		std::vector<RString> ImageDir;
+		split( CommonMetrics::IMAGES_TO_CACHE, ",", ImageDir );
+		for( unsigned c=0; c<ImageDir.size(); c++ )
+			EmptyDir( SpecialFiles::CACHE_DIR+ImageDir[c]+"/" );
 
-	CacheIndex.Clear();
-	/* This is right now in place because our song file paths are apparently being
-	 * cached in two distinct areas, and songs were loading from paths in FILEMAN.
-	 * This is admittedly a hack for now, but this does bring up a good question on
-	 * whether we really need a dedicated cache for future versions of StepMania.
-	 */
-	FILEMAN->FlushDirCache();
+		m_Entries.clear();
+		bNeedRewrite = true;
+		/* This is right now in place because our song file paths are apparently being
+		 * cached in two distinct areas, and songs were loading from paths in FILEMAN.
+		 * This is admittedly a hack for now, but this does bring up a good question on
+		 * whether we really need a dedicated cache for future versions of StepMania.
+		 */
+		FILEMAN->FlushDirCache();
+	}
+
+	if( bNeedRewrite || LogNeedsCompaction(m_iNumRecords, m_Entries.size()) )
+		WriteLog();
+	if( bImported )
+		FILEMAN->Remove( CACHE_INDEX_INI );
 }
 
 void SongCacheIndex::SaveCacheIndex()
 {
-	CacheIndex.WriteFile(CACHE_INDEX);
+	LockMut( m_Mutex );
+	if( LogNeedsCompaction(m_iNumRecords, m_Entries.size()) )
+		WriteLog();
+	else
+		FlushPendingRecords();
 }
 
-void SongCacheIndex::AddCacheIndex(const RString &path, unsigned hash)
+void SongCacheIndex::SetEntry( const RString &path, const CacheEntry &entry )
 {
-	if( hash == 0 )
-		++hash; /* no 0 hash values */
-	CacheIndex.SetValue( "Cache", "CacheVersion", FILE_CACHE_VERSION );
-	CacheIndex.SetValue( "Cache", MangleName(path), hash );
+	LockMut( m_Mutex );
+	CacheEntry &old = m_Entries[path];
+	if( old.iHash == entry.iHash && old.bHasStamp == entry.bHasStamp &&
+		old.iStamp == entry.iStamp && old.vsFiles == entry.vsFiles )
+		return;
+	old = entry;
+
+	PutRecord( m_sPendingRecords, path, entry.iHash, entry.bHasStamp, entry.iStamp, entry.vsFiles );
+	++m_iNumRecords;
 	if(!delay_save_cache)
 	{
-		CacheIndex.WriteFile(CACHE_INDEX);
+		SaveCacheIndex();
 	}
 }
 
+void SongCacheIndex::AddCacheIndex(const RString &path, unsigned hash)
+{
+	CacheEntry entry;
+	entry.iHash = hash == 0? 1:hash; /* no 0 hash values */
+	SetEntry( path, entry );
+}
+
+void SongCacheIndex::AddCacheIndex( const RString &path, unsigned hash, const std::vector<RString> &vsFiles )
+{
+	CacheEntry entry;
+	entry.iHash = hash == 0? 1:hash; /* no 0 hash values */
+	entry.vsFiles = vsFiles;
+	entry.bHasStamp = GetStampForDirectory( path, vsFiles, entry.iStamp );
+	SetEntry( path, entry );
+}
+
 unsigned SongCacheIndex::GetCacheHash( const RString &path ) const
 {
-	unsigned iDirHash = 0;
-	if( !CacheIndex.GetValue( "Cache", MangleName(path), iDirHash ) )
+	LockMut( m_Mutex );
+	auto it = m_Entries.find( path );
+	if( it == m_Entries.end() )
 		return 0;
-	if( iDirHash == 0 )
-		++iDirHash; /* no 0 hash values */
-	return iDirHash;
+	return it->second.iHash;
 }
 
-RString SongCacheIndex::MangleName( const RString &Name )
+bool SongCacheIndex::IsDirectoryUnchanged( const RString &sDir )
 {
-	/* We store paths in an INI.  We can't store '='. */
-	RString ret = Name;
-	ret.Replace( "=", "");
-	return ret;
+	CacheEntry entry;
+	{
+		LockMut( m_Mutex );
+		auto it = m_Entries.find( sDir );
+		if( it == m_Entries.end() )
+			return false;
+		entry = it->second;
+	}
+
+	unsigned iStamp = 0;
+	const bool bHasStamp = GetStampForDirectory( sDir, entry.vsFiles, iStamp );
+	if( bHasStamp && entry.bHasStamp && iStamp == entry.iStamp )
+		return true;
+
+	unsigned iHash = GetHashForDirectory( sDir );
+	if( iHash == 0 )
+		++iHash; /* no 0 hash values */
+	if( iHash != entry.iHash )
+		return false;
+
+	/* Touched, but nothing we hash changed.  Take a new snapshot so the next
+	 * check is cheap again. */
+	entry.bHasStamp = bHasStamp;
+	entry.iStamp = iStamp;
+	SetEntry( sDir, entry );
+	return true;
 }
 
 /*
@@ -1,12 +1,42 @@
 #ifndef SONG_CACHE_INDEX_H
 #define SONG_CACHE_INDEX_H
 
-#include "IniFile.h"
+#include "RageThreads.h"
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 class SongCacheIndex
 {
-	IniFile CacheIndex;
-	static RString MangleName( const RString &Name );
+	struct CacheEntry
+	{
+		CacheEntry(): iHash(0), bHasStamp(false), iStamp(0) { }
+		/* GetHashForDirectory (or GetHashForFile, for courses). */
+		unsigned iHash;
+		/* GetStampForDirectory over vsFiles, taken along with iHash. */
+		bool bHasStamp;
+		unsigned iStamp;
+		std::vector<RString> vsFiles;
+	};
+
+	/* Entry for each song or course path.  On disk this is an append-only
+	 * log of records; the last record for a path wins. */
+	std::unordered_map<std::string, CacheEntry> m_Entries;
+	/* Records not yet appended to the log, while delay_save_cache is set. */
+	RString m_sPendingRecords;
+	/* Records in the log, including pending ones.  Once this gets well past
+	 * m_Entries.size(), the log is rewritten from scratch. */
+	std::size_t m_iNumRecords;
+	/* Songs may be loaded from several threads at once. */
+	mutable RageMutex m_Mutex;
+
+	int ReadLog( bool &bNeedRewrite );
+	int ImportIniIndex();
+	void WriteLog();
+	void FlushPendingRecords();
+	void SetEntry( const RString &path, const CacheEntry &entry );
 
 public:
 	SongCacheIndex();
@@ -17,7 +47,14 @@ public:
 	void ReadCacheIndex();
 	void SaveCacheIndex();
 	void AddCacheIndex( const RString &path, unsigned hash );
+	/* As above, and also take a stat snapshot of the song directory path and
+	 * vsFiles, the files its data was loaded from. */
+	void AddCacheIndex( const RString &path, unsigned hash, const std::vector<RString> &vsFiles );
 	unsigned GetCacheHash( const RString &path ) const;
+	/* True if the song directory sDir still has the hash it was added with.
+	 * When the stat snapshot still matches, the directory isn't listed or
+	 * hashed at all. */
+	bool IsDirectoryUnchanged( const RString &sDir );
 	bool delay_save_cache;
 };
 
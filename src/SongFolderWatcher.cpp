@@ -0,0 +1,281 @@
+#include "global.h"
+#include "SongFolderWatcher.h"
+#include "PrefsManager.h"
+#include "RageFileDriverDirectHelpers.h"
+#include "RageFileManager.h"
+#include "RageLog.h"
+#include "RageUtil.h"
+#include "RageUtil_ThreadPool.h"
+#include "Song.h"
+#include "SpecialFiles.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <sys/stat.h>
+
+#if defined(HAVE_SYS_INOTIFY_H)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+/* Copying a song in takes a while; don't load it until it has been left
+ * alone for this long. */
+static const float QUIET_SECONDS = 2.0f;
+
+static RString SongsRoot()
+{
+	return "/" + SpecialFiles::SONGS_DIR;
+}
+
+SongFolderWatcher::SongFolderWatcher():
+	m_bShutdown( false ),
+	m_Mutex( "SongFolderWatcher" )
+{
+	m_iFD = -1;
+}
+
+SongFolderWatcher::~SongFolderWatcher()
+{
+	if( m_Thread.IsCreated() )
+	{
+		m_bShutdown = true;
+		LOG->Trace( "Shutting down song folder watcher thread ..." );
+		m_Thread.Wait();
+		LOG->Trace( "Song folder watcher thread shut down." );
+	}
+
+#if defined(HAVE_SYS_INOTIFY_H)
+	if( m_iFD != -1 )
+		close( m_iFD );
+#endif
+
+	for( Song *pSong : m_vpLoadedSongs )
+		delete pSong;
+}
+
+bool SongFolderWatcher::Start( const std::vector<RString> &vsLoadedDirs )
+{
+#if defined(HAVE_SYS_INOTIFY_H)
+	ASSERT( !m_Thread.IsCreated() );
+
+	m_iFD = inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
+	if( m_iFD == -1 )
+	{
+		LOG->Warn( "Couldn't watch song folders: inotify_init1: %s", strerror(errno) );
+		return false;
+	}
+
+	for( RString sDir : vsLoadedDirs )
+	{
+		sDir.MakeLower();
+		m_sKnownDirs.insert( sDir );
+	}
+
+	/* Every real folder that shows up under /Songs/ gets a watch: the game's
+	 * own Songs folder is under a "/" mount, AdditionalSongFolders are
+	 * mounted at /Songs/ itself. */
+	const RString sRoot = SongsRoot();
+	std::vector<RageFileManager::DriverLocation> vMounts;
+	FILEMAN->GetLoadedDrivers( vMounts );
+	for( RageFileManager::DriverLocation const &l : vMounts )
+	{
+		if( l.Type != "dir" && l.Type != "dirro" )
+			continue;
+		if( sRoot.Left(l.MountPoint.size()).CompareNoCase(l.MountPoint) )
+			continue;
+		const RString sOSRoot = l.Root + "/" + sRoot.substr( l.MountPoint.size() );
+		AddWatch( sOSRoot, sRoot, 0 );
+
+		std::vector<RString> vsGroups;
+		GetDirListing( sRoot + "*", vsGroups, true, false );
+		for( RString const &sGroup : vsGroups )
+			AddWatch( sOSRoot + sGroup + "/", sRoot + sGroup + "/", 1 );
+	}
+
+	if( m_Watches.empty() )
+	{
+		close( m_iFD );
+		m_iFD = -1;
+		return false;
+	}
+
+	LOG->Trace( "Watching %i song folders for new songs.", (int) m_Watches.size() );
+	m_bShutdown = false;
+	m_Thread.SetName( "Song folder watcher" );
+	m_Thread.Create( WatcherThread_Start, this );
+	return true;
+#else
+	return false;
+#endif
+}
+
+void SongFolderWatcher::GetLoadedSongs( std::vector<Song*> &vpOut )
+{
+	LockMut( m_Mutex );
+	vpOut.insert( vpOut.end(), m_vpLoadedSongs.begin(), m_vpLoadedSongs.end() );
+	m_vpLoadedSongs.clear();
+}
+
+void SongFolderWatcher::AddWatch( const RString &sOSDir, const RString &sDir, int iDepth )
+{
+#if defined(HAVE_SYS_INOTIFY_H)
+	/* Listings are merged across mounts, so sDir may only exist in
+	 * another one. */
+	struct stat st;
+	if( DoStat(sOSDir, &st) == -1 || !S_ISDIR(st.st_mode) )
+		return;
+
+	uint32_t iMask = IN_ONLYDIR | IN_CREATE | IN_MOVED_TO;
+	if( iDepth == 2 )
+		iMask |= IN_CLOSE_WRITE | IN_DELETE;
+
+	const int iWatch = inotify_add_watch( m_iFD, sOSDir.c_str(), iMask );
+	if( iWatch == -1 )
+	{
+		LOG->Warn( "Couldn't watch \"%s\": %s", sOSDir.c_str(), strerror(errno) );
+		return;
+	}
+
+	Watch w = { sOSDir, sDir, iDepth };
+	m_Watches[iWatch] = w;
+#endif
+}
+
+/* A folder was created or moved in.  Anything inside it may have been
+ * copied before the watch was in place, so look at what's already there. */
+void SongFolderWatcher::AddNewFolder( const RString &sOSDir, const RString &sDir, int iDepth )
+{
+	if( iDepth > 2 )
+		return;
+
+	AddWatch( sOSDir, sDir, iDepth );
+	FILEMAN->FlushDirCache( sDir );
+
+	if( iDepth == 1 )
+	{
+		std::vector<RString> vsSongs;
+		GetDirListing( sDir + "*", vsSongs, true, false );
+		StripCvsAndSvn( vsSongs );
+		StripMacResourceForks( vsSongs );
+		for( RString const &sSong : vsSongs )
+			AddNewFolder( sOSDir + sSong + "/", sDir + sSong + "/", 2 );
+	}
+	else if( iDepth == 2 )
+	{
+		RString sLower = sDir;
+		sLower.MakeLower();
+		if( m_sKnownDirs.find(sLower) == m_sKnownDirs.end() )
+			m_PendingDirs[sDir].Touch();
+	}
+}
+
+void SongFolderWatcher::ReadEvents()
+{
+#if defined(HAVE_SYS_INOTIFY_H)
+	alignas(struct inotify_event) char buf[4096];
+	for(;;)
+	{
+		const ssize_t iGot = read( m_iFD, buf, sizeof(buf) );
+		if( iGot <= 0 )
+			break;
+
+		for( const char *p = buf; p < buf + iGot; )
+		{
+			const struct inotify_event *ev = reinterpret_cast<const struct inotify_event *>( p );
+			p += sizeof(struct inotify_event) + ev->len;
+
+			if( ev->mask & IN_Q_OVERFLOW )
+			{
+				LOG->Warn( "Song folder watcher missed events; use Reload Songs to pick up anything new." );
+				continue;
+			}
+
+			std::map<int, Watch>::iterator it = m_Watches.find( ev->wd );
+			if( it == m_Watches.end() )
+				continue;
+			if( ev->mask & IN_IGNORED )
+			{
+				m_Watches.erase( it );
+				continue;
+			}
+
+			/* Copy it; AddNewFolder may add to m_Watches. */
+			const Watch w = it->second;
+			const RString sName = ev->len? RString( ev->name ):RString();
+			if( w.iDepth == 2 )
+			{
+				RString sLower = w.sDir;
+				sLower.MakeLower();
+				if( m_sKnownDirs.find(sLower) == m_sKnownDirs.end() )
+					m_PendingDirs[w.sDir].Touch();
+			}
+			else if( (ev->mask & IN_ISDIR) && !sName.empty() && sName[0] != '.' )
+			{
+				AddNewFolder( w.sOSDir + sName + "/", w.sDir + sName + "/", w.iDepth + 1 );
+			}
+		}
+	}
+#endif
+}
+
+void SongFolderWatcher::LoadQuietFolders()
+{
+	std::vector<RString> vsDirs;
+	for( std::map<RString, RageTimer>::iterator it = m_PendingDirs.begin(); it != m_PendingDirs.end(); )
+	{
+		if( it->second.Ago() < QUIET_SECONDS )
+		{
+			++it;
+			continue;
+		}
+		vsDirs.push_back( it->first );
+		m_PendingDirs.erase( it++ );
+	}
+	if( vsDirs.empty() )
+		return;
+
+	std::vector<Song*> vpSongs( vsDirs.size(), nullptr );
+	for( RString const &sDir : vsDirs )
+		FILEMAN->FlushDirCache( sDir );
+
+	RageThreadPool pool( "Song folder watcher", PREFSMAN->m_iSongLoadThreads );
+	pool.Run( vsDirs.size(),
+		[&]( std::size_t i )
+		{
+			Song *pSong = new Song;
+			if( !pSong->LoadFromSongDir(vsDirs[i]) )
+			{
+				// Probably still incomplete; the next write will queue it again.
+				delete pSong;
+				return;
+			}
+			vpSongs[i] = pSong;
+		} );
+
+	LockMut( m_Mutex );
+	for( std::size_t i = 0; i < vsDirs.size(); ++i )
+	{
+		if( vpSongs[i] == nullptr )
+			continue;
+		LOG->Trace( "Song folder watcher loaded \"%s\".", vsDirs[i].c_str() );
+		RString sLower = vsDirs[i];
+		sLower.MakeLower();
+		m_sKnownDirs.insert( sLower );
+		m_vpLoadedSongs.push_back( vpSongs[i] );
+	}
+}
+
+void SongFolderWatcher::WatcherThread()
+{
+#if defined(HAVE_SYS_INOTIFY_H)
+	while( !m_bShutdown )
+	{
+		struct pollfd pfd = { m_iFD, POLLIN, 0 };
+		if( poll(&pfd, 1, 250) > 0 )
+			ReadEvents();
+		LoadQuietFolders();
+	}
+#endif
+}
@@ -0,0 +1,75 @@
+/* SongFolderWatcher - Loads song folders copied in while the game is running. */
+
+#ifndef SONG_FOLDER_WATCHER_H
+#define SONG_FOLDER_WATCHER_H
+
+#include "RageThreads.h"
+#include "RageTimer.h"
+
+#include <atomic>
+#include <map>
+#include <set>
+#include <vector>
+
+class Song;
+
+/* Watches the real folders mounted at /Songs/ (the Songs folder and any
+ * AdditionalSongFolders) for new group and song folders.  A new song folder
+ * is loaded on the watcher's thread once nothing has been written to it for
+ * a moment, and is then held until SongManager collects it with
+ * GetLoadedSongs() at a point where nothing is walking the song lists.
+ *
+ * Only folders that aren't loaded yet are picked up; changes to songs that
+ * are already loaded still need a reload.  This is only implemented with
+ * inotify; elsewhere Start() fails and LoadAdditions rescans as before. */
+class SongFolderWatcher
+{
+public:
+	SongFolderWatcher();
+	~SongFolderWatcher();
+
+	/* vsLoadedDirs are the song directories that are already loaded. */
+	bool Start( const std::vector<RString> &vsLoadedDirs );
+
+	/* Move songs loaded since the last call into vpOut.  The caller owns
+	 * them. */
+	void GetLoadedSongs( std::vector<Song*> &vpOut );
+
+private:
+	static int WatcherThread_Start( void *p ) { ((SongFolderWatcher *) p)->WatcherThread(); return 0; }
+	void WatcherThread();
+
+	/* Depth below /Songs/: 0 is the root, 1 a group, 2 a song. */
+	void AddWatch( const RString &sOSDir, const RString &sDir, int iDepth );
+	void AddNewFolder( const RString &sOSDir, const RString &sDir, int iDepth );
+	void ReadEvents();
+	void LoadQuietFolders();
+
+	int m_iFD;
+	struct Watch
+	{
+		RString sOSDir;
+		RString sDir;
+		int iDepth;
+	};
+	std::map<int, Watch> m_Watches;
+
+	/* Song directories with unloaded changes, and when each last changed.
+	 * Only touched by the watcher thread. */
+	std::map<RString, RageTimer> m_PendingDirs;
+	/* Lowercased song directories that are loaded or have been handed out. */
+	std::set<RString> m_sKnownDirs;
+
+	RageThread m_Thread;
+	std::atomic<bool> m_bShutdown;
+
+	/* Protects m_vpLoadedSongs. */
+	RageMutex m_Mutex;
+	std::vector<Song*> m_vpLoadedSongs;
+
+	// Swallow up warnings. If they must be used, define them.
+	SongFolderWatcher& operator=(const SongFolderWatcher& rhs);
+	SongFolderWatcher(const SongFolderWatcher& rhs);
+};
+
+#endif
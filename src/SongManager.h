@@ -3,6 +3,7 @@
 
 class LoadingWindow;
 class Song;
+class SongFolderWatcher;
 class Style;
 class Steps;
 class PlayerOptions;
@@ -17,6 +18,7 @@ struct lua_State;
 #include "Course.h"
 #include "ThemeMetric.h"
 #include "RageTexturePreloader.h"
+#include "RageThreads.h"
 #include "RageUtil.h"
 
 #include <cstddef>
@@ -90,8 +92,16 @@ public:
 	void InitAll( LoadingWindow *ld, bool onlyAdditions );
 	void Reload( bool bAllowFastLoad, LoadingWindow *ld=nullptr );
 	void LoadAdditions( LoadingWindow *ld=nullptr );
+	/**
+	 * @brief Add the songs the song folder watcher has loaded since the
+	 *        last call.  Only call this while nothing is walking the song
+	 *        lists, e.g. before building a music wheel.
+	 * @return true if any songs were added
+	 */
+	bool AddWatchedSongs();
 	void PreloadSongImages();
 
+	/** @brief Safe to call from the song folder watcher's thread. */
 	bool IsGroupNeverCached(const RString& group) const;
 
 	RString GetSongGroupBannerPath( RString sSongGroup ) const;
@@ -216,10 +226,15 @@ protected:
 	int GetNumEditsLoadedFromProfile( ProfileSlot slot ) const;
 
 	void AddSongToList(Song* new_song);
+	void StartFolderWatcher();
+	/** @brief Loads new song folders in the background, if enabled. */
+	SongFolderWatcher *m_pFolderWatcher;
 	/** @brief All of the songs that can be played. */
 	std::vector<Song*>		m_pSongs;
 	std::map<RString, Song*> m_SongsByDir;
 	std::set<RString> m_GroupsToNeverCache;
+	/** @brief Guards m_GroupsToNeverCache, which background loads read. */
+	mutable RageMutex m_GroupsToNeverCacheMutex;
 
 	/** @brief Hold pointers to all the songs that have been deleted from disk but must at least be kept temporarily alive for smooth audio transitions. */
 	std::vector<Song*>	m_pDeletedSongs;
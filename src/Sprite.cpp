@@ -5,6 +5,7 @@
 #include "RageLog.h"
 #include "RageDisplay.h"
 #include "RageTexture.h"
+#include "RageMath.h"
 #include "RageTimer.h"
 #include "RageUtil.h"
 #include "ActorUtil.h"
@@ -536,6 +537,42 @@ void TexCoordArrayFromRect( float fImageCoords[8], const RectF &rect )
 	fImageCoords[6] = rect.right;	fImageCoords[7] = rect.top;	// top right
 }
 
+/* If pTexture was copied into an atlas page, move the texture coordinates
+ * of v onto the page, through the current texture matrix, and return the
+ * page.  The page doesn't repeat the image, so this only works if every
+ * coordinate lands inside the image; otherwise v is left alone. */
+static RageTexture *MapToAtlasPage( const RageTexture *pTexture, RageSpriteVertex v[4] )
+{
+	RageTexture *pPage = pTexture->GetAtlasPage();
+	if( pPage == nullptr )
+		return nullptr;
+
+	// Texture coordinates over the image area, which is all the page has.
+	const float fScaleX = float(pTexture->GetTextureWidth()) / pTexture->GetImageWidth();
+	const float fScaleY = float(pTexture->GetTextureHeight()) / pTexture->GetImageHeight();
+	const RageMatrix *pTextureMatrix = DISPLAY->GetTextureTop();
+	const float fEpsilon = 0.0001f;
+
+	RageVector2 t[4];
+	for( int i = 0; i < 4; ++i )
+	{
+		RageVector4 in( v[i].t.x, v[i].t.y, 0, 1 ), out;
+		RageVec4TransformCoord( &out, &in, pTextureMatrix );
+		t[i].x = out.x * fScaleX;
+		t[i].y = out.y * fScaleY;
+		if( t[i].x < -fEpsilon || t[i].x > 1+fEpsilon || t[i].y < -fEpsilon || t[i].y > 1+fEpsilon )
+			return nullptr;
+	}
+
+	const RectF &rect = pTexture->GetAtlasRect();
+	for( int i = 0; i < 4; ++i )
+	{
+		v[i].t.x = SCALE( t[i].x, 0.f, 1.f, rect.left, rect.right );
+		v[i].t.y = SCALE( t[i].y, 0.f, 1.f, rect.top, rect.bottom );
+	}
+	return pPage;
+}
+
 void Sprite::DrawTexture( const TweenState *state )
 {
 	Actor::SetGlobalRenderStates(); // set Actor-specified render states
@@ -586,14 +623,6 @@ void Sprite::DrawTexture( const TweenState *state )
 		}
 	}
 
-	DISPLAY->ClearAllTextures();
-	DISPLAY->SetTexture( TextureUnit_1, m_pTexture? m_pTexture->GetTexHandle():0 );
-
-	// Must call this after setting the texture or else texture
-	// parameters have no effect.
-	Actor::SetTextureRenderStates(); // set Actor-specified render states
-	DISPLAY->SetEffectMode( m_EffectMode );
-
 	if( m_pTexture )
 	{
 		float f[8];
@@ -636,6 +665,28 @@ void Sprite::DrawTexture( const TweenState *state )
 			v[i].t.x = v[i].t.y = 0;
 	}
 
+	RageTexture *pAtlasPage = nullptr;
+	if( m_pTexture && !m_bTextureWrapping && m_EffectMode == EffectMode_Normal )
+		pAtlasPage = MapToAtlasPage( m_pTexture, v );
+
+	// Don't clear the first unit in between, or every sprite ends the quad batch.
+	if( pAtlasPage )
+		DISPLAY->SetSingleTexture( pAtlasPage->GetTexHandle() );
+	else
+		DISPLAY->SetSingleTexture( m_pTexture? m_pTexture->GetTexHandle():0 );
+
+	// Must call this after setting the texture or else texture
+	// parameters have no effect.
+	Actor::SetTextureRenderStates(); // set Actor-specified render states
+	DISPLAY->SetEffectMode( m_EffectMode );
+
+	// MapToAtlasPage already applied the texture matrix.
+	if( pAtlasPage )
+	{
+		DISPLAY->TexturePushMatrix();
+		DISPLAY->TextureLoadIdentity();
+	}
+
 	// Draw if we're not fully transparent
 	if( state->diffuse[0].a > 0 ||
 		state->diffuse[1].a > 0 ||
@@ -671,6 +722,8 @@ void Sprite::DrawTexture( const TweenState *state )
 		v[0].c = v[1].c = v[2].c = v[3].c = state->glow;
 		DISPLAY->DrawQuad( v );
 	}
+	if( pAtlasPage )
+		DISPLAY->TexturePopMatrix();
 	DISPLAY->SetEffectMode( EffectMode_Normal );
 }
 
@@ -53,6 +53,7 @@
 #include "InputMapper.h"
 #include "InputQueue.h"
 #include "SongCacheIndex.h"
+#include "ChartResidencyManager.h"
 #include "ImageCache.h"
 #include "UnlockManager.h"
 #include "RageFileManager.h"
@@ -315,6 +316,7 @@ void ShutdownGame()
 	RageUtil::SafeDelete( CRYPTMAN );
 	RageUtil::SafeDelete( MEMCARDMAN );
 	RageUtil::SafeDelete( SONGMAN );
+	RageUtil::SafeDelete( CHARTRESIDENCY ); // after SONGMAN, which owns the Steps
 	RageUtil::SafeDelete( IMAGECACHE );
 	RageUtil::SafeDelete( SONGINDEX );
 	RageUtil::SafeDelete( SOUND ); // uses GAMESTATE, PREFSMAN
@@ -992,6 +994,7 @@ int sm_main(int argc, char* argv[])
 
 	INPUTQUEUE	= new InputQueue;
 	SONGINDEX	= new SongCacheIndex;
+	CHARTRESIDENCY	= new ChartResidencyManager;
 	IMAGECACHE	= new ImageCache;
 
 	// depends on SONGINDEX:
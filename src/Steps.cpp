@@ -13,6 +13,7 @@
  * memory. */
 #include "global.h"
 #include "Steps.h"
+#include "ChartResidencyManager.h"
 #include "StepsUtil.h"
 #include "GameState.h"
 #include "Song.h"
@@ -22,6 +23,7 @@
 #include "GameManager.h"
 #include "SongManager.h"
 #include "NoteDataUtil.h"
+#include "RageFile.h"
 #include "NotesLoaderSSC.h"
 #include "NotesLoaderSM.h"
 #include "NotesLoaderSMA.h"
@@ -50,7 +52,9 @@ LuaXType( DisplayBPM );
 
 Steps::Steps(Song *song): m_StepsType(StepsType_Invalid), m_pSong(song),
 	parent(nullptr), m_pNoteData(new NoteData), m_bNoteDataIsFilled(false),
-	m_sNoteDataCompressed(""), m_sFilename(""), m_bSavedToDisk(false),
+	m_sNoteDataCompressed(""), m_sFilename(""),
+	m_iCacheNoteOffset(0), m_iCacheNoteSize(0), m_iCacheNoteHash(0),
+	m_bSavedToDisk(false),
 	m_LoadedFromProfile(ProfileSlot_Invalid), m_iHash(0),
 	m_sDescription(""), m_sChartStyle(""),
 	m_Difficulty(Difficulty_Invalid), m_iMeter(0),
@@ -60,6 +64,8 @@ Steps::Steps(Song *song): m_StepsType(StepsType_Invalid), m_pSong(song),
 
 Steps::~Steps()
 {
+	if( CHARTRESIDENCY )
+		CHARTRESIDENCY->Released( this );
 }
 
 void Steps::GetDisplayBpms( DisplayBpms &AddTo ) const
@@ -89,19 +95,18 @@ unsigned Steps::GetHash() const
 		return parent->GetHash();
 	if( m_iHash )
 		return m_iHash;
-	if( m_sNoteDataCompressed.empty() )
-	{
-		if( !m_bNoteDataIsFilled )
-			return 0; // No data, no hash.
-		NoteDataUtil::GetSMNoteDataString( *m_pNoteData, m_sNoteDataCompressed );
-	}
-	m_iHash = GetHashForString( m_sNoteDataCompressed );
+	RString sSMNoteData;
+	GetSMNoteData( sSMNoteData );
+	if( sSMNoteData.empty() )
+		return 0; // No data, no hash.
+	m_iHash = GetHashForString( sSMNoteData );
 	return m_iHash;
 }
 
 bool Steps::IsNoteDataEmpty() const
 {
-	return this->m_sNoteDataCompressed.empty();
+	return this->m_sNoteDataCompressed.empty() && m_sNoteDataPacked.empty() &&
+		!m_bNoteDataIsFilled && m_iCacheNoteSize == 0;
 }
 
 bool Steps::GetNoteDataFromSimfile()
@@ -181,8 +186,13 @@ void Steps::SetNoteData( const NoteData& noteDataNew )
 
 	*m_pNoteData = noteDataNew;
 	m_bNoteDataIsFilled = true;
+	// This can't be decompressed again, so it mustn't be evicted.
+	if( CHARTRESIDENCY )
+		CHARTRESIDENCY->Released( this );
 
 	m_sNoteDataCompressed = RString();
+	m_sNoteDataPacked = RString();
+	m_iCacheNoteSize = 0;
 	m_iHash = 0;
 }
 
@@ -212,11 +222,56 @@ void Steps::SetSMNoteData( const RString &notes_comp_ )
 {
 	m_pNoteData->Init();
 	m_bNoteDataIsFilled = false;
+	if( CHARTRESIDENCY )
+		CHARTRESIDENCY->Released( this );
 
 	m_sNoteDataCompressed = notes_comp_;
+	m_sNoteDataPacked = RString();
+	m_iCacheNoteSize = 0;
 	m_iHash = 0;
 }
 
+void Steps::SetCacheNoteData( unsigned iOffset, unsigned iSize, unsigned iPackedHash, unsigned iHash )
+{
+	m_iCacheNoteOffset = iOffset;
+	m_iCacheNoteSize = iSize;
+	m_iCacheNoteHash = iPackedHash;
+	m_iHash = iHash;
+}
+
+bool Steps::LoadFromPackedNoteData( const RString &sPacked ) const
+{
+	m_pNoteData->Init();
+	if( !NoteDataUtil::LoadFromPackedNoteDataString(*m_pNoteData, sPacked) ||
+		m_pNoteData->GetNumTracks() != GAMEMAN->GetStepsTypeInfo(m_StepsType).iNumTracks )
+	{
+		m_pNoteData->Init();
+		return false;
+	}
+	m_bNoteDataIsFilled = true;
+	return true;
+}
+
+bool Steps::GetNoteDataFromCache( RString &sOut ) const
+{
+	if( m_iCacheNoteSize == 0 || m_pSong == nullptr )
+		return false;
+
+	RageFile f;
+	if( f.Open(m_pSong->GetCacheFilePath()) &&
+		f.Seek(m_iCacheNoteOffset) == static_cast<int>(m_iCacheNoteOffset) &&
+		f.Read(sOut, m_iCacheNoteSize) == static_cast<int>(m_iCacheNoteSize) &&
+		GetHashForString(sOut) == m_iCacheNoteHash )
+		return true;
+
+	/* The cache file was rewritten or removed after we were loaded.  Don't
+	 * try it again; the simfile still has the data. */
+	LOG->Trace( "Cache note data for \"%s\" is stale.", m_sFilename.c_str() );
+	m_iCacheNoteSize = 0;
+	sOut = RString();
+	return false;
+}
+
 /* XXX: this function should pull data from m_sFilename, like Decompress() */
 void Steps::GetSMNoteData( RString &notes_comp_out ) const
 {
@@ -224,6 +279,15 @@ void Steps::GetSMNoteData( RString &notes_comp_out ) const
 	{
 		if( !m_bNoteDataIsFilled )
 		{
+			/* Unpack it from memory or the cache, but don't keep it around. */
+			RString sPacked = m_sNoteDataPacked;
+			NoteData nd;
+			if( (!sPacked.empty() || GetNoteDataFromCache(sPacked)) &&
+				NoteDataUtil::LoadFromPackedNoteDataString(nd, sPacked) )
+			{
+				NoteDataUtil::GetSMNoteDataString( nd, notes_comp_out );
+				return;
+			}
 			/* no data is no data */
 			notes_comp_out = "";
 			return;
@@ -377,7 +441,20 @@ bool stepstype_is_kickbox(StepsType st)
 void Steps::Decompress()
 {
 	if( m_bNoteDataIsFilled )
+	{
+		if( CHARTRESIDENCY )
+			CHARTRESIDENCY->Hit( this );
 		return;	// already decompressed
+	}
+
+	DecompressNoteData();
+
+	if( m_bNoteDataIsFilled && CHARTRESIDENCY )
+		CHARTRESIDENCY->Loaded( this, m_pNoteData->GetMemoryUsage() );
+}
+
+void Steps::DecompressNoteData()
+{
 
 	if( parent )
 	{
@@ -417,6 +494,18 @@ void Steps::Decompress()
 		return;
 	}
 
+	if( m_sNoteDataCompressed.empty() )
+	{
+		// Packed data is quicker to load than SM data, so prefer it.
+		if( !m_sNoteDataPacked.empty() && LoadFromPackedNoteData(m_sNoteDataPacked) )
+			return;
+
+		// Read just this chart out of the song's cache file.
+		RString sPacked;
+		if( GetNoteDataFromCache(sPacked) && LoadFromPackedNoteData(sPacked) )
+			return;
+	}
+
 	if( !m_sFilename.empty() && m_sNoteDataCompressed.empty() )
 	{
 		// We have NoteData on disk and not in memory. Load it.
@@ -460,7 +549,7 @@ void Steps::Compress() const
 		return;
 	}
 
-	if( !m_sFilename.empty() && m_LoadedFromProfile == ProfileSlot_Invalid )
+	if( (!m_sFilename.empty() || m_iCacheNoteSize != 0) && m_LoadedFromProfile == ProfileSlot_Invalid )
 	{
 		/* We have a file on disk; clear all data in memory.
 		 * Data on profiles can't be accessed normally (need to mount and time-out
@@ -469,23 +558,51 @@ void Steps::Compress() const
 		 * Also, Decompress() doesn't know how to load .edits. */
 		m_pNoteData->Init();
 		m_bNoteDataIsFilled = false;
+		if( CHARTRESIDENCY )
+			CHARTRESIDENCY->Released( this );
 
 		/* Be careful; 'x = ""', m_sNoteDataCompressed.clear() and m_sNoteDataCompressed.reserve(0)
 		 * don't always free the allocated memory. */
 		m_sNoteDataCompressed = RString();
+		m_sNoteDataPacked = RString();
 		return;
 	}
 
-	// We have no file on disk. Compress the data, if necessary.
-	if( m_sNoteDataCompressed.empty() )
+	// We have no file on disk. Pack the data; it's much smaller than SM data,
+	// and quicker to load back.
+	PackNoteData();
+}
+
+void Steps::PackNoteData() const
+{
+	if( m_sNoteDataPacked.empty() )
 	{
+		if( !m_bNoteDataIsFilled && !m_sNoteDataCompressed.empty() )
+			Decompress();
 		if( !m_bNoteDataIsFilled )
 			return; /* no data is no data */
-		NoteDataUtil::GetSMNoteDataString( *m_pNoteData, m_sNoteDataCompressed );
+		GetHash(); // it's computed from SM data, which is about to go
+		NoteDataUtil::GetPackedNoteDataString( *m_pNoteData, m_sNoteDataPacked );
 	}
 
+	m_sNoteDataCompressed = RString();
 	m_pNoteData->Init();
 	m_bNoteDataIsFilled = false;
+	if( CHARTRESIDENCY )
+		CHARTRESIDENCY->Released( this );
+}
+
+void Steps::GetPackedNoteData( RString &sOut ) const
+{
+	if( !m_bNoteDataIsFilled && !m_sNoteDataPacked.empty() )
+	{
+		sOut = m_sNoteDataPacked;
+		return;
+	}
+
+	NoteData nd;
+	GetNoteData( nd );
+	NoteDataUtil::GetPackedNoteDataString( nd, sOut );
 }
 
 /* Copy our parent's data. This is done when we're being changed from autogen
@@ -55,6 +55,10 @@ public:
 	void CreateBlank( StepsType ntTo );
 
 	void Compress() const;
+	/** @brief Keep only the packed form of the notes, even if they could be
+	 * read back from a file; they're unpacked again when they're needed. */
+	void PackNoteData() const;
+	void GetPackedNoteData( RString &sOut ) const;
 	void Decompress() const;
 	void Decompress();
 	/**
@@ -148,6 +152,14 @@ public:
 	void SetNoteData( const NoteData& noteDataNew );
 	void SetSMNoteData( const RString &notes_comp );
 	void GetSMNoteData( RString &notes_comp_out ) const;
+	/**
+	 * @brief Note where this chart's packed note data sits in its song's
+	 * cache file, so it can be read from there instead of parsing the simfile.
+	 * @param iOffset the byte offset into the cache file.
+	 * @param iSize the length of the note data.
+	 * @param iPackedHash GetHashForString of the packed note data.
+	 * @param iHash GetHash() of the chart. */
+	void SetCacheNoteData( unsigned iOffset, unsigned iSize, unsigned iPackedHash, unsigned iHash );
 
 	/**
 	 * @brief Retrieve the NoteData from the original source.
@@ -231,9 +243,20 @@ private:
 	mutable HiddenPtr<NoteData>	m_pNoteData;
 	mutable bool			m_bNoteDataIsFilled;
 	mutable RString			m_sNoteDataCompressed;
+	/* The idle form of charts with no file to reload from; see
+	 * NoteDataUtil::GetPackedNoteDataString. */
+	mutable RString			m_sNoteDataPacked;
 
 	/** @brief The name of the file where these steps are stored. */
 	RString				m_sFilename;
+	/** @brief Where the note data is in the song's cache file; a size of 0
+	 * means it isn't there. */
+	mutable unsigned		m_iCacheNoteOffset;
+	mutable unsigned		m_iCacheNoteSize;
+	unsigned			m_iCacheNoteHash;
+	bool GetNoteDataFromCache( RString &sOut ) const;
+	bool LoadFromPackedNoteData( const RString &sPacked ) const;
+	void DecompressNoteData();
 	/** @brief true if these Steps were loaded from or saved to disk. */
 	bool				m_bSavedToDisk;
 	/** @brief allows the steps to specify their own music file. */
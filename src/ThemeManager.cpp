@@ -7,6 +7,7 @@
 #include "IniFile.h"
 #include "RageTimer.h"
 #include "FontCharAliases.h"
+#include "FontCache.h"
 #include "arch/ArchHooks/ArchHooks.h"
 #include "arch/Dialog/Dialog.h"
 #include "RageFile.h"
@@ -453,6 +454,10 @@ void ThemeManager::SwitchThemeAndLanguage( const RString &sThemeName_, const RSt
 
 #endif
 
+		// Forget fonts compiled from the old theme; fonts.cache is read again.
+		FontCache::Save();
+		FontCache::Clear();
+
 		/* Lua globals can use metrics which are cached, and vice versa.  Update Lua
 		 * globals first; it's Lua's job to explicitly update cached metrics that it
 		 * uses. */
@@ -930,6 +935,8 @@ bool ThemeManager::HasString( const RString &sMetricsGroup, const RString &sValu
 void ThemeManager::ReloadMetrics()
 {
 	FILEMAN->FlushDirCache( GetCurThemeDir() );
+	FontCache::Save();
+	FontCache::Clear();
 
 	// Reloading Lua scripts can cause crashes; don't do this. -aj
 	//UpdateLuaGlobals();
@@ -7,53 +7,117 @@
 #include "ThemeManager.h"
 #include "NoteTypes.h"
 
+#include <algorithm>
 #include <cfloat>
+#include <climits>
 #include <cmath>
 #include <cstddef>
 #include <vector>
 
 
-static void EraseSegment(std::vector<TimingSegment*> &vSegs, int index, TimingSegment *cur);
 static const int INVALID_INDEX = -1;
 
 TimingSegment* GetSegmentAtRow( int iNoteRow, TimingSegmentType tst );
 
-TimingData::TimingData(float fOffset) : m_fBeat0OffsetInSeconds(fOffset)
+TimingData::TimingData(float fOffset) : m_fBeat0OffsetInSeconds(fOffset),
+	m_fLookupOffset(0), m_iLookupTimeHint(0), m_iLookupRowHint(0)
 {
 }
 
 void TimingData::Copy( const TimingData& cpy )
 {
-	/* de-allocate any old pointers we had */
-	Clear();
+	if( &cpy == this )
+		return;
+	ReleaseLookup();
 
 	m_fBeat0OffsetInSeconds = cpy.m_fBeat0OffsetInSeconds;
 	m_sFile = cpy.m_sFile;
 
+	// The other's segments are already sorted and tidied, so take them as
+	// they are rather than adding them one at a time.
 	FOREACH_TimingSegmentType( tst )
 	{
-		const std::vector<TimingSegment*> &vpSegs = cpy.m_avpTimingSegments[tst];
-
-		for( unsigned i = 0; i < vpSegs.size(); ++i )
-			AddSegment( vpSegs[i] );
+		WithSegmentArray( tst, [&]( auto pArray ) { this->*pArray = cpy.*pArray; } );
+		UpdateSegmentPointers( tst );
 	}
 }
 
 void TimingData::Clear()
 {
-	/* Delete all pointers owned by this TimingData. */
+	ReleaseLookup();
+
 	FOREACH_TimingSegmentType( tst )
 	{
-		std::vector<TimingSegment*> &vSegs = m_avpTimingSegments[tst];
-		for( unsigned i = 0; i < vSegs.size(); ++i )
-		{
-			RageUtil::SafeDelete( vSegs[i] );
-		}
+		WithSegmentArray( tst, [&]( auto pArray ) { (this->*pArray).clear(); } );
+		m_avpTimingSegments[tst].clear();
+	}
+}
 
-		vSegs.clear();
+template<typename Func>
+void TimingData::WithSegmentArray( TimingSegmentType tst, Func f )
+{
+	switch( tst )
+	{
+	case SEGMENT_BPM:	f( &TimingData::m_BPMSegments );		break;
+	case SEGMENT_STOP:	f( &TimingData::m_StopSegments );		break;
+	case SEGMENT_DELAY:	f( &TimingData::m_DelaySegments );		break;
+	case SEGMENT_TIME_SIG:	f( &TimingData::m_TimeSignatureSegments );	break;
+	case SEGMENT_WARP:	f( &TimingData::m_WarpSegments );		break;
+	case SEGMENT_LABEL:	f( &TimingData::m_LabelSegments );		break;
+	case SEGMENT_TICKCOUNT:	f( &TimingData::m_TickcountSegments );		break;
+	case SEGMENT_COMBO:	f( &TimingData::m_ComboSegments );		break;
+	case SEGMENT_SPEED:	f( &TimingData::m_SpeedSegments );		break;
+	case SEGMENT_SCROLL:	f( &TimingData::m_ScrollSegments );		break;
+	case SEGMENT_FAKE:	f( &TimingData::m_FakeSegments );		break;
+	default:		FAIL_M( ssprintf("Invalid timing segment type %i", tst) );
 	}
 }
 
+void TimingData::UpdateSegmentPointers( TimingSegmentType tst )
+{
+	std::vector<TimingSegment*> &vpSegs = m_avpTimingSegments[tst];
+	WithSegmentArray( tst, [&]( auto pArray ) {
+		auto &vSegs = this->*pArray;
+		vpSegs.resize( vSegs.size() );
+		for( unsigned i = 0; i < vSegs.size(); ++i )
+			vpSegs[i] = &vSegs[i];
+	} );
+}
+
+void TimingData::InsertSegment( int index, const TimingSegment *seg )
+{
+	const TimingSegmentType tst = seg->GetType();
+	WithSegmentArray( tst, [&]( auto pArray ) {
+		auto &vSegs = this->*pArray;
+		typedef typename std::decay<decltype(vSegs)>::type::value_type Seg;
+		vSegs.insert( vSegs.begin() + index, *static_cast<const Seg *>(seg) );
+	} );
+	UpdateSegmentPointers( tst );
+}
+
+void TimingData::ReplaceSegment( int index, const TimingSegment *seg )
+{
+	WithSegmentArray( seg->GetType(), [&]( auto pArray ) {
+		auto &vSegs = this->*pArray;
+		typedef typename std::decay<decltype(vSegs)>::type::value_type Seg;
+		vSegs[index] = *static_cast<const Seg *>(seg);
+	} );
+}
+
+void TimingData::EraseSegment( TimingSegmentType tst, int index )
+{
+#ifdef WITH_LOGGING_TIMING_DATA
+	LOG->Trace( "EraseSegment(%d)", index );
+	m_avpTimingSegments[tst][index]->DebugPrint();
+#endif
+
+	WithSegmentArray( tst, [&]( auto pArray ) {
+		auto &vSegs = this->*pArray;
+		vSegs.erase( vSegs.begin() + index );
+	} );
+	UpdateSegmentPointers( tst );
+}
+
 bool TimingData::IsSafeFullTiming()
 {
 	static std::vector<TimingSegmentType> needed_segments;
@@ -84,48 +148,82 @@ TimingData::~TimingData()
 
 void TimingData::PrepareLookup()
 {
-	// If multiple players have the same timing data, then adding to the
-	// lookups would probably cause FindEntryInLookup to return the wrong
-	// thing.  So release the lookups. -Kyz
+	// If multiple players have the same timing data, then the table is
+	// already there, but build it again in case the segments changed.
 	ReleaseLookup();
-	const unsigned int segments_per_lookup= 16;
-	const std::vector<TimingSegment*>& bpms= m_avpTimingSegments[SEGMENT_BPM];
-	const std::vector<TimingSegment*>& warps= m_avpTimingSegments[SEGMENT_WARP];
-	const std::vector<TimingSegment*>& stops= m_avpTimingSegments[SEGMENT_STOP];
-	const std::vector<TimingSegment*>& delays= m_avpTimingSegments[SEGMENT_DELAY];
-
-	unsigned int total_segments= bpms.size() + warps.size() + stops.size() + delays.size();
-	unsigned int lookup_entries= total_segments / segments_per_lookup;
-	m_beat_start_lookup.reserve(lookup_entries);
-	m_time_start_lookup.reserve(lookup_entries);
-	for(unsigned int curr_segment= segments_per_lookup;
-			curr_segment < total_segments; curr_segment+= segments_per_lookup)
-	{
-		GetBeatStarts beat_start;
-		beat_start.last_time= -m_fBeat0OffsetInSeconds;
-		GetBeatArgs args;
+	unsigned int total_segments= 0;
+	for(auto const seg_type : {SEGMENT_BPM, SEGMENT_WARP, SEGMENT_STOP, SEGMENT_DELAY})
+	{
+		total_segments+= m_avpTimingSegments[seg_type].size();
+	}
+	m_fLookupOffset= m_fBeat0OffsetInSeconds;
+
+	// Walk through one segment at a time, keeping where the walk is before
+	// each one.  A time can start from an entry once it's at or past every
+	// time the walk checked against on the way there.
+	m_LookupTimeKeys.reserve(total_segments + 1);
+	m_LookupBeatStarts.reserve(total_segments + 1);
+	m_LookupBeatWarps.reserve(total_segments + 1);
+	GetBeatStarts beat_start;
+	beat_start.last_time= -m_fBeat0OffsetInSeconds;
+	GetBeatArgs args;
+	for(;;)
+	{
+		m_LookupTimeKeys.push_back(beat_start.passed_time);
+		m_LookupBeatStarts.push_back(beat_start);
+		LookupWarp warp= {args.warp_begin_out, args.warp_dest_out};
+		m_LookupBeatWarps.push_back(warp);
+		unsigned int curr_segment= beat_start.bpm + beat_start.warp +
+			beat_start.stop + beat_start.delay;
+		if(curr_segment >= total_segments)
+		{
+			break;
+		}
 		args.elapsed_time= FLT_MAX;
-		GetBeatInternal(beat_start, args, curr_segment);
-		m_beat_start_lookup.push_back(lookup_item_t(args.elapsed_time, beat_start));
-
-		GetBeatStarts time_start;
-		time_start.last_time= -m_fBeat0OffsetInSeconds;
-		m_time_start_lookup.push_back(lookup_item_t(NoteRowToBeat(time_start.last_row), time_start));
+		GetBeatInternal(beat_start, args, curr_segment + 1);
+		// A 0 bpm never gets to the next segment.
+		if(beat_start.bpm + beat_start.warp + beat_start.stop + beat_start.delay == curr_segment)
+		{
+			break;
+		}
 	}
-	// If there are less than two entries, then FindEntryInLookup in lookup
-	// will always decide there's no appropriate entry.  So clear the table.
-	// -Kyz
-	if(m_beat_start_lookup.size() < 2)
-	{
-		ReleaseLookup();
+
+	// A row can start from an entry once the walk for it would have gone
+	// past every segment before it.  The row being looked for comes before
+	// stops and warps on the same row, and after everything else.
+	m_LookupRowKeys.reserve(total_segments + 1);
+	m_LookupTimeStarts.reserve(total_segments + 1);
+	GetBeatStarts time_start;
+	time_start.last_time= -m_fBeat0OffsetInSeconds;
+	int row_key= INT_MIN;
+	for(;;)
+	{
+		m_LookupRowKeys.push_back(row_key);
+		m_LookupTimeStarts.push_back(time_start);
+		unsigned int curr_segment= time_start.bpm + time_start.warp +
+			time_start.stop + time_start.delay;
+		if(curr_segment >= total_segments)
+		{
+			break;
+		}
+		const GetBeatStarts before= time_start;
+		GetElapsedTimeInternal(time_start, FLT_MAX, curr_segment + 1);
+		const bool passed_stop_or_warp= time_start.stop != before.stop ||
+			time_start.warp != before.warp;
+		row_key= std::max(row_key, time_start.last_row + (passed_stop_or_warp ? 1 : 0));
 	}
 	// DumpLookupTables();
 }
 
 void TimingData::ReleaseLookup()
 {
-	m_beat_start_lookup = beat_start_lookup_t();
-	m_time_start_lookup = beat_start_lookup_t();
+	m_LookupTimeKeys = std::vector<float>();
+	m_LookupBeatStarts = std::vector<GetBeatStarts>();
+	m_LookupBeatWarps = std::vector<LookupWarp>();
+	m_LookupRowKeys = std::vector<int>();
+	m_LookupTimeStarts = std::vector<GetBeatStarts>();
+	m_iLookupTimeHint.store(0, std::memory_order_relaxed);
+	m_iLookupRowHint.store(0, std::memory_order_relaxed);
 }
 
 RString SegInfoStr(const std::vector<TimingSegment*>& segs, unsigned int index, const RString& name)
@@ -137,26 +235,34 @@ RString SegInfoStr(const std::vector<TimingSegment*>& segs, unsigned int index,
 	return ssprintf("%s: %d at end", name.c_str(), index);
 }
 
-void TimingData::DumpOneTable(const beat_start_lookup_t& lookup, const RString& name)
+void TimingData::DumpOneTable(const std::vector<GetBeatStarts>& starts,
+	const RString& name)
 {
 	const std::vector<TimingSegment*>& bpms= m_avpTimingSegments[SEGMENT_BPM];
 	const std::vector<TimingSegment*>& warps= m_avpTimingSegments[SEGMENT_WARP];
 	const std::vector<TimingSegment*>& stops= m_avpTimingSegments[SEGMENT_STOP];
 	const std::vector<TimingSegment*>& delays= m_avpTimingSegments[SEGMENT_DELAY];
 	LOG->Trace("%s lookup table:", name.c_str());
-	for(size_t lit= 0; lit < lookup.size(); ++lit)
+	for(size_t lit= 0; lit < starts.size(); ++lit)
 	{
-		const lookup_item_t& item= lookup[lit];
-		const GetBeatStarts& starts= item.second;
-		LOG->Trace("%zu: %f", lit, item.first);
+		const GetBeatStarts& start= starts[lit];
+		if(&starts == &m_LookupBeatStarts)
+		{
+			LOG->Trace("%zu: %f", lit, m_LookupTimeKeys[lit]);
+		}
+		else
+		{
+			LOG->Trace("%zu: %d", lit, m_LookupRowKeys[lit]);
+		}
 		RString str= ssprintf("  %s, %s, %s, %s,\n"
-			"  last_row: %d, last_time: %.3f,\n"
+			"  last_row: %d, last_time: %.3f, bps: %.3f,\n"
 			"  warp_destination: %.3f, is_warping: %d",
-			SegInfoStr(bpms, starts.bpm, "bpm").c_str(),
-			SegInfoStr(warps, starts.warp, "warp").c_str(),
-			SegInfoStr(stops, starts.stop, "stop").c_str(),
-			SegInfoStr(delays, starts.delay, "delay").c_str(),
-			starts.last_row, starts.last_time, starts.warp_destination, starts.is_warping);
+			SegInfoStr(bpms, start.bpm, "bpm").c_str(),
+			SegInfoStr(warps, start.warp, "warp").c_str(),
+			SegInfoStr(stops, start.stop, "stop").c_str(),
+			SegInfoStr(delays, start.delay, "delay").c_str(),
+			start.last_row, start.last_time, start.bps,
+			start.warp_destination, start.is_warping);
 		LOG->Trace("%s", str.c_str());
 	}
 }
@@ -164,55 +270,45 @@ void TimingData::DumpOneTable(const beat_start_lookup_t& lookup, const RString&
 void TimingData::DumpLookupTables()
 {
 	LOG->Trace("Dumping timing data lookup tables for %s:", m_sFile.c_str());
-	DumpOneTable(m_beat_start_lookup, "m_beat_start_lookup");
-	DumpOneTable(m_time_start_lookup, "m_time_start_lookup");
+	DumpOneTable(m_LookupBeatStarts, "beat");
+	DumpOneTable(m_LookupTimeStarts, "time");
 	LOG->Trace("Finished dumping lookup tables for %s:", m_sFile.c_str());
 }
 
-TimingData::beat_start_lookup_t::const_iterator FindEntryInLookup(
-	const TimingData::beat_start_lookup_t& lookup, float entry)
+// Returns the last entry in keys at or before key.  The first entry is the
+// start of the walk, so it's used for anything before it too.  A NaN key
+// goes past everything, as it does in the walks.
+template<typename T>
+static unsigned int FindEntryInLookup(const std::vector<T>& keys, T key,
+	std::atomic<unsigned>& hint)
 {
-	if(lookup.empty())
+	unsigned int i= hint.load(std::memory_order_relaxed);
+	if(i >= keys.size())
 	{
-		return lookup.end();
+		i= 0;
 	}
-	size_t lower= 0;
-	size_t upper= lookup.size()-1;
-	if(lookup[lower].first > entry)
+	typename std::vector<T>::const_iterator found;
+	if(!(key < keys[i]))
 	{
-		return lookup.end();
-	}
-	if(lookup[upper].first < entry)
-	{
-		// See explanation at the end of this function. -Kyz
-		return lookup.begin() + upper - 1;
-	}
-	while(upper - lower > 1)
-	{
-		size_t next= (upper + lower) / 2;
-		if(lookup[next].first > entry)
-		{
-			upper= next;
-		}
-		else if(lookup[next].first < entry)
+		// Usually this entry or the next, since time moves forward.
+		if(i + 1 == keys.size() || key < keys[i + 1])
 		{
-			lower= next;
+			return i;
 		}
-		else
+		if(i + 2 == keys.size() || key < keys[i + 2])
 		{
-			lower= next;
-			break;
+			hint.store(i + 1, std::memory_order_relaxed);
+			return i + 1;
 		}
+		found= std::upper_bound(keys.begin() + i + 2, keys.end(), key);
 	}
-	// If the time or beat being looked up is close enough to the starting
-	// point that is returned, such as putting the time inside a stop or delay,
-	// then it can make arrows unhittable.  So always return the entry before
-	// the closest one to prevent that. -Kyz
-	if(lower == 0)
+	else
 	{
-		return lookup.end();
+		found= std::upper_bound(keys.begin(), keys.begin() + i, key);
 	}
-	return lookup.begin() + lower - 1;
+	i= found == keys.begin() ? 0 : found - keys.begin() - 1;
+	hint.store(i, std::memory_order_relaxed);
+	return i;
 }
 
 bool TimingData::empty() const
@@ -256,7 +352,7 @@ void TimingData::ShiftRange(int start_row, int end_row,
 	{
 		if(seg_type == shift_type || shift_type == TimingSegmentType_Invalid)
 		{
-			std::vector<TimingSegment*>& segs= GetTimingSegments(seg_type);
+			const std::vector<TimingSegment*>& segs= GetTimingSegments(seg_type);
 			int first_row= std::min(start_row, start_row + shift_amount);
 			int last_row= std::max(end_row, end_row + shift_amount);
 			int first_affected= GetSegmentIndexAtRow(seg_type, first_row);
@@ -291,7 +387,7 @@ void TimingData::ShiftRange(int start_row, int end_row,
 					{
 						if(segs.size() > 1)
 						{
-							EraseSegment(segs, i, segs[i]);
+							EraseSegment(seg_type, i);
 							--i;
 							--last_affected;
 							erased = true;
@@ -313,7 +409,7 @@ void TimingData::ShiftRange(int start_row, int end_row,
 					{
 						if(segs.size() > 1)
 						{
-							EraseSegment(segs, i, segs[i]);
+							EraseSegment(seg_type, i);
 							--i;
 							--last_affected;
 							erased = true;
@@ -331,7 +427,7 @@ void TimingData::ClearRange(int start_row, int end_row, TimingSegmentType clear_
 	{
 		if(seg_type == clear_type || clear_type == TimingSegmentType_Invalid)
 		{
-			std::vector<TimingSegment*>& segs= GetTimingSegments(seg_type);
+			const std::vector<TimingSegment*>& segs= GetTimingSegments(seg_type);
 			int first_affected= GetSegmentIndexAtRow(seg_type, start_row);
 			int last_affected= GetSegmentIndexAtRow(seg_type, end_row);
 			if(first_affected == INVALID_INDEX)
@@ -344,7 +440,7 @@ void TimingData::ClearRange(int start_row, int end_row, TimingSegmentType clear_
 				if(segs.size() > 1 && seg_row > 0 && seg_row >= start_row &&
 					seg_row <= end_row)
 				{
-					EraseSegment(segs, index, segs[index]);
+					EraseSegment(seg_type, index);
 				}
 			}
 		}
@@ -436,7 +532,7 @@ struct ts_less
 void TimingData::MultiplyBPMInBeatRange( int iStartIndex, int iEndIndex, float fFactor )
 {
 	// Change all other BPM segments in this range.
-	std::vector<TimingSegment *> &bpms = m_avpTimingSegments[SEGMENT_BPM];
+	const std::vector<TimingSegment *> &bpms = m_avpTimingSegments[SEGMENT_BPM];
 	for( unsigned i=0; i<bpms.size(); i++ )
 	{
 		BPMSegment *bs = ToBPM(bpms[i]);
@@ -451,9 +547,8 @@ void TimingData::MultiplyBPMInBeatRange( int iStartIndex, int iEndIndex, float f
 		 * split it into two. */
 		if( iStartIndexThisSegment < iStartIndex && iStartIndexNextSegment > iStartIndex )
 		{
-			BPMSegment * b = new BPMSegment(iStartIndexNextSegment,
-											bs->GetBPS());
-			bpms.insert(bpms.begin()+i+1, b);
+			BPMSegment b(iStartIndexNextSegment, bs->GetBPS());
+			InsertSegment(i+1, &b);
 
 			/* Don't apply the BPM change to the first half of the segment we
 			 * just split, since it lies outside the range. */
@@ -463,9 +558,10 @@ void TimingData::MultiplyBPMInBeatRange( int iStartIndex, int iEndIndex, float f
 		// If this BPM segment crosses the end of the range, split it into two.
 		if( iStartIndexThisSegment < iEndIndex && iStartIndexNextSegment > iEndIndex )
 		{
-			BPMSegment * b = new BPMSegment(iEndIndex,
-											bs->GetBPS());
-			bpms.insert(bpms.begin()+i+1, b);
+			BPMSegment b(iEndIndex, bs->GetBPS());
+			InsertSegment(i+1, &b);
+			// That moved the segments around.
+			bs = ToBPM(bpms[i]);
 		}
 		else if( iStartIndexNextSegment > iEndIndex )
 			continue;
@@ -581,19 +677,8 @@ TimingSegment* TimingData::GetSegmentAtRow( int iNoteRow, TimingSegmentType tst
 	return const_cast<TimingSegment*>( static_cast<const TimingData*>(this)->GetSegmentAtRow(iNoteRow, tst) );
 }
 
-static void EraseSegment( std::vector<TimingSegment*> &vSegs, int index, TimingSegment *cur )
-{
-#ifdef WITH_LOGGING_TIMING_DATA
-	LOG->Trace( "EraseSegment(%d, %p)", index, cur );
-	cur->DebugPrint();
-#endif
-
-	vSegs.erase( vSegs.begin() + index );
-	RageUtil::SafeDelete( cur );
-}
-
 // NOTE: the pointer we're passed is a reference to a temporary,
-// so we must deep-copy it (with ::Copy) for new allocations.
+// so we must copy it into our own segments.
 void TimingData::AddSegment( const TimingSegment *seg )
 {
 #ifdef WITH_LOGGING_TIMING_DATA
@@ -602,12 +687,12 @@ void TimingData::AddSegment( const TimingSegment *seg )
 #endif
 
 	TimingSegmentType tst = seg->GetType();
-	std::vector<TimingSegment*> &vSegs = m_avpTimingSegments[tst];
+	const std::vector<TimingSegment*> &vSegs = m_avpTimingSegments[tst];
 
 	// OPTIMIZATION: if this is our first segment, push and return.
 	if( vSegs.empty() )
 	{
-		vSegs.push_back( seg->Copy() );
+		InsertSegment( 0, seg );
 		return;
 	}
 
@@ -631,7 +716,7 @@ void TimingData::AddSegment( const TimingSegment *seg )
 			// one, take it to mean deleting the existing segment
 			if( bOnSameRow && !bIsNotable )
 			{
-				EraseSegment( vSegs, index, cur );
+				EraseSegment( tst, index );
 				return;
 			}
 
@@ -665,10 +750,10 @@ void TimingData::AddSegment( const TimingSegment *seg )
 					{
 						// This new segment is redundant.  Erase the next segment and
 						// ignore this new one.
-						EraseSegment(vSegs, index + 1, next);
+						EraseSegment( tst, index + 1 );
 						if( prev != cur )
 						{
-							EraseSegment( vSegs, index, cur );
+							EraseSegment( tst, index );
 						}
 						return;
 					}
@@ -678,7 +763,7 @@ void TimingData::AddSegment( const TimingSegment *seg )
 						next->SetRow(seg->GetRow());
 						if( prev != cur )
 						{
-							EraseSegment( vSegs, index, cur );
+							EraseSegment( tst, index );
 						}
 						return;
 					}
@@ -690,7 +775,7 @@ void TimingData::AddSegment( const TimingSegment *seg )
 					{
 						if( prev != cur )
 						{
-							EraseSegment( vSegs, index, cur );
+							EraseSegment( tst, index );
 						}
 						return;
 					}
@@ -703,7 +788,7 @@ void TimingData::AddSegment( const TimingSegment *seg )
 				{
 					if( prev != cur )
 					{
-						EraseSegment( vSegs, index, cur );
+						EraseSegment( tst, index );
 					}
 					return;
 				}
@@ -723,22 +808,17 @@ void TimingData::AddSegment( const TimingSegment *seg )
 		return;
 	}
 
-	// Copy() the segment (which allocates a new segment), assign it
-	// to the position of the old one, then delete the old pointer.
-	TimingSegment *cpy = seg->Copy();
-
 	if( bOnSameRow )
 	{
-		// delete the existing pointer and replace it
-		RageUtil::SafeDelete( cur );
-		vSegs[index] = cpy;
+		// overwrite the existing segment
+		ReplaceSegment( index, seg );
 	}
 	else
 	{
 		// copy and insert a new segment
-		std::vector<TimingSegment*>::iterator it;
-		it = upper_bound( vSegs.begin(), vSegs.end(), cpy, ts_less() );
-		vSegs.insert( it, cpy );
+		std::vector<TimingSegment*>::const_iterator it;
+		it = upper_bound( vSegs.begin(), vSegs.end(), seg, ts_less() );
+		InsertSegment( it - vSegs.begin(), seg );
 	}
 }
 
@@ -773,22 +853,22 @@ enum
 
 void FindEvent(int& event_row, int& event_type,
 	TimingData::GetBeatStarts& start, float beat, bool find_marker,
-	const std::vector<TimingSegment*>& bpms, const std::vector<TimingSegment*>& warps,
-	const std::vector<TimingSegment*>& stops, const std::vector<TimingSegment*>& delays)
+	const std::vector<BPMSegment>& bpms, const std::vector<WarpSegment>& warps,
+	const std::vector<StopSegment>& stops, const std::vector<DelaySegment>& delays)
 {
 	if(start.is_warping && BeatToNoteRow(start.warp_destination) < event_row)
 	{
 		event_row= BeatToNoteRow(start.warp_destination);
 		event_type= FOUND_WARP_DESTINATION;
 	}
-	if(start.bpm < bpms.size() && bpms[start.bpm]->GetRow() < event_row)
+	if(start.bpm < bpms.size() && bpms[start.bpm].GetRow() < event_row)
 	{
-		event_row= bpms[start.bpm]->GetRow();
+		event_row= bpms[start.bpm].GetRow();
 		event_type= FOUND_BPM_CHANGE;
 	}
-	if(start.delay < delays.size() && delays[start.delay]->GetRow() < event_row)
+	if(start.delay < delays.size() && delays[start.delay].GetRow() < event_row)
 	{
-		event_row= delays[start.delay]->GetRow();
+		event_row= delays[start.delay].GetRow();
 		event_type= FOUND_DELAY;
 	}
 	if(find_marker && BeatToNoteRow(beat) < event_row)
@@ -796,15 +876,15 @@ void FindEvent(int& event_row, int& event_type,
 		event_row= BeatToNoteRow(beat);
 		event_type= FOUND_MARKER;
 	}
-	if(start.stop < stops.size() && stops[start.stop]->GetRow() < event_row)
+	if(start.stop < stops.size() && stops[start.stop].GetRow() < event_row)
 	{
 		int tmp_row= event_row;
-		event_row= stops[start.stop]->GetRow();
+		event_row= stops[start.stop].GetRow();
 		event_type= (tmp_row == event_row) ? FOUND_STOP_DELAY : FOUND_STOP;
 	}
-	if(start.warp < warps.size() && warps[start.warp]->GetRow() < event_row)
+	if(start.warp < warps.size() && warps[start.warp].GetRow() < event_row)
 	{
-		event_row= warps[start.warp]->GetRow();
+		event_row= warps[start.warp].GetRow();
 		event_type= FOUND_WARP;
 	}
 }
@@ -812,13 +892,13 @@ void FindEvent(int& event_row, int& event_type,
 void TimingData::GetBeatInternal(GetBeatStarts& start, GetBeatArgs& args,
 	unsigned int max_segment) const
 {
-	const std::vector<TimingSegment*>& bpms= m_avpTimingSegments[SEGMENT_BPM];
-	const std::vector<TimingSegment*>& warps= m_avpTimingSegments[SEGMENT_WARP];
-	const std::vector<TimingSegment*>& stops= m_avpTimingSegments[SEGMENT_STOP];
-	const std::vector<TimingSegment*>& delays= m_avpTimingSegments[SEGMENT_DELAY];
+	const std::vector<BPMSegment>& bpms= m_BPMSegments;
+	const std::vector<WarpSegment>& warps= m_WarpSegments;
+	const std::vector<StopSegment>& stops= m_StopSegments;
+	const std::vector<DelaySegment>& delays= m_DelaySegments;
 	unsigned int curr_segment= start.bpm+start.warp+start.stop+start.delay;
 
-	float bps= GetBPMAtRow(start.last_row) / 60.0f;
+	float bps= start.bps != 0 ? start.bps : GetBPMAtRow(start.last_row) / 60.0f;
 	while(curr_segment < max_segment)
 	{
 		int event_row= INT_MAX;
@@ -835,20 +915,21 @@ void TimingData::GetBeatInternal(GetBeatStarts& start, GetBeatArgs& args,
 			break;
 		}
 		start.last_time= next_event_time;
+		start.passed_time= std::max(start.passed_time, next_event_time);
 		switch(event_type)
 		{
 			case FOUND_WARP_DESTINATION:
 				start.is_warping= false;
 				break;
 			case FOUND_BPM_CHANGE:
-				bps= ToBPM(bpms[start.bpm])->GetBPS();
+				bps= bpms[start.bpm].GetBPS();
 				++start.bpm;
 				++curr_segment;
 				break;
 			case FOUND_DELAY:
 			case FOUND_STOP_DELAY:
 				{
-					const DelaySegment* ss= ToDelay(delays[start.delay]);
+					const DelaySegment* ss= &delays[start.delay];
 					time_to_next_event= ss->GetPause();
 					next_event_time= start.last_time + time_to_next_event;
 					if(args.elapsed_time < next_event_time)
@@ -860,6 +941,7 @@ void TimingData::GetBeatInternal(GetBeatStarts& start, GetBeatArgs& args,
 						return;
 					}
 					start.last_time= next_event_time;
+					start.passed_time= std::max(start.passed_time, next_event_time);
 					++start.delay;
 					++curr_segment;
 					if(event_type == FOUND_DELAY)
@@ -870,7 +952,7 @@ void TimingData::GetBeatInternal(GetBeatStarts& start, GetBeatArgs& args,
 				}
 			case FOUND_STOP:
 				{
-					const StopSegment* ss= ToStop(stops[start.stop]);
+					const StopSegment* ss= &stops[start.stop];
 					time_to_next_event= ss->GetPause();
 					next_event_time= start.last_time + time_to_next_event;
 					if(args.elapsed_time < next_event_time)
@@ -882,6 +964,7 @@ void TimingData::GetBeatInternal(GetBeatStarts& start, GetBeatArgs& args,
 						return;
 					}
 					start.last_time= next_event_time;
+					start.passed_time= std::max(start.passed_time, next_event_time);
 					++start.stop;
 					++curr_segment;
 					break;
@@ -889,7 +972,7 @@ void TimingData::GetBeatInternal(GetBeatStarts& start, GetBeatArgs& args,
 			case FOUND_WARP:
 				{
 					start.is_warping= true;
-					const WarpSegment* ws= ToWarp(warps[start.warp]);
+					const WarpSegment* ws= &warps[start.warp];
 					float warp_sum= ws->GetLength() + ws->GetBeat();
 					if(warp_sum > start.warp_destination)
 					{
@@ -908,6 +991,7 @@ void TimingData::GetBeatInternal(GetBeatStarts& start, GetBeatArgs& args,
 	{
 		args.elapsed_time= start.last_time;
 	}
+	start.bps= bps;
 	args.beat= NoteRowToBeat(start.last_row) +
 		(args.elapsed_time - start.last_time) * bps;
 	args.bps_out= bps;
@@ -917,11 +1001,18 @@ void TimingData::GetBeatAndBPSFromElapsedTimeNoOffset(GetBeatArgs& args) const
 {
 	GetBeatStarts start;
 	start.last_time= -m_fBeat0OffsetInSeconds;
-	beat_start_lookup_t::const_iterator looked_up_start=
-		FindEntryInLookup(m_beat_start_lookup, args.elapsed_time);
-	if(looked_up_start != m_beat_start_lookup.end())
-	{
-		start= looked_up_start->second;
+	// Autosync can move the offset during gameplay, which the table has
+	// built in.
+	if(!m_LookupTimeKeys.empty() && m_fLookupOffset == m_fBeat0OffsetInSeconds)
+	{
+		unsigned int i= FindEntryInLookup(m_LookupTimeKeys, args.elapsed_time, m_iLookupTimeHint);
+		start= m_LookupBeatStarts[i];
+		// Report the last warp gone past, even if it was before the entry.
+		if(m_LookupBeatWarps[i].begin_row != -1)
+		{
+			args.warp_begin_out= m_LookupBeatWarps[i].begin_row;
+			args.warp_dest_out= m_LookupBeatWarps[i].destination;
+		}
 	}
 	GetBeatInternal(start, args, INT_MAX);
 }
@@ -929,13 +1020,13 @@ void TimingData::GetBeatAndBPSFromElapsedTimeNoOffset(GetBeatArgs& args) const
 float TimingData::GetElapsedTimeInternal(GetBeatStarts& start, float beat,
 	unsigned int max_segment) const
 {
-	const std::vector<TimingSegment*>& bpms= m_avpTimingSegments[SEGMENT_BPM];
-	const std::vector<TimingSegment*>& warps= m_avpTimingSegments[SEGMENT_WARP];
-	const std::vector<TimingSegment*>& stops= m_avpTimingSegments[SEGMENT_STOP];
-	const std::vector<TimingSegment*>& delays= m_avpTimingSegments[SEGMENT_DELAY];
+	const std::vector<BPMSegment>& bpms= m_BPMSegments;
+	const std::vector<WarpSegment>& warps= m_WarpSegments;
+	const std::vector<StopSegment>& stops= m_StopSegments;
+	const std::vector<DelaySegment>& delays= m_DelaySegments;
 	unsigned int curr_segment= start.bpm+start.warp+start.stop+start.delay;
 
-	float bps= GetBPMAtRow(start.last_row) / 60.0f;
+	float bps= start.bps != 0 ? start.bps : GetBPMAtRow(start.last_row) / 60.0f;
 	bool find_marker= beat < FLT_MAX;
 
 	while(curr_segment < max_segment)
@@ -952,31 +1043,32 @@ float TimingData::GetElapsedTimeInternal(GetBeatStarts& start, float beat,
 				start.is_warping= false;
 				break;
 			case FOUND_BPM_CHANGE:
-				bps= ToBPM(bpms[start.bpm])->GetBPS();
+				bps= bpms[start.bpm].GetBPS();
 				++start.bpm;
 				++curr_segment;
 				break;
 			case FOUND_STOP:
 			case FOUND_STOP_DELAY:
-				time_to_next_event= ToStop(stops[start.stop])->GetPause();
+				time_to_next_event= stops[start.stop].GetPause();
 				next_event_time= start.last_time + time_to_next_event;
 				start.last_time= next_event_time;
 				++start.stop;
 				++curr_segment;
 				break;
 			case FOUND_DELAY:
-				time_to_next_event= ToDelay(delays[start.delay])->GetPause();
+				time_to_next_event= delays[start.delay].GetPause();
 				next_event_time= start.last_time + time_to_next_event;
 				start.last_time= next_event_time;
 				++start.delay;
 				++curr_segment;
 				break;
 			case FOUND_MARKER:
+				start.bps= bps;
 				return start.last_time;
 			case FOUND_WARP:
 				{
 					start.is_warping= true;
-					WarpSegment* ws= ToWarp(warps[start.warp]);
+					const WarpSegment* ws= &warps[start.warp];
 					float warp_sum= ws->GetLength() + ws->GetBeat();
 					if(warp_sum > start.warp_destination)
 					{
@@ -989,6 +1081,7 @@ float TimingData::GetElapsedTimeInternal(GetBeatStarts& start, float beat,
 		}
 		start.last_row= event_row;
 	}
+	start.bps= bps;
 	return start.last_time;
 }
 
@@ -1002,11 +1095,12 @@ float TimingData::GetElapsedTimeFromBeatNoOffset( float fBeat ) const
 {
 	GetBeatStarts start;
 	start.last_time= -m_fBeat0OffsetInSeconds;
-	beat_start_lookup_t::const_iterator looked_up_start=
-		FindEntryInLookup(m_time_start_lookup, fBeat);
-	if(looked_up_start != m_time_start_lookup.end())
+	if(!m_LookupRowKeys.empty() && m_fLookupOffset == m_fBeat0OffsetInSeconds)
 	{
-		start= looked_up_start->second;
+		// Beats that aren't below FLT_MAX aren't looked for, so they go
+		// through every segment.
+		const int row= fBeat < FLT_MAX ? BeatToNoteRow(fBeat) : INT_MAX;
+		start= m_LookupTimeStarts[FindEntryInLookup(m_LookupRowKeys, row, m_iLookupRowHint)];
 	}
 	GetElapsedTimeInternal(start, fBeat, INT_MAX);
 	return start.last_time;
@@ -1016,14 +1110,14 @@ float TimingData::GetDisplayedBeat( float fBeat ) const
 {
 	float fOutBeat = 0;
 	unsigned i;
-	const std::vector<TimingSegment *> &scrolls = m_avpTimingSegments[SEGMENT_SCROLL];
+	const std::vector<ScrollSegment> &scrolls = m_ScrollSegments;
 	for( i=0; i<scrolls.size()-1; i++ )
 	{
-		if( scrolls[i+1]->GetBeat() > fBeat )
+		if( scrolls[i+1].GetBeat() > fBeat )
 			break;
-		fOutBeat += (scrolls[i+1]->GetBeat() - scrolls[i]->GetBeat()) * ToScroll(scrolls[i])->GetRatio();
+		fOutBeat += (scrolls[i+1].GetBeat() - scrolls[i].GetBeat()) * scrolls[i].GetRatio();
 	}
-	fOutBeat += (fBeat - scrolls[i]->GetBeat()) * ToScroll(scrolls[i])->GetRatio();
+	fOutBeat += (fBeat - scrolls[i].GetBeat()) * scrolls[i].GetRatio();
 	return fOutBeat;
 }
 
@@ -1109,7 +1203,7 @@ void TimingData::DeleteRows( int iStartRow, int iRowsToDelete )
 		}
 
 		// Now delete and shift up
-		std::vector<TimingSegment *> &segs = m_avpTimingSegments[tst];
+		const std::vector<TimingSegment *> &segs = m_avpTimingSegments[tst];
 		for (unsigned j = 0; j < segs.size(); j++)
 		{
 			TimingSegment *seg = segs[j];
@@ -1119,7 +1213,7 @@ void TimingData::DeleteRows( int iStartRow, int iRowsToDelete )
 			// Inside deleted region:
 			if (seg->GetRow() < iStartRow + iRowsToDelete)
 			{
-				segs.erase(segs.begin()+j, segs.begin()+j+1);
+				EraseSegment(tst, j);
 				--j;
 				continue;
 			}
@@ -1234,8 +1328,11 @@ void TimingData::TidyUpData(bool allowEmpty)
 
 void TimingData::SortSegments( TimingSegmentType tst )
 {
-	std::vector<TimingSegment*> &vSegments = m_avpTimingSegments[tst];
-	sort( vSegments.begin(), vSegments.end() );
+	WithSegmentArray( tst, [&]( auto pArray ) {
+		auto &vSegs = this->*pArray;
+		std::stable_sort( vSegs.begin(), vSegs.end() );
+	} );
+	UpdateSegmentPointers( tst );
 }
 
 bool TimingData::HasSpeedChanges() const
@@ -6,6 +6,7 @@
 #include "PrefsManager.h"
 
 #include <array>
+#include <atomic>
 #include <cfloat>
 #include <vector>
 
@@ -71,16 +72,16 @@ public:
 	void Clear();
 	bool IsSafeFullTiming();
 
-	TimingData( const TimingData &cpy ) { Copy(cpy); }
+	TimingData( const TimingData &cpy ) :m_fLookupOffset(0), m_iLookupTimeHint(0),
+		m_iLookupRowHint(0) { Copy(cpy); }
 	TimingData& operator=( const TimingData &cpy ) { Copy(cpy); return *this; }
 
-	// GetBeatArgs, GetBeatStarts, m_beat_start_lookup, m_time_start_lookup,
-	// PrepareLookup, and ReleaseLookup form a system for speeding up finding
-	// the current beat and bps from the time, or finding the time from the
-	// current beat.
-	// The lookup tables contain indices for the beat and time finding
-	// functions to start at so they don't have to walk through all the timing
-	// segments.
+	// GetBeatArgs, GetBeatStarts, PrepareLookup, and ReleaseLookup form a
+	// system for speeding up finding the current beat and bps from the time,
+	// or finding the time from the current beat.
+	// The lookup table holds where the beat and time finding functions are
+	// before each timing segment, so they can start at the last one before
+	// the time or beat instead of walking through all the timing segments.
 	// PrepareLookup should be called before gameplay starts, so that the lookup
 	// tables are populated.  ReleaseLookup should be called after gameplay
 	// finishes so that memory isn't wasted.
@@ -106,30 +107,19 @@ public:
 		int last_row;
 		float last_time;
 		float warp_destination;
+		// The bps in effect at last_row, or 0 to look it up.
+		float bps;
+		// The latest time GetBeatInternal had to get past to get here.
+		float passed_time;
 		bool is_warping;
 	GetBeatStarts() :bpm(0), warp(0), stop(0), delay(0), last_row(0),
-			last_time(0), warp_destination(0), is_warping(false) {}
+			last_time(0), warp_destination(0), bps(0), passed_time(-FLT_MAX),
+			is_warping(false) {}
 	};
-	// map can't be used for the lookup table because its find or *_bound
-	// functions would return the wrong entry.
-	// In a std::map<int, int> with three entries, [-1]= 3, [6]= 1, [8]= 2,
-	// lower_bound(0) and upper_bound(0) both returned the entry at [6]= 1.
-	// So the lookup table is a vector of entries and FindEntryInLookup does a
-	// binary search.
-	// -Kyz
-	struct lookup_item_t
-	{
-		float first;
-		GetBeatStarts second;
-	lookup_item_t(float f, GetBeatStarts& s) :first(f), second(s) {}
-	};
-	typedef std::vector<lookup_item_t> beat_start_lookup_t;
-	beat_start_lookup_t m_beat_start_lookup;
-	beat_start_lookup_t m_time_start_lookup;
 
 	void PrepareLookup();
 	void ReleaseLookup();
-	void DumpOneTable(const beat_start_lookup_t& lookup, const RString& name);
+	void DumpOneTable(const std::vector<GetBeatStarts>& starts, const RString& name);
 	void DumpLookupTables();
 
 	int GetSegmentIndexAtRow(TimingSegmentType tst, int row) const;
@@ -211,6 +201,10 @@ public:
 		void AddSegment( const Seg &seg ) \
 		{ \
 			AddSegment( &seg ); \
+		} \
+		const std::vector<Seg> &Get##Seg##s() const \
+		{ \
+			return m_##Seg##s; \
 		}
 
 	// "XXX: this comment (and quote mark) exists so nano won't
@@ -431,14 +425,13 @@ public:
 
 	void SortSegments( TimingSegmentType tst );
 
+	/* The segments can be changed through these, but add and remove them
+	 * with AddSegment and EraseSegment. */
 	const std::vector<TimingSegment*> &GetTimingSegments( TimingSegmentType tst ) const
-	{
-		return const_cast<TimingData *>(this)->GetTimingSegments(tst);
-	}
-	std::vector<TimingSegment *> &GetTimingSegments( TimingSegmentType tst )
 	{
 		return m_avpTimingSegments[tst];
 	}
+	void EraseSegment( TimingSegmentType tst, int index );
 
 	/**
 	 * @brief Tidy up the timing data, e.g. provide default BPMs, labels, tickcounts.
@@ -466,8 +459,53 @@ protected:
 	// don't call this directly; use the derived-type overloads.
 	void AddSegment( const TimingSegment *seg );
 
+	/* The lookup table, one entry per timing segment plus one for the start,
+	 * in the order the walk passes them.  Entry i of the beat table is where
+	 * GetBeatInternal is after i segments, and can be started from for any
+	 * time at or after m_LookupTimeKeys[i]; the time table is the same for
+	 * GetElapsedTimeInternal and rows at or after m_LookupRowKeys[i].  The
+	 * keys are kept apart from the starts so that searching them stays in
+	 * cache.  Gameplay asks for times that move forward a little each frame,
+	 * so the last entry found is remembered and tried first.  Those are
+	 * atomic since timing can be looked up from more than one thread. */
+	struct LookupWarp
+	{
+		int begin_row;
+		float destination;
+	};
+	std::vector<float> m_LookupTimeKeys;
+	std::vector<GetBeatStarts> m_LookupBeatStarts;
+	std::vector<LookupWarp> m_LookupBeatWarps;
+	std::vector<int> m_LookupRowKeys;
+	std::vector<GetBeatStarts> m_LookupTimeStarts;
+	float m_fLookupOffset;
+	mutable std::atomic<unsigned> m_iLookupTimeHint;
+	mutable std::atomic<unsigned> m_iLookupRowHint;
+
 	// All of the following vectors must be sorted before gameplay.
 	std::array<std::vector<TimingSegment *>, NUM_TimingSegmentType> m_avpTimingSegments;
+
+	/* The segments themselves, in one array of each type, so copying timing
+	 * doesn't allocate every segment and walking them stays in cache.
+	 * m_avpTimingSegments points into these, so add, remove and reorder
+	 * segments only with the functions below, which fix the pointers up. */
+	std::vector<BPMSegment> m_BPMSegments;
+	std::vector<StopSegment> m_StopSegments;
+	std::vector<DelaySegment> m_DelaySegments;
+	std::vector<TimeSignatureSegment> m_TimeSignatureSegments;
+	std::vector<WarpSegment> m_WarpSegments;
+	std::vector<LabelSegment> m_LabelSegments;
+	std::vector<TickcountSegment> m_TickcountSegments;
+	std::vector<ComboSegment> m_ComboSegments;
+	std::vector<SpeedSegment> m_SpeedSegments;
+	std::vector<ScrollSegment> m_ScrollSegments;
+	std::vector<FakeSegment> m_FakeSegments;
+
+	// Calls f with a pointer to the member holding segments of type tst.
+	template<typename Func> static void WithSegmentArray( TimingSegmentType tst, Func f );
+	void InsertSegment( int index, const TimingSegment *seg );
+	void ReplaceSegment( int index, const TimingSegment *seg );
+	void UpdateSegmentPointers( TimingSegmentType tst );
 };
 
 #endif
@@ -62,6 +62,7 @@ struct TimingSegment
 
 	TimingSegment(const TimingSegment &other) :
 		m_iStartRow( other.GetRow() ) { }
+	TimingSegment &operator=( const TimingSegment &other ) = default;
 
 	// for our purposes, two floats within this level of error are equal
 	static constexpr double EPSILON = 1e-6;
@@ -146,6 +147,7 @@ struct FakeSegment : public TimingSegment
 	FakeSegment( const FakeSegment &other ) :
 		TimingSegment( other.GetRow() ),
 		m_iLengthRows( other.GetLengthRows() ) { }
+	FakeSegment &operator=( const FakeSegment &other ) = default;
 
 	int GetLengthRows() const { return m_iLengthRows; }
 	float GetLengthBeats() const { return ToBeat(m_iLengthRows); }
@@ -199,6 +201,7 @@ struct WarpSegment : public TimingSegment
 	WarpSegment( const WarpSegment &other ) :
 		TimingSegment( other.GetRow() ),
 		m_iLengthRows( other.GetLengthRows() ) { }
+	WarpSegment &operator=( const WarpSegment &other ) = default;
 
 	WarpSegment( int iStartRow, int iLengthRows ) :
 		TimingSegment(iStartRow), m_iLengthRows(iLengthRows) { }
@@ -265,6 +268,7 @@ struct TickcountSegment : public TimingSegment
 	TickcountSegment( const TickcountSegment &other ) :
 		TimingSegment( other.GetRow() ),
 		m_iTicksPerBeat( other.GetTicks() ) { }
+	TickcountSegment &operator=( const TickcountSegment &other ) = default;
 
 	int GetTicks() const { return m_iTicksPerBeat; }
 	void SetTicks( int iTicks ) { m_iTicksPerBeat = iTicks; }
@@ -314,6 +318,7 @@ struct ComboSegment : public TimingSegment
 		TimingSegment( other.GetRow() ),
 		m_iCombo( other.GetCombo() ),
 		m_iMissCombo( other.GetMissCombo() ) { }
+	ComboSegment &operator=( const ComboSegment &other ) = default;
 
 	int GetCombo() const { return m_iCombo; }
 	int GetMissCombo() const { return m_iMissCombo; }
@@ -369,6 +374,7 @@ struct LabelSegment : public TimingSegment
 	LabelSegment(const LabelSegment &other) :
 		TimingSegment( other.GetRow() ),
 		m_sLabel( other.GetLabel() ) { }
+	LabelSegment &operator=( const LabelSegment &other ) = default;
 
 	const RString& GetLabel() const { return m_sLabel; }
 	void SetLabel( const RString& sLabel ) { m_sLabel.assign(sLabel); }
@@ -415,6 +421,7 @@ struct BPMSegment : public TimingSegment
 	BPMSegment( const BPMSegment &other ) :
 		TimingSegment( other.GetRow() ),
 		m_fBPS( other.GetBPS() ) { }
+	BPMSegment &operator=( const BPMSegment &other ) = default;
 
 	float GetBPS() const { return m_fBPS; }
 	float GetBPM() const { return m_fBPS * 60.0f; }
@@ -470,6 +477,7 @@ struct TimeSignatureSegment : public TimingSegment
 		TimingSegment( other.GetRow() ),
 		m_iNumerator( other.GetNum() ),
 		m_iDenominator( other.GetDen() ) { }
+	TimeSignatureSegment &operator=( const TimeSignatureSegment &other ) = default;
 
 	int GetNum() const { return m_iNumerator; }
 	void SetNum( int num ) { m_iNumerator = num; }
@@ -549,6 +557,7 @@ struct SpeedSegment : public TimingSegment
 		m_fRatio( other.GetRatio() ),
 		m_fDelay( other.GetDelay() ),
 		m_Unit( other.GetUnit() ) { }
+	SpeedSegment &operator=( const SpeedSegment &other ) = default;
 
 	float GetRatio() const { return m_fRatio; }
 	void SetRatio( float fRatio ) { m_fRatio = fRatio; }
@@ -617,6 +626,7 @@ struct ScrollSegment : public TimingSegment
 	ScrollSegment(const ScrollSegment &other) :
 		TimingSegment( other.GetRow() ),
 		m_fRatio( other.GetRatio() ) { }
+	ScrollSegment &operator=( const ScrollSegment &other ) = default;
 
 	float GetRatio() const { return m_fRatio; }
 	void SetRatio( float fRatio ) { m_fRatio = fRatio; }
@@ -662,6 +672,7 @@ struct StopSegment : public TimingSegment
 	StopSegment (const StopSegment &other) :
 		TimingSegment( other.GetRow() ),
 		m_fSeconds( other.GetPause() ) { }
+	StopSegment &operator=( const StopSegment &other ) = default;
 
 	float GetPause() const { return m_fSeconds; }
 	void SetPause( float fSeconds ) { m_fSeconds = fSeconds; }
@@ -706,6 +717,7 @@ struct DelaySegment : public TimingSegment
 	DelaySegment( const DelaySegment &other ) :
 		TimingSegment( other.GetRow() ),
 		m_fSeconds( other.GetPause() ) { }
+	DelaySegment &operator=( const DelaySegment &other ) = default;
 
 	float GetPause() const { return m_fSeconds; }
 	void SetPause( float fSeconds ) { m_fSeconds = fSeconds; }
@@ -24,6 +24,9 @@
 /* Defined to 1 if <sys/utsname.h> is found. */
 #cmakedefine HAVE_SYS_UTSNAME_H 1
 
+/* Defined to 1 if <sys/inotify.h> is found. */
+#cmakedefine HAVE_SYS_INOTIFY_H 1
+
 /* Defined to 1 if <fcntl.h> is found. */
 #cmakedefine HAVE_FCNTL_H 1
 
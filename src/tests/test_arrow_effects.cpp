@@ -0,0 +1,262 @@
+#include "global.h"
+#include "RageLog.h"
+#include "RageFile.h"
+#include "RageFileManager.h"
+#include "RageUtil.h"
+#include "ArrowEffects.h"
+#include "GameManager.h"
+#include "GameState.h"
+#include "LuaManager.h"
+#include "NoteData.h"
+#include "NoteFieldCache.h"
+#include "PlayerState.h"
+#include "PrefsManager.h"
+#include "Song.h"
+#include "Steps.h"
+#include "ThemeManager.h"
+#include "test_arrow_effects_reference.h"
+#include "test_misc.h"
+
+#include <cstring>
+
+/* Drives ArrowEffects with synthetic PlayerStates: every per-note query made
+ * with a context loaded for that note, with one context for the column, and
+ * through the batch functions has to give the same numbers, and the same
+ * numbers as the per-note functions from before there were contexts and
+ * batches. */
+
+static const int NUM_COLS = 4;
+
+/* A random handful of mods; most of them off, like most real mod sets. */
+static void MakeOptions( PlayerOptions &po, float fChance )
+{
+	const PlayerNumber pn = po.m_pn;
+	po = PlayerOptions();
+	po.m_pn = pn;
+	for( int i = 0; i < PlayerOptions::NUM_EFFECTS; ++i )
+		po.m_fEffects[i] = test_maybe( fChance, -1.5f, 1.5f );
+	for( int i = 0; i < PlayerOptions::NUM_ACCELS; ++i )
+		po.m_fAccels[i] = test_maybe( fChance, -1, 1.5f );
+	for( int i = 0; i < PlayerOptions::NUM_APPEARANCES; ++i )
+		po.m_fAppearances[i] = test_maybe( fChance, 0, 1 );
+	for( int i = 0; i < PlayerOptions::NUM_SCROLLS; ++i )
+		po.m_fScrolls[i] = test_maybe( fChance, 0, 1 );
+	for( int c = 0; c < NUM_COLS; ++c )
+	{
+		po.m_fReverse[c] = test_maybe( fChance, 0, 1 );
+		po.m_fStealth[c] = test_maybe( fChance, 0, 1 );
+		po.m_fConfusionZ[c] = test_maybe( fChance, -1, 1 );
+		po.m_fMovesX[c] = test_maybe( fChance, -1, 1 );
+	}
+	po.m_fScrollSpeed = test_random_range( 0.5f, 3 );
+	po.m_fMaxScrollBPM = test_random(5) == 0? 600.0f:0.0f;
+	po.m_fTimeSpacing = test_random(4) == 0? 0.5f:0.0f;
+	po.m_fRandomSpeed = test_maybe( fChance, 0, 2 );
+	po.m_fPerspectiveTilt = test_maybe( fChance, -1, 1 );
+	// The game timer keeps running from one query to the next, so drunk and
+	// blink would only match by luck.  These two only move with the song.
+	po.m_ModTimerType = test_random(2) == 0? ModTimerType_Beat:ModTimerType_Song;
+	po.m_fModTimerMult = test_maybe( fChance, -0.5f, 1 );
+	po.m_fModTimerOffset = test_maybe( fChance, -2, 2 );
+}
+
+static void SetPosition( PlayerState *pPlayerState, const TimingData &td, float fBeat )
+{
+	SongPosition &pos = pPlayerState->m_Position;
+	pos.m_fSongBeat = pos.m_fSongBeatVisible = fBeat;
+	pos.m_fMusicSeconds = pos.m_fMusicSecondsVisible = td.GetElapsedTimeFromBeat( fBeat );
+	GAMESTATE->m_Position = pos;
+}
+
+/* Taps from fBeat on, a few to a beat. */
+static void MakeBeats( ArrowEffects::NoteBatch &batch, float fBeat, unsigned iNotes )
+{
+	batch.Resize( iNotes );
+	for( unsigned i = 0; i < iNotes; ++i )
+	{
+		fBeat += test_random(3) == 0? 0.25f:0.0625f * (1 + test_random(4));
+		batch.m_fBeat[i] = fBeat;
+		batch.m_fPercentFadeToFail[i] = test_random(3) != 0? -1:test_random_range( 0, 1 );
+		batch.m_bIsHoldHead[i] = test_random(5) == 0;
+		batch.m_bIsHoldCap[i] = batch.m_bIsHoldHead[i] || test_random(5) == 0;
+	}
+}
+
+static bool Same( float a, float b )
+{
+	return memcmp( &a, &b, sizeof(float) ) == 0;
+}
+
+static const float REVERSE_OFFSET = 240, DRAW_BEFORE = 1000, FADE_IN = 0.25f;
+
+/* Every query for note i of the batch, with the given context. */
+static bool CompareNote( const char *sWhat, const ArrowEffects::FrameContext &context, const ArrowEffects::NoteBatch &batch, unsigned i )
+{
+	const float fYOffset = ArrowEffects::GetYOffset( context, batch.m_fBeat[i] );
+	RageVector3 pos;
+	ArrowEffects::GetXYZPos( context, fYOffset, pos );
+
+	const float fExpected[] = { batch.m_fYOffset[i], batch.m_fX[i], batch.m_fY[i], batch.m_fZ[i],
+		batch.m_fRotationX[i], batch.m_fRotationY[i], batch.m_fRotationZ[i],
+		batch.m_fZoom[i], batch.m_fAlpha[i], batch.m_fGlow[i] };
+	const float fGot[] = { fYOffset, pos.x, pos.y, pos.z,
+		ArrowEffects::GetRotationX( context, fYOffset, batch.m_bIsHoldCap[i] != 0 ),
+		ArrowEffects::GetRotationY( context, fYOffset ),
+		ArrowEffects::GetRotationZ( context, batch.m_fBeat[i], batch.m_bIsHoldHead[i] != 0 ),
+		ArrowEffects::GetZoom( context, fYOffset ),
+		ArrowEffects::GetAlpha( context, fYOffset, batch.m_fPercentFadeToFail[i], DRAW_BEFORE, FADE_IN ),
+		ArrowEffects::GetGlow( context, fYOffset, batch.m_fPercentFadeToFail[i], DRAW_BEFORE, FADE_IN ) };
+	static const char *sNames[] = { "y offset", "x", "y", "z", "rotation x", "rotation y", "rotation z", "zoom", "alpha", "glow" };
+
+	for( unsigned j = 0; j < ARRAYLEN(fGot); ++j )
+	{
+		if( Same(fGot[j], fExpected[j]) )
+			continue;
+		LOG->Warn( "Note %u at beat %f, %s: %s is %.9g, batch gave %.9g", i, batch.m_fBeat[i], sWhat, sNames[j], fGot[j], fExpected[j] );
+		return false;
+	}
+	return true;
+}
+
+/* Note i of the batch against the old per-note functions. */
+static bool CompareReference( const ArrowEffects::FrameContext &context, const ArrowEffects::NoteBatch &batch, unsigned i )
+{
+	const PlayerState *pPlayerState = context.m_pPlayerState;
+	const int iCol = context.m_iCol;
+	const float fBeat = batch.m_fBeat[i];
+	const float fPercentFadeToFail = batch.m_fPercentFadeToFail[i];
+
+	float fPeakYOffset, fExpectedPeakYOffset;
+	bool bIsPastPeak, bExpectedIsPastPeak;
+	ArrowEffects::GetYOffset( context, fBeat, fPeakYOffset, bIsPastPeak );
+	const float fYOffset = ReferenceArrowEffects::GetYOffset( pPlayerState, iCol, fBeat, fExpectedPeakYOffset, bExpectedIsPastPeak, false );
+
+	const float fExpected[] = { fYOffset,
+		ReferenceArrowEffects::GetMoveX(iCol) + ReferenceArrowEffects::GetXPos( pPlayerState, iCol, fYOffset ),
+		ReferenceArrowEffects::GetMoveY(iCol) + ReferenceArrowEffects::GetYPos( pPlayerState, iCol, fYOffset, REVERSE_OFFSET, true ),
+		ReferenceArrowEffects::GetMoveZ(iCol) + ReferenceArrowEffects::GetZPos( pPlayerState, iCol, fYOffset ),
+		ReferenceArrowEffects::GetRotationX( pPlayerState, fYOffset, batch.m_bIsHoldCap[i] != 0, iCol ),
+		ReferenceArrowEffects::GetRotationY( pPlayerState, fYOffset, iCol ),
+		ReferenceArrowEffects::GetRotationZ( pPlayerState, fBeat, batch.m_bIsHoldHead[i] != 0, iCol ),
+		ReferenceArrowEffects::GetZoom( pPlayerState, fYOffset, iCol ),
+		ReferenceArrowEffects::GetAlpha( pPlayerState, iCol, fYOffset, fPercentFadeToFail, REVERSE_OFFSET, DRAW_BEFORE, FADE_IN ),
+		ReferenceArrowEffects::GetGlow( pPlayerState, iCol, fYOffset, fPercentFadeToFail, REVERSE_OFFSET, DRAW_BEFORE, FADE_IN ),
+		fExpectedPeakYOffset, bExpectedIsPastPeak? 1.0f:0.0f };
+	const float fGot[] = { batch.m_fYOffset[i], batch.m_fX[i], batch.m_fY[i], batch.m_fZ[i],
+		batch.m_fRotationX[i], batch.m_fRotationY[i], batch.m_fRotationZ[i],
+		batch.m_fZoom[i], batch.m_fAlpha[i], batch.m_fGlow[i],
+		fPeakYOffset, bIsPastPeak? 1.0f:0.0f };
+	static const char *sNames[] = { "y offset", "x", "y", "z", "rotation x", "rotation y", "rotation z", "zoom", "alpha", "glow",
+		"peak y offset", "past peak" };
+
+	for( unsigned j = 0; j < ARRAYLEN(fGot); ++j )
+	{
+		if( Same(fGot[j], fExpected[j]) )
+			continue;
+		LOG->Warn( "Note %u at beat %f: %s is %.9g, the old functions gave %.9g", i, fBeat, sNames[j], fGot[j], fExpected[j] );
+		return false;
+	}
+	return true;
+}
+
+static bool Compare( PlayerState *pPlayerState, const TimingData &td, int iTrials )
+{
+	ArrowEffects::NoteBatch batch;
+	PlayerOptions &po = pPlayerState->m_PlayerOptions.GetCurrent();
+	for( int i = 0; i < iTrials; ++i )
+	{
+		MakeOptions( po, 0.15f );
+		ArrowEffects::SetCurrentOptions( &po );
+		ReferenceArrowEffects::SetCurrentOptions( &po );
+		GAMESTATE->m_bInStepEditor = test_random(6) == 0;
+		const float fSongBeat = test_random_range( -2, 60 );
+		SetPosition( pPlayerState, td, fSongBeat );
+
+		const int iCol = test_random( NUM_COLS );
+		ArrowEffects::FrameContext context;
+		context.Load( pPlayerState, iCol, REVERSE_OFFSET );
+
+		MakeBeats( batch, fSongBeat - 4, 1 + test_random(300) );
+		ArrowEffects::GetYOffsets( context, batch );
+		ArrowEffects::GetNoteEffects( context, batch, DRAW_BEFORE, FADE_IN );
+
+		for( unsigned n = 0; n < batch.Size(); ++n )
+		{
+			ArrowEffects::FrameContext note_context;
+			note_context.Load( pPlayerState, iCol, REVERSE_OFFSET );
+			if( !CompareNote("column context", context, batch, n) ||
+				!CompareNote("note context", note_context, batch, n) ||
+				!CompareReference(context, batch, n) )
+			{
+				LOG->Warn( "Trial %i failed (%s)", i, po.GetString().c_str() );
+				return false;
+			}
+		}
+	}
+
+	LOG->Trace( "%i trials matched.", iTrials );
+	return true;
+}
+
+static bool run()
+{
+	GAMESTATE->SetCurGame( GAMEMAN->GetDefaultGame() );
+	GAMESTATE->SetCurrentStyle( GAMEMAN->GameAndStringToStyle(GAMESTATE->GetCurrentGame(), "single"), PLAYER_INVALID );
+	THEME->SwitchThemeAndLanguage( "_fallback", "en", false );
+
+	Song song;
+	Steps *pSteps = song.CreateSteps();
+	song.AddSteps( pSteps );
+	TimingData &td = song.m_SongTiming;
+	td.AddSegment( BPMSegment(0, 150) );
+	td.AddSegment( BPMSegment(BeatToNoteRow(40), 300) );
+	td.AddSegment( ScrollSegment(0, 1) );
+	td.AddSegment( ScrollSegment(BeatToNoteRow(16), 2.5f) );
+	td.AddSegment( ScrollSegment(BeatToNoteRow(24), -0.5f) );
+	td.AddSegment( ScrollSegment(BeatToNoteRow(30), 1) );
+	td.AddSegment( SpeedSegment(BeatToNoteRow(8), 1.5f, 2.0f) );
+	GAMESTATE->m_pCurSteps[PLAYER_1].Set( pSteps );
+
+	NoteData nd;
+	nd.SetNumTracks( NUM_COLS );
+	for( int iRow = 0; iRow < 1600; iRow += ROWS_PER_BEAT/4 )
+		nd.SetTapNote( test_random(NUM_COLS), iRow, TAP_ORIGINAL_TAP );
+
+	PlayerState *pPlayerState = GAMESTATE->m_pPlayerState[PLAYER_1];
+	pPlayerState->m_fReadBPM = 150;
+	pPlayerState->m_pNoteFieldCache = NoteFieldCache::Get( td, nd );
+	ArrowEffects::Init( PLAYER_1 );
+	ReferenceArrowEffects::Init( PLAYER_1 );
+
+	const bool bOK = Compare( pPlayerState, td, 2000 );
+
+	GAMESTATE->m_pCurSteps[PLAYER_1].Set( nullptr );
+	pPlayerState->m_pNoteFieldCache.reset();
+	return bOK;
+}
+
+int main( int argc, char *argv[] )
+{
+	LUA			= new LuaManager;
+	FILEMAN			= new RageFileManager( argv[0] );
+	FILEMAN->Mount( "dir", ".", "" );
+	LOG			= new RageLog();
+	PREFSMAN		= new PrefsManager;
+	GAMEMAN			= new GameManager;
+	THEME			= new ThemeManager;
+	GAMESTATE		= new GameState;
+	LOG->SetShowLogOutput( true );
+	LOG->SetFlushing( true );
+
+	const bool bOK = run();
+
+	delete GAMESTATE;
+	delete THEME;
+	delete GAMEMAN;
+	delete PREFSMAN;
+	delete LOG;
+	delete FILEMAN;
+	delete LUA;
+
+	exit( bOK? 0:1 );
+}
@@ -0,0 +1,134 @@
+#include "global.h"
+#include "RageLog.h"
+#include "RageFile.h"
+#include "RageFileManager.h"
+#include "RageUtil.h"
+#include "BitmapText.h"
+#include "Font.h"
+#include "LuaManager.h"
+#include "PrefsManager.h"
+#include "test_misc.h"
+
+#include <vector>
+
+/* Checks that layouts from BitmapText's shared cache match laying the text
+ * out again, for the same font and after the font is reloaded. */
+
+static const char *CHARS = " 0123456789:.,%ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+
+/* A font page with glyphs of random widths, and no textures. */
+static void AddPage( Font &font )
+{
+	FontPage *pPage = new FontPage;
+	pPage->m_iHeight = 16 + test_random(16);
+	pPage->m_iLineSpacing = pPage->m_iHeight + test_random(8);
+	pPage->m_fVshift = -float(pPage->m_iHeight/2);
+
+	std::vector<wchar_t> vChars( CHARS, CHARS + strlen(CHARS) );
+	vChars.push_back( FONT_DEFAULT_GLYPH );
+	for( wchar_t c : vChars )
+	{
+		glyph g;
+		g.m_pPage = pPage;
+		g.m_iHadvance = 4 + test_random(16);
+		g.m_fWidth = float(g.m_iHadvance + test_random(3));
+		g.m_fHeight = float(pPage->m_iHeight);
+		g.m_fHshift = float(test_random(3) - 1);
+		g.m_TexRect = RectF( test_random(100) / 100.0f, test_random(100) / 100.0f, test_random(100) / 100.0f, test_random(100) / 100.0f );
+		pPage->m_iCharToGlyphNo[c] = pPage->m_aGlyphs.size();
+		pPage->m_aGlyphs.push_back( g );
+	}
+
+	font.AddPage( pPage );
+	font.SetDefaultGlyph( pPage );
+}
+
+static RString MakeText()
+{
+	RString s;
+	const int iLength = test_random(40);
+	for( int i = 0; i < iLength; ++i )
+	{
+		if( test_random(20) == 0 )
+			s += '\n';
+		else
+			s += CHARS[test_random(strlen(CHARS))];
+	}
+	return s;
+}
+
+static bool SameLayout( const BitmapText::GlyphLayout &a, const BitmapText::GlyphLayout &b )
+{
+	if( a.m_wTextLines != b.m_wTextLines || a.m_iLineWidths != b.m_iLineWidths )
+		return false;
+	if( a.m_size.x != b.m_size.x || a.m_size.y != b.m_size.y )
+		return false;
+	if( a.m_vpFontPageTextures != b.m_vpFontPageTextures || a.m_aVertices.size() != b.m_aVertices.size() )
+		return false;
+	for( unsigned i = 0; i < a.m_aVertices.size(); ++i )
+	{
+		const RageSpriteVertex &va = a.m_aVertices[i], &vb = b.m_aVertices[i];
+		if( va.p.x != vb.p.x || va.p.y != vb.p.y || va.p.z != vb.p.z || va.t.x != vb.t.x || va.t.y != vb.t.y )
+			return false;
+	}
+	return true;
+}
+
+static bool Compare( int iStrings )
+{
+	Font font;
+	AddPage( font );
+
+	const float fAligns[] = { 0.0f, 0.5f, 1.0f };
+	for( int i = 0; i < iStrings; ++i )
+	{
+		// Reloading the font has to throw away everything laid out from it.
+		if( test_random(100) == 0 )
+		{
+			font.Unload();
+			AddPage( font );
+		}
+
+		const RString sText = MakeText();
+		const int iWrap = test_random(3) == 0? 40 + test_random(200):-1;
+		const int iVertSpacing = test_random(3) - 1;
+		const float fAlign = fAligns[test_random(3)];
+
+		BitmapText::GlyphLayout expected;
+		BitmapText::LayOut( &font, sText, iWrap, iVertSpacing, fAlign, expected );
+		// Once to lay it out and once to find it.
+		for( int j = 0; j < 2; ++j )
+		{
+			const BitmapText::GlyphLayout &got = BitmapText::GetLayout( &font, sText, iWrap, iVertSpacing, fAlign );
+			if( !SameLayout(got, expected) )
+			{
+				LOG->Warn( "\"%s\" (wrap %i, spacing %i, align %.1f) laid out differently from the cache",
+					sText.c_str(), iWrap, iVertSpacing, fAlign );
+				return false;
+			}
+		}
+	}
+
+	LOG->Trace( "%i strings laid out the same from the cache.", iStrings );
+	return true;
+}
+
+int main( int argc, char *argv[] )
+{
+	LUA			= new LuaManager;
+	FILEMAN			= new RageFileManager( argv[0] );
+	FILEMAN->Mount( "dir", ".", "" );
+	LOG			= new RageLog();
+	PREFSMAN		= new PrefsManager;
+	LOG->SetShowLogOutput( true );
+	LOG->SetFlushing( true );
+
+	const bool bOK = Compare( 20000 );
+
+	delete PREFSMAN;
+	delete LOG;
+	delete FILEMAN;
+	delete LUA;
+
+	exit( bOK? 0:1 );
+}
@@ -0,0 +1,179 @@
+#include "global.h"
+#include "RageLog.h"
+#include "RageFile.h"
+#include "RageFileManager.h"
+#include "RageUtil.h"
+#include "Font.h"
+#include "FontCache.h"
+#include "SpecialFiles.h"
+#include "LuaManager.h"
+#include "PrefsManager.h"
+#include "test_misc.h"
+
+#include <vector>
+
+/* Writes random compiled fonts to the font cache, checks that they read back
+ * the same, and that a changed hash or a damaged file reads back nothing. */
+
+/* A page mapped the way theme fonts usually are: a code page or two,
+ * a run of Unicode, a few single characters and some widths. */
+static FontPageSettings MakePage( int iPage )
+{
+	FontPageSettings cfg;
+	cfg.m_sTexturePath = ssprintf( "/Themes/_fallback/Fonts/Common Normal [page%i] 16x16.png", iPage );
+	cfg.m_iDrawExtraPixelsLeft = test_random(4);
+	cfg.m_iDrawExtraPixelsRight = test_random(4);
+	cfg.m_iAddToAllWidths = test_random(3) - 1;
+	cfg.m_iLineSpacing = test_random(2)? -1:16 + test_random(32);
+	cfg.m_iTop = test_random(2)? -1:test_random(16);
+	cfg.m_iBaseline = test_random(2)? -1:16 + test_random(16);
+	cfg.m_iDefaultWidth = test_random(2)? -1:8 + test_random(16);
+	cfg.m_iAdvanceExtraPixels = test_random(3);
+	cfg.m_fScaleAllWidthsBy = test_random(2)? 1.0f:test_random(200) / 100.0f;
+	cfg.m_sTextureHints = test_random(2)? "default":"16bpp";
+
+	cfg.MapRange( test_random(2)? "ascii":"cp1252", 0, 0, -1 );
+	if( test_random(2) )
+		cfg.MapRange( "Unicode", 0x3041 + test_random(64), test_random(256), 64 + test_random(1024) );
+	for( int i = test_random(20); i > 0; --i )
+		cfg.CharToGlyphNo[wchar_t(0x2000 + test_random(0x1000))] = test_random(256);
+	for( int i = test_random(40); i > 0; --i )
+		cfg.m_mapGlyphWidths[test_random(256)] = test_random(32);
+	return cfg;
+}
+
+static CompiledFont MakeFont()
+{
+	CompiledFont font;
+	font.m_iHash = g_iTestSeed;
+	font.m_fCompileSeconds = test_random(1000) / 1000.0f;
+	font.m_bCapitalsOnly = test_random(10) == 0;
+	font.m_bRightToLeft = test_random(10) == 0;
+	font.m_bDistanceField = test_random(10) == 0;
+	font.m_bHasDefaultStrokeColor = test_random(2) == 0;
+	if( font.m_bHasDefaultStrokeColor )
+		font.m_DefaultStrokeColor = RageColor( test_random(100) / 100.0f, test_random(100) / 100.0f, test_random(100) / 100.0f, 1 );
+	for( int i = test_random(3); i > 0; --i )
+		font.m_vsImports.push_back( ssprintf("Common import%i", test_random(10)) );
+	for( int i = 1 + test_random(3); i > 0; --i )
+		font.m_vPages.push_back( MakePage(i) );
+	return font;
+}
+
+static bool SamePage( const FontPageSettings &a, const FontPageSettings &b )
+{
+	return a.m_sTexturePath == b.m_sTexturePath &&
+		a.m_iDrawExtraPixelsLeft == b.m_iDrawExtraPixelsLeft &&
+		a.m_iDrawExtraPixelsRight == b.m_iDrawExtraPixelsRight &&
+		a.m_iAddToAllWidths == b.m_iAddToAllWidths &&
+		a.m_iLineSpacing == b.m_iLineSpacing &&
+		a.m_iTop == b.m_iTop &&
+		a.m_iBaseline == b.m_iBaseline &&
+		a.m_iDefaultWidth == b.m_iDefaultWidth &&
+		a.m_iAdvanceExtraPixels == b.m_iAdvanceExtraPixels &&
+		a.m_fScaleAllWidthsBy == b.m_fScaleAllWidthsBy &&
+		a.m_sTextureHints == b.m_sTextureHints &&
+		a.CharToGlyphNo == b.CharToGlyphNo &&
+		a.m_mapGlyphWidths == b.m_mapGlyphWidths;
+}
+
+static bool SameFont( const CompiledFont &a, const CompiledFont &b )
+{
+	if( a.m_iHash != b.m_iHash || a.m_fCompileSeconds != b.m_fCompileSeconds )
+		return false;
+	if( a.m_bCapitalsOnly != b.m_bCapitalsOnly || a.m_bRightToLeft != b.m_bRightToLeft || a.m_bDistanceField != b.m_bDistanceField )
+		return false;
+	if( a.m_bHasDefaultStrokeColor != b.m_bHasDefaultStrokeColor || a.m_DefaultStrokeColor != b.m_DefaultStrokeColor )
+		return false;
+	if( a.m_vsImports != b.m_vsImports || a.m_vPages.size() != b.m_vPages.size() )
+		return false;
+	for( unsigned i = 0; i < a.m_vPages.size(); ++i )
+		if( !SamePage(a.m_vPages[i], b.m_vPages[i]) )
+			return false;
+	return true;
+}
+
+static RString FontPath( int i )
+{
+	return ssprintf( "/Themes/_fallback/Fonts/Font%i.ini", i );
+}
+
+static RString FontChars( int i )
+{
+	return i % 5 == 0? "0123456789":"";
+}
+
+static bool Compare( int iFonts )
+{
+	FontCache::Clear();
+	std::vector<CompiledFont> vFonts;
+	for( int i = 0; i < iFonts; ++i )
+	{
+		vFonts.push_back( MakeFont() );
+		FontCache::Add( FontPath(i), FontChars(i), vFonts.back() );
+	}
+	FontCache::Save();
+
+	// Read back from the file, not what's in memory.
+	FontCache::Clear();
+	for( int i = 0; i < iFonts; ++i )
+	{
+		const CompiledFont *pFont = FontCache::Get( FontPath(i), FontChars(i), vFonts[i].m_iHash );
+		if( pFont == nullptr || !SameFont(*pFont, vFonts[i]) )
+		{
+			LOG->Warn( "Font %i read back differently from the cache", i );
+			return false;
+		}
+		if( FontCache::Get(FontPath(i), FontChars(i), vFonts[i].m_iHash + 1) != nullptr ||
+			FontCache::Get(FontPath(i), FontChars(i) + "x", vFonts[i].m_iHash) != nullptr )
+		{
+			LOG->Warn( "Font %i was found with a different hash or characters", i );
+			return false;
+		}
+	}
+
+	// A write that didn't finish has to be thrown away as a whole.
+	RString sBuf;
+	{
+		RageFile f;
+		f.Open( SpecialFiles::CACHE_DIR + "fonts.cache" );
+		f.Read( sBuf );
+	}
+	{
+		RageFile f;
+		f.Open( SpecialFiles::CACHE_DIR + "fonts.cache", RageFile::WRITE );
+		f.Write( sBuf.substr(0, sBuf.size() / 2) );
+	}
+	FontCache::Clear();
+	for( int i = 0; i < iFonts; ++i )
+	{
+		if( FontCache::Get(FontPath(i), FontChars(i), vFonts[i].m_iHash) != nullptr )
+		{
+			LOG->Warn( "Font %i was read from a damaged cache", i );
+			return false;
+		}
+	}
+
+	LOG->Trace( "%i fonts read back the same from the cache.", iFonts );
+	return true;
+}
+
+int main( int argc, char *argv[] )
+{
+	LUA			= new LuaManager;
+	FILEMAN			= new RageFileManager( argv[0] );
+	FILEMAN->Mount( "dir", ".", "" );
+	LOG			= new RageLog();
+	PREFSMAN		= new PrefsManager;
+	LOG->SetShowLogOutput( true );
+	LOG->SetFlushing( true );
+
+	const bool bOK = Compare( 200 );
+
+	delete PREFSMAN;
+	delete LOG;
+	delete FILEMAN;
+	delete LUA;
+
+	exit( bOK? 0:1 );
+}
@@ -0,0 +1,333 @@
+#include "global.h"
+#include "RageLog.h"
+#include "RageFile.h"
+#include "RageFileManager.h"
+#include "RageUtil.h"
+#include "RageDisplay.h"
+#include "RageDisplay_Null.h"
+#include "RageTexture.h"
+#include "RageTextureManager.h"
+#include "ArrowEffects.h"
+#include "GameManager.h"
+#include "GameState.h"
+#include "LuaManager.h"
+#include "NoteData.h"
+#include "NoteDisplay.h"
+#include "NoteFieldCache.h"
+#include "PlayerState.h"
+#include "PrefsManager.h"
+#include "Song.h"
+#include "Sprite.h"
+#include "Steps.h"
+#include "ThemeManager.h"
+#include "test_misc.h"
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+/* Draws hold tops, bodies and bottoms under random mods that leave the
+ * hold's shape and alpha alone, once the way NoteDisplay does (a row only
+ * at the ends and where the fade in starts and stops) and once with a row
+ * every y_step pixels, worked out from scratch the way holds were always
+ * drawn.  Every row of the second strip has to lie on the first one: same
+ * position, texture coordinates and color, for both the alpha and the glow
+ * pass. */
+
+static const int NUM_COLS = 4;
+static const float REVERSE_OFFSET = 240;
+
+/* Collects each row (left, center, right) of the strips DrawHoldPart draws. */
+class RecordingDisplay: public RageDisplay_Null
+{
+public:
+	std::vector<RageSpriteVertex> m_vRows;
+
+protected:
+	void DrawSymmetricQuadStripInternal( const RageSpriteVertex v[], int iNumVerts )
+	{
+		m_vRows.insert( m_vRows.end(), v, v + iNumVerts );
+	}
+};
+
+class FakeTexture: public RageTexture
+{
+public:
+	FakeTexture( int iWidth, int iHeight ):
+		RageTexture( RageTextureID(ssprintf("fake %ix%i.png", iWidth, iHeight)) )
+	{
+		m_iSourceWidth = m_iTextureWidth = m_iImageWidth = iWidth;
+		m_iSourceHeight = m_iTextureHeight = m_iImageHeight = iHeight;
+		m_TextureCoordRects.push_back( RectF(0, 0, 1, 1) );
+	}
+	uintptr_t GetTexHandle() const { return 1; }
+};
+
+/* A hold only gets the short strip when nothing bends it, twists it, widens
+ * it along its length or changes its alpha other than linearly down it.
+ * These are the effects that leave it alone; parabola y isn't one of the
+ * ArrowEffects mod groups, so it's left out by hand. */
+static std::vector<int> g_viFlatEffects;
+static void FindFlatEffects( PlayerState *pPlayerState )
+{
+	typedef ArrowEffects::FrameContext FrameContext;
+	PlayerOptions &po = pPlayerState->m_PlayerOptions.GetCurrent();
+	for( int i = 0; i < PlayerOptions::NUM_EFFECTS; ++i )
+	{
+		po = PlayerOptions();
+		po.m_fEffects[i] = 1;
+		ArrowEffects::SetCurrentOptions( &po );
+		FrameContext context;
+		context.Load( pPlayerState, 0, REVERSE_OFFSET );
+		if( !context.IsOn(FrameContext::MOD_XPOS | FrameContext::MOD_YPOS |
+			FrameContext::MOD_ZPOS | FrameContext::MOD_ROTATION_Y | FrameContext::MOD_ZOOM) &&
+			i != PlayerOptions::EFFECT_PARABOLA_Y )
+			g_viFlatEffects.push_back( i );
+	}
+}
+
+static void MakeOptions( PlayerOptions &po )
+{
+	const PlayerNumber pn = po.m_pn;
+	po = PlayerOptions();
+	po.m_pn = pn;
+	for( int i : g_viFlatEffects )
+		po.m_fEffects[i] = test_maybe( 0.15f, -1.5f, 1.5f );
+	for( int i = 0; i < PlayerOptions::NUM_ACCELS; ++i )
+		po.m_fAccels[i] = test_maybe( 0.2f, -1, 1.5f );
+	for( int i = 0; i < PlayerOptions::NUM_SCROLLS; ++i )
+		po.m_fScrolls[i] = test_maybe( 0.2f, 0, 1 );
+	for( int c = 0; c < NUM_COLS; ++c )
+	{
+		po.m_fReverse[c] = test_maybe( 0.2f, 0, 1 );
+		po.m_fConfusionZ[c] = test_maybe( 0.2f, -1, 1 );
+		po.m_fMovesX[c] = test_maybe( 0.2f, -1, 1 );
+	}
+	po.m_fScrollSpeed = test_random_range( 0.5f, 3 );
+	po.m_fMaxScrollBPM = test_random(5) == 0? 600.0f:0.0f;
+	po.m_fTimeSpacing = test_random(4) == 0? 0.5f:0.0f;
+	po.m_ModTimerType = test_random(2) == 0? ModTimerType_Beat:ModTimerType_Song;
+}
+
+static void SetPosition( PlayerState *pPlayerState, const TimingData &td, float fBeat )
+{
+	SongPosition &pos = pPlayerState->m_Position;
+	pos.m_fSongBeat = pos.m_fSongBeatVisible = fBeat;
+	pos.m_fMusicSeconds = pos.m_fMusicSecondsVisible = td.GetElapsedTimeFromBeat( fBeat );
+	GAMESTATE->m_Position = pos;
+}
+
+static bool Close( float a, float b, float fTolerance )
+{
+	return std::abs(a - b) <= fTolerance * std::max( 1.0f, std::abs(a) );
+}
+
+/* Whether every row of vFine lies on the strip vCoarse.  Rows are found by
+ * their center's y, which goes down the hold in both.  A row of vFine that
+ * isn't on vCoarse at all has to be one vCoarse skipped for being
+ * transparent.  Where the alpha drops straight to nothing at fEdgeY, vFine
+ * fades it out over whichever step that falls in and vCoarse over a pixel,
+ * so rows within a step of it aren't compared. */
+static bool CompareRows( const std::vector<RageSpriteVertex> &vCoarse, const std::vector<RageSpriteVertex> &vFine,
+	float fEdgeY, float fStep, RString &sError )
+{
+	for( unsigned i = 0; i < vFine.size(); i += 3 )
+	{
+		const float fY = vFine[i+1].p.y;
+		if( std::abs(fY - fEdgeY) < fStep )
+			continue;
+		unsigned j = 0;
+		while( j + 3 < vCoarse.size() && !(vCoarse[j+1].p.y <= fY && fY <= vCoarse[j+4].p.y) )
+			j += 3;
+		if( j + 3 >= vCoarse.size() )
+		{
+			if( vFine[i].c.a <= 1 )
+				continue;
+			sError = ssprintf( "row %u at y %f is not on the strip", i/3, fY );
+			return false;
+		}
+
+		const float fSpan = vCoarse[j+4].p.y - vCoarse[j+1].p.y;
+		const float fPercent = fSpan == 0? 0:(fY - vCoarse[j+1].p.y) / fSpan;
+		for( int k = 0; k < 3; ++k )
+		{
+			const RageSpriteVertex &a = vCoarse[j+k], &b = vCoarse[j+3+k], &got = vFine[i+k];
+			const float fExpected[] = {
+				lerp( fPercent, a.p.x, b.p.x ), lerp( fPercent, a.p.y, b.p.y ), lerp( fPercent, a.p.z, b.p.z ),
+				lerp( fPercent, a.t.x, b.t.x ), lerp( fPercent, a.t.y, b.t.y ),
+				lerp( fPercent, float(a.c.r), float(b.c.r) ), lerp( fPercent, float(a.c.g), float(b.c.g) ),
+				lerp( fPercent, float(a.c.b), float(b.c.b) ), lerp( fPercent, float(a.c.a), float(b.c.a) ) };
+			const float fGot[] = { got.p.x, got.p.y, got.p.z, got.t.x, got.t.y,
+				float(got.c.r), float(got.c.g), float(got.c.b), float(got.c.a) };
+			// Positions to well under a pixel; colors to a step, since they're bytes.
+			const float fTolerance[] = { 0.01f, 0.01f, 0.01f, 0.0001f, 0.0001f, 1.01f, 1.01f, 1.01f, 1.01f };
+			static const char *sNames[] = { "x", "y", "z", "texture x", "texture y", "red", "green", "blue", "alpha" };
+			for( unsigned n = 0; n < ARRAYLEN(fGot); ++n )
+			{
+				if( n < 5? Close(fGot[n], fExpected[n], fTolerance[n]):std::abs(fGot[n] - fExpected[n]) <= fTolerance[n] )
+					continue;
+				sError = ssprintf( "row %u at y %f, vertex %i: %s is %f, the strip has %f", i/3, fY, k, sNames[n], fGot[n], fExpected[n] );
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+static bool Compare( RecordingDisplay &display, PlayerState *pPlayerState, const TimingData &td, Sprite &sprite, int iTrials )
+{
+	PlayerOptions &po = pPlayerState->m_PlayerOptions.GetCurrent();
+	const NCSplineHandler handler;
+	int iCoarseRows = 0, iFineRows = 0;
+	for( int i = 0; i < iTrials; ++i )
+	{
+		MakeOptions( po );
+		ArrowEffects::SetCurrentOptions( &po );
+		const float fSongBeat = test_random_range( 0, 60 );
+		SetPosition( pPlayerState, td, fSongBeat );
+
+		NoteFieldRenderArgs field_args;
+		field_args.player_state= pPlayerState;
+		field_args.reverse_offset_pixels= REVERSE_OFFSET;
+		field_args.draw_pixels_after_targets= -test_random_range( 0, 200 );
+		field_args.draw_pixels_before_targets= test_random_range( 200, 1500 );
+		field_args.fade_before_targets= test_random(3) == 0? 0:test_random_range( 0, 1 );
+
+		NoteColumnRenderArgs column_args;
+		column_args.pos_handler= column_args.rot_handler= column_args.zoom_handler= &handler;
+		column_args.diffuse= RageColor( test_random_range(0, 1), test_random_range(0, 1), test_random_range(0, 1), test_random_range(0.5f, 1) );
+		column_args.glow= RageColor( 1, 1, 1, 0 );
+		column_args.song_beat= fSongBeat;
+		column_args.column= test_random( NUM_COLS );
+		column_args.ae_context.Load( pPlayerState, column_args.column, REVERSE_OFFSET );
+
+		// What DrawHoldBody works out for each part.
+		const bool reverse= po.GetReversePercentForColumn( column_args.column ) > 0.5f;
+		const int part_type= test_random( 3 );
+		const float top_beat= fSongBeat + test_random_range( -2, 8 );
+		const float bottom_beat= part_type == NoteDisplay::hpt_body? top_beat + test_random_range( 0.25f, 16 ):top_beat;
+		const float y_top= ArrowEffects::GetYPos( column_args.ae_context, ArrowEffects::GetYOffset(column_args.ae_context, top_beat) );
+		const float y_bottom= part_type == NoteDisplay::hpt_body?
+			ArrowEffects::GetYPos( column_args.ae_context, ArrowEffects::GetYOffset(column_args.ae_context, bottom_beat) ):
+			y_top + sprite.GetUnzoomedHeight() * ArrowEffects::GetZoom( column_args.ae_context, 0 );
+
+		NoteDisplay::draw_hold_part_args part_args;
+		part_args.y_step= test_random(2) == 0? 4:16;
+		part_args.percent_fade_to_fail= test_random(3) != 0? -1:test_random_range( 0, 1 );
+		part_args.color_scale= test_random_range( 0.5f, 1 );
+		part_args.overlapped_time= 0;
+		part_args.y_top= std::min( y_top, y_bottom );
+		part_args.y_bottom= std::max( y_top, y_bottom );
+		part_args.y_start_pos= ArrowEffects::GetYPos( column_args.ae_context, field_args.draw_pixels_after_targets );
+		part_args.y_end_pos= ArrowEffects::GetYPos( column_args.ae_context, field_args.draw_pixels_before_targets );
+		if( reverse )
+			std::swap( part_args.y_start_pos, part_args.y_end_pos );
+		part_args.top_beat= top_beat;
+		part_args.bottom_beat= bottom_beat;
+		part_args.wrapping= part_type == NoteDisplay::hpt_body;
+		part_args.anchor_to_top= test_random(2) == 0;
+		part_args.flip_texture_vertically= test_random(2) == 0;
+
+		const float fEdgeY= field_args.fade_before_targets == 0?
+			ArrowEffects::GetYPos( column_args.ae_context, field_args.draw_pixels_before_targets ) + ArrowEffects::GetMoveY( column_args.column ):
+			std::numeric_limits<float>::infinity();
+
+		std::vector<Sprite*> vpSpr( 1, &sprite );
+		for( int glow = 0; glow < 2; ++glow )
+		{
+			display.m_vRows.clear();
+			part_args.sample_every_step= false;
+			NoteDisplay::DrawHoldPart( vpSpr, field_args, column_args, part_args, glow != 0, part_type );
+			const std::vector<RageSpriteVertex> vCoarse= display.m_vRows;
+
+			display.m_vRows.clear();
+			part_args.sample_every_step= true;
+			NoteDisplay::DrawHoldPart( vpSpr, field_args, column_args, part_args, glow != 0, part_type );
+
+			RString sError;
+			if( !CompareRows(vCoarse, display.m_vRows, fEdgeY, part_args.y_step + 1.0f, sError) )
+			{
+				LOG->Warn( "Trial %i, part %i%s: %s (%s)", i, part_type, glow? " glow":"", sError.c_str(), po.GetString().c_str() );
+				return false;
+			}
+			iCoarseRows += vCoarse.size() / 3;
+			iFineRows += display.m_vRows.size() / 3;
+		}
+	}
+
+	LOG->Trace( "%i trials matched: %i rows drawn, %i with a row every step.", iTrials, iCoarseRows, iFineRows );
+	return true;
+}
+
+static bool run( RecordingDisplay &display )
+{
+	GAMESTATE->SetCurGame( GAMEMAN->GetDefaultGame() );
+	GAMESTATE->SetCurrentStyle( GAMEMAN->GameAndStringToStyle(GAMESTATE->GetCurrentGame(), "single"), PLAYER_INVALID );
+	THEME->SwitchThemeAndLanguage( "_fallback", "en", false );
+
+	Song song;
+	Steps *pSteps = song.CreateSteps();
+	song.AddSteps( pSteps );
+	TimingData &td = song.m_SongTiming;
+	td.AddSegment( BPMSegment(0, 150) );
+	td.AddSegment( BPMSegment(BeatToNoteRow(40), 300) );
+	td.AddSegment( ScrollSegment(0, 1) );
+	td.AddSegment( ScrollSegment(BeatToNoteRow(16), 2.5f) );
+	td.AddSegment( ScrollSegment(BeatToNoteRow(30), 1) );
+	GAMESTATE->m_pCurSteps[PLAYER_1].Set( pSteps );
+
+	NoteData nd;
+	nd.SetNumTracks( NUM_COLS );
+	for( int iRow = 0; iRow < 1600; iRow += ROWS_PER_BEAT )
+		nd.AddHoldNote( test_random(NUM_COLS), iRow, iRow + ROWS_PER_BEAT/2, TAP_ORIGINAL_HOLD_HEAD );
+
+	PlayerState *pPlayerState = GAMESTATE->m_pPlayerState[PLAYER_1];
+	pPlayerState->m_fReadBPM = 150;
+	pPlayerState->m_pNoteFieldCache = NoteFieldCache::Get( td, nd );
+	ArrowEffects::Init( PLAYER_1 );
+	FindFlatEffects( pPlayerState );
+
+	FakeTexture *pTexture = new FakeTexture( 64, 32 );
+	Sprite sprite;
+	sprite.SetTexture( TEXTUREMAN->CopyTexture(pTexture) );
+
+	const bool bOK = Compare( display, pPlayerState, td, sprite, 2000 );
+
+	sprite.UnloadTexture();
+	delete pTexture;
+	GAMESTATE->m_pCurSteps[PLAYER_1].Set( nullptr );
+	pPlayerState->m_pNoteFieldCache.reset();
+	return bOK;
+}
+
+int main( int argc, char *argv[] )
+{
+	LUA			= new LuaManager;
+	FILEMAN			= new RageFileManager( argv[0] );
+	FILEMAN->Mount( "dir", ".", "" );
+	LOG			= new RageLog();
+	PREFSMAN		= new PrefsManager;
+	GAMEMAN			= new GameManager;
+	THEME			= new ThemeManager;
+	GAMESTATE		= new GameState;
+	LOG->SetShowLogOutput( true );
+	LOG->SetFlushing( true );
+
+	RecordingDisplay *pDisplay = new RecordingDisplay;
+	DISPLAY			= pDisplay;
+	TEXTUREMAN		= new RageTextureManager;
+	const bool bOK = run( *pDisplay );
+	delete TEXTUREMAN;
+	DISPLAY			= nullptr;
+	delete pDisplay;
+
+	delete GAMESTATE;
+	delete THEME;
+	delete GAMEMAN;
+	delete PREFSMAN;
+	delete LOG;
+	delete FILEMAN;
+	delete LUA;
+
+	exit( bOK? 0:1 );
+}
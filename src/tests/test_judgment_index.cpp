@@ -0,0 +1,343 @@
+#include "global.h"
+#include "RageLog.h"
+#include "RageFile.h"
+#include "RageFileManager.h"
+#include "RageUtil.h"
+#include "JudgmentIndex.h"
+#include "NoteData.h"
+#include "TimingData.h"
+#include "test_misc.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+/* Replays recorded steps against a chart the way Player::Step looks for the
+ * note each one hits, once with the NoteData search Player used to do and
+ * once with JudgmentIndex, and checks that every step lands on the same note
+ * and gets the same judgment. */
+
+static const int NUM_TRACKS = 4;
+static const float STEP_SEARCH_DISTANCE = 1.0f;
+static const float MISS_WINDOW = 0.18f;
+
+/* The search Player::GetClosestNoteDirectional did before. */
+static int ReferenceClosestNoteDirectional( const NoteData &nd, const TimingData &td, int col, int iStartRow, int iEndRow, bool bAllowGraded, bool bForward )
+{
+	NoteData::const_iterator begin, end;
+	nd.GetTapNoteRange( col, iStartRow, iEndRow, begin, end );
+
+	if( !bForward )
+		std::swap( begin, end );
+
+	while( begin != end )
+	{
+		if( !bForward )
+			--begin;
+
+		do {
+			const TapNote &tn = begin->second;
+			if( !td.IsJudgableAtRow(begin->first) )
+				break;
+			if( tn.type == TapNoteType_Empty || tn.type == TapNoteType_AutoKeysound )
+				break;
+			if( !bAllowGraded && tn.result.tns != TNS_None )
+				break;
+
+			return begin->first;
+		} while(0);
+
+		if( bForward )
+			++begin;
+	}
+
+	return -1;
+}
+
+static int ReferenceClosestNote( const NoteData &nd, const TimingData &td, int col, int iNoteRow, int iMaxRowsAhead, int iMaxRowsBehind, bool bAllowGraded )
+{
+	int iNextIndex = ReferenceClosestNoteDirectional( nd, td, col, iNoteRow, iNoteRow+iMaxRowsAhead, bAllowGraded, true );
+	int iPrevIndex = ReferenceClosestNoteDirectional( nd, td, col, iNoteRow-iMaxRowsBehind, iNoteRow, bAllowGraded, false );
+
+	if( iNextIndex == -1 && iPrevIndex == -1 )
+		return -1;
+	if( iNextIndex == -1 )
+		return iPrevIndex;
+	if( iPrevIndex == -1 )
+		return iNextIndex;
+	if( std::abs(iNoteRow-iNextIndex) > std::abs(iNoteRow-iPrevIndex) )
+		return iPrevIndex;
+	else
+		return iNextIndex;
+}
+
+/* A stamina chart: long runs of 16ths, jumps, holds, mines and the odd
+ * lift, fake and keysound, over timing with BPM changes, stops, warps and
+ * fake sections. */
+static void MakeChart( NoteData &nd, TimingData &td, int iMeasures )
+{
+	td.AddSegment( BPMSegment(0, test_random_range(120, 200)) );
+	for( int m = 4; m < iMeasures; m += 1 + test_random(16) )
+	{
+		const int iRow = BeatToNoteRow( m * 4.0f );
+		switch( test_random(4) )
+		{
+		case 0: td.AddSegment( BPMSegment(iRow, test_random_range(100, 300)) ); break;
+		case 1: td.AddSegment( StopSegment(iRow, test_random_range(0.1f, 1.0f)) ); break;
+		case 2: td.AddSegment( WarpSegment(iRow, test_random_range(0.5f, 4.0f)) ); break;
+		case 3: td.AddSegment( FakeSegment(iRow, test_random_range(0.5f, 4.0f)) ); break;
+		}
+	}
+
+	nd.SetNumTracks( NUM_TRACKS );
+	for( int iRow = 0; iRow < iMeasures * 4 * ROWS_PER_BEAT; iRow += ROWS_PER_BEAT/4 )
+	{
+		if( test_random(5) == 0 )
+			continue;
+		const int iNotes = test_random(6) == 0? 2:1;
+		for( int i = 0; i < iNotes; ++i )
+		{
+			const int t = test_random( NUM_TRACKS );
+			if( nd.GetTapNote(t, iRow).type != TapNoteType_Empty || nd.IsHoldNoteAtRow(t, iRow) )
+				continue;
+			switch( test_random(40) )
+			{
+			case 0:
+			case 1:
+				nd.AddHoldNote( t, iRow, iRow + ROWS_PER_BEAT * (1 + test_random(4)), TAP_ORIGINAL_HOLD_HEAD );
+				break;
+			case 2: nd.SetTapNote( t, iRow, TAP_ORIGINAL_MINE ); break;
+			case 3: nd.SetTapNote( t, iRow, TAP_ORIGINAL_LIFT ); break;
+			case 4: nd.SetTapNote( t, iRow, TAP_ORIGINAL_FAKE ); break;
+			case 5: nd.SetTapNote( t, iRow, TAP_ORIGINAL_AUTO_KEYSOUND ); break;
+			default: nd.SetTapNote( t, iRow, TAP_ORIGINAL_TAP ); break;
+			}
+		}
+	}
+}
+
+struct RecordedStep
+{
+	float fSeconds;
+	int iCol;
+	// Worked out from fSeconds up front, as they would be either way.
+	int iSongRow;
+	int iStepSearchRows;
+	int iMissIfOlderThanThisRow;
+	bool operator<( const RecordedStep &other ) const { return fSeconds < other.fSeconds; }
+};
+
+/* What a player might have done: most notes hit a little early or late, some
+ * missed, and bursts of mashing on top. */
+static void RecordSteps( const NoteData &nd, const TimingData &td, std::vector<RecordedStep> &vOut )
+{
+	for( int t = 0; t < nd.GetNumTracks(); ++t )
+	{
+		for( NoteData::const_iterator it = nd.begin(t); it != nd.end(t); ++it )
+		{
+			if( test_random(10) == 0 )
+				continue;
+			RecordedStep s = { td.GetElapsedTimeFromBeat(NoteRowToBeat(it->first)) + test_random_range(-0.15f, 0.15f), t, 0, 0, 0 };
+			vOut.push_back( s );
+		}
+	}
+
+	const float fLastSecond = td.GetElapsedTimeFromBeat( nd.GetLastBeat() );
+	for( int i = 0; i < 200; ++i )
+	{
+		const float fStart = test_random_range( 0, fLastSecond );
+		for( int j = 0; j < 50; ++j )
+		{
+			RecordedStep s = { fStart + j * 0.01f, test_random(NUM_TRACKS), 0, 0, 0 };
+			vOut.push_back( s );
+		}
+	}
+	std::stable_sort( vOut.begin(), vOut.end() );
+
+	for( RecordedStep &s : vOut )
+	{
+		s.iSongRow = BeatToNoteRow( td.GetBeatFromElapsedTime(s.fSeconds) );
+		s.iStepSearchRows = std::max(
+			BeatToNoteRow( td.GetBeatFromElapsedTime(s.fSeconds + STEP_SEARCH_DISTANCE) ) - s.iSongRow,
+			s.iSongRow - BeatToNoteRow( td.GetBeatFromElapsedTime(s.fSeconds - STEP_SEARCH_DISTANCE) )
+		) + ROWS_PER_BEAT;
+		s.iMissIfOlderThanThisRow = BeatToNoteRow( td.GetBeatFromElapsedTime(s.fSeconds - MISS_WINDOW) );
+	}
+}
+
+static TapNoteScore Judge( float fOffset )
+{
+	fOffset = std::abs( fOffset );
+	if( fOffset <= 0.0225f )	return TNS_W1;
+	if( fOffset <= 0.045f )		return TNS_W2;
+	if( fOffset <= 0.09f )		return TNS_W3;
+	if( fOffset <= 0.135f )		return TNS_W4;
+	if( fOffset <= MISS_WINDOW )	return TNS_W5;
+	return TNS_None;
+}
+
+/* Marks everything before iRow that wasn't stepped on as missed, like
+ * Player::UpdateTapNotesMissedOlderThan. */
+static void MissOlderThan( NoteData &nd, const TimingData &td, int &iFirstUncheckedRow, int iRow )
+{
+	if( iRow <= iFirstUncheckedRow )
+		return;
+	NoteData::all_tracks_iterator it = nd.GetTapNoteRangeAllTracks( iFirstUncheckedRow, iRow );
+	for( ; !it.IsAtEnd(); ++it )
+	{
+		TapNote &tn = *it;
+		if( tn.result.tns == TNS_None && tn.type != TapNoteType_Empty && tn.type != TapNoteType_AutoKeysound &&
+			tn.type != TapNoteType_Fake && tn.type != TapNoteType_HoldTail && td.IsJudgableAtRow(it.Row()) )
+			tn.result.tns = TNS_Miss;
+	}
+	iFirstUncheckedRow = iRow;
+}
+
+/* Plays vSteps into nd the way Player::Step does, with either search, and
+ * returns the rows stepped on (-1 for none) and, for each, the row whose
+ * keysound plays. */
+static void Replay( NoteData &nd, const TimingData &td, const std::vector<RecordedStep> &vSteps, bool bUseIndex, std::vector<int> &vRowsOut )
+{
+	JudgmentIndex index;
+	if( bUseIndex )
+		index.Load( nd, td );
+
+	vRowsOut.clear();
+	int iFirstUncheckedRow = 0;
+	for( RecordedStep const &s : vSteps )
+	{
+		MissOlderThan( nd, td, iFirstUncheckedRow, s.iMissIfOlderThanThisRow );
+
+		const int iSongRow = s.iSongRow;
+		const int iStepSearchRows = s.iStepSearchRows;
+
+		int iRow;
+		if( bUseIndex )
+			iRow = index.GetClosestNote( s.iCol, iSongRow, iStepSearchRows, iStepSearchRows, false );
+		else
+			iRow = ReferenceClosestNote( nd, td, s.iCol, iSongRow, iStepSearchRows, iStepSearchRows, false );
+
+		TapNoteScore tns = TNS_None;
+		if( iRow != -1 )
+		{
+			float fNoteSeconds;
+			if( bUseIndex )
+				fNoteSeconds = index.GetElapsedTimeOfNote( s.iCol, iRow );
+			else
+				fNoteSeconds = td.GetElapsedTimeFromBeat( NoteRowToBeat(iRow) );
+
+			TapNote &tn = nd.FindTapNote( s.iCol, iRow )->second;
+			tns = Judge( fNoteSeconds - s.fSeconds );
+			if( tn.type == TapNoteType_Mine )
+				tns = tns != TNS_None && tns <= TNS_W3? TNS_HitMine:TNS_None;
+			if( tns != TNS_None )
+				tn.result.tns = tns;
+		}
+		vRowsOut.push_back( iRow );
+
+		int iKeysoundRow = iRow;
+		if( tns == TNS_None )
+		{
+			if( bUseIndex )
+				iKeysoundRow = index.GetClosestNote( s.iCol, iSongRow, MAX_NOTE_ROW, MAX_NOTE_ROW, true );
+			else
+				iKeysoundRow = ReferenceClosestNote( nd, td, s.iCol, iSongRow, MAX_NOTE_ROW, MAX_NOTE_ROW, true );
+		}
+		vRowsOut.push_back( iKeysoundRow );
+	}
+}
+
+static bool SameJudgments( const NoteData &a, const NoteData &b )
+{
+	for( int t = 0; t < a.GetNumTracks(); ++t )
+	{
+		NoteData::const_iterator ia = a.begin(t), ib = b.begin(t);
+		for( ; ia != a.end(t) && ib != b.end(t); ++ia, ++ib )
+			if( ia->first != ib->first || ia->second.result.tns != ib->second.result.tns )
+				return false;
+		if( ia != a.end(t) || ib != b.end(t) )
+			return false;
+	}
+	return true;
+}
+
+/* The timeline should visit notes just as an all_tracks_iterator does. */
+static bool SameTimeline( NoteData &nd, const TimingData &td )
+{
+	JudgmentIndex index;
+	index.Load( nd, td );
+	const std::vector<JudgmentIndex::TimelineNote> &vTimeline = index.GetTimeline();
+	const std::vector<unsigned> &vHoldHeads = index.GetHoldHeads();
+
+	unsigned i = 0, iHold = 0;
+	for( NoteData::all_tracks_iterator it = nd.GetTapNoteRangeAllTracks(0, MAX_NOTE_ROW); !it.IsAtEnd(); ++it, ++i )
+	{
+		if( i == vTimeline.size() || vTimeline[i].iRow != it.Row() || vTimeline[i].iTrack != it.Track() || vTimeline[i].pTapNote != &*it )
+			return false;
+		if( vTimeline[i].bJudgable != td.IsJudgableAtRow(it.Row()) )
+			return false;
+		if( it->type == TapNoteType_HoldHead && (iHold == vHoldHeads.size() || vHoldHeads[iHold++] != i) )
+			return false;
+		if( index.FindInTimeline(it.Row(), it.Track()) != i )
+			return false;
+	}
+	return i == vTimeline.size() && iHold == vHoldHeads.size();
+}
+
+static bool Compare( int iCharts )
+{
+	for( int i = 0; i < iCharts; ++i )
+	{
+		NoteData nd;
+		TimingData td;
+		MakeChart( nd, td, 20 + test_random(100) );
+		if( !SameTimeline(nd, td) )
+		{
+			LOG->Warn( "Chart %i: timeline differs", i );
+			return false;
+		}
+
+		std::vector<RecordedStep> vSteps;
+		RecordSteps( nd, td, vSteps );
+
+		NoteData ndReference = nd, ndIndex = nd;
+		std::vector<int> vReference, vIndex;
+		Replay( ndReference, td, vSteps, false, vReference );
+		Replay( ndIndex, td, vSteps, true, vIndex );
+
+		if( vReference != vIndex )
+		{
+			for( unsigned j = 0; j < vReference.size(); ++j )
+			{
+				if( vReference[j] != vIndex[j] )
+				{
+					LOG->Warn( "Chart %i, step %u: found row %i, expected %i", i, j/2, vIndex[j], vReference[j] );
+					break;
+				}
+			}
+			return false;
+		}
+		if( !SameJudgments(ndReference, ndIndex) )
+		{
+			LOG->Warn( "Chart %i: judgments differ", i );
+			return false;
+		}
+	}
+	LOG->Trace( "%i charts replayed the same.", iCharts );
+	return true;
+}
+
+int main( int argc, char *argv[] )
+{
+	FILEMAN			= new RageFileManager( argv[0] );
+	FILEMAN->Mount( "dir", ".", "" );
+	LOG			= new RageLog();
+	LOG->SetShowLogOutput( true );
+	LOG->SetFlushing( true );
+
+	const bool bOK = Compare( 200 );
+
+	delete LOG;
+	delete FILEMAN;
+
+	exit( bOK? 0:1 );
+}
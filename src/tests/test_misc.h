@@ -4,5 +4,24 @@
 void test_handle_args( int argc, char *argv[] );
 void test_init();
 void test_deinit();
+
+/* A small LCG rather than rand(), so a test makes the same random data on
+ * every platform and a failure can be repeated.  Set g_iTestSeed to start
+ * a sequence over. */
+inline unsigned g_iTestSeed = 1;
+inline int test_random( int iMax )
+{
+	g_iTestSeed = g_iTestSeed * 1103515245 + 12345;
+	return (g_iTestSeed >> 16) % iMax;
+}
+inline float test_random_range( float fMin, float fMax )
+{
+	return fMin + test_random(10001) / 10000.0f * (fMax - fMin);
+}
+/* A value in the range fChance of the time, and 0 otherwise. */
+inline float test_maybe( float fChance, float fMin, float fMax )
+{
+	return test_random(1000) < fChance * 1000? test_random_range(fMin, fMax):0;
+}
 	
 #endif
@@ -0,0 +1,166 @@
+#include "global.h"
+#include "RageLog.h"
+#include "RageFile.h"
+#include "RageFileManager.h"
+#include "RageUtil.h"
+#include "NoteFieldCache.h"
+#include "NoteData.h"
+#include "TimingData.h"
+#include "test_misc.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+
+/* Checks NoteFieldCache's displayed beats against TimingData::GetDisplayedBeat
+ * and its note counts against counting the notes, and that players on the
+ * same chart share one. */
+
+static const int NUM_TRACKS = 8;
+
+/* Streams with chords and holds, over scroll changes. */
+static void MakeChart( NoteData &nd, TimingData &td, int iMeasures )
+{
+	td.AddSegment( BPMSegment(0, 150) );
+	td.AddSegment( ScrollSegment(0, 1) );
+	for( int m = 1; m < iMeasures; m += 1 + test_random(8) )
+		td.AddSegment( ScrollSegment(BeatToNoteRow(m * 4.0f + test_random(4)), test_random_range(-1.0f, 4.0f)) );
+
+	nd.SetNumTracks( NUM_TRACKS );
+	for( int iRow = 0; iRow < iMeasures * 4 * ROWS_PER_BEAT; iRow += ROWS_PER_BEAT/4 )
+	{
+		if( test_random(4) == 0 )
+			continue;
+		const int iNotes = 1 + test_random(3);
+		for( int i = 0; i < iNotes; ++i )
+		{
+			const int t = test_random( NUM_TRACKS );
+			if( nd.GetTapNote(t, iRow).type != TapNoteType_Empty || nd.IsHoldNoteAtRow(t, iRow) )
+				continue;
+			if( test_random(20) == 0 )
+				nd.AddHoldNote( t, iRow, iRow + ROWS_PER_BEAT * (1 + test_random(4)), TAP_ORIGINAL_HOLD_HEAD );
+			else
+				nd.SetTapNote( t, iRow, test_random(10) == 0? TAP_ORIGINAL_MINE:TAP_ORIGINAL_TAP );
+		}
+	}
+}
+
+/* The notes on rows from the last row with notes at or before fLow (or the
+ * first one) through the last one at or before fHigh, counted one by one. */
+static int ReferenceNumNotesInRange( const NoteData &nd, float fLow, float fHigh )
+{
+	int iFirstRow = -1, iLowRow = -1, iHighRow = -1;
+	for( NoteData::all_tracks_const_iterator it = nd.GetTapNoteRangeAllTracks(0, MAX_NOTE_ROW, true); !it.IsAtEnd(); ++it )
+	{
+		if( *it == TAP_EMPTY )
+			continue;
+		const float fBeat = NoteRowToBeat( it.Row() );
+		if( iFirstRow == -1 )
+			iFirstRow = it.Row();
+		if( fBeat <= fLow )
+			iLowRow = it.Row();
+		if( fBeat <= fHigh )
+			iHighRow = it.Row();
+	}
+	if( iFirstRow == -1 )
+		return 0;
+	if( iLowRow == -1 )
+		iLowRow = iFirstRow;
+	if( iHighRow == -1 )
+		iHighRow = iFirstRow;
+
+	int iCount = 0;
+	for( NoteData::all_tracks_const_iterator it = nd.GetTapNoteRangeAllTracks(iLowRow, iHighRow+1); !it.IsAtEnd(); ++it )
+		if( *it != TAP_EMPTY )
+			++iCount;
+	return iCount;
+}
+
+static bool Compare( int iCharts )
+{
+	for( int i = 0; i < iCharts; ++i )
+	{
+		NoteData nd;
+		TimingData td;
+		MakeChart( nd, td, 4 + test_random(60) );
+		std::shared_ptr<const NoteFieldCache> pCache = NoteFieldCache::Get( td, nd );
+
+		const float fLastBeat = nd.GetLastBeat() + 4;
+		for( int j = 0; j < 200; ++j )
+		{
+			const float fBeat = test_random_range( -4, fLastBeat );
+			const float fExpected = td.GetDisplayedBeat( fBeat );
+			const float fGot = pCache->GetDisplayedBeat( fBeat );
+			if( std::abs(fGot - fExpected) > 0.001f )
+			{
+				LOG->Warn( "Chart %i: displayed beat at %f is %f, expected %f", i, fBeat, fGot, fExpected );
+				return false;
+			}
+
+			float fLow = test_random_range( -4, fLastBeat );
+			float fHigh = test_random_range( fLow, fLastBeat );
+			const int iExpected = ReferenceNumNotesInRange( nd, fLow, fHigh );
+			const int iGot = pCache->GetNumNotesInRange( fLow, fHigh );
+			if( iGot != iExpected )
+			{
+				LOG->Warn( "Chart %i: %i notes from %f to %f, expected %i", i, iGot, fLow, fHigh, iExpected );
+				return false;
+			}
+		}
+	}
+
+	NoteData nd, ndOther;
+	TimingData td, tdOther;
+	MakeChart( nd, td, 32 );
+	MakeChart( ndOther, tdOther, 32 );
+	std::shared_ptr<const NoteFieldCache> p1 = NoteFieldCache::Get( td, nd );
+	std::shared_ptr<const NoteFieldCache> p2 = NoteFieldCache::Get( td, nd );
+	std::shared_ptr<const NoteFieldCache> pOther = NoteFieldCache::Get( tdOther, ndOther );
+	// Each player has their own copy of the notes.
+	NoteData ndCopy = nd;
+	std::shared_ptr<const NoteFieldCache> pCopy = NoteFieldCache::Get( td, ndCopy );
+	// One note more on a row that has notes changes the counts, not the rows.
+	const int iRow = BeatToNoteRow( nd.GetFirstBeat() );
+	for( int t = 0; t < NUM_TRACKS; ++t )
+	{
+		if( ndCopy.GetTapNote(t, iRow).type == TapNoteType_Empty && !ndCopy.IsHoldNoteAtRow(t, iRow) )
+		{
+			ndCopy.SetTapNote( t, iRow, TAP_ORIGINAL_TAP );
+			break;
+		}
+	}
+	std::shared_ptr<const NoteFieldCache> pChanged = NoteFieldCache::Get( td, ndCopy );
+	if( p1 != p2 || p1 != pCopy || p1 == pOther || p1 == pChanged )
+	{
+		LOG->Warn( "Caches aren't shared by chart" );
+		return false;
+	}
+
+	NoteData ndEmpty;
+	ndEmpty.SetNumTracks( NUM_TRACKS );
+	std::shared_ptr<const NoteFieldCache> pEmpty = NoteFieldCache::Get( TimingData(), ndEmpty );
+	if( pEmpty->HasNotes() || pEmpty->GetNumNotesInRange(0, 100) != 0 || pEmpty->GetDisplayedBeat(3.5f) != 3.5f )
+	{
+		LOG->Warn( "Empty chart cache isn't empty" );
+		return false;
+	}
+
+	LOG->Trace( "%i charts matched.", iCharts );
+	return true;
+}
+
+int main( int argc, char *argv[] )
+{
+	FILEMAN			= new RageFileManager( argv[0] );
+	FILEMAN->Mount( "dir", ".", "" );
+	LOG			= new RageLog();
+	LOG->SetShowLogOutput( true );
+	LOG->SetFlushing( true );
+
+	const bool bOK = Compare( 200 );
+
+	delete LOG;
+	delete FILEMAN;
+
+	exit( bOK? 0:1 );
+}
@@ -0,0 +1,124 @@
+#include "global.h"
+#include "RageLog.h"
+#include "RageFile.h"
+#include "RageFileManager.h"
+#include "RageUtil.h"
+#include "NoteTrack.h"
+#include "test_misc.h"
+
+#include <map>
+
+/* Checks NoteTrack against the std::map<int,TapNote> it replaced in
+ * NoteData, through random inserts, removals and lookups. */
+
+typedef std::map<int,TapNote> MapTrack;
+
+static TapNote RandomNote()
+{
+	TapNote tn = test_random(8) == 0? TAP_ORIGINAL_MINE:TAP_ORIGINAL_TAP;
+	tn.iKeysoundIndex = test_random( 100 ) - 1;
+	return tn;
+}
+
+template<typename Track>
+static bool SameNotes( const Track &track, const MapTrack &map )
+{
+	if( track.size() != map.size() )
+		return false;
+	typename Track::const_iterator it = track.begin();
+	for( MapTrack::const_iterator m = map.begin(); m != map.end(); ++m, ++it )
+		if( it->first != m->first || it->second != m->second )
+			return false;
+	return true;
+}
+
+static bool Compare()
+{
+	for( int iRun = 0; iRun < 200; ++iRun )
+	{
+		NoteTrack track;
+		MapTrack map;
+		for( int i = 0; i < 2000; ++i )
+		{
+			const int iRow = test_random( 500 );
+			switch( test_random(6) )
+			{
+			case 0:
+			case 1:
+			{
+				const TapNote tn = RandomNote();
+				track[iRow] = tn;
+				map[iRow] = tn;
+				break;
+			}
+			case 2:
+				if( track.erase(iRow) != map.erase(iRow) )
+				{
+					LOG->Warn( "erase(%i) differs", iRow );
+					return false;
+				}
+				break;
+			case 3:
+			{
+				NoteTrack::iterator it = track.lower_bound( iRow );
+				MapTrack::iterator m = map.lower_bound( iRow );
+				const int iLast = iRow + test_random( 20 );
+				int iErased = 0;
+				while( it != track.end() && it->first < iLast )
+				{
+					it = track.erase( it );
+					++iErased;
+				}
+				while( m != map.end() && m->first < iLast )
+				{
+					map.erase( m++ );
+					--iErased;
+				}
+				if( iErased != 0 )
+				{
+					LOG->Warn( "erasing [%i,%i) differs", iRow, iLast );
+					return false;
+				}
+				break;
+			}
+			default:
+			{
+				NoteTrack::const_iterator lb = track.lower_bound( iRow ), ub = track.upper_bound( iRow ), f = track.find( iRow );
+				MapTrack::const_iterator mlb = map.lower_bound( iRow ), mub = map.upper_bound( iRow ), mf = map.find( iRow );
+				const bool bSame =
+					(lb == track.end()) == (mlb == map.end()) && (lb == track.end() || lb->first == mlb->first) &&
+					(ub == track.end()) == (mub == map.end()) && (ub == track.end() || ub->first == mub->first) &&
+					(f == track.end()) == (mf == map.end());
+				if( !bSame )
+				{
+					LOG->Warn( "lookups of row %i differ", iRow );
+					return false;
+				}
+			}
+			}
+		}
+		if( !SameNotes(track, map) )
+		{
+			LOG->Warn( "Run %i: contents differ", iRun );
+			return false;
+		}
+	}
+	LOG->Trace( "NoteTrack matches std::map." );
+	return true;
+}
+
+int main( int argc, char *argv[] )
+{
+	FILEMAN			= new RageFileManager( argv[0] );
+	FILEMAN->Mount( "dir", ".", "" );
+	LOG			= new RageLog();
+	LOG->SetShowLogOutput( true );
+	LOG->SetFlushing( true );
+
+	const bool bOK = Compare();
+
+	delete LOG;
+	delete FILEMAN;
+
+	exit( bOK? 0:1 );
+}
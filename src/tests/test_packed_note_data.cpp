@@ -0,0 +1,135 @@
+#include "global.h"
+#include "RageLog.h"
+#include "RageFile.h"
+#include "RageFileManager.h"
+#include "RageUtil.h"
+#include "GameManager.h"
+#include "GameState.h"
+#include "LuaManager.h"
+#include "NoteData.h"
+#include "NoteDataUtil.h"
+#include "PrefsManager.h"
+#include "test_misc.h"
+
+#include <cstdlib>
+
+/* Packs random NoteData with NoteDataUtil::GetPackedNoteDataString and
+ * checks that unpacking it gives back the same notes and the same
+ * GetSMNoteDataString; that cut off or damaged strings are refused without
+ * leaving notes behind. */
+
+/* Every kind of note, mostly plain taps, with now and then the keysounds,
+ * players, attacks and additions that only some notes carry. */
+static void MakeRandomNoteData( NoteData &nd, int iMeasures )
+{
+	nd.SetNumTracks( 1 + test_random(MAX_NOTE_TRACKS) );
+	static const TapNote *NOTES[] = {
+		&TAP_ORIGINAL_TAP, &TAP_ORIGINAL_TAP, &TAP_ORIGINAL_TAP, &TAP_ORIGINAL_TAP,
+		&TAP_ORIGINAL_MINE, &TAP_ORIGINAL_LIFT, &TAP_ORIGINAL_FAKE, &TAP_ORIGINAL_AUTO_KEYSOUND,
+		&TAP_ADDITION_TAP, &TAP_ADDITION_MINE };
+	for( int iRow = 0; iRow < iMeasures * 4 * ROWS_PER_BEAT; iRow += ROWS_PER_BEAT / (1 << test_random(5)) )
+	{
+		if( test_random(3) == 0 )
+			continue;
+		const int t = test_random( nd.GetNumTracks() );
+		if( nd.GetTapNote(t, iRow).type != TapNoteType_Empty || nd.IsHoldNoteAtRow(t, iRow) )
+			continue;
+
+		if( test_random(10) == 0 )
+		{
+			const int iEndRow = iRow + 1 + test_random( ROWS_PER_BEAT * 8 );
+			nd.AddHoldNote( t, iRow, iEndRow, test_random(3) == 0? TAP_ORIGINAL_ROLL_HEAD:TAP_ORIGINAL_HOLD_HEAD );
+			continue;
+		}
+
+		TapNote tn = *NOTES[test_random(ARRAYLEN(NOTES))];
+		if( test_random(20) == 0 )
+			tn.iKeysoundIndex = test_random( 1000 );
+		if( test_random(30) == 0 )
+			tn.pn = (PlayerNumber) test_random( NUM_PLAYERS );
+		if( test_random(50) == 0 )
+		{
+			tn.type = TapNoteType_Attack;
+			tn.sAttackModifiers = test_random(4) == 0? RString():ssprintf( "%i%% drunk, *%i mini", test_random(200), test_random(10) );
+			tn.fAttackDurationSeconds = test_random( 10000 ) / 100.0f;
+		}
+		nd.SetTapNote( t, iRow, tn );
+	}
+}
+
+static bool RoundTrip( int iIterations )
+{
+	int iPackedBytes = 0, iSMBytes = 0;
+	for( int i = 0; i < iIterations; ++i )
+	{
+		NoteData nd;
+		MakeRandomNoteData( nd, test_random(4) == 0? 0:1 + test_random(20) );
+
+		RString sPacked;
+		NoteDataUtil::GetPackedNoteDataString( nd, sPacked );
+		NoteData unpacked;
+		if( !NoteDataUtil::LoadFromPackedNoteDataString(unpacked, sPacked) )
+		{
+			LOG->Warn( "Chart %i: the packed string (%i bytes) was refused", i, int(sPacked.size()) );
+			return false;
+		}
+
+		RString sExpected, sGot;
+		NoteDataUtil::GetSMNoteDataString( nd, sExpected );
+		NoteDataUtil::GetSMNoteDataString( unpacked, sGot );
+		if( unpacked != nd || unpacked.GetNumTracks() != nd.GetNumTracks() || sGot != sExpected )
+		{
+			LOG->Warn( "Chart %i on %i tracks unpacked differently:\n%s\nexpected:\n%s",
+				i, nd.GetNumTracks(), sGot.c_str(), sExpected.c_str() );
+			return false;
+		}
+		iPackedBytes += sPacked.size();
+		iSMBytes += sExpected.size();
+
+		// Anything cut short has to be refused; a damaged byte may still
+		// unpack to something, but a refusal can't leave notes behind.
+		NoteData damaged;
+		const RString sCut = sPacked.substr( 0, test_random(sPacked.size()) );
+		if( NoteDataUtil::LoadFromPackedNoteDataString(damaged, sCut) || !damaged.IsEmpty() )
+		{
+			LOG->Warn( "Chart %i: %i of %i bytes of the packed string were accepted",
+				i, int(sCut.size()), int(sPacked.size()) );
+			return false;
+		}
+		RString sFlipped = sPacked;
+		sFlipped[test_random(sFlipped.size())] ^= char( 1 << test_random(8) );
+		if( !NoteDataUtil::LoadFromPackedNoteDataString(damaged, sFlipped) && !damaged.IsEmpty() )
+		{
+			LOG->Warn( "Chart %i: a refused packed string left notes behind", i );
+			return false;
+		}
+	}
+
+	LOG->Trace( "%i random charts unpacked the same: %i bytes packed, %i bytes of SM note data.",
+		iIterations, iPackedBytes, iSMBytes );
+	return true;
+}
+
+int main( int argc, char *argv[] )
+{
+	LUA			= new LuaManager;
+	FILEMAN			= new RageFileManager( argv[0] );
+	FILEMAN->Mount( "dir", ".", "" );
+	LOG			= new RageLog();
+	PREFSMAN		= new PrefsManager;
+	GAMEMAN			= new GameManager;
+	GAMESTATE		= new GameState;
+	LOG->SetShowLogOutput( true );
+	LOG->SetFlushing( true );
+
+	const bool bOK = RoundTrip( 20000 );
+
+	delete GAMESTATE;
+	delete GAMEMAN;
+	delete PREFSMAN;
+	delete LOG;
+	delete FILEMAN;
+	delete LUA;
+
+	exit( bOK? 0:1 );
+}
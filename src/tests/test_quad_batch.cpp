@@ -0,0 +1,320 @@
+#include "global.h"
+#include "RageLog.h"
+#include "RageFile.h"
+#include "RageFileManager.h"
+#include "RageUtil.h"
+#include "RageMath.h"
+#include "RageDisplay.h"
+#include "RageDisplay_Null.h"
+#include "RageTexture.h"
+#include "RageTextureManager.h"
+#include "Sprite.h"
+#include "LuaManager.h"
+#include "PrefsManager.h"
+#include "test_misc.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+/* Draws random runs of sprites with RageDisplay's quad batching on and off,
+ * checks that every vertex reaches the backend in the same place, in the
+ * same order and under the same texture and blend mode either way, checks
+ * and that Sprites drawn one after another on the same texture share a
+ * batch. */
+
+struct DrawnVertex
+{
+	RageVector4 pos;
+	RageVector4 texcoord;
+	RageVColor c;
+	uintptr_t iTexture;
+	BlendMode blend;
+	bool bFan;
+};
+
+/* Records what a GL backend would rasterize: each vertex through the
+ * matrices current at the draw, and the state it was drawn with. */
+class RecordingDisplay: public RageDisplay_Null
+{
+public:
+	bool m_bBatch = true;
+	int m_iDrawCalls = 0;
+	std::vector<DrawnVertex> m_vDrawn;
+
+	void SetTexture( TextureUnit tu, uintptr_t iTexture )
+	{
+		RageDisplay_Null::SetTexture( tu, iTexture );
+		if( tu == TextureUnit_1 )
+			m_iTexture = iTexture;
+	}
+	void SetBlendMode( BlendMode mode )
+	{
+		RageDisplay_Null::SetBlendMode( mode );
+		m_Blend = mode;
+	}
+
+protected:
+	bool SupportsQuadBatching() const { return m_bBatch; }
+	void DrawQuadsInternal( const RageSpriteVertex v[], int iNumVerts ) { Record( v, iNumVerts, false ); }
+	void DrawFanInternal( const RageSpriteVertex v[], int iNumVerts ) { Record( v, iNumVerts, true ); }
+
+private:
+	uintptr_t m_iTexture = 0;
+	BlendMode m_Blend = BLEND_NORMAL;
+
+	void Record( const RageSpriteVertex v[], int iNumVerts, bool bFan )
+	{
+		++m_iDrawCalls;
+
+		RageMatrix projection, modelView, mvp;
+		RageMatrixMultiply( &projection, GetCentering(), GetProjectionTop() );
+		RageMatrixMultiply( &modelView, GetViewTop(), GetWorldTop() );
+		RageMatrixMultiply( &mvp, &projection, &modelView );
+
+		for( int i = 0; i < iNumVerts; ++i )
+		{
+			DrawnVertex d;
+			RageVector4 p( v[i].p.x, v[i].p.y, v[i].p.z, 1 );
+			RageVec4TransformCoord( &d.pos, &p, &mvp );
+			RageVector4 t( v[i].t.x, v[i].t.y, 0, 1 );
+			RageVec4TransformCoord( &d.texcoord, &t, GetTextureTop() );
+			d.c = v[i].c;
+			d.iTexture = m_iTexture;
+			d.blend = m_Blend;
+			d.bFan = bFan;
+			m_vDrawn.push_back( d );
+		}
+	}
+};
+
+static void MakeQuad( RageSpriteVertex v[4], float fWidth, float fHeight )
+{
+	const float x[4] = { -fWidth/2, +fWidth/2, +fWidth/2, -fWidth/2 };
+	const float y[4] = { -fHeight/2, -fHeight/2, +fHeight/2, +fHeight/2 };
+	for( int i = 0; i < 4; ++i )
+	{
+		v[i].p = RageVector3( x[i], y[i], 0 );
+		v[i].n = RageVector3( 0, 0, 1 );
+		v[i].t = RageVector2( x[i] > 0? 1.0f:0.0f, y[i] > 0? 1.0f:0.0f );
+		v[i].c = RageColor( test_random(256) / 255.0f, test_random(256) / 255.0f, test_random(256) / 255.0f, 1 );
+	}
+}
+
+/* A frame of sprites the way actors draw them: every state set before every
+ * draw, most of them to the value they already had, each sprite under its
+ * own transform, with the occasional camera, texture matrix, non-quad draw
+ * or lit sprite in between. */
+static void DrawFrame( RecordingDisplay &display, int iSprites )
+{
+	display.BeginFrame();
+	uintptr_t iTexture = 1 + test_random(3);
+	BlendMode blend = BLEND_NORMAL;
+	for( int i = 0; i < iSprites; ++i )
+	{
+		if( test_random(8) == 0 )
+			iTexture = 1 + test_random(3);
+		if( test_random(20) == 0 )
+			blend = blend == BLEND_NORMAL? BLEND_ADD:BLEND_NORMAL;
+
+		const bool bCamera = test_random(30) == 0;
+		if( bCamera )
+		{
+			display.CameraPushMatrix();
+			display.LoadMenuPerspective( test_random_range(0, 90), 640, 480, test_random_range(0, 640), test_random_range(0, 480) );
+		}
+		const bool bTexture = test_random(15) == 0;
+		if( bTexture )
+		{
+			display.TexturePushMatrix();
+			display.TextureTranslate( test_random_range(0, 1), test_random_range(0, 1) );
+		}
+		const bool bLit = test_random(40) == 0;
+
+		display.SetBlendMode( blend );
+		display.SetTexture( TextureUnit_1, iTexture );
+		display.SetTextureMode( TextureUnit_1, TextureMode_Modulate );
+		display.SetTextureWrapping( TextureUnit_1, false );
+		display.SetTextureFiltering( TextureUnit_1, true );
+		display.SetZTestMode( ZTEST_OFF );
+		display.SetZWrite( false );
+		display.SetCullMode( CULL_NONE );
+		display.SetLighting( bLit );
+
+		display.PushMatrix();
+		display.Translate( test_random_range(0, 640), test_random_range(0, 480), test_random_range(-10, 10) );
+		display.RotateZ( test_random_range(0, 360) );
+		display.Scale( test_random_range(0.5f, 2), test_random_range(0.5f, 2), 1 );
+
+		RageSpriteVertex v[4];
+		MakeQuad( v, test_random_range(8, 64), test_random_range(8, 64) );
+		if( test_random(25) == 0 )
+			display.DrawFan( v, 4 );
+		else
+			display.DrawQuad( v );
+
+		display.PopMatrix();
+		if( bLit )
+			display.SetLighting( false );
+		if( bTexture )
+			display.TexturePopMatrix();
+		if( bCamera )
+			display.CameraPopMatrix();
+	}
+	display.EndFrame();
+}
+
+static bool Close( float a, float b )
+{
+	return std::abs(a - b) <= 0.001f * std::max( 1.0f, std::abs(a) );
+}
+
+static bool Compare( RecordingDisplay &display, int iFrames )
+{
+	int iBatchedCalls = 0, iUnbatchedCalls = 0;
+	for( int i = 0; i < iFrames; ++i )
+	{
+		const unsigned iSeed = g_iTestSeed;
+		const int iSprites = 1 + test_random(300);
+
+		display.m_bBatch = false;
+		display.m_iDrawCalls = 0;
+		display.m_vDrawn.clear();
+		DrawFrame( display, iSprites );
+		const std::vector<DrawnVertex> vExpected = display.m_vDrawn;
+		iUnbatchedCalls += display.m_iDrawCalls;
+
+		g_iTestSeed = iSeed;
+		test_random( 300 );
+		display.m_bBatch = true;
+		display.m_iDrawCalls = 0;
+		display.m_vDrawn.clear();
+		DrawFrame( display, iSprites );
+		const std::vector<DrawnVertex> &vGot = display.m_vDrawn;
+		iBatchedCalls += display.m_iDrawCalls;
+
+		if( vGot.size() != vExpected.size() )
+		{
+			LOG->Warn( "Frame %i: %i vertices drawn, expected %i", i, int(vGot.size()), int(vExpected.size()) );
+			return false;
+		}
+		for( unsigned j = 0; j < vGot.size(); ++j )
+		{
+			const DrawnVertex &a = vGot[j], &b = vExpected[j];
+			const bool bSame =
+				Close( a.pos.x, b.pos.x ) && Close( a.pos.y, b.pos.y ) &&
+				Close( a.pos.z, b.pos.z ) && Close( a.pos.w, b.pos.w ) &&
+				Close( a.texcoord.x, b.texcoord.x ) && Close( a.texcoord.y, b.texcoord.y ) &&
+				a.c.r == b.c.r && a.c.g == b.c.g && a.c.b == b.c.b && a.c.a == b.c.a &&
+				a.iTexture == b.iTexture && a.blend == b.blend && a.bFan == b.bFan;
+			if( !bSame )
+			{
+				LOG->Warn( "Frame %i, vertex %i: (%f,%f,%f,%f) texture %i, expected (%f,%f,%f,%f) texture %i",
+					i, j, a.pos.x, a.pos.y, a.pos.z, a.pos.w, int(a.iTexture),
+					b.pos.x, b.pos.y, b.pos.z, b.pos.w, int(b.iTexture) );
+				return false;
+			}
+		}
+	}
+
+	LOG->Trace( "%i frames matched: %i draw calls batched, %i unbatched.", iFrames, iBatchedCalls, iUnbatchedCalls );
+	return true;
+}
+
+class FakeTexture: public RageTexture
+{
+public:
+	FakeTexture( uintptr_t iTexHandle ):
+		RageTexture( RageTextureID(ssprintf("fake %i.png", int(iTexHandle))) ), m_iTexHandle( iTexHandle )
+	{
+		m_iSourceWidth = m_iTextureWidth = m_iImageWidth = 64;
+		m_iSourceHeight = m_iTextureHeight = m_iImageHeight = 64;
+		m_TextureCoordRects.push_back( RectF(0, 0, 1, 1) );
+	}
+	uintptr_t GetTexHandle() const { return m_iTexHandle; }
+
+private:
+	uintptr_t m_iTexHandle;
+};
+
+/* Runs of Sprites on a few textures, drawn through Sprite::Draw the way a
+ * note field draws them: each run has to reach the backend as one draw. */
+static bool CheckSprites( RecordingDisplay &display, int iFrames )
+{
+	display.m_bBatch = true;
+	FakeTexture *pTextures[3] = { new FakeTexture(1), new FakeTexture(2), new FakeTexture(3) };
+
+	bool bOK = true;
+	for( int i = 0; i < iFrames && bOK; ++i )
+	{
+		std::vector<Sprite*> vpSprites;
+		int iRuns = 0;
+		int iTexture = -1;
+		for( int j = 1 + test_random(200); j > 0; --j )
+		{
+			if( iTexture == -1 || test_random(10) == 0 )
+			{
+				const int iLast = iTexture;
+				while( iTexture == iLast )
+					iTexture = test_random(3);
+				++iRuns;
+			}
+			Sprite *pSprite = new Sprite;
+			pSprite->SetTexture( TEXTUREMAN->CopyTexture(pTextures[iTexture]) );
+			pSprite->SetXY( test_random_range(0, 640), test_random_range(0, 480) );
+			pSprite->SetRotationZ( test_random_range(0, 360) );
+			vpSprites.push_back( pSprite );
+		}
+
+		display.m_iDrawCalls = 0;
+		display.m_vDrawn.clear();
+		display.BeginFrame();
+		for( Sprite *pSprite : vpSprites )
+			pSprite->Draw();
+		display.EndFrame();
+
+		const int iDrawn = display.m_vDrawn.size() / 4;
+		for( Sprite *pSprite : vpSprites )
+			delete pSprite;
+
+		if( iDrawn != int(vpSprites.size()) || display.m_iDrawCalls != iRuns )
+		{
+			LOG->Warn( "Frame %i: %i of %i sprites drawn in %i draw calls, expected %i",
+				i, iDrawn, int(vpSprites.size()), display.m_iDrawCalls, iRuns );
+			bOK = false;
+		}
+	}
+
+	for( FakeTexture *pTexture : pTextures )
+		delete pTexture;
+
+	if( bOK )
+		LOG->Trace( "%i frames of sprites drew one batch per run of textures.", iFrames );
+	return bOK;
+}
+
+int main( int argc, char *argv[] )
+{
+	LUA			= new LuaManager;
+	FILEMAN			= new RageFileManager( argv[0] );
+	FILEMAN->Mount( "dir", ".", "" );
+	LOG			= new RageLog();
+	PREFSMAN		= new PrefsManager;
+	LOG->SetShowLogOutput( true );
+	LOG->SetFlushing( true );
+
+	RecordingDisplay *pDisplay = new RecordingDisplay;
+	DISPLAY			= pDisplay;
+	TEXTUREMAN		= new RageTextureManager;
+	const bool bOK = Compare( *pDisplay, 200 ) && CheckSprites( *pDisplay, 200 );
+	delete TEXTUREMAN;
+	DISPLAY			= nullptr;
+	delete pDisplay;
+
+	delete PREFSMAN;
+	delete LOG;
+	delete FILEMAN;
+	delete LUA;
+
+	exit( bOK? 0:1 );
+}
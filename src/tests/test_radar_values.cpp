@@ -0,0 +1,154 @@
+#include "global.h"
+#include "RageLog.h"
+#include "RageFile.h"
+#include "RageFileManager.h"
+#include "RageTimer.h"
+#include "RageUtil.h"
+#include "RageUtil_ThreadPool.h"
+#include "GameManager.h"
+#include "GameState.h"
+#include "LuaManager.h"
+#include "NotesLoaderSM.h"
+#include "PrefsManager.h"
+#include "Song.h"
+#include "Steps.h"
+
+#include <vector>
+
+/* Times Song::ReCalculateRadarValuesAndLastSecond as a cold cache sees it:
+ * every chart parsed and no radar values stored yet.  Songs are done one
+ * at a time with the Steps of each in parallel, then with the songs
+ * themselves in parallel, and every pass has to give the same numbers. */
+
+static const RString ROOT = "/radar_values_test/";
+static const int NUM_SONGS = 200;
+static const int NUM_MEASURES = 120;
+static const char *DIFFICULTIES[] = { "Beginner", "Easy", "Medium", "Hard", "Challenge" };
+
+static RString MakeChart( int iSeed )
+{
+	RString s;
+	for( int m = 0; m < NUM_MEASURES; ++m )
+	{
+		if( m )
+			s += ",\n";
+		for( int r = 0; r < 16; ++r )
+		{
+			iSeed = iSeed * 1103515245 + 12345;
+			const int iBits = (iSeed >> 16) & 0x7fff;
+			for( int t = 0; t < 4; ++t )
+				s += ((iBits >> (t*3)) & 7) == 0? '1':'0';
+			s += '\n';
+		}
+	}
+	return s;
+}
+
+static void MakeSongs()
+{
+	for( int i = 0; i < NUM_SONGS; ++i )
+	{
+		RString sData = ssprintf( "#TITLE:Song %i;\n#OFFSET:0;\n#BPMS:0=%i,64=%i;\n#STOPS:32=0.5;\n",
+			i, 120 + i % 60, 180 + i % 40 );
+		for( unsigned d = 0; d < ARRAYLEN(DIFFICULTIES); ++d )
+			sData += ssprintf( "#NOTES:\n     dance-single:\n     :\n     %s:\n     %i:\n     0,0,0,0,0:\n%s;\n",
+				DIFFICULTIES[d], int(d*3+1), MakeChart(i*ARRAYLEN(DIFFICULTIES)+d).c_str() );
+
+		RageFile f;
+		const RString sPath = ssprintf( "%ssong%04i.sm", ROOT.c_str(), i );
+		if( !f.Open(sPath, RageFile::WRITE) || f.Write(sData) == -1 )
+			LOG->Warn( "Couldn't write %s: %s", sPath.c_str(), f.GetError().c_str() );
+	}
+}
+
+static void LoadSongs( std::vector<Song *> &vpSongs )
+{
+	for( int i = 0; i < NUM_SONGS; ++i )
+	{
+		Song *pSong = new Song;
+		SMLoader loader;
+		if( !loader.LoadFromSimfile(ssprintf("%ssong%04i.sm", ROOT.c_str(), i), *pSong) )
+		{
+			LOG->Warn( "Couldn't load song %i", i );
+			delete pSong;
+			continue;
+		}
+		pSong->m_fMusicLengthSeconds = 120;
+		vpSongs.push_back( pSong );
+	}
+}
+
+static void GetResults( const std::vector<Song *> &vpSongs, std::vector<float> &vOut )
+{
+	vOut.clear();
+	for( Song const *pSong : vpSongs )
+	{
+		vOut.push_back( pSong->GetFirstSecond() );
+		vOut.push_back( pSong->GetLastSecond() );
+		for( Steps const *pSteps : pSong->GetAllSteps() )
+			FOREACH_ENUM( RadarCategory, rc )
+				vOut.push_back( pSteps->GetRadarValues(PLAYER_1)[rc] );
+	}
+}
+
+static bool Pass( const char *szName, const std::vector<Song *> &vpSongs, int iSongThreads, int iStepsThreads,
+	const std::vector<float> &vExpected, std::vector<float> &vResults )
+{
+	PREFSMAN->m_iSongLoadThreads.Set( iStepsThreads );
+	RageThreadPool pool( "Radar test", iSongThreads );
+	RageTimer timer;
+	pool.Run( vpSongs.size(), [&]( std::size_t i ) {
+		vpSongs[i]->ReCalculateRadarValuesAndLastSecond();
+	} );
+	const float fSeconds = timer.GetDeltaTime();
+	LOG->Trace( "%s: %i songs in %f (%.0f songs/sec)", szName, int(vpSongs.size()), fSeconds, vpSongs.size() / fSeconds );
+
+	GetResults( vpSongs, vResults );
+	if( !vExpected.empty() && vResults != vExpected )
+	{
+		LOG->Warn( "%s: results differ from the serial pass", szName );
+		return false;
+	}
+	return true;
+}
+
+void run()
+{
+	MakeSongs();
+	std::vector<Song *> vpSongs;
+	LoadSongs( vpSongs );
+
+	std::vector<float> vSerial, vResults;
+	Pass( "serial", vpSongs, 1, 1, std::vector<float>(), vSerial );
+	if( Pass("parallel steps", vpSongs, 1, 0, vSerial, vResults) )
+		Pass( "parallel songs", vpSongs, 0, 0, vSerial, vResults );
+
+	for( Song *pSong : vpSongs )
+		delete pSong;
+}
+
+int main( int argc, char *argv[] )
+{
+	LUA			= new LuaManager;
+	FILEMAN			= new RageFileManager( argv[0] );
+	FILEMAN->Mount( "dir", ".", "" );
+	LOG			= new RageLog();
+	PREFSMAN		= new PrefsManager;
+	GAMEMAN			= new GameManager;
+	GAMESTATE		= new GameState;
+	LOG->SetShowLogOutput( true );
+	LOG->SetFlushing( true );
+
+	run();
+
+	DeleteRecursive( ROOT );
+
+	delete GAMESTATE;
+	delete GAMEMAN;
+	delete PREFSMAN;
+	delete LOG;
+	delete FILEMAN;
+	delete LUA;
+
+	exit(0);
+}
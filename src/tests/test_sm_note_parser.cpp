@@ -0,0 +1,217 @@
+#include "global.h"
+#include "RageLog.h"
+#include "RageFile.h"
+#include "RageFileManager.h"
+#include "RageUtil.h"
+#include "GameManager.h"
+#include "GameState.h"
+#include "LuaManager.h"
+#include "NoteData.h"
+#include "NoteDataUtil.h"
+#include "PrefsManager.h"
+#include "test_misc.h"
+
+#include <cstdlib>
+#include <cstring>
+
+/* Checks NoteDataUtil::LoadFromSMNoteDataString against the parser it
+ * replaced, which set one note at a time, on random note data. */
+
+static const int BEATS_PER_MEASURE = 4;
+
+/* The old parser, kept as it was apart from the disabled attack and item
+ * code. */
+static void ReferenceParse( NoteData& out, const RString &sSMNoteData, int start, int len, PlayerNumber pn, int iNumTracks )
+{
+	int size = -1;
+	const int end = start + len;
+	std::vector<std::pair<const char*, const char*> > aMeasureLines;
+	for( unsigned m = 0; true; ++m )
+	{
+		split( sSMNoteData, ",", start, size, end, true );
+		if( start == end )
+			break;
+
+		int measureLineStart = start, measureLineSize = -1;
+		const int measureEnd = start + size;
+
+		aMeasureLines.clear();
+		for(;;)
+		{
+			split( sSMNoteData, "\n", measureLineStart, measureLineSize, measureEnd, true );
+			if( measureLineStart == measureEnd )
+				break;
+			const char *beginLine = sSMNoteData.data() + measureLineStart;
+			const char *endLine = beginLine + measureLineSize;
+
+			while( beginLine < endLine && strchr("\r\n\t ", *beginLine) )
+				++beginLine;
+			while( endLine > beginLine && strchr("\r\n\t ", *(endLine - 1)) )
+				--endLine;
+			if( beginLine < endLine )
+				aMeasureLines.push_back( std::pair<const char*, const char*>(beginLine, endLine) );
+		}
+
+		for( unsigned l=0; l<aMeasureLines.size(); l++ )
+		{
+			const char *p = aMeasureLines[l].first;
+			const char *const endLine = aMeasureLines[l].second;
+
+			const float fPercentIntoMeasure = l/(float)aMeasureLines.size();
+			const float fBeat = (m + fPercentIntoMeasure) * BEATS_PER_MEASURE;
+			const int iIndex = BeatToNoteRow( fBeat );
+
+			int iTrack = 0;
+			while( iTrack < iNumTracks && p < endLine )
+			{
+				TapNote tn;
+				char ch = *p;
+
+				switch( ch )
+				{
+				case '0': tn = TAP_EMPTY;				break;
+				case '1': tn = TAP_ORIGINAL_TAP;			break;
+				case '2':
+				case '4':
+					tn = ch == '2' ? TAP_ORIGINAL_HOLD_HEAD : TAP_ORIGINAL_ROLL_HEAD;
+					tn.iDuration = MAX_NOTE_ROW;
+					break;
+				case '3':
+				{
+					int iHeadRow;
+					if( out.IsHoldNoteAtRow(iTrack, iIndex, &iHeadRow) )
+						out.FindTapNote( iTrack, iHeadRow )->second.iDuration = iIndex - iHeadRow;
+					break;
+				}
+				case 'M': tn = TAP_ORIGINAL_MINE;			break;
+				case 'K': tn = TAP_ORIGINAL_AUTO_KEYSOUND;		break;
+				case 'L': tn = TAP_ORIGINAL_LIFT;			break;
+				case 'F': tn = TAP_ORIGINAL_FAKE;			break;
+				default: tn = TAP_EMPTY;				break;
+				}
+
+				p++;
+				if( *p == '[' )
+				{
+					p++;
+					int iKeysoundIndex = 0;
+					if( 1 == sscanf( p, "%d]", &iKeysoundIndex ) )
+						tn.iKeysoundIndex = iKeysoundIndex;
+
+					while( p < endLine )
+					{
+						if( *(p++) == ']' )
+							break;
+					}
+				}
+
+				if( tn.type != TapNoteType_Empty && ch != '3' )
+				{
+					tn.pn = pn;
+					out.SetTapNote( iTrack, iIndex, tn );
+				}
+
+				iTrack++;
+			}
+		}
+	}
+
+	for( int t=0; t<out.GetNumTracks(); t++ )
+	{
+		NoteData::iterator begin = out.begin( t );
+		while( begin != out.end(t) )
+		{
+			const TapNote &tn = begin->second;
+			if( tn.type == TapNoteType_HoldHead && tn.iDuration == MAX_NOTE_ROW )
+				begin = out.RemoveTapNote( t, begin );
+			else
+				++begin;
+		}
+	}
+	out.RevalidateATIs( std::vector<int>(), false );
+}
+
+/* Mostly well-formed rows, with enough junk, keysounds, odd line lengths
+ * and stray separators to reach the edge cases. */
+static RString MakeRandomNoteData( int iNumTracks )
+{
+	static const char NOTES[] = "0000000000001234MKLF";
+	static const char JUNK[] = "0123MKLF4[]9 \r\t,x";
+	RString s;
+	const int iMeasures = test_random( 6 );
+	for( int m = 0; m < iMeasures; ++m )
+	{
+		const int iRows = test_random(4) == 0? test_random(50):(4 << test_random(4));
+		for( int r = 0; r < iRows; ++r )
+		{
+			int iChars = iNumTracks;
+			if( test_random(8) == 0 )
+				iChars += test_random(5) - 2;
+			for( int c = 0; c < iChars; ++c )
+			{
+				if( test_random(40) == 0 )
+					s += JUNK[test_random(sizeof(JUNK)-1)];
+				else
+					s += NOTES[test_random(sizeof(NOTES)-1)];
+				if( test_random(60) == 0 )
+					s += ssprintf( "[%i]", test_random(100) );
+			}
+			s += test_random(10) == 0? "\r\n":"\n";
+		}
+		s += ",\n";
+	}
+	return s;
+}
+
+static bool Fuzz( int iIterations )
+{
+	// Unmatched 3s are logged, and there are a lot of them.
+	LOG->SetShowLogOutput( false );
+	for( int i = 0; i < iIterations; ++i )
+	{
+		const int iNumTracks = 1 + test_random( 10 );
+		const RString sData = MakeRandomNoteData( iNumTracks );
+
+		NoteData expected;
+		expected.SetNumTracks( iNumTracks );
+		ReferenceParse( expected, sData, 0, sData.size(), PLAYER_INVALID, iNumTracks );
+
+		NoteData actual;
+		actual.SetNumTracks( iNumTracks );
+		NoteDataUtil::LoadFromSMNoteDataString( actual, sData, false );
+
+		if( expected != actual )
+		{
+			LOG->SetShowLogOutput( true );
+			LOG->Warn( "Parsers differ on %i tracks of \"%s\"", iNumTracks, sData.c_str() );
+			return false;
+		}
+	}
+	LOG->SetShowLogOutput( true );
+	LOG->Trace( "%i random charts parsed the same.", iIterations );
+	return true;
+}
+
+int main( int argc, char *argv[] )
+{
+	LUA			= new LuaManager;
+	FILEMAN			= new RageFileManager( argv[0] );
+	FILEMAN->Mount( "dir", ".", "" );
+	LOG			= new RageLog();
+	PREFSMAN		= new PrefsManager;
+	GAMEMAN			= new GameManager;
+	GAMESTATE		= new GameState;
+	LOG->SetShowLogOutput( true );
+	LOG->SetFlushing( true );
+
+	const bool bOK = Fuzz( 100000 );
+
+	delete GAMESTATE;
+	delete GAMEMAN;
+	delete PREFSMAN;
+	delete LOG;
+	delete FILEMAN;
+	delete LUA;
+
+	exit( bOK? 0:1 );
+}
@@ -0,0 +1,154 @@
+#include "global.h"
+#include "RageLog.h"
+#include "RageFile.h"
+#include "RageFileManager.h"
+#include "RageUtil.h"
+#include "GameManager.h"
+#include "GameState.h"
+#include "LuaManager.h"
+#include "NoteData.h"
+#include "PrefsManager.h"
+#include "Song.h"
+#include "SongCacheIndex.h"
+#include "SongManager.h"
+#include "SpecialFiles.h"
+#include "Steps.h"
+#include "ThemeManager.h"
+
+#include <vector>
+
+/* Loads a song with no cache file, which writes one, then loads it again
+ * from that cache file, and checks that every chart has the same notes both
+ * times.  Run from the game directory, for the themes. */
+
+static const RString GROUP_DIR = "/Songs/song_cache_test/";
+static const RString SONG_DIR = GROUP_DIR + "Song/";
+static const char *DIFFICULTIES[] = { "Beginner", "Easy", "Medium", "Hard", "Challenge" };
+
+static RString MakeChart( int iSeed )
+{
+	RString s;
+	for( int m = 0; m < 32; ++m )
+	{
+		if( m )
+			s += ",\n";
+		for( int r = 0; r < 16; ++r )
+		{
+			iSeed = iSeed * 1103515245 + 12345;
+			const int iBits = (iSeed >> 16) & 0x7fff;
+			for( int t = 0; t < 4; ++t )
+			{
+				switch( (iBits >> (t*3)) & 7 )
+				{
+				case 0: s += '1'; break;
+				case 1: s += (iBits & 0x1000)? 'M':'0'; break;
+				default: s += '0'; break;
+				}
+			}
+			s += '\n';
+		}
+	}
+	return s;
+}
+
+static void WriteFile( const RString &sPath, const RString &sData )
+{
+	RageFile f;
+	if( !f.Open(sPath, RageFile::WRITE) || f.Write(sData) == -1 )
+		LOG->Warn( "Couldn't write %s: %s", sPath.c_str(), f.GetError().c_str() );
+}
+
+static void MakeSong()
+{
+	RString sData = "#TITLE:Cache test;\n#MUSIC:song.ogg;\n#OFFSET:0;\n#BPMS:0=150;\n";
+	for( unsigned d = 0; d < ARRAYLEN(DIFFICULTIES); ++d )
+		sData += ssprintf( "#NOTES:\n     dance-single:\n     :\n     %s:\n     %i:\n     0,0,0,0,0:\n%s;\n",
+			DIFFICULTIES[d], int(d*3+1), MakeChart(d).c_str() );
+	WriteFile( SONG_DIR + "song.sm", sData );
+	WriteFile( SONG_DIR + "song.ogg", RString() );
+}
+
+/* Taps and mines of each chart, in the song's order. */
+static bool GetNoteCounts( const RString &sWhen, std::vector<int> &vOut )
+{
+	Song song;
+	if( !song.LoadFromSongDir(SONG_DIR) )
+	{
+		LOG->Warn( "%s: the song didn't load", sWhen.c_str() );
+		return false;
+	}
+
+	vOut.clear();
+	for( Steps const *pSteps : song.GetAllSteps() )
+	{
+		NoteData nd;
+		pSteps->GetNoteData( nd );
+		if( nd.GetNumTapNotes() == 0 )
+		{
+			LOG->Warn( "%s: the %s chart has no notes", sWhen.c_str(), DifficultyToString(pSteps->GetDifficulty()).c_str() );
+			return false;
+		}
+		vOut.push_back( nd.GetNumTapNotes() );
+		vOut.push_back( nd.GetNumMines() );
+	}
+	return true;
+}
+
+static bool Run()
+{
+	MakeSong();
+	FILEMAN->Remove( SongCacheIndex::GetCacheFilePath("Songs", SONG_DIR) );
+
+	std::vector<int> vCold, vCached;
+	if( !GetNoteCounts("cold", vCold) )
+		return false;
+	if( !DoesFileExist(SongCacheIndex::GetCacheFilePath("Songs", SONG_DIR)) )
+	{
+		LOG->Warn( "No cache file was written" );
+		return false;
+	}
+	if( !GetNoteCounts("cached", vCached) )
+		return false;
+
+	if( vCached != vCold )
+	{
+		LOG->Warn( "The charts loaded from the cache have different notes" );
+		return false;
+	}
+	LOG->Trace( "%i charts loaded the same from the cache", int(vCold.size() / 2) );
+	return true;
+}
+
+int main( int argc, char *argv[] )
+{
+	LUA			= new LuaManager;
+	FILEMAN			= new RageFileManager( argv[0] );
+	FILEMAN->Mount( "dir", ".", "" );
+	LOG			= new RageLog();
+	PREFSMAN		= new PrefsManager;
+	GAMEMAN			= new GameManager;
+	GAMESTATE		= new GameState;
+	THEME			= new ThemeManager;
+	THEME->SwitchThemeAndLanguage( SpecialFiles::BASE_THEME_NAME, "en", false );
+	SONGINDEX		= new SongCacheIndex;
+	SONGMAN			= new SongManager;
+	LOG->SetShowLogOutput( true );
+	LOG->SetFlushing( true );
+
+	const bool bOK = Run();
+
+	FILEMAN->Remove( SongCacheIndex::GetCacheFilePath("Songs", SONG_DIR) );
+	DeleteRecursive( GROUP_DIR );
+
+	delete SONGMAN;
+	delete SONGINDEX;
+	delete THEME;
+	delete GAMESTATE;
+	delete GAMEMAN;
+	delete PREFSMAN;
+	delete LOG;
+	delete FILEMAN;
+	delete LUA;
+
+	exit( bOK? 0:1 );
+}
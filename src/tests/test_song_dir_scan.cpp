@@ -0,0 +1,136 @@
+#include "global.h"
+#include "RageLog.h"
+#include "RageFile.h"
+#include "RageFileManager.h"
+#include "RageTimer.h"
+#include "RageUtil.h"
+#include "PrefsManager.h"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+/* Times the checks Song::LoadFromSongDir makes to see whether a cached song
+ * is still current: a full GetHashForDirectory on a cold directory cache,
+ * GetStampForDirectory against a stored snapshot, and a snapshot pass after
+ * one song has been edited. */
+
+static const RString ROOT = "/song_dir_scan_test/";
+static const int NUM_SONGS = 2000;
+static const int FILES_PER_SONG = 6;
+
+struct SongDir
+{
+	RString sDir;
+	std::vector<RString> vsCharts;
+	unsigned iHash;
+	unsigned iStamp;
+};
+
+static void WriteFile( const RString &sPath, const RString &sData )
+{
+	RageFile f;
+	if( !f.Open(sPath, RageFile::WRITE) || f.Write(sData) == -1 )
+		LOG->Warn( "Couldn't write %s: %s", sPath.c_str(), f.GetError().c_str() );
+}
+
+static void MakeTree( std::vector<SongDir> &vSongs )
+{
+	for( int i = 0; i < NUM_SONGS; ++i )
+	{
+		SongDir song;
+		song.sDir = ssprintf( "%sGroup%02i/Song%04i/", ROOT.c_str(), i % 20, i );
+		song.vsCharts.push_back( song.sDir + "song.ssc" );
+		song.vsCharts.push_back( song.sDir + "song.sm" );
+		for( RString const &sChart : song.vsCharts )
+			WriteFile( sChart, "#TITLE:test;\n" );
+		for( int j = 2; j < FILES_PER_SONG; ++j )
+			WriteFile( ssprintf("%sfile%i.png", song.sDir.c_str(), j), "x" );
+		vSongs.push_back( song );
+	}
+	FILEMAN->FlushDirCache( ROOT );
+}
+
+void run()
+{
+	std::vector<SongDir> vSongs;
+	MakeTree( vSongs );
+
+	/* Cold: what every boot used to pay. */
+	FILEMAN->FlushDirCache( ROOT );
+	RageTimer timer;
+	for( SongDir &song : vSongs )
+		song.iHash = GetHashForDirectory( song.sDir );
+	LOG->Trace( "cold, full hash: %i dirs in %f", NUM_SONGS, timer.GetDeltaTime() );
+
+	for( SongDir &song : vSongs )
+	{
+		if( !GetStampForDirectory(song.sDir, song.vsCharts, song.iStamp) )
+		{
+			LOG->Warn( "Couldn't stamp %s", song.sDir.c_str() );
+			return;
+		}
+	}
+
+	/* Warm: nothing changed, so only the snapshot is checked. */
+	FILEMAN->FlushDirCache( ROOT );
+	timer.Touch();
+	int iChanged = 0;
+	for( SongDir const &song : vSongs )
+	{
+		unsigned iStamp = 0;
+		if( !GetStampForDirectory(song.sDir, song.vsCharts, iStamp) || iStamp != song.iStamp )
+			++iChanged;
+	}
+	LOG->Trace( "warm, snapshot: %i dirs in %f, %i changed", NUM_SONGS, timer.GetDeltaTime(), iChanged );
+	if( iChanged != 0 )
+	{
+		LOG->Warn( "Expected no changed directories, got %i", iChanged );
+		return;
+	}
+
+	/* Edit one chart in place and add a file to another song.  Both have to
+	 * be noticed, and only they should be rehashed. */
+	const SongDir &edited = vSongs[NUM_SONGS/3];
+	const SongDir &added = vSongs[NUM_SONGS/2];
+	/* Directory mtimes only have one-second resolution. */
+	std::this_thread::sleep_for( std::chrono::seconds(1) );
+	WriteFile( edited.vsCharts[0], "#TITLE:test, but longer;\n" );
+	WriteFile( added.sDir + "new.ogg", "x" );
+
+	FILEMAN->FlushDirCache( ROOT );
+	timer.Touch();
+	iChanged = 0;
+	for( SongDir const &song : vSongs )
+	{
+		unsigned iStamp = 0;
+		if( GetStampForDirectory(song.sDir, song.vsCharts, iStamp) && iStamp == song.iStamp )
+			continue;
+		++iChanged;
+		if( GetHashForDirectory(song.sDir) == song.iHash )
+			LOG->Warn( "%s: snapshot changed but hash didn't", song.sDir.c_str() );
+	}
+	LOG->Trace( "one song changed, snapshot: %i dirs in %f, %i changed", NUM_SONGS, timer.GetDeltaTime(), iChanged );
+	if( iChanged != 2 )
+		LOG->Warn( "Expected 2 changed directories, got %i", iChanged );
+}
+
+int main( int argc, char *argv[] )
+{
+	FILEMAN			= new RageFileManager( argv[0] );
+	FILEMAN->Mount( "dir", ".", "" );
+	LOG			= new RageLog();
+	PREFSMAN		= new PrefsManager;
+	LOG->SetShowLogOutput( true );
+	LOG->SetFlushing( true );
+
+	run();
+
+	DeleteRecursive( ROOT );
+
+	delete PREFSMAN;
+	delete LOG;
+	delete FILEMAN;
+
+	exit(0);
+}
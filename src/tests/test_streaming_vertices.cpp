@@ -0,0 +1,190 @@
+#include "global.h"
+#include "RageDisplay_OGL_StreamingVertices.h"
+#include "test_misc.h"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+/* Draws random quads, strips and fans through StreamingVertexBuffer and from
+ * client arrays into an offscreen framebuffer, and checks that every frame
+ * comes out the same, through many trips around the ring and restarts in
+ * the middle of it.
+ *
+ * This needs nothing but GL, so it runs without a window under Mesa's
+ * software rasterizer (surfaceless EGL), which is how CI runs it:
+ *
+ * EGL_PLATFORM=surfaceless LIBGL_ALWAYS_SOFTWARE=1 ./test_streaming_vertices */
+
+static const int SIZE = 256;
+static StreamingVertexBuffer g_Buffer;
+
+/* What RageDisplay_Legacy does without the buffer. */
+static void SetupClientVertices( const std::vector<RageSpriteVertex> &v )
+{
+	static std::vector<StreamingVertex> vOut;
+	vOut.resize( v.size() );
+	for( unsigned i = 0; i < v.size(); ++i )
+	{
+		StreamingVertex &out = vOut[i];
+		for( int j = 0; j < 3; ++j )
+		{
+			out.p[j] = v[i].p[j];
+			out.n[j] = v[i].n[j];
+		}
+		out.c[0] = v[i].c.r;
+		out.c[1] = v[i].c.g;
+		out.c[2] = v[i].c.b;
+		out.c[3] = v[i].c.a;
+		out.t[0] = v[i].t[0];
+		out.t[1] = v[i].t[1];
+	}
+
+	const GLsizei iStride = sizeof(StreamingVertex);
+	glBindBufferARB( GL_ARRAY_BUFFER_ARB, 0 );
+	glEnableClientState( GL_VERTEX_ARRAY );
+	glVertexPointer( 3, GL_FLOAT, iStride, vOut[0].p );
+	glEnableClientState( GL_COLOR_ARRAY );
+	glColorPointer( 4, GL_UNSIGNED_BYTE, iStride, vOut[0].c );
+	glEnableClientState( GL_TEXTURE_COORD_ARRAY );
+	glTexCoordPointer( 2, GL_FLOAT, iStride, vOut[0].t );
+	glEnableClientState( GL_NORMAL_ARRAY );
+	glNormalPointer( GL_FLOAT, iStride, vOut[0].n );
+}
+
+static RageSpriteVertex RandomVertex( float fX, float fY )
+{
+	RageSpriteVertex v;
+	v.p = RageVector3( fX, fY, 0 );
+	v.n = RageVector3( 0, 0, 1 );
+	v.t = RageVector2( 0, 0 );
+	v.c = RageColor( test_random(256) / 255.0f, test_random(256) / 255.0f, test_random(256) / 255.0f, 1 );
+	return v;
+}
+
+/* Most draws are one quad, as they are in the game; now and then there's a
+ * long strip or fan, big enough to push the ring into its next section. */
+static void DrawFrame( int iDraws, bool bStream, std::vector<unsigned char> &vPixels, int &iStreamed )
+{
+	glClear( GL_COLOR_BUFFER_BIT );
+	std::vector<RageSpriteVertex> v;
+	for( int d = 0; d < iDraws; ++d )
+	{
+		const float fX = test_random(SIZE) * 2.0f / SIZE - 1;
+		const float fY = test_random(SIZE) * 2.0f / SIZE - 1;
+		const float fSize = (1 + test_random(20)) * 2.0f / SIZE;
+
+		GLenum mode;
+		v.clear();
+		switch( test_random(50) )
+		{
+		case 0:
+			mode = GL_TRIANGLE_STRIP;
+			for( int i = test_random(20000); i >= 0; --i )
+				v.push_back( RandomVertex(fX + (i/2) * fSize / 64, fY + (i%2) * fSize) );
+			break;
+		case 1:
+			mode = GL_TRIANGLE_FAN;
+			v.push_back( RandomVertex(fX, fY) );
+			for( int i = 0; i < 64; ++i )
+				v.push_back( RandomVertex(fX + fSize * std::cos(i * 0.1f), fY + fSize * std::sin(i * 0.1f)) );
+			break;
+		default:
+			mode = GL_QUADS;
+			v.push_back( RandomVertex(fX, fY) );
+			v.push_back( RandomVertex(fX + fSize, fY) );
+			v.push_back( RandomVertex(fX + fSize, fY + fSize) );
+			v.push_back( RandomVertex(fX, fY + fSize) );
+			break;
+		}
+
+		// What concurrent rendering does when it starts and stops.
+		if( test_random(500) == 0 )
+			g_Buffer.Restart();
+
+		if( bStream && g_Buffer.SetupVertices(&v[0], v.size()) )
+			++iStreamed;
+		else
+			SetupClientVertices( v );
+		glDrawArrays( mode, 0, v.size() );
+	}
+
+	vPixels.resize( SIZE * SIZE * 4 );
+	glReadPixels( 0, 0, SIZE, SIZE, GL_RGBA, GL_UNSIGNED_BYTE, &vPixels[0] );
+}
+
+static bool Compare( int iFrames )
+{
+	std::vector<unsigned char> vExpected, vGot;
+	int iStreamed = 0, iClient = 0;
+	for( int iFrame = 0; iFrame < iFrames; ++iFrame )
+	{
+		g_iTestSeed = 100 + iFrame;
+		DrawFrame( 3000, false, vExpected, iClient );
+		g_iTestSeed = 100 + iFrame;
+		DrawFrame( 3000, true, vGot, iStreamed );
+		if( vGot != vExpected )
+		{
+			printf( "Frame %i drawn from the streaming buffer differs from client arrays\n", iFrame );
+			return false;
+		}
+	}
+
+	if( iStreamed == 0 )
+	{
+		printf( "Nothing was drawn from the streaming buffer%s\n", g_Buffer.MapFailed()? " (it couldn't be mapped)":"" );
+		return false;
+	}
+	const GLenum iError = glGetError();
+	if( iError != GL_NO_ERROR )
+	{
+		printf( "GL error 0x%x\n", iError );
+		return false;
+	}
+	printf( "%i frames, %i draws from the streaming buffer, matched client arrays\n", iFrames, iStreamed );
+	return true;
+}
+
+int main()
+{
+	PFNEGLGETPLATFORMDISPLAYEXTPROC pGetPlatformDisplay =
+		(PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress( "eglGetPlatformDisplayEXT" );
+	EGLDisplay display = pGetPlatformDisplay?
+		pGetPlatformDisplay( EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr ):EGL_NO_DISPLAY;
+	EGLint iMajor, iMinor;
+	if( display == EGL_NO_DISPLAY || !eglInitialize(display, &iMajor, &iMinor) || !eglBindAPI(EGL_OPENGL_API) )
+	{
+		printf( "Couldn't open a surfaceless EGL display\n" );
+		return 1;
+	}
+	EGLContext context = eglCreateContext( display, nullptr, EGL_NO_CONTEXT, nullptr );
+	if( context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context) )
+	{
+		printf( "Couldn't create a GL context\n" );
+		return 1;
+	}
+
+	/* glewInit looks for GLX, which isn't there; it finds the functions anyway. */
+	glewInit();
+	printf( "%s, %s\n", glGetString(GL_RENDERER), glGetString(GL_VERSION) );
+
+	GLuint iFramebuffer, iRenderbuffer;
+	glGenFramebuffers( 1, &iFramebuffer );
+	glBindFramebuffer( GL_FRAMEBUFFER, iFramebuffer );
+	glGenRenderbuffers( 1, &iRenderbuffer );
+	glBindRenderbuffer( GL_RENDERBUFFER, iRenderbuffer );
+	glRenderbufferStorage( GL_RENDERBUFFER, GL_RGBA8, SIZE, SIZE );
+	glFramebufferRenderbuffer( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, iRenderbuffer );
+	glViewport( 0, 0, SIZE, SIZE );
+
+	const bool bOK = Compare( 30 );
+	g_Buffer.Free();
+
+	eglMakeCurrent( display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT );
+	eglDestroyContext( display, context );
+	eglTerminate( display );
+	return bOK? 0:1;
+}
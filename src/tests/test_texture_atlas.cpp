@@ -0,0 +1,199 @@
+#include "global.h"
+#include "RageLog.h"
+#include "RageFile.h"
+#include "RageFileManager.h"
+#include "RageUtil.h"
+#include "RageSurface.h"
+#include "RageTextureAtlas.h"
+#include "LuaManager.h"
+#include "PrefsManager.h"
+#include "test_misc.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+/* Packs random sets of images the size of note skin parts, checks that
+ * every image lands on its page inside the bounds, apart from every other,
+ * with its pixels and the repeated edge around it intact. */
+
+static const int GUTTER = 2;
+
+static RageSurface *MakeImage( int iWidth, int iHeight )
+{
+	RageSurface *pImage = CreateSurface( iWidth, iHeight, 32, 0xFF000000, 0x00FF0000, 0x0000FF00, 0x000000FF );
+	for( int y = 0; y < iHeight; ++y )
+	{
+		uint32_t *pRow = (uint32_t *) (pImage->pixels + y*pImage->pitch);
+		for( int x = 0; x < iWidth; ++x )
+			pRow[x] = g_iTestSeed = g_iTestSeed * 1103515245 + 12345;
+	}
+	return pImage;
+}
+
+static uint32_t GetPixel( const RageSurface *pImage, int x, int y )
+{
+	return ((const uint32_t *) (pImage->pixels + y*pImage->pitch))[x];
+}
+
+static void MakePlacements( std::vector<RageTextureAtlas::Placement> &vPlacements, int iCount )
+{
+	vPlacements.clear();
+	for( int i = 0; i < iCount; ++i )
+	{
+		// Mostly 64x64 frames in strips, with the odd receptor sheet or explosion.
+		RageTextureAtlas::Placement p;
+		p.iWidth = 64 << test_random(3);
+		p.iHeight = 64 << test_random(3);
+		if( test_random(10) == 0 )
+			p.iWidth = p.iHeight = 2048;
+		if( test_random(10) == 0 )
+			p.iWidth = 1 + test_random(100);
+		vPlacements.push_back( p );
+	}
+}
+
+static bool CheckPack( const std::vector<RageTextureAtlas::Placement> &vPlacements, int iPageSize )
+{
+	for( unsigned i = 0; i < vPlacements.size(); ++i )
+	{
+		const RageTextureAtlas::Placement &a = vPlacements[i];
+		if( a.iPage == -1 )
+		{
+			if( a.iWidth + GUTTER*2 <= iPageSize && a.iHeight + GUTTER*2 <= iPageSize )
+			{
+				LOG->Warn( "%ix%i wasn't placed", a.iWidth, a.iHeight );
+				return false;
+			}
+			continue;
+		}
+		if( a.iX < GUTTER || a.iY < GUTTER ||
+			a.iX + a.iWidth + GUTTER > iPageSize || a.iY + a.iHeight + GUTTER > iPageSize )
+		{
+			LOG->Warn( "%ix%i at %i,%i is off the page", a.iWidth, a.iHeight, a.iX, a.iY );
+			return false;
+		}
+
+		for( unsigned j = 0; j < i; ++j )
+		{
+			const RageTextureAtlas::Placement &b = vPlacements[j];
+			if( b.iPage != a.iPage )
+				continue;
+			if( a.iX - GUTTER < b.iX + b.iWidth + GUTTER && b.iX - GUTTER < a.iX + a.iWidth + GUTTER &&
+				a.iY - GUTTER < b.iY + b.iHeight + GUTTER && b.iY - GUTTER < a.iY + a.iHeight + GUTTER )
+			{
+				LOG->Warn( "%ix%i at %i,%i overlaps %ix%i at %i,%i on page %i",
+					a.iWidth, a.iHeight, a.iX, a.iY, b.iWidth, b.iHeight, b.iX, b.iY, a.iPage );
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+static bool CheckCompose( int iPageSize )
+{
+	std::vector<RageTextureAtlas::Placement> vPlacements;
+	MakePlacements( vPlacements, 40 );
+	RageTextureAtlas::Pack( vPlacements, iPageSize, GUTTER );
+
+	int iPages = 0;
+	for( const RageTextureAtlas::Placement &p : vPlacements )
+		iPages = std::max( iPages, p.iPage + 1 );
+
+	std::vector<RageSurface *> vpPages, vpImages;
+	for( int i = 0; i < iPages; ++i )
+		vpPages.push_back( MakeImage(iPageSize, iPageSize) );
+
+	bool bOK = true;
+	for( const RageTextureAtlas::Placement &p : vPlacements )
+	{
+		// Images are usually bigger than what's used of them, as textures are.
+		RageSurface *pImage = MakeImage( p.iWidth + test_random(3), p.iHeight + test_random(3) );
+		vpImages.push_back( pImage );
+		if( p.iPage != -1 )
+			RageTextureAtlas::Compose( vpPages[p.iPage], pImage, p.iX, p.iY, p.iWidth, p.iHeight, GUTTER );
+	}
+
+	// Check after everything is placed, so a later image drawing over an
+	// earlier one shows up.
+	for( unsigned i = 0; bOK && i < vPlacements.size(); ++i )
+	{
+		const RageTextureAtlas::Placement &p = vPlacements[i];
+		if( p.iPage == -1 )
+			continue;
+		for( int y = -GUTTER; bOK && y < p.iHeight + GUTTER; ++y )
+		{
+			for( int x = -GUTTER; bOK && x < p.iWidth + GUTTER; ++x )
+			{
+				const int iSrcX = std::clamp( x, 0, p.iWidth-1 );
+				const int iSrcY = std::clamp( y, 0, p.iHeight-1 );
+				const uint32_t iExpected = GetPixel( vpImages[i], iSrcX, iSrcY );
+				const uint32_t iGot = GetPixel( vpPages[p.iPage], p.iX + x, p.iY + y );
+				if( iGot != iExpected )
+				{
+					LOG->Warn( "Image %i (%ix%i), pixel %i,%i: %08x, expected %08x",
+						i, p.iWidth, p.iHeight, x, y, iGot, iExpected );
+					bOK = false;
+				}
+			}
+		}
+	}
+
+	for( RageSurface *p : vpImages )
+		delete p;
+	for( RageSurface *p : vpPages )
+		delete p;
+	return bOK;
+}
+
+static bool Compare( int iSets )
+{
+	const int iPageSizes[] = { 256, 1024, 2048 };
+	int iPlaced = 0, iTotal = 0, iPages = 0;
+	for( int i = 0; i < iSets; ++i )
+	{
+		const int iPageSize = iPageSizes[test_random(3)];
+		std::vector<RageTextureAtlas::Placement> vPlacements;
+		MakePlacements( vPlacements, 1 + test_random(60) );
+		RageTextureAtlas::Pack( vPlacements, iPageSize, GUTTER );
+		if( !CheckPack(vPlacements, iPageSize) )
+			return false;
+
+		int iSetPages = 0;
+		for( const RageTextureAtlas::Placement &p : vPlacements )
+		{
+			iSetPages = std::max( iSetPages, p.iPage + 1 );
+			iPlaced += p.iPage != -1;
+		}
+		iPages += iSetPages;
+		iTotal += vPlacements.size();
+	}
+
+	for( int i = 0; i < 10; ++i )
+		if( !CheckCompose(1024) )
+			return false;
+
+	LOG->Trace( "%i sets packed: %i of %i images placed on %i pages.", iSets, iPlaced, iTotal, iPages );
+	return true;
+}
+
+int main( int argc, char *argv[] )
+{
+	LUA			= new LuaManager;
+	FILEMAN			= new RageFileManager( argv[0] );
+	FILEMAN->Mount( "dir", ".", "" );
+	LOG			= new RageLog();
+	PREFSMAN		= new PrefsManager;
+	LOG->SetShowLogOutput( true );
+	LOG->SetFlushing( true );
+
+	const bool bOK = Compare( 500 );
+
+	delete PREFSMAN;
+	delete LOG;
+	delete FILEMAN;
+	delete LUA;
+
+	exit( bOK? 0:1 );
+}
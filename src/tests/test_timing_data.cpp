@@ -6,136 +6,340 @@
 #include "PrefsManager.h"
 #include "RageFileManager.h"
 #include "TimingData.h"
+#include "test_misc.h"
 
-void run()
+#include <cstring>
+
+/* Sanity checks on beat and time lookups, then checks that the lookup table
+ * PrepareLookup builds gives exactly what walking through all the segments
+ * does, and that the segment lists stay in order through edits. */
+
+static bool run()
 {
 #define CHECK(call, exp) \
 { \
 	float ret = call; \
-	if( call != exp ) { \
+	if( ret != exp ) { \
 		LOG->Warn( "Line %i: Got %f, expected %f", __LINE__, ret, exp); \
-		return; \
+		return false; \
 	} \
 }
 
 	TimingData test;
-	test.AddBPMSegment( BPMSegment(0, 60) );
+	test.SetBPMAtBeat( 0, 60 );
 
 	/* First, trivial sanity checks. */
-	CHECK( test.GetBeatFromElapsedTime(60), 60.0f );
-	CHECK( test.GetElapsedTimeFromBeat(60), 60.0f );
+	CHECK( test.GetBeatFromElapsedTimeNoOffset(60), 60.0f );
+	CHECK( test.GetElapsedTimeFromBeatNoOffset(60), 60.0f );
 
 	/* The first BPM segment extends backwards in time. */
-	CHECK( test.GetBeatFromElapsedTime(-60), -60.0f );
-	CHECK( test.GetElapsedTimeFromBeat(-60), -60.0f );
+	CHECK( test.GetBeatFromElapsedTimeNoOffset(-60), -60.0f );
+	CHECK( test.GetElapsedTimeFromBeatNoOffset(-60), -60.0f );
 
-	CHECK( test.GetBeatFromElapsedTime(100000), 100000.0f );
-	CHECK( test.GetElapsedTimeFromBeat(100000), 100000.0f );
-	CHECK( test.GetBeatFromElapsedTime(-100000), -100000.0f );
-	CHECK( test.GetElapsedTimeFromBeat(-100000), -100000.0f );
+	CHECK( test.GetBeatFromElapsedTimeNoOffset(100000), 100000.0f );
+	CHECK( test.GetElapsedTimeFromBeatNoOffset(100000), 100000.0f );
+	CHECK( test.GetBeatFromElapsedTimeNoOffset(-100000), -100000.0f );
+	CHECK( test.GetElapsedTimeFromBeatNoOffset(-100000), -100000.0f );
 
 	CHECK( test.GetBPMAtBeat(0), 60.0f );
 	CHECK( test.GetBPMAtBeat(100000), 60.0f );
 	CHECK( test.GetBPMAtBeat(-100000), 60.0f );
 
 	/* 120BPM at beat 10: */
-	test.AddBPMSegment( BPMSegment(10, 120) );
-	CHECK( test.GetBPMAtBeat(9.99), 60.0f );
+	test.SetBPMAtBeat( 10, 120 );
+	CHECK( test.GetBPMAtBeat(9.9f), 60.0f );
 	CHECK( test.GetBPMAtBeat(10), 120.0f );
 
-	CHECK( test.GetBeatFromElapsedTime(9), 9.0f );
-	CHECK( test.GetBeatFromElapsedTime(10), 10.0f );
-	CHECK( test.GetBeatFromElapsedTime(10.5), 11.0f );
+	CHECK( test.GetBeatFromElapsedTimeNoOffset(9), 9.0f );
+	CHECK( test.GetBeatFromElapsedTimeNoOffset(10), 10.0f );
+	CHECK( test.GetBeatFromElapsedTimeNoOffset(10.5), 11.0f );
 
-	CHECK( test.GetElapsedTimeFromBeat(9), 9.0f );
-	CHECK( test.GetElapsedTimeFromBeat(10), 10.0f );
-	CHECK( test.GetElapsedTimeFromBeat(11), 10.5f );
+	CHECK( test.GetElapsedTimeFromBeatNoOffset(9), 9.0f );
+	CHECK( test.GetElapsedTimeFromBeatNoOffset(10), 10.0f );
+	CHECK( test.GetElapsedTimeFromBeatNoOffset(11), 10.5f );
 
 	/* Add a 5-second stop at beat 10. */
-	test.AddStopSegment( StopSegment(10, 5) );
+	TimingData stop = test;
+	stop.SetStopAtBeat( 10, 5 );
 
 	/* The stop shouldn't affect GetBPMAtBeat at all. */
-	CHECK( test.GetBPMAtBeat(9.99), 60.0f );
-	CHECK( test.GetBPMAtBeat(10), 120.0f );
+	CHECK( stop.GetBPMAtBeat(9.9f), 60.0f );
+	CHECK( stop.GetBPMAtBeat(10), 120.0f );
 
-	CHECK( test.GetBeatFromElapsedTime(9), 9.0f );
-	CHECK( test.GetBeatFromElapsedTime(10), 10.0f );
-	CHECK( test.GetBeatFromElapsedTime(12), 10.0f );
-	CHECK( test.GetBeatFromElapsedTime(14), 10.0f );
-	CHECK( test.GetBeatFromElapsedTime(15), 10.0f );
-	CHECK( test.GetBeatFromElapsedTime(15.5), 11.0f );
-
-	CHECK( test.GetElapsedTimeFromBeat(9), 9.0f );
-	CHECK( test.GetElapsedTimeFromBeat(10), 10.0f );
-	CHECK( test.GetElapsedTimeFromBeat(11), 15.5f );
-
-	/* Add a 2-second stop at beat 5 and a 5-second stop at beat 15. */
-	test.m_StopSegments.clear();
-	test.AddStopSegment( StopSegment(5, 2) );
-	test.AddStopSegment( StopSegment(15, 5) );
-	CHECK( test.GetBPMAtBeat(9.99), 60.0f );
-	CHECK( test.GetBPMAtBeat(10), 120.0f );
+	CHECK( stop.GetBeatFromElapsedTimeNoOffset(9), 9.0f );
+	CHECK( stop.GetBeatFromElapsedTimeNoOffset(10), 10.0f );
+	CHECK( stop.GetBeatFromElapsedTimeNoOffset(12), 10.0f );
+	CHECK( stop.GetBeatFromElapsedTimeNoOffset(14), 10.0f );
+	CHECK( stop.GetBeatFromElapsedTimeNoOffset(15), 10.0f );
+	CHECK( stop.GetBeatFromElapsedTimeNoOffset(15.5), 11.0f );
+
+	CHECK( stop.GetElapsedTimeFromBeatNoOffset(9), 9.0f );
+	CHECK( stop.GetElapsedTimeFromBeatNoOffset(10), 10.0f );
+	CHECK( stop.GetElapsedTimeFromBeatNoOffset(11), 15.5f );
+
+	/* A 2-second stop at beat 5 and a 5-second stop at beat 15 instead. */
+	stop = test;
+	stop.SetStopAtBeat( 5, 2 );
+	stop.SetStopAtBeat( 15, 5 );
+	CHECK( stop.GetBPMAtBeat(9.9f), 60.0f );
+	CHECK( stop.GetBPMAtBeat(10), 120.0f );
+
+	CHECK( stop.GetBeatFromElapsedTimeNoOffset(1), 1.0f );
+	CHECK( stop.GetBeatFromElapsedTimeNoOffset(2), 2.0f );
+	CHECK( stop.GetBeatFromElapsedTimeNoOffset(5), 5.0f ); // stopped
+	CHECK( stop.GetBeatFromElapsedTimeNoOffset(6), 5.0f ); // stopped
+	CHECK( stop.GetBeatFromElapsedTimeNoOffset(7), 5.0f ); // stop finished
+	CHECK( stop.GetBeatFromElapsedTimeNoOffset(8), 6.0f );
+	CHECK( stop.GetBeatFromElapsedTimeNoOffset(12), 10.0f ); // bpm changes to 120
+	CHECK( stop.GetBeatFromElapsedTimeNoOffset(13), 12.0f );
+	CHECK( stop.GetBeatFromElapsedTimeNoOffset(14), 14.0f );
+	CHECK( stop.GetBeatFromElapsedTimeNoOffset(14.5f), 15.0f ); // stopped
+	CHECK( stop.GetBeatFromElapsedTimeNoOffset(15), 15.0f ); // stopped
+	CHECK( stop.GetBeatFromElapsedTimeNoOffset(17), 15.0f ); // stopped
+	CHECK( stop.GetBeatFromElapsedTimeNoOffset(19.5f), 15.0f ); // stop finished
+	CHECK( stop.GetBeatFromElapsedTimeNoOffset(20), 16.0f );
 
-	CHECK( test.GetBeatFromElapsedTime(1), 1.0f );
-	CHECK( test.GetBeatFromElapsedTime(2), 2.0f );
-	CHECK( test.GetBeatFromElapsedTime(5), 5.0f ); // stopped
-	CHECK( test.GetBeatFromElapsedTime(6), 5.0f ); // stopped
-	CHECK( test.GetBeatFromElapsedTime(7), 5.0f ); // stop finished
-	CHECK( test.GetBeatFromElapsedTime(8), 6.0f );
-	CHECK( test.GetBeatFromElapsedTime(12), 10.0f ); // bpm changes to 120
-	CHECK( test.GetBeatFromElapsedTime(13), 12.0f );
-	CHECK( test.GetBeatFromElapsedTime(14), 14.0f );
-	CHECK( test.GetBeatFromElapsedTime(14.5f), 15.0f ); // stopped
-	CHECK( test.GetBeatFromElapsedTime(15), 15.0f ); // stopped
-	CHECK( test.GetBeatFromElapsedTime(17), 15.0f ); // stopped
-	CHECK( test.GetBeatFromElapsedTime(19.5f), 15.0f ); // stop finished
-	CHECK( test.GetBeatFromElapsedTime(20), 16.0f );
-
-	CHECK( test.GetElapsedTimeFromBeat(1), 1.0f );
-	CHECK( test.GetElapsedTimeFromBeat(2), 2.0f );
-	CHECK( test.GetElapsedTimeFromBeat(5), 5.0f ); // stopped
-	CHECK( test.GetElapsedTimeFromBeat(6), 8.0f );
-	CHECK( test.GetElapsedTimeFromBeat(10), 12.0f ); // bpm changes to 120
-	CHECK( test.GetElapsedTimeFromBeat(12), 13.0f );
-	CHECK( test.GetElapsedTimeFromBeat(14), 14.0f );
-	CHECK( test.GetElapsedTimeFromBeat(15.0f), 14.5f ); // stopped
-	CHECK( test.GetElapsedTimeFromBeat(16), 20.0f );
-
-	// todo: add warp tests -aj
-
-RageTimer foobar;
-	/* We can look up the time of any given beat, then look up the beat of that
-	 * time and get the original value.  (We can't do this in reverse; the beat
-	 * doesn't move during stop segments.) */
-int q = 0;
-	for( float f = -10; f < 250; f += 0.002 )
+	CHECK( stop.GetElapsedTimeFromBeatNoOffset(1), 1.0f );
+	CHECK( stop.GetElapsedTimeFromBeatNoOffset(2), 2.0f );
+	CHECK( stop.GetElapsedTimeFromBeatNoOffset(5), 5.0f ); // stopped
+	CHECK( stop.GetElapsedTimeFromBeatNoOffset(6), 8.0f );
+	CHECK( stop.GetElapsedTimeFromBeatNoOffset(10), 12.0f ); // bpm changes to 120
+	CHECK( stop.GetElapsedTimeFromBeatNoOffset(12), 13.0f );
+	CHECK( stop.GetElapsedTimeFromBeatNoOffset(14), 14.0f );
+	CHECK( stop.GetElapsedTimeFromBeatNoOffset(15.0f), 14.5f ); // stopped
+	CHECK( stop.GetElapsedTimeFromBeatNoOffset(16), 20.0f );
+
+	/* A 4 beat warp at beat 20 skips straight from beat 20 to 24. */
+	TimingData warp = test;
+	warp.SetWarpAtBeat( 20, 4 );
+	CHECK( warp.GetElapsedTimeFromBeatNoOffset(20), 15.0f );
+	CHECK( warp.GetElapsedTimeFromBeatNoOffset(22), 15.0f );
+	CHECK( warp.GetElapsedTimeFromBeatNoOffset(24), 15.0f );
+	CHECK( warp.GetElapsedTimeFromBeatNoOffset(26), 16.0f );
+	CHECK( warp.GetBeatFromElapsedTimeNoOffset(14.5f), 19.0f );
+	CHECK( warp.GetBeatFromElapsedTimeNoOffset(15.5f), 25.0f );
+
+	TimingData test2;
+	test2.SetBPMAtBeat( 0, 60 );
+	test2.SetStopAtBeat( 0, 1 );
+	CHECK( test2.GetBeatFromElapsedTimeNoOffset(-1), -1.0f );
+	CHECK( test2.GetBeatFromElapsedTimeNoOffset(0), 0.0f );
+	CHECK( test2.GetBeatFromElapsedTimeNoOffset(1), 0.0f );
+	CHECK( test2.GetBeatFromElapsedTimeNoOffset(2), 1.0f );
+	CHECK( test2.GetElapsedTimeFromBeatNoOffset(-1), -1.0f );
+	CHECK( test2.GetElapsedTimeFromBeatNoOffset(0), 0.0f );
+	CHECK( test2.GetElapsedTimeFromBeatNoOffset(1), 2.0f );
+	CHECK( test2.GetElapsedTimeFromBeatNoOffset(2), 3.0f );
+
+	/* The same again with the lookup table. */
+	test2.PrepareLookup();
+	CHECK( test2.GetBeatFromElapsedTimeNoOffset(-1), -1.0f );
+	CHECK( test2.GetBeatFromElapsedTimeNoOffset(1), 0.0f );
+	CHECK( test2.GetBeatFromElapsedTimeNoOffset(2), 1.0f );
+	CHECK( test2.GetElapsedTimeFromBeatNoOffset(0), 0.0f );
+	CHECK( test2.GetElapsedTimeFromBeatNoOffset(1), 2.0f );
+
+	LOG->Trace( "Sanity checks passed." );
+	return true;
+#undef CHECK
+}
+
+/* A chart with a timing segment every few rows: BPM changes, stops, delays
+ * and warps, some on the same rows, and the odd negative stop. */
+static void MakeGimmickTiming( TimingData &td, int iSegments )
+{
+	td.m_fBeat0OffsetInSeconds = test_random_range( -1, 1 );
+	td.SetBPMAtRow( 0, test_random_range(60, 240) );
+	int iRow = 0;
+	for( int i = 0; i < iSegments; ++i )
 	{
-		++q;
-//		const float t = test.GetElapsedTimeFromBeat( f );
-		const float b = test.GetBeatFromElapsedTime( f );
+		iRow += test_random(4) == 0? 0:1 + test_random( ROWS_PER_BEAT * 2 );
+		switch( test_random(8) )
+		{
+		case 0:
+		case 1:
+		case 2:
+			td.SetBPMAtRow( iRow, test_random_range(30, 600) );
+			break;
+		case 3:
+		case 4:
+			td.SetStopAtRow( iRow, test_random(10) == 0? test_random_range(-0.2f, 0):test_random_range(0.01f, 1) );
+			break;
+		case 5:
+			td.SetDelayAtRow( iRow, test_random_range(0.01f, 1) );
+			break;
+		default:
+			td.SetWarpAtRow( iRow, test_random_range(0.1f, 3) );
+			break;
+		}
+	}
+}
+
+static bool SameArgs( const TimingData::GetBeatArgs &a, const TimingData::GetBeatArgs &b )
+{
+	// Compare bits, so that a NaN matches itself.
+	return !memcmp( &a.beat, &b.beat, sizeof(float) ) &&
+		!memcmp( &a.bps_out, &b.bps_out, sizeof(float) ) &&
+		a.warp_dest_out == b.warp_dest_out && a.warp_begin_out == b.warp_begin_out &&
+		a.freeze_out == b.freeze_out && a.delay_out == b.delay_out;
+}
 
-		/* b == f */
+static bool SameTime( float a, float b )
+{
+	return !memcmp( &a, &b, sizeof(float) );
+}
 
-//		if( std::abs(b-f) > 0.001 )
-//		{
-//			LOG->Warn( "%f != %f", b, f );
-//			return;
-//		}
+/* Looks up fSeconds and fBeat with the table and without it, and expects
+ * the same bits back. */
+static bool CompareOne( const TimingData &walk, const TimingData &table, float fSeconds, float fBeat )
+{
+	TimingData::GetBeatArgs a, b;
+	a.elapsed_time = b.elapsed_time = fSeconds;
+	walk.GetBeatAndBPSFromElapsedTimeNoOffset( a );
+	table.GetBeatAndBPSFromElapsedTimeNoOffset( b );
+	if( !SameArgs(a, b) )
+	{
+		LOG->Warn( "Time %.9g: walk gives beat %.9g bps %.9g warp %i, table gives beat %.9g bps %.9g warp %i",
+			fSeconds, a.beat, a.bps_out, a.warp_begin_out, b.beat, b.bps_out, b.warp_begin_out );
+		return false;
 	}
-LOG->Trace("... %i in %f", q, foobar.GetDeltaTime());
 
-	TimingData test2;
-	test2.AddBPMSegment( BPMSegment(0, 60) );
-	test2.AddStopSegment( StopSegment(0, 1) );
-	//test2.AddWarpSegment( WarpSegment() );
-	CHECK( test2.GetBeatFromElapsedTime(-1), -1.0f );
-	CHECK( test2.GetBeatFromElapsedTime(0), 0.0f );
-	CHECK( test2.GetBeatFromElapsedTime(1), 0.0f );
-	CHECK( test2.GetBeatFromElapsedTime(2), 1.0f );
-	CHECK( test2.GetElapsedTimeFromBeat(-1), -1.0f );
-	CHECK( test2.GetElapsedTimeFromBeat(0), 0.0f );
-	CHECK( test2.GetElapsedTimeFromBeat(1), 2.0f );
-	CHECK( test2.GetElapsedTimeFromBeat(2), 3.0f );
+	const float fWalk = walk.GetElapsedTimeFromBeatNoOffset( fBeat );
+	const float fTable = table.GetElapsedTimeFromBeatNoOffset( fBeat );
+	if( !SameTime(fWalk, fTable) )
+	{
+		LOG->Warn( "Beat %.9g: walk gives %.9g, table gives %.9g", fBeat, fWalk, fTable );
+		return false;
+	}
+	return true;
+}
+
+static bool Compare()
+{
+	for( int iRun = 0; iRun < 50; ++iRun )
+	{
+		TimingData walk;
+		MakeGimmickTiming( walk, 1 + test_random(300) );
+		TimingData table = walk;
+		table.PrepareLookup();
+
+		const float fStart = walk.GetElapsedTimeFromBeatNoOffset( -4 );
+		const float fEnd = walk.GetElapsedTimeFromBeatNoOffset( 200 );
+		// Forward, the way gameplay asks.
+		for( float f = fStart; f < fEnd; f += 1/120.0f )
+			if( !CompareOne(walk, table, f, walk.GetBeatFromElapsedTimeNoOffset(f)) )
+				return false;
+
+		// Exactly on each segment, and just either side of it.
+		const TimingSegmentType types[] = { SEGMENT_BPM, SEGMENT_STOP, SEGMENT_DELAY, SEGMENT_WARP };
+		for( unsigned t = 0; t < ARRAYLEN(types); ++t )
+		{
+			for( TimingSegment const *pSeg : walk.GetTimingSegments(types[t]) )
+			{
+				const float fBeat = pSeg->GetBeat();
+				const float fSeconds = walk.GetElapsedTimeFromBeatNoOffset( fBeat );
+				for( int d = -2; d <= 2; ++d )
+				{
+					const float fNearBeat = NoteRowToBeat( pSeg->GetRow() + d );
+					const float fNearSeconds = fSeconds + d * 0.0001f;
+					if( !CompareOne(walk, table, fNearSeconds, fNearBeat) )
+						return false;
+				}
+			}
+		}
+
+		// Anywhere, in any order.
+		for( int i = 0; i < 2000; ++i )
+			if( !CompareOne(walk, table, test_random_range(fStart - 10, fEnd + 10), test_random_range(-10, 210)) )
+				return false;
+	}
+	LOG->Trace( "The lookup table matches walking the segments." );
+	return true;
+}
+
+template<typename Seg>
+static bool PointsIntoArray( const TimingData &td, TimingSegmentType tst, const std::vector<Seg> &vSegs )
+{
+	const std::vector<TimingSegment*> &vpSegs = td.GetTimingSegments( tst );
+	if( vpSegs.size() != vSegs.size() )
+		return false;
+	for( unsigned i = 0; i < vpSegs.size(); ++i )
+	{
+		if( vpSegs[i] != &vSegs[i] || vpSegs[i]->GetType() != tst )
+			return false;
+		if( i > 0 && vpSegs[i-1]->GetRow() > vpSegs[i]->GetRow() )
+			return false;
+	}
+	return true;
+}
+
+/* Each GetTimingSegments list should point at the segments of that type, in
+ * order, after anything that adds, removes or moves them. */
+static bool SegmentsInOrder( const TimingData &td )
+{
+	return PointsIntoArray( td, SEGMENT_BPM, td.GetBPMSegments() ) &&
+		PointsIntoArray( td, SEGMENT_STOP, td.GetStopSegments() ) &&
+		PointsIntoArray( td, SEGMENT_DELAY, td.GetDelaySegments() ) &&
+		PointsIntoArray( td, SEGMENT_TIME_SIG, td.GetTimeSignatureSegments() ) &&
+		PointsIntoArray( td, SEGMENT_WARP, td.GetWarpSegments() ) &&
+		PointsIntoArray( td, SEGMENT_LABEL, td.GetLabelSegments() ) &&
+		PointsIntoArray( td, SEGMENT_TICKCOUNT, td.GetTickcountSegments() ) &&
+		PointsIntoArray( td, SEGMENT_COMBO, td.GetComboSegments() ) &&
+		PointsIntoArray( td, SEGMENT_SPEED, td.GetSpeedSegments() ) &&
+		PointsIntoArray( td, SEGMENT_SCROLL, td.GetScrollSegments() ) &&
+		PointsIntoArray( td, SEGMENT_FAKE, td.GetFakeSegments() );
+}
+
+static bool EditSegments()
+{
+	// DeleteRows logs every segment it moves.
+	LOG->SetShowLogOutput( false );
+	for( int iRun = 0; iRun < 100; ++iRun )
+	{
+		TimingData td;
+		MakeGimmickTiming( td, test_random(50) );
+		td.TidyUpData( false );
+		for( int i = 0; i < 200; ++i )
+		{
+			const int iRow = test_random( ROWS_PER_BEAT * 64 );
+			switch( test_random(10) )
+			{
+			case 0: td.SetBPMAtRow( iRow, test_random_range(60, 200) ); break;
+			case 1: td.SetStopAtRow( iRow, test_random(3) == 0? 0:test_random_range(0.1f, 1) ); break;
+			case 2: td.AddSegment( LabelSegment(iRow, ssprintf("Label %i", i)) ); break;
+			case 3: td.AddSegment( ScrollSegment(iRow, test_random_range(0.5f, 2)) ); break;
+			case 4: td.InsertRows( iRow, test_random(ROWS_PER_BEAT * 4) ); break;
+			case 5: td.DeleteRows( iRow, test_random(ROWS_PER_BEAT * 4) ); break;
+			case 6: td.ShiftRange( iRow, iRow + test_random(ROWS_PER_BEAT * 8), TimingSegmentType_Invalid, test_random(ROWS_PER_BEAT * 8) - ROWS_PER_BEAT * 4 ); break;
+			case 7: td.ClearRange( iRow, iRow + test_random(ROWS_PER_BEAT * 4), TimingSegmentType_Invalid ); break;
+			case 8:
+				if( !td.GetStopSegments().empty() )
+					td.EraseSegment( SEGMENT_STOP, test_random(td.GetStopSegments().size()) );
+				break;
+			default:
+			{
+				TimingData copy;
+				copy = td;
+				if( copy != td || !SegmentsInOrder(copy) )
+				{
+					LOG->SetShowLogOutput( true );
+					LOG->Warn( "Run %i: copy differs", iRun );
+					return false;
+				}
+				td = copy;
+			}
+			}
+			if( !SegmentsInOrder(td) )
+			{
+				LOG->SetShowLogOutput( true );
+				LOG->Warn( "Run %i, edit %i: segments out of order", iRun, i );
+				return false;
+			}
+		}
+	}
+	LOG->SetShowLogOutput( true );
+	LOG->Trace( "Segment lists stay in order through edits and copies." );
+	return true;
 }
 
 int main( int argc, char *argv[] )
@@ -147,11 +351,11 @@ int main( int argc, char *argv[] )
 	LOG->SetShowLogOutput( true );
 	LOG->SetFlushing( true );
 
-	run();
+	const bool bOK = run() && Compare() && EditSegments();
 
 	delete PREFSMAN;
 	delete LOG;
 	delete FILEMAN;
 
-	exit(0);
+	exit( bOK? 0:1 );
 }